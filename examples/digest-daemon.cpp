@@ -0,0 +1,171 @@
+/*
+
+	ffuzzy++ examples
+
+	digest-daemon.cpp
+	Similarity search daemon (and its client) over a Unix domain socket
+
+	Copyright (C) 2026 Tsukasa OI <floss_ssdeep@irq.a4lg.com>
+
+
+	Permission to use, copy, modify, and/or distribute this software for
+	any purpose with or without fee is hereby granted, provided that the
+	above copyright notice and this permission notice appear in all copies.
+
+	THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+	WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+	MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+	ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+	WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+	ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+	OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+
+*/
+
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <pthread.h>
+#include <signal.h>
+
+/*
+	This enables compilation without libffuzzypp.a.
+	Define this in **one** of the source files to make the linker happy.
+*/
+#define FFUZZYPP_DECLARATIONS
+
+// the following line will activate assertions.
+//#define FFUZZYPP_DEBUG
+
+#include "ffuzzy.hpp"
+using namespace ffuzzy;
+
+#ifdef FFUZZYPP_DISABLE_SOCKETS
+int main(void)
+{
+	fprintf(stderr, "error: this program requires Unix domain sockets.\n");
+	return 1;
+}
+#else
+
+static int usage(const char* prog)
+{
+	fprintf(stderr,
+		"usage: %s serve SOCKET FILE [WORKERS]\n"
+		"       %s query SOCKET MIN_SCORE TOP_K HASH...\n"
+		"FILE contains a digest on each line (ssdeep output is accepted).\n"
+		"TOP_K of zero reports all matches.\n",
+		prog, prog);
+	return 1;
+}
+
+static int serve(const char* path, const char* filename, unsigned workers)
+{
+	/*
+		Load digests (IDs are zero-based line numbers of valid digests)
+		Only the digest part of "digest,filename" lines is used.
+	*/
+	FILE* fp = fopen(filename, "r");
+	if (!fp)
+	{
+		fprintf(stderr, "error: failed to open %s.\n", filename);
+		return 1;
+	}
+	digest_index_t index;
+	char line[4096];
+	size_t skipped = 0;
+	while (fgets(line, sizeof(line), fp))
+	{
+		line[strcspn(line, ",\r\n")] = '\0';
+		digest_ra_long_t d;
+		if (!digest_ra_long_t::parse(d, line))
+		{
+			skipped++;
+			continue;
+		}
+		index.push_back(d);
+	}
+	fclose(fp);
+	fprintf(stderr, "loaded %zu digests (%zu lines skipped).\n", index.size(), skipped);
+
+	/*
+		Signals are received by the main thread only
+		(other threads inherit the blocked signal mask).
+	*/
+	sigset_t sigs;
+	sigemptyset(&sigs);
+	sigaddset(&sigs, SIGINT);
+	sigaddset(&sigs, SIGTERM);
+	pthread_sigmask(SIG_BLOCK, &sigs, nullptr);
+
+	digest_service_server<digest_index_t> server(index, workers);
+	if (!server.listen(path))
+	{
+		fprintf(stderr, "error: failed to listen on %s.\n", path);
+		return 1;
+	}
+	fprintf(stderr, "listening on %s.\n", path);
+	bool ok = true;
+	std::thread runner([&] { ok = server.run(); });
+	int sig;
+	sigwait(&sigs, &sig);
+	server.stop();
+	runner.join();
+	if (!ok)
+	{
+		fprintf(stderr, "error: failed to start worker threads.\n");
+		return 1;
+	}
+	return 0;
+}
+
+static int query(const char* path, unsigned min_score, unsigned top_k, char** hashes, int count)
+{
+	digest_service_client client(path);
+	if (!client.is_open())
+	{
+		fprintf(stderr, "error: failed to connect to %s.\n", path);
+		return 1;
+	}
+	// All hashes in one batch
+	std::vector<digest_service_query> queries;
+	for (int i = 0; i < count; i++)
+		queries.push_back(digest_service_query{ hashes[i], min_score, top_k });
+	std::vector<digest_service_reply> replies;
+	uint_least64_t request_id;
+	if (!client.send(1, queries) || !client.receive(request_id, replies) || replies.size() != queries.size())
+	{
+		fprintf(stderr, "error: failed to communicate with the server.\n");
+		return 1;
+	}
+	for (size_t i = 0; i < replies.size(); i++)
+	{
+		printf("%s\n", queries[i].digest.c_str());
+		if (!replies[i].is_valid)
+		{
+			printf("\t(invalid digest)\n");
+			continue;
+		}
+		for (const digest_search_result& r : replies[i].matches)
+			printf("\t%zu\t%u\n", r.index, unsigned(r.score));
+	}
+	return 0;
+}
+
+int main(int argc, char** argv)
+{
+	if (argc >= 4 && !strcmp(argv[1], "serve") && argc <= 5)
+		return serve(argv[2], argv[3], argc == 5 ? unsigned(strtoul(argv[4], nullptr, 10)) : 0);
+	if (argc >= 6 && !strcmp(argv[1], "query"))
+		return query(argv[2], unsigned(strtoul(argv[3], nullptr, 10)),
+			unsigned(strtoul(argv[4], nullptr, 10)), argv + 5, argc - 5);
+	return usage(argv[0]);
+}
+
+#endif
@@ -25,19 +25,24 @@
 #define FFUZZYPP_ROOT_FFUZZY_HPP
 
 #include "ffuzzypp/utils/likely.hpp"
+#include "ffuzzypp/utils/prefetch.hpp"
+#include "ffuzzypp/utils/bits.hpp"
 #include "ffuzzypp/utils/minmax.hpp"
 #include "ffuzzypp/utils/safe_int.hpp"
 #include "ffuzzypp/utils/static_assert_query.hpp"
 #include "ffuzzypp/utils/numeric_digits.hpp"
 #include "ffuzzypp/utils/type_modifier.hpp"
 #include "ffuzzypp/utils/ranges.hpp"
+#include "ffuzzypp/utils/mapped_file.hpp"
 #include "ffuzzypp/base64.hpp"
 #include "ffuzzypp/context_hash.hpp"
 #include "ffuzzypp/context_hash_fast.hpp"
 #include "ffuzzypp/rolling_hash.hpp"
 #include "ffuzzypp/rolling_hash_ssdeep.hpp"
 #include "ffuzzypp/strings/position_array.hpp"
+#include "ffuzzypp/strings/compact_position_array.hpp"
 #include "ffuzzypp/strings/common_substr.hpp"
+#include "ffuzzypp/strings/common_substr_edit_dist.hpp"
 #include "ffuzzypp/strings/edit_dist.hpp"
 #include "ffuzzypp/strings/terminators.hpp"
 #include "ffuzzypp/strings/transform.hpp"
@@ -45,10 +50,31 @@
 #include "ffuzzypp/strings/nosequences.hpp"
 #include "ffuzzypp/digest_blocksize.hpp"
 #include "ffuzzypp/digest_data.hpp"
+#include "ffuzzypp/digest_view.hpp"
+#include "ffuzzypp/digest_wire.hpp"
 #include "ffuzzypp/digest_position_array_base.hpp"
 #include "ffuzzypp/digest_comparison.hpp"
+#include "ffuzzypp/digest_comparison_table.hpp"
 #include "ffuzzypp/digest_base.hpp"
 #include "ffuzzypp/digest_position_array.hpp"
+#include "ffuzzypp/digest_compact_store.hpp"
+#include "ffuzzypp/digest_bitsliced_store.hpp"
+#include "ffuzzypp/blockhash_signature.hpp"
+#include "ffuzzypp/digest_store.hpp"
+#include "ffuzzypp/digest_query.hpp"
+#include "ffuzzypp/digest_posting_list.hpp"
+#include "ffuzzypp/digest_index.hpp"
+#include "ffuzzypp/digest_lsh_index.hpp"
+#include "ffuzzypp/digest_snapshot.hpp"
+#include "ffuzzypp/digest_concurrent_index.hpp"
+#include "ffuzzypp/digest_lsm_index.hpp"
+#include "ffuzzypp/digest_shard.hpp"
+#include "ffuzzypp/digest_service.hpp"
+#include "ffuzzypp/digest_all_pairs.hpp"
+#include "ffuzzypp/digest_parallel_all_pairs.hpp"
+#include "ffuzzypp/digest_intern.hpp"
+#include "ffuzzypp/digest_join.hpp"
+#include "ffuzzypp/digest_stream_cluster.hpp"
 #include "ffuzzypp/digest.hpp"
 #include "ffuzzypp/digest_filesize.hpp"
 #include "ffuzzypp/digest_generator.hpp"
@@ -0,0 +1,143 @@
+/*
+
+	ffuzzy++ : C++ implementation of fast fuzzy hashing
+
+	blockhash_signature.hpp
+	Bloom filter signature of block hash substrings (prefilter)
+
+	Copyright (C) 2026 Tsukasa OI <floss_ssdeep@irq.a4lg.com>
+
+
+	Permission to use, copy, modify, and/or distribute this software for
+	any purpose with or without fee is hereby granted, provided that the
+	above copyright notice and this permission notice appear in all copies.
+
+	THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+	WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+	MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+	ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+	WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+	ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+	OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+
+*/
+#ifndef FFUZZYPP_BLOCKHASH_SIGNATURE_HPP
+#define FFUZZYPP_BLOCKHASH_SIGNATURE_HPP
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+#include "digest_comparison.hpp"
+#include "digest_data.hpp"
+#include "rolling_hash.hpp"
+
+namespace ffuzzy {
+
+/*
+	Block hash signature (Bloom filter of substrings)
+
+	For each substring of blockhash_comparison_params::min_match_len
+	characters, one bit (selected by the rolling hash of the substring)
+	is set to the signature.
+
+	Two block hashes which share a common substring of that length
+	always have a common bit in their signatures (the same substring
+	sets the same bit). So, if signatures of two block hashes have
+	no common bits, the block hashes cannot have a common substring
+	and their comparison score is always zero.
+	This is a prefilter with no false negatives
+	(false positives are resolved by actual common substring search).
+
+	Block hashes shorter than min_match_len have empty signatures
+	(which never match).
+
+	Note that the signature saturates as the block hash gets longer
+	(a block hash of 64 characters sets up to 58 bits) and the
+	rejection rate drops accordingly. The check (a few AND operations)
+	is still far cheaper than common substring search.
+
+	Signatures pay off only when both sides are reused: digest_store
+	computes them once per stored digest and digest_query once per
+	query.  digest_comparison::compare and digest_position_array do not
+	use them because the other side is an ordinary digest and building
+	its signature (a rolling hash over the block hash) costs about as
+	much as the common substring search it would save.
+*/
+class blockhash_signature
+{
+public:
+	static constexpr const size_t bits = 256;
+	static constexpr const size_t word_bits = 64;
+	static constexpr const size_t words = bits / word_bits;
+	static_assert(bits % word_bits == 0, "bits must be a multiple of word_bits.");
+	static_assert(bits != 0 && (bits & (bits - 1)) == 0, "bits must be a power of two.");
+	static_assert(blockhash_comparison_params::min_match_len >= rolling_hash::window_size,
+		"min_match_len must be equal or greater than window_size.");
+private:
+	uint_least64_t sig[words];
+public:
+	bool empty(void) const noexcept
+	{
+		uint_least64_t x = 0;
+		for (size_t i = 0; i < words; i++)
+			x |= sig[i];
+		return x == 0;
+	}
+	bool test(size_t bit) const noexcept
+	{
+		#ifdef FFUZZYPP_DEBUG
+		assert(bit < bits);
+		#endif
+		return (sig[bit / word_bits] >> (bit % word_bits)) & 1u;
+	}
+	static size_t bit_for(uint_least32_t hash) noexcept
+	{
+		// Take upper bits of the multiplicative hash (rolling hash is weak in lower bits)
+		return size_t(((hash * uint_least32_t(0x9e3779b1ul)) & uint_least32_t(0xfffffffful)) >> 24) % bits;
+	}
+public:
+	void reset(void) noexcept
+	{
+		for (size_t i = 0; i < words; i++)
+			sig[i] = 0;
+	}
+	void construct(const char* str, size_t len) noexcept
+	{
+		static constexpr const size_t substr_size = blockhash_comparison_params::min_match_len;
+		reset();
+		if (len < substr_size)
+			return;
+		rolling_hash r;
+		for (size_t i = 0; i < substr_size - 1; i++)
+			r.update(static_cast<unsigned char>(str[i]));
+		for (size_t i = substr_size - 1; i < len; i++)
+		{
+			r.update(static_cast<unsigned char>(str[i]));
+			size_t bit = bit_for(r.sum());
+			sig[bit / word_bits] |= uint_least64_t(1u) << (bit % word_bits);
+		}
+	}
+	// Returns false if two block hashes never have a common substring
+	static bool may_match(const blockhash_signature& a, const blockhash_signature& b) noexcept
+	{
+		uint_least64_t x = 0;
+		for (size_t i = 0; i < words; i++)
+			x |= a.sig[i] & b.sig[i];
+		return x != 0;
+	}
+	bool may_match(const blockhash_signature& other) const noexcept
+	{
+		return may_match(*this, other);
+	}
+public:
+	blockhash_signature(void) noexcept = default; // initialize to undefined state
+	blockhash_signature(const char* str, size_t len) noexcept
+	{
+		construct(str, len);
+	}
+};
+
+}
+
+#endif
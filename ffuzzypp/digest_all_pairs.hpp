@@ -0,0 +1,260 @@
+/*
+
+	ffuzzy++ : C++ implementation of fast fuzzy hashing
+
+	digest_all_pairs.hpp
+	Cache-blocked all-pairs comparison
+
+	Copyright (C) 2026 Tsukasa OI <floss_ssdeep@irq.a4lg.com>
+
+
+	Permission to use, copy, modify, and/or distribute this software for
+	any purpose with or without fee is hereby granted, provided that the
+	above copyright notice and this permission notice appear in all copies.
+
+	THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+	WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+	MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+	ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+	WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+	ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+	OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+
+*/
+#ifndef FFUZZYPP_DIGEST_ALL_PAIRS_HPP
+#define FFUZZYPP_DIGEST_ALL_PAIRS_HPP
+
+#include <cassert>
+#include <cstddef>
+
+#include <algorithm>
+#include <vector>
+
+#include "digest_blocksize.hpp"
+#include "digest_comparison.hpp"
+#include "digest_query.hpp"
+#include "digest_store.hpp"
+
+namespace ffuzzy {
+
+class digest_all_pairs_params
+{
+private:
+	digest_all_pairs_params(void) = delete;
+	digest_all_pairs_params(const digest_all_pairs_params&) = delete;
+public:
+	// Number of compiled queries kept at once (each takes about 1KiB on RA)
+	static constexpr const size_t query_tile_size = 16;
+	// Number of candidates compared against a query tile at once
+	static constexpr const size_t candidate_tile_size = 128;
+	static_assert(query_tile_size != 0, "query_tile_size must not be zero.");
+	static_assert(candidate_tile_size != 0, "candidate_tile_size must not be zero.");
+};
+
+/*
+	Cache-blocked all-pairs comparison
+
+	Digests in the store are grouped by block size (buckets).
+	Only pairs within a bucket and pairs between a bucket and the
+	bucket of the doubled block size can have nonzero scores.
+
+	Each bucket is split into tiles of queries (compiled as
+	digest_query objects) and tiles of candidates so that the
+	compiled queries and candidate block hashes of a tile stay in
+	the cache while all pairs between them are compared.
+
+	Each unordered pair is compared once and reported as
+	(i, j, score) with i < j (indices of the store) if the score
+	is equal to or greater than the threshold.
+*/
+template <bool IsAlphabetRestricted, comparison_version Version = comparison_version::latest>
+class digest_all_pairs
+{
+public:
+	static constexpr const bool is_alphabet_restricted = IsAlphabetRestricted;
+	typedef digest_store<IsAlphabetRestricted> store_type;
+	typedef digest_query<IsAlphabetRestricted, Version> query_type;
+
+	// Bucket of digests with the same block size (order[begin..end))
+	struct bucket
+	{
+		digest_blocksize_t blocksize;
+		size_t begin;
+		size_t end;
+	};
+
+	// Data structure
+private:
+	const store_type* store;
+	std::vector<size_t> order;
+	std::vector<bucket> buckets;
+public:
+	const std::vector<size_t>& sorted_indices(void) const noexcept { return order; }
+	const std::vector<bucket>& bucket_list(void) const noexcept { return buckets; }
+
+	// Construction (the store must not be modified while this object is in use)
+public:
+	explicit digest_all_pairs(const store_type& st)
+		: store(&st)
+	{
+		order.resize(st.size());
+		for (size_t i = 0; i < order.size(); i++)
+			order[i] = i;
+		std::sort(order.begin(), order.end(),
+			[&st](size_t a, size_t b)
+			{
+				digest_blocksize_t ba = st.blocksize(a), bb = st.blocksize(b);
+				return ba != bb ? ba < bb : a < b;
+			});
+		for (size_t k = 0; k < order.size(); )
+		{
+			digest_blocksize_t bs = st.blocksize(order[k]);
+			size_t e = k + 1;
+			while (e < order.size() && st.blocksize(order[e]) == bs)
+				e++;
+			buckets.push_back(bucket{ bs, k, e });
+			k = e;
+		}
+	}
+
+	// Bucket lookup
+public:
+	// Index of the bucket with doubled block size (or buckets.size() if not found)
+	size_t double_bucket_of(size_t b) const noexcept
+	{
+		#ifdef FFUZZYPP_DEBUG
+		assert(b < buckets.size());
+		#endif
+		digest_blocksize_t bs = buckets[b].blocksize;
+		if (!digest_blocksize::is_safe_to_double(bs))
+			return buckets.size();
+		auto it = std::lower_bound(buckets.begin() + b, buckets.end(), bs * 2,
+			[](const bucket& x, digest_blocksize_t v) { return x.blocksize < v; });
+		if (it == buckets.end() || it->blocksize != bs * 2)
+			return buckets.size();
+		return size_t(it - buckets.begin());
+	}
+
+	// Tiled kernel
+private:
+	template <typename TCallback>
+	void compare_tile(
+		const query_type* queries, size_t qbegin, size_t qend,
+		size_t cbegin, size_t cend, bool is_same_bucket,
+		digest_comparison_score_t min_score,
+		TCallback& callback
+	) const
+	{
+		for (size_t q = qbegin; q < qend; q++)
+		{
+			const query_type& query = queries[q - qbegin];
+			size_t i = order[q];
+			// skip symmetric duplicates (and the query itself)
+			size_t c = is_same_bucket ? std::max(cbegin, q + 1) : cbegin;
+			for (; c < cend; c++)
+			{
+				size_t j = order[c];
+				digest_comparison_score_t score = query.compare_threshold(*store, j, min_score);
+				if (score)
+				{
+					if (i < j)
+						callback(i, j, score);
+					else
+						callback(j, i, score);
+				}
+			}
+		}
+	}
+	template <typename TCallback>
+	void compare_queries(
+		const query_type* queries, size_t qbegin, size_t qend,
+		size_t cbegin, size_t cend, bool is_same_bucket,
+		digest_comparison_score_t min_score,
+		TCallback& callback
+	) const
+	{
+		static constexpr const size_t ctile = digest_all_pairs_params::candidate_tile_size;
+		// candidates before the query tile never produce new pairs in the same bucket
+		if (is_same_bucket)
+			cbegin = std::max(cbegin, qbegin + 1);
+		for (size_t c = cbegin; c < cend; c += ctile)
+			compare_tile(queries, qbegin, qend, c, std::min(c + ctile, cend),
+				is_same_bucket, min_score, callback);
+	}
+public:
+	/*
+		Compare all pairs in the bucket b and between the bucket b and
+		the bucket with doubled block size.
+		Calling this for every bucket covers all pairs exactly once.
+	*/
+	template <typename TCallback>
+	void run_bucket(
+		size_t b,
+		digest_comparison_score_t min_score,
+		TCallback&& callback
+	) const
+	{
+		#ifdef FFUZZYPP_DEBUG
+		assert(b < buckets.size());
+		#endif
+		static constexpr const size_t qtile = digest_all_pairs_params::query_tile_size;
+		if (!min_score)
+			min_score = 1;
+		const bucket& bk = buckets[b];
+		size_t d = double_bucket_of(b);
+		query_type queries[qtile];
+		for (size_t q = bk.begin; q < bk.end; q += qtile)
+		{
+			size_t qend = std::min(q + qtile, bk.end);
+			for (size_t k = q; k < qend; k++)
+				queries[k - q].construct(*store, order[k]);
+			compare_queries(queries, q, qend, q, bk.end, true, min_score, callback);
+			if (d != buckets.size())
+				compare_queries(queries, q, qend, buckets[d].begin, buckets[d].end,
+					false, min_score, callback);
+		}
+	}
+	/*
+		Compare queries sorted_indices()[qbegin..qend) against candidates
+		sorted_indices()[cbegin..cend).  If is_same_bucket, both ranges
+		must be in the same bucket and only candidates after each query
+		are compared.  This is the unit of work for parallel drivers
+		(see digest_parallel_all_pairs.hpp).
+	*/
+	template <typename TCallback>
+	void run_tile(
+		size_t qbegin, size_t qend,
+		size_t cbegin, size_t cend,
+		bool is_same_bucket,
+		digest_comparison_score_t min_score,
+		TCallback&& callback
+	) const
+	{
+		#ifdef FFUZZYPP_DEBUG
+		assert(qbegin <= qend && qend <= order.size());
+		assert(cbegin <= cend && cend <= order.size());
+		#endif
+		static constexpr const size_t qtile = digest_all_pairs_params::query_tile_size;
+		if (!min_score)
+			min_score = 1;
+		query_type queries[qtile];
+		for (size_t q = qbegin; q < qend; q += qtile)
+		{
+			size_t qe = std::min(q + qtile, qend);
+			for (size_t k = q; k < qe; k++)
+				queries[k - q].construct(*store, order[k]);
+			compare_queries(queries, q, qe, cbegin, cend, is_same_bucket, min_score, callback);
+		}
+	}
+	// Compare all pairs (callback(i, j, score) with i < j)
+	template <typename TCallback>
+	void run(digest_comparison_score_t min_score, TCallback&& callback) const
+	{
+		for (size_t b = 0; b < buckets.size(); b++)
+			run_bucket(b, min_score, callback);
+	}
+};
+
+}
+
+#endif
@@ -122,6 +122,15 @@ public:
 	{
 		return digest_comparison<Version>::compare_near_lt(a, b);
 	}
+	template <comparison_version Version = comparison_version::latest>
+	static digest_comparison_score_t compare_threshold(
+		const digest_base& a,
+		const digest_base& b,
+		digest_comparison_score_t min_score
+	) noexcept
+	{
+		return digest_comparison<Version>::compare_threshold(a, b, min_score);
+	}
 public:
 	template <comparison_version Version = comparison_version::latest>
 	digest_comparison_score_t compare(const digest_base& other) const noexcept
@@ -148,6 +157,11 @@ public:
 	{
 		return compare_near_lt<Version>(*this, other);
 	}
+	template <comparison_version Version = comparison_version::latest>
+	digest_comparison_score_t compare_threshold(const digest_base& other, digest_comparison_score_t min_score) const noexcept
+	{
+		return compare_threshold<Version>(*this, other, min_score);
+	}
 
 	// Comparison (on different digests)
 public:
@@ -0,0 +1,332 @@
+/*
+
+	ffuzzy++ : C++ implementation of fast fuzzy hashing
+
+	digest_bitsliced_store.hpp
+	Bit-sliced store of digests with the same block size
+
+	Copyright (C) 2026 Tsukasa OI <floss_ssdeep@irq.a4lg.com>
+
+
+	Permission to use, copy, modify, and/or distribute this software for
+	any purpose with or without fee is hereby granted, provided that the
+	above copyright notice and this permission notice appear in all copies.
+
+	THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+	WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+	MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+	ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+	WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+	ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+	OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+
+*/
+#ifndef FFUZZYPP_DIGEST_BITSLICED_STORE_HPP
+#define FFUZZYPP_DIGEST_BITSLICED_STORE_HPP
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+#include "digest_blocksize.hpp"
+#include "digest_data.hpp"
+#include "digest_comparison.hpp"
+#include "digest_view.hpp"
+#include "utils/bits.hpp"
+
+namespace ffuzzy {
+
+/*
+	Bit-sliced (transposed) store of digests with the same block size
+
+	Digests are grouped into slices of 64.  For each block hash and
+	character position, a slice holds 64-bit words whose k-th bit
+	tells the character of the k-th digest in the slice (see below).
+	The common substring test against a
+	query block hash is performed on whole words, evaluating all
+	64 digests of a slice at once.
+
+	Every common substring of length 7 on the candidate side covers
+	exactly one position p where p % 7 == 6 (an anchor).  So, for each
+	anchor and each query position aligned to it, the test extends
+	the diagonal match from the anchor in both directions
+	(stopping as soon as no digests in the slice match).
+
+	Digests passing the test go on to the ordinary edit distance
+	kernel (raw block hashes are also kept for that purpose).
+
+	This store is intended for very large buckets of the same block
+	size.  Digests must be normalized and alphabet restricted.
+*/
+class digest_bitsliced_store
+{
+public:
+	typedef uint_least64_t word_type;
+	static constexpr const size_t slice_size = 64;
+	static constexpr const size_t char_bits = 6;
+	static constexpr const size_t max_len = digest_params::max_blockhash_len;
+	static constexpr const size_t substr_size = blockhash_comparison_params::min_match_len;
+	typedef unsigned char len_type;
+	static_assert(max_len <= std::numeric_limits<len_type>::max(),
+		"max_blockhash_len must be in range of len_type.");
+	static_assert(substr_size > 1, "substr_size must be greater than 1.");
+
+	/*
+		Transposed block hashes of a slice
+
+		Each 6-bit character is split into three 2-bit groups and
+		for each group value, the word of digests with that value is
+		stored (minterms).  Equality of a position against any
+		character is then evaluated with three lookups:
+		eq(p, c) = m[p][0][c & 3] & m[p][1][(c >> 2) & 3] & m[p][2][c >> 4]
+		Positions out of range never match (folded into the first group).
+	*/
+private:
+	struct slice
+	{
+		word_type m[2][max_len + 1][3][4]; // with one padding position
+		word_type active[2]; // block hash is long enough to match
+		len_type len[2];     // maximum block hash length
+		word_type eq(size_t w, size_t p, char c) const noexcept
+		{
+			unsigned v = static_cast<unsigned char>(c);
+			return m[w][p][0][v & 3u] & m[w][p][1][(v >> 2) & 3u] & m[w][p][2][v >> 4];
+		}
+	};
+
+	// Data structure
+private:
+	digest_blocksize_t blksize;
+	std::vector<slice> slices;
+	std::vector<len_type> blkhash1_lens;
+	std::vector<len_type> blkhash2_lens;
+	std::vector<char> blkhash_chars; // [bh1 (max_len) | bh2 (max_len)] per digest
+public:
+	explicit digest_bitsliced_store(digest_blocksize_t blocksize) noexcept
+		: blksize(blocksize) {}
+	unsigned long blocksize(void) const noexcept { return blksize; }
+	size_t size(void) const noexcept { return blkhash1_lens.size(); }
+	bool empty(void) const noexcept { return blkhash1_lens.empty(); }
+	size_t slice_count(void) const noexcept { return slices.size(); }
+	size_t blockhash1_len(size_t i) const noexcept { return blkhash1_lens[i]; }
+	size_t blockhash2_len(size_t i) const noexcept { return blkhash2_lens[i]; }
+	const char* blockhash1(size_t i) const noexcept { return blkhash_chars.data() + i * (2 * max_len); }
+	const char* blockhash2(size_t i) const noexcept { return blkhash_chars.data() + i * (2 * max_len) + max_len; }
+	digest_view<true> view(size_t i) const noexcept
+	{
+		#ifdef FFUZZYPP_DEBUG
+		assert(i < size());
+		#endif
+		return digest_view<true>(blksize,
+			blockhash1(i), blkhash1_lens[i],
+			blockhash2(i), blkhash2_lens[i]);
+	}
+	size_t memory_usage(void) const noexcept
+	{
+		return
+			slices.capacity() * sizeof(slice) +
+			blkhash1_lens.capacity() + blkhash2_lens.capacity() +
+			blkhash_chars.capacity();
+	}
+
+	// Insertion (the block size of the digest must match the store)
+public:
+	size_t push_back(const digest_view<true>& d)
+	{
+		#ifdef FFUZZYPP_DEBUG
+		assert(d.is_valid());
+		assert(d.blocksize() == blksize);
+		#endif
+		size_t i = size();
+		if (i % slice_size == 0)
+			slices.emplace_back(); // zero-initialized
+		slice& sl = slices.back();
+		if (i % slice_size == 0)
+		{
+			// out of range positions match nothing (first group is left zero)
+			for (size_t w = 0; w < 2; w++)
+				for (size_t p = 0; p <= max_len; p++)
+					for (size_t k = 1; k < 3; k++)
+						for (size_t v = 0; v < 4; v++)
+							sl.m[w][p][k][v] = ~word_type(0u);
+		}
+		word_type lane = word_type(1u) << (i % slice_size);
+		const char* bh[2] = { d.blockhash1(), d.blockhash2() };
+		size_t lens[2] = { d.blockhash1_len(), d.blockhash2_len() };
+		for (size_t w = 0; w < 2; w++)
+		{
+			for (size_t p = 0; p < lens[w]; p++)
+			{
+				unsigned v = static_cast<unsigned char>(bh[w][p]);
+				for (size_t k = 0; k < 3; k++)
+					for (size_t x = 0; x < 4; x++)
+						if (((v >> (k * 2)) & 3u) != x)
+							sl.m[w][p][k][x] &= ~lane;
+				sl.m[w][p][0][v & 3u] |= lane;
+			}
+			if (lens[w] >= substr_size)
+			{
+				sl.active[w] |= lane;
+				sl.len[w] = std::max(sl.len[w], len_type(lens[w]));
+			}
+		}
+		blkhash1_lens.push_back(len_type(lens[0]));
+		blkhash2_lens.push_back(len_type(lens[1]));
+		blkhash_chars.resize((i + 1) * (2 * max_len));
+		memcpy(blkhash_chars.data() + i * (2 * max_len), bh[0], lens[0]);
+		memcpy(blkhash_chars.data() + i * (2 * max_len) + max_len, bh[1], lens[1]);
+		return i;
+	}
+
+	// Bit-sliced common substring test
+public:
+	/*
+		Returns the mask of digests in slice s whose block hash
+		(w == 0: block hash 1, w == 1: block hash 2) has a common
+		substring (of length 7) with the query block hash q.
+		lanes restricts the test to given digests.
+	*/
+	word_type common_substr_mask(
+		size_t s, size_t w,
+		const char* q, size_t qlen,
+		word_type lanes = ~word_type(0u)
+	) const noexcept
+	{
+		#ifdef FFUZZYPP_DEBUG
+		assert(s < slices.size());
+		assert(w < 2);
+		assert(qlen <= max_len);
+		#endif
+		if (qlen < substr_size)
+			return 0;
+		const slice& sl = slices[s];
+		// Candidates with short block hashes never match
+		word_type active = sl.active[w] & lanes;
+		if (!active)
+			return 0;
+		size_t len = sl.len[w];
+		word_type found = 0;
+		for (size_t j = substr_size - 1; j < len; j += substr_size)
+		{
+			for (size_t i = 0; i < qlen; i++)
+			{
+				word_type e0 = sl.eq(w, j, q[i]) & active & ~found;
+				/*
+					Every match covering the anchor also covers
+					either of its neighbors.  Testing character pairs
+					first rejects most of the seeds with a
+					(well-predicted) single branch.
+				*/
+				word_type e1 = 0;
+				if (i != 0)
+					e1 |= sl.eq(w, j - 1, q[i - 1]);
+				if (i + 1 != qlen)
+					e1 |= sl.eq(w, j + 1, q[i + 1]);
+				if (!(e0 & e1))
+					continue;
+				// left[t]: cells (j-t..j) match, right[t]: cells (j..j+t) match
+				word_type left[substr_size], right[substr_size];
+				left[0] = right[0] = e0;
+				size_t nl = 1, nr = 1;
+				for (; nl < substr_size && nl <= i && nl <= j; nl++)
+				{
+					left[nl] = left[nl - 1] & sl.eq(w, j - nl, q[i - nl]);
+					if (!left[nl])
+						break;
+				}
+				for (; nr < substr_size && i + nr < qlen && j + nr < len; nr++)
+				{
+					right[nr] = right[nr - 1] & sl.eq(w, j + nr, q[i + nr]);
+					if (!right[nr])
+						break;
+				}
+				// left[0..nl) and right[0..nr) are valid (left[nl], right[nr] are zero or out of range)
+				for (size_t t = 0; t < nl; t++)
+				{
+					size_t u = (substr_size - 1) - t;
+					if (u < nr)
+						found |= left[t] & right[u];
+				}
+				if (found == active)
+					return found;
+			}
+		}
+		return found;
+	}
+
+	// Comparison
+private:
+	template <comparison_version Version>
+	void score_slice(
+		size_t s, size_t w,
+		const char* q, size_t qlen,
+		digest_blocksize_t bs,
+		word_type lanes,
+		digest_comparison_score_t* out
+	) const noexcept
+	{
+		word_type m = common_substr_mask(s, w, q, qlen, lanes);
+		for (; m; m &= m - 1u)
+		{
+			size_t i = s * slice_size + bits::count_trailing_zeros(m);
+			const char* c = w == 0 ? blockhash1(i) : blockhash2(i);
+			size_t clen = w == 0 ? blkhash1_lens[i] : blkhash2_lens[i];
+			digest_comparison_score_t score = blockhash_comparison<Version>::score(
+				internal::blockhash_comparison_base::edit_dist_t::cost(q, qlen, c, clen),
+				bs, blockhash_len_t(qlen), blockhash_len_t(clen));
+			out[i] = std::max(out[i], score);
+		}
+	}
+public:
+	// Compare the query against all digests and write the scores to out[0..size())
+	template <comparison_version Version = comparison_version::latest>
+	void compare_all(const digest_view<true>& query, digest_comparison_score_t* out) const noexcept
+	{
+		#ifdef FFUZZYPP_DEBUG
+		assert(query.is_valid());
+		#endif
+		for (size_t i = 0; i < size(); i++)
+			out[i] = 0;
+		digest_blocksize_t qbs = digest_blocksize_t(query.blocksize());
+		if (!digest_blocksize::is_near(qbs, blksize))
+			return;
+		for (size_t s = 0; s < slices.size(); s++)
+		{
+			size_t begin = s * slice_size;
+			size_t end = std::min(begin + slice_size, size());
+			word_type lanes = ~word_type(0u);
+			if (digest_blocksize::is_near_eq(qbs, blksize))
+			{
+				// Identical digests (which may have short block hashes)
+				for (size_t i = begin; i < end; i++)
+				{
+					if (digest_view<true>::is_eq(query, view(i)))
+					{
+						out[i] = digest_comparison<Version>::compare_identical(query);
+						lanes &= ~(word_type(1u) << (i - begin));
+					}
+				}
+				score_slice<Version>(s, 0, query.blockhash1(), query.blockhash1_len(),
+					blksize, lanes, out);
+				if (digest_blocksize::is_safe_to_double(blksize))
+					score_slice<Version>(s, 1, query.blockhash2(), query.blockhash2_len(),
+						blksize * 2, lanes, out);
+			}
+			else if (digest_blocksize::is_near_lt(qbs, blksize))
+				score_slice<Version>(s, 0, query.blockhash2(), query.blockhash2_len(),
+					blksize, lanes, out);
+			else if (digest_blocksize::is_near_gt(qbs, blksize))
+				score_slice<Version>(s, 1, query.blockhash1(), query.blockhash1_len(),
+					qbs, lanes, out);
+		}
+	}
+};
+
+}
+
+#endif
@@ -0,0 +1,313 @@
+/*
+
+	ffuzzy++ : C++ implementation of fast fuzzy hashing
+
+	digest_compact_store.hpp
+	Compact store of position arrays (for large in-memory corpora)
+
+	Copyright (C) 2026 Tsukasa OI <floss_ssdeep@irq.a4lg.com>
+
+
+	Permission to use, copy, modify, and/or distribute this software for
+	any purpose with or without fee is hereby granted, provided that the
+	above copyright notice and this permission notice appear in all copies.
+
+	THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+	WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+	MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+	ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+	WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+	ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+	OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+
+*/
+#ifndef FFUZZYPP_DIGEST_COMPACT_STORE_HPP
+#define FFUZZYPP_DIGEST_COMPACT_STORE_HPP
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+#include <algorithm>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "digest_blocksize.hpp"
+#include "digest_data.hpp"
+#include "digest_base.hpp"
+#include "digest_comparison.hpp"
+#include "strings/compact_position_array.hpp"
+#include "strings/position_array.hpp"
+#include "utils/bits.hpp"
+
+namespace ffuzzy {
+
+/*
+	Compact store of position arrays
+
+	digest_position_array holds two full position arrays per digest
+	(64 bitmaps each on the restricted alphabet, 256 on the others).
+	This store keeps, for each block hash, a presence mask of
+	characters and bitmaps of present characters only
+	(see strings/compact_position_array.hpp) in a shared pool.
+	A digest with typical block hashes takes about one twelfth of the
+	memory of digest_position_array<false> but about one third of
+	digest_position_array<true> (33MB, 412MB and 105MB for 100k digests).
+
+	Digests are always stored in the 6-bit (alphabet restricted) form.
+	Digests are not remapped on parsing but only by this store:
+	non-restricted digests are copied to the restricted form on every
+	insertion and comparison and digest_parse_error is thrown if they
+	contain a character out of the Base64 charset.  Parse digests as
+	alphabet restricted ones (e.g. digest_ra_long_t) to avoid both.
+
+	On comparison, block hashes of the stored digest are expanded to
+	ordinary position arrays so that the bit-parallel algorithms run
+	at the same speed as on digest_position_array.  Expansion costs
+	about 7% over comparison with digest_position_array but it is
+	the cheapest way to feed the stored side: a cached (expanded)
+	query would require decoding the stored block hash to a string
+	instead, which is about three times as slow as the expansion.
+*/
+class digest_compact_store
+{
+public:
+	typedef unsigned long long bitmap_type;
+	typedef strings::position_array<bitmap_type, char, 0x00, 0x3f> dense_type;
+	typedef strings::compact_position_array<bitmap_type, char, 0x00, 0x3f> compact_type;
+	typedef compact_type::mask_type mask_type;
+	typedef unsigned char len_type;
+	typedef size_t offset_type;
+	static_assert(dense_type::max_strlen >= digest_params::max_blockhash_len,
+		"bitmap_type must be able to hold max_blockhash_len bits.");
+	static_assert(digest_params::max_blockhash_len <= std::numeric_limits<len_type>::max(),
+		"max_blockhash_len must be in range of len_type.");
+
+	// Data structure
+private:
+	std::vector<digest_blocksize_t> blksizes;
+	std::vector<len_type> blkhash1_lens;
+	std::vector<len_type> blkhash2_lens;
+	std::vector<mask_type> blkhash1_masks;
+	std::vector<mask_type> blkhash2_masks;
+	// bitmaps of block hash 1 start at offsets[i] and followed by block hash 2
+	std::vector<offset_type> offsets;
+	std::vector<bitmap_type> pool;
+public:
+	size_t size(void) const noexcept { return blksizes.size(); }
+	bool empty(void) const noexcept { return blksizes.empty(); }
+	void clear(void) noexcept
+	{
+		blksizes.clear();
+		blkhash1_lens.clear();
+		blkhash2_lens.clear();
+		blkhash1_masks.clear();
+		blkhash2_masks.clear();
+		offsets.clear();
+		pool.clear();
+	}
+	void reserve(size_t n)
+	{
+		blksizes.reserve(n);
+		blkhash1_lens.reserve(n);
+		blkhash2_lens.reserve(n);
+		blkhash1_masks.reserve(n);
+		blkhash2_masks.reserve(n);
+		offsets.reserve(n);
+	}
+	// Approximate memory usage in bytes (excluding unused capacity)
+	size_t memory_usage(void) const noexcept
+	{
+		return size() * (
+			sizeof(digest_blocksize_t) + sizeof(len_type) * 2 +
+			sizeof(mask_type) * 2 + sizeof(offset_type)
+		) + pool.size() * sizeof(bitmap_type);
+	}
+
+	// Accessors (per digest)
+public:
+	digest_blocksize_t blocksize(size_t i) const noexcept
+	{
+		#ifdef FFUZZYPP_DEBUG
+		assert(i < size());
+		#endif
+		return blksizes[i];
+	}
+	blockhash_len_t blockhash1_len(size_t i) const noexcept
+	{
+		#ifdef FFUZZYPP_DEBUG
+		assert(i < size());
+		#endif
+		return blkhash1_lens[i];
+	}
+	blockhash_len_t blockhash2_len(size_t i) const noexcept
+	{
+		#ifdef FFUZZYPP_DEBUG
+		assert(i < size());
+		#endif
+		return blkhash2_lens[i];
+	}
+	compact_type blockhash1_array(size_t i) const noexcept
+	{
+		#ifdef FFUZZYPP_DEBUG
+		assert(i < size());
+		#endif
+		return compact_type(blkhash1_masks[i], pool.data() + offsets[i]);
+	}
+	compact_type blockhash2_array(size_t i) const noexcept
+	{
+		#ifdef FFUZZYPP_DEBUG
+		assert(i < size());
+		#endif
+		return compact_type(blkhash2_masks[i],
+			pool.data() + offsets[i] + bits::popcount(blkhash1_masks[i]));
+	}
+
+	// Insertion
+private:
+	static void throw_parse_error(void) noexcept(false)
+	{
+		throw digest_parse_error();
+	}
+	template <bool IsShort>
+	static digest_base<true, IsShort, true> remap(
+		const digest_base<false, IsShort, true>& d
+	) noexcept(false)
+	{
+		digest_base<true, IsShort, true> tmp;
+		if (!internal::digest_copy::copy_to_ra(tmp, d))
+			throw_parse_error();
+		return tmp;
+	}
+public:
+	template <bool IsShort>
+	size_t push_back(const digest_base<true, IsShort, true>& d)
+	{
+		#ifdef FFUZZYPP_DEBUG
+		assert(d.is_valid());
+		#endif
+		size_t i = blksizes.size();
+		size_t offset = pool.size();
+		mask_type mask1, mask2;
+		pool.resize(offset + d.blockhash1_len() + d.blockhash2_len());
+		size_t n1 = compact_type::encode(mask1, pool.data() + offset,
+			d.digest_buffer(), d.blockhash1_len());
+		size_t n2 = compact_type::encode(mask2, pool.data() + offset + n1,
+			d.digest_buffer() + d.blockhash1_len(), d.blockhash2_len());
+		pool.resize(offset + n1 + n2);
+		blksizes.push_back(digest_blocksize_t(d.blocksize()));
+		blkhash1_lens.push_back(len_type(d.blockhash1_len()));
+		blkhash2_lens.push_back(len_type(d.blockhash2_len()));
+		blkhash1_masks.push_back(mask1);
+		blkhash2_masks.push_back(mask2);
+		offsets.push_back(offset_type(offset));
+		return i;
+	}
+	template <bool IsShort>
+	size_t push_back(const digest_base<false, IsShort, true>& d) noexcept(false)
+	{
+		return push_back(remap(d));
+	}
+	size_t push_back(const char* str) noexcept(false)
+	{
+		return push_back(digest_base<true, false, true>(str));
+	}
+	size_t push_back(const std::string& str)
+	{
+		return push_back(str.c_str());
+	}
+
+	// Expansion
+public:
+	void expand(size_t i, dense_type& bh1, dense_type& bh2) const noexcept
+	{
+		blockhash1_array(i).expand(bh1);
+		blockhash2_array(i).expand(bh2);
+	}
+
+	// Comparison against a digest
+private:
+	static bool is_eq_blockhash(
+		const compact_type& ca, blockhash_len_t calen,
+		const char* s, blockhash_len_t slen
+	) noexcept
+	{
+		if (calen != slen)
+			return false;
+		for (blockhash_len_t k = 0; k < slen; k++)
+			if (!((ca[s[k]] >> k) & 1u))
+				return false;
+		return true;
+	}
+	template <comparison_version Version>
+	static digest_comparison_score_t score(
+		const compact_type& ca, blockhash_len_t calen,
+		const char* s, blockhash_len_t slen,
+		digest_blocksize_t blocksize
+	) noexcept
+	{
+		// avoid expansion if block hashes are too short to match
+		if (calen < blockhash_comparison_params::min_match_len ||
+			slen < blockhash_comparison_params::min_match_len)
+			return 0;
+		dense_type pa;
+		ca.expand(pa);
+		return blockhash_comparison<Version>::score(pa, calen, s, slen, blocksize);
+	}
+public:
+	template <comparison_version Version = comparison_version::latest, bool IsShort>
+	digest_comparison_score_t compare(
+		size_t i,
+		const digest_base<true, IsShort, true>& b
+	) const noexcept
+	{
+		#ifdef FFUZZYPP_DEBUG
+		assert(i < size());
+		assert(b.is_valid());
+		#endif
+		digest_blocksize_t bs = blksizes[i];
+		digest_blocksize_t bbs = digest_blocksize_t(b.blocksize());
+		if (!digest_blocksize::is_near(bs, bbs))
+			return 0;
+		const char* b1 = b.digest_buffer();
+		const char* b2 = b.digest_buffer() + b.blockhash1_len();
+		blockhash_len_t b1len = blockhash_len_t(b.blockhash1_len());
+		blockhash_len_t b2len = blockhash_len_t(b.blockhash2_len());
+		if (digest_blocksize::is_near_eq(bs, bbs))
+		{
+			if (is_eq_blockhash(blockhash1_array(i), blkhash1_lens[i], b1, b1len) &&
+				is_eq_blockhash(blockhash2_array(i), blkhash2_lens[i], b2, b2len))
+			{
+				return digest_comparison<Version>::compare_identical(b);
+			}
+			digest_comparison_score_t score1 = score<Version>(
+				blockhash1_array(i), blkhash1_lens[i], b1, b1len, bs);
+			// block hash 2 never matches if the block size is not safe to double
+			if (!digest_blocksize::is_safe_to_double(bs))
+				return score1;
+			return std::max(score1, score<Version>(
+				blockhash2_array(i), blkhash2_lens[i], b2, b2len, bs * 2));
+		}
+		if (digest_blocksize::is_near_lt(bs, bbs))
+		{
+			if (!digest_blocksize::is_safe_to_double(bs))
+				return 0;
+			return score<Version>(blockhash2_array(i), blkhash2_lens[i], b1, b1len, bbs);
+		}
+		// digest_blocksize::is_near_gt
+		return score<Version>(blockhash1_array(i), blkhash1_lens[i], b2, b2len, bs);
+	}
+	template <comparison_version Version = comparison_version::latest, bool IsShort>
+	digest_comparison_score_t compare(
+		size_t i,
+		const digest_base<false, IsShort, true>& b
+	) const noexcept(false)
+	{
+		return compare<Version>(i, remap(b));
+	}
+};
+
+}
+
+#endif
@@ -44,7 +44,9 @@
 #include "digest_blocksize.hpp"
 #include "digest_data.hpp"
 #include "digest_position_array_base.hpp"
+#include "digest_view.hpp"
 #include "strings/common_substr.hpp"
+#include "strings/common_substr_edit_dist.hpp"
 #include "strings/edit_dist.hpp"
 #include "strings/position_array.hpp"
 #include "utils/minmax.hpp"
@@ -97,6 +99,11 @@ namespace internal
 		typedef strings::edit_dist_norm<
 			strings::edit_dist_nonempty_fast<digest_comparison_score_t, digest_params::max_blockhash_len>
 		> edit_dist_t;
+		// Fused common substring test and edit distance (on position arrays)
+		template <typename TBitmap, char CMin, char CMax>
+		using common_substr_edit_dist_t = strings::common_substr_edit_dist_bitparallel<
+			digest_comparison_score_t, TBitmap, CMin, CMax,
+			digest_params::max_blockhash_len, blockhash_comparison_params::min_match_len>;
 
 		/*
 			Score capping to prevent exaggerations
@@ -243,16 +250,11 @@ namespace internal
 			const char* s2, blockhash_len_t s2len
 		) noexcept
 		{
-			if (!strings::common_substr_bitparallel<TBitmap, CMin, CMax,
-				digest_params::max_blockhash_len, blockhash_comparison_params::min_match_len>::match(s1, s2, size_t(s2len)))
-			{
+			digest_comparison_score_t edit_distance;
+			if (!common_substr_edit_dist_t<TBitmap, CMin, CMax>::cost(
+					edit_distance, s1, size_t(s1len), s2, size_t(s2len)))
 				return 0;
-			}
-			return uncapped_score(
-				strings::edit_dist_bitparallel<digest_comparison_score_t, TBitmap,
-					CMin, CMax, digest_params::max_blockhash_len>::cost(s1, size_t(s1len), s2, size_t(s2len)),
-				s1len, s2len
-			);
+			return uncapped_score(edit_distance, s1len, s2len);
 		}
 	private:
 		static constexpr digest_comparison_score_t CONST_capped_score(
@@ -322,16 +324,110 @@ namespace internal
 			digest_blocksize_t blocksize
 		) noexcept
 		{
-			if (!strings::common_substr_bitparallel<TBitmap, CMin, CMax,
-				digest_params::max_blockhash_len, blockhash_comparison_params::min_match_len>::match(s1, s2, size_t(s2len)))
+			digest_comparison_score_t edit_distance;
+			if (!common_substr_edit_dist_t<TBitmap, CMin, CMax>::cost(
+					edit_distance, s1, size_t(s1len), s2, size_t(s2len)))
+				return 0;
+			return score(edit_distance, blocksize, s1len, s2len);
+		}
+
+		/*
+			Scoring with threshold
+			(returns zero if the score is less than min_score)
+		*/
+	public:
+		/*
+			Maximum edit distance to achieve the uncapped score of min_score or more.
+
+			uncapped_score is 100 - floor(100 * t / M) where
+			t = floor(edit_distance * M / (s1len + s2len)) and M = max_blockhash_len.
+			Solving (uncapped_score >= min_score) for edit_distance gives:
+			t <= t_max = floor((M * (101 - min_score) - 1) / 100) and
+			edit_distance <= floor(((t_max + 1) * (s1len + s2len) - 1) / M).
+		*/
+		static digest_comparison_score_t max_edit_distance_for_uncapped_score(
+			digest_comparison_score_t min_score,
+			blockhash_len_t s1len,
+			blockhash_len_t s2len
+		) noexcept
+		{
+			static_assert(safe_int::safe_mul<
+					safe_int::uvalue<digest_comparison_score_t, digest_params::max_blockhash_len>,
+					safe_int::uvalue<digest_comparison_score_t, 101>
+				>::is_valid,
+				"max_blockhash_len * 101 must be in range of digest_comparison_score_t.");
+			#ifdef FFUZZYPP_DEBUG
+			assert(min_score <= 100);
+			assert(s1len >= blockhash_comparison_params::min_match_len && s1len <= digest_params::max_blockhash_len);
+			assert(s2len >= blockhash_comparison_params::min_match_len && s2len <= digest_params::max_blockhash_len);
+			#endif
+			const digest_comparison_score_t M = digest_comparison_score_t(digest_params::max_blockhash_len);
+			const digest_comparison_score_t L = digest_comparison_score_t(s1len + s2len);
+			digest_comparison_score_t t_max = (M * (101 - min_score) - 1) / 100;
+			return minmax::min(((t_max + 1) * L - 1) / M, L);
+		}
+		/*
+			Maximum edit distance to achieve the (capped) score of min_score or more.
+			Returns false if min_score is never achieved (without computing edit distance).
+		*/
+		static bool threshold_max_edit_distance(
+			digest_comparison_score_t& max_edit_distance,
+			digest_comparison_score_t min_score,
+			digest_blocksize_t blocksize,
+			blockhash_len_t s1len,
+			blockhash_len_t s2len
+		) noexcept
+		{
+			if (s1len < blockhash_comparison_params::min_match_len || s2len < blockhash_comparison_params::min_match_len)
+				return false;
+			if (min_score > 100)
+				return false;
+			if (is_safe_for_score_capping(blocksize) &&
+				CONST_score_cap_unsafe(blocksize, s1len, s2len) < min_score)
+				return false;
+			max_edit_distance = max_edit_distance_for_uncapped_score(min_score, s1len, s2len);
+			// Indel distance is at least the difference of lengths
+			return digest_comparison_score_t(s1len < s2len ? s2len - s1len : s1len - s2len) <= max_edit_distance;
+		}
+		static digest_comparison_score_t score_threshold(
+			const char* s1, blockhash_len_t s1len,
+			const char* s2, blockhash_len_t s2len,
+			digest_blocksize_t blocksize,
+			digest_comparison_score_t min_score
+		) noexcept
+		{
+			digest_comparison_score_t max_edit_distance;
+			if (!threshold_max_edit_distance(max_edit_distance, min_score, blocksize, s1len, s2len))
+				return 0;
+			if (!strings::common_substr_fast<digest_params::max_blockhash_len,
+				blockhash_comparison_params::min_match_len>::match(s1, size_t(s1len), s2, size_t(s2len)))
 			{
 				return 0;
 			}
-			return score(
-				strings::edit_dist_bitparallel<digest_comparison_score_t, TBitmap,
-					CMin, CMax, digest_params::max_blockhash_len>::cost(s1, size_t(s1len), s2, size_t(s2len)),
-				blocksize, s1len, s2len
-			);
+			digest_comparison_score_t edit_distance =
+				edit_dist_t::cost_bounded(s1, size_t(s1len), s2, size_t(s2len), max_edit_distance);
+			if (edit_distance > max_edit_distance)
+				return 0;
+			return score(edit_distance, blocksize, s1len, s2len);
+		}
+		template <typename TBitmap, char CMin, char CMax>
+		static digest_comparison_score_t score_threshold(
+			const strings::position_array<TBitmap, char, CMin, CMax>& s1, blockhash_len_t s1len,
+			const char* s2, blockhash_len_t s2len,
+			digest_blocksize_t blocksize,
+			digest_comparison_score_t min_score
+		) noexcept
+		{
+			digest_comparison_score_t max_edit_distance;
+			if (!threshold_max_edit_distance(max_edit_distance, min_score, blocksize, s1len, s2len))
+				return 0;
+			digest_comparison_score_t edit_distance;
+			if (!common_substr_edit_dist_t<TBitmap, CMin, CMax>::cost_bounded(
+					edit_distance, s1, size_t(s1len), s2, size_t(s2len), max_edit_distance))
+				return 0;
+			if (edit_distance > max_edit_distance)
+				return 0;
+			return score(edit_distance, blocksize, s1len, s2len);
 		}
 
 		/*
@@ -343,7 +439,8 @@ namespace internal
 			digest_blocksize_t blocksize
 		) noexcept
 		{
-			return CONST_score(0, blocksize, blockhash_len, blockhash_len);
+			// Empty block hashes never match (and would divide by zero)
+			return blockhash_len == 0 ? 0 : CONST_score(0, blocksize, blockhash_len, blockhash_len);
 		}
 
 		/*
@@ -707,8 +804,111 @@ namespace internal
 			}
 		}
 
+		template <bool IsAlphabetRestricted>
+		static digest_comparison_score_t compare_identical_2_9(
+			const digest_view<IsAlphabetRestricted>& a
+		) noexcept
+		{
+			if (digest_blocksize::is_safe_to_double(a.blocksize()))
+			{
+				return std::max(
+					blockhash_comparison<Version>::score_identical(a.blockhash1_len(), a.blocksize()),
+					blockhash_comparison<Version>::score_identical(a.blockhash2_len(), a.blocksize() * 2)
+				);
+			}
+			else
+			{
+				// See compare_identical_2_9 above for assumptions.
+				return blockhash_comparison<Version>::score_identical(a.blockhash1_len(), a.blocksize());
+			}
+		}
+
+		// Comparison (on different digests; generic block hash form)
+	private:
+		/*
+			Same as compare_near_diff below but block hashes are
+			given separately (a1/a2 may be either raw strings or
+			position arrays).  Used by digest_view overloads.
+		*/
+		template <typename TBlockhashA>
+		static digest_comparison_score_t compare_near_diff_blockhashes(
+			digest_blocksize_t a_blksize,
+			const TBlockhashA& a1, blockhash_len_t a1len,
+			const TBlockhashA& a2, blockhash_len_t a2len,
+			digest_blocksize_t b_blksize,
+			const char* b1, blockhash_len_t b1len,
+			const char* b2, blockhash_len_t b2len
+		) noexcept
+		{
+			#ifdef FFUZZYPP_DEBUG
+			assert(digest_blocksize::is_near(a_blksize, b_blksize));
+			#endif
+			if (digest_blocksize::is_safe_to_double(a_blksize))
+			{
+				if (digest_blocksize::is_near_eq(a_blksize, b_blksize))
+					return std::max(
+						blockhash_comparison<Version>::score(a1, a1len, b1, b1len, a_blksize),
+						blockhash_comparison<Version>::score(a2, a2len, b2, b2len, a_blksize * 2));
+				else if (digest_blocksize::is_near_lt(a_blksize, b_blksize))
+					return blockhash_comparison<Version>::score(a2, a2len, b1, b1len, b_blksize);
+				else // digest_blocksize::is_near_gt
+					return blockhash_comparison<Version>::score(a1, a1len, b2, b2len, a_blksize);
+			}
+			else
+			{
+				// See compare_near_diff below for assumptions.
+				static_assert(blockhash_comparison_params::min_match_len > 1,
+					"if the block size is not safe to double, the second block hash should not match "
+					"(due to implementation restrictions).");
+				if (digest_blocksize::is_near_eq(a_blksize, b_blksize))
+					return blockhash_comparison<Version>::score(a1, a1len, b1, b1len, a_blksize);
+				else if (digest_blocksize::is_near_gt(a_blksize, b_blksize))
+					return blockhash_comparison<Version>::score(a1, a1len, b2, b2len, a_blksize);
+				else // overflow (no common substring)
+					return 0;
+			}
+		}
+
 		// Comparison (on different digests)
 	public:
+		template <bool IsAlphabetRestricted>
+		static digest_comparison_score_t compare_near_diff(
+			const digest_view<IsAlphabetRestricted>& a,
+			const digest_view<IsAlphabetRestricted>& b
+		) noexcept
+		{
+			#ifdef FFUZZYPP_DEBUG
+			assert(a.is_valid() && a.is_normalized());
+			assert(b.is_valid() && b.is_normalized());
+			assert(a != b);
+			#endif
+			return compare_near_diff_blockhashes(
+				digest_blocksize_t(a.blocksize()),
+				a.blockhash1(), a.blockhash1_len(),
+				a.blockhash2(), a.blockhash2_len(),
+				digest_blocksize_t(b.blocksize()),
+				b.blockhash1(), b.blockhash1_len(),
+				b.blockhash2(), b.blockhash2_len());
+		}
+		template <bool IsAlphabetRestricted>
+		static digest_comparison_score_t compare_near_diff(
+			const digest_position_array_base<IsAlphabetRestricted>& a,
+			const digest_view<IsAlphabetRestricted>& b
+		) noexcept
+		{
+			#ifdef FFUZZYPP_DEBUG
+			assert(a.is_valid());
+			assert(b.is_valid() && b.is_normalized());
+			assert(!digest_position_array_base<IsAlphabetRestricted>::is_eq(a, b));
+			#endif
+			return compare_near_diff_blockhashes(
+				a.blksize,
+				a.blkhash1, a.blkhash1_len,
+				a.blkhash2, a.blkhash2_len,
+				digest_blocksize_t(b.blocksize()),
+				b.blockhash1(), b.blockhash1_len(),
+				b.blockhash2(), b.blockhash2_len());
+		}
 		template <bool IsAlphabetRestricted, bool IsShort>
 		static digest_comparison_score_t compare_near_diff(
 			const digest_data<IsAlphabetRestricted, IsShort>& a,
@@ -862,6 +1062,181 @@ namespace internal
 			return compare_near_diff(a, b);
 		}
 
+		// Comparison (on different digests; with threshold)
+	public:
+		template <bool IsAlphabetRestricted, bool IsShort>
+		static digest_comparison_score_t compare_near_diff_threshold(
+			const digest_data<IsAlphabetRestricted, IsShort>& a,
+			const digest_data<IsAlphabetRestricted, IsShort>& b,
+			digest_comparison_score_t min_score
+		) noexcept
+		{
+			#ifdef FFUZZYPP_DEBUG
+			assert(a.is_valid() && a.is_normalized());
+			assert(b.is_valid() && b.is_normalized());
+			assert(digest_blocksize::is_near(a.blksize, b.blksize));
+			assert(a != b);
+			#endif
+			if (digest_blocksize::is_near_eq(a.blksize, b.blksize))
+			{
+				digest_comparison_score_t score1 = blockhash_comparison<Version>::score_threshold(
+					a.digest, a.blkhash1_len,
+					b.digest, b.blkhash1_len,
+					a.blksize, min_score);
+				// The second block hash does not match if the block size is not safe to double.
+				if (!digest_blocksize::is_safe_to_double(a.blksize))
+					return score1;
+				// Only scores exceeding score1 are interesting.
+				if (score1)
+					min_score = score1 + 1;
+				digest_comparison_score_t score2 = blockhash_comparison<Version>::score_threshold(
+					a.digest+a.blkhash1_len, a.blkhash2_len,
+					b.digest+b.blkhash1_len, b.blkhash2_len,
+					a.blksize * 2, min_score);
+				return std::max(score1, score2);
+			}
+			else if (digest_blocksize::is_near_lt(a.blksize, b.blksize))
+				return blockhash_comparison<Version>::score_threshold(
+					a.digest+a.blkhash1_len, a.blkhash2_len,
+					b.digest, b.blkhash1_len,
+					b.blksize, min_score);
+			else if (digest_blocksize::is_near_gt(a.blksize, b.blksize))
+				return blockhash_comparison<Version>::score_threshold(
+					a.digest, a.blkhash1_len,
+					b.digest+b.blkhash1_len, b.blkhash2_len,
+					a.blksize, min_score);
+			else // overflow (no common substring)
+				return 0;
+		}
+		template <bool IsAlphabetRestricted, bool IsShort>
+		static digest_comparison_score_t compare_near_diff_threshold(
+			const digest_position_array_base<IsAlphabetRestricted>& a,
+			const digest_data<IsAlphabetRestricted, IsShort>& b,
+			digest_comparison_score_t min_score
+		) noexcept
+		{
+			#ifdef FFUZZYPP_DEBUG
+			assert(a.is_valid());
+			assert(b.is_valid() && b.is_normalized());
+			assert(digest_blocksize::is_near(a.blksize, b.blksize));
+			assert(a != b);
+			#endif
+			if (digest_blocksize::is_near_eq(a.blksize, b.blksize))
+			{
+				digest_comparison_score_t score1 = blockhash_comparison<Version>::score_threshold(
+					a.blkhash1, a.blkhash1_len,
+					b.digest, b.blkhash1_len,
+					a.blksize, min_score);
+				// The second block hash does not match if the block size is not safe to double.
+				if (!digest_blocksize::is_safe_to_double(a.blksize))
+					return score1;
+				// Only scores exceeding score1 are interesting.
+				if (score1)
+					min_score = score1 + 1;
+				digest_comparison_score_t score2 = blockhash_comparison<Version>::score_threshold(
+					a.blkhash2, a.blkhash2_len,
+					b.digest+b.blkhash1_len, b.blkhash2_len,
+					a.blksize * 2, min_score);
+				return std::max(score1, score2);
+			}
+			else if (digest_blocksize::is_near_lt(a.blksize, b.blksize))
+				return blockhash_comparison<Version>::score_threshold(
+					a.blkhash2, a.blkhash2_len,
+					b.digest, b.blkhash1_len,
+					b.blksize, min_score);
+			else if (digest_blocksize::is_near_gt(a.blksize, b.blksize))
+				return blockhash_comparison<Version>::score_threshold(
+					a.blkhash1, a.blkhash1_len,
+					b.digest+b.blkhash1_len, b.blkhash2_len,
+					a.blksize, min_score);
+			else // overflow (no common substring)
+				return 0;
+		}
+
+		// Comparison (on different digests; with threshold; generic block hash form)
+	private:
+		// Same as compare_near_diff_blockhashes but with threshold
+		template <typename TBlockhashA>
+		static digest_comparison_score_t compare_near_diff_threshold_blockhashes(
+			digest_blocksize_t a_blksize,
+			const TBlockhashA& a1, blockhash_len_t a1len,
+			const TBlockhashA& a2, blockhash_len_t a2len,
+			digest_blocksize_t b_blksize,
+			const char* b1, blockhash_len_t b1len,
+			const char* b2, blockhash_len_t b2len,
+			digest_comparison_score_t min_score
+		) noexcept
+		{
+			#ifdef FFUZZYPP_DEBUG
+			assert(digest_blocksize::is_near(a_blksize, b_blksize));
+			#endif
+			if (digest_blocksize::is_near_eq(a_blksize, b_blksize))
+			{
+				digest_comparison_score_t score1 = blockhash_comparison<Version>::score_threshold(
+					a1, a1len, b1, b1len, a_blksize, min_score);
+				// The second block hash does not match if the block size is not safe to double.
+				if (!digest_blocksize::is_safe_to_double(a_blksize))
+					return score1;
+				// Only scores exceeding score1 are interesting.
+				if (score1)
+					min_score = score1 + 1;
+				digest_comparison_score_t score2 = blockhash_comparison<Version>::score_threshold(
+					a2, a2len, b2, b2len, a_blksize * 2, min_score);
+				return std::max(score1, score2);
+			}
+			else if (digest_blocksize::is_near_lt(a_blksize, b_blksize))
+				return blockhash_comparison<Version>::score_threshold(
+					a2, a2len, b1, b1len, b_blksize, min_score);
+			else if (digest_blocksize::is_near_gt(a_blksize, b_blksize))
+				return blockhash_comparison<Version>::score_threshold(
+					a1, a1len, b2, b2len, a_blksize, min_score);
+			else // overflow (no common substring)
+				return 0;
+		}
+	public:
+		template <bool IsAlphabetRestricted>
+		static digest_comparison_score_t compare_near_diff_threshold(
+			const digest_view<IsAlphabetRestricted>& a,
+			const digest_view<IsAlphabetRestricted>& b,
+			digest_comparison_score_t min_score
+		) noexcept
+		{
+			#ifdef FFUZZYPP_DEBUG
+			assert(a.is_valid() && a.is_normalized());
+			assert(b.is_valid() && b.is_normalized());
+			assert(a != b);
+			#endif
+			return compare_near_diff_threshold_blockhashes(
+				digest_blocksize_t(a.blocksize()),
+				a.blockhash1(), a.blockhash1_len(),
+				a.blockhash2(), a.blockhash2_len(),
+				digest_blocksize_t(b.blocksize()),
+				b.blockhash1(), b.blockhash1_len(),
+				b.blockhash2(), b.blockhash2_len(),
+				min_score);
+		}
+		template <bool IsAlphabetRestricted>
+		static digest_comparison_score_t compare_near_diff_threshold(
+			const digest_position_array_base<IsAlphabetRestricted>& a,
+			const digest_view<IsAlphabetRestricted>& b,
+			digest_comparison_score_t min_score
+		) noexcept
+		{
+			#ifdef FFUZZYPP_DEBUG
+			assert(a.is_valid());
+			assert(b.is_valid() && b.is_normalized());
+			assert(!digest_position_array_base<IsAlphabetRestricted>::is_eq(a, b));
+			#endif
+			return compare_near_diff_threshold_blockhashes(
+				a.blksize,
+				a.blkhash1, a.blkhash1_len,
+				a.blkhash2, a.blkhash2_len,
+				digest_blocksize_t(b.blocksize()),
+				b.blockhash1(), b.blockhash1_len(),
+				b.blockhash2(), b.blockhash2_len(),
+				min_score);
+		}
+
 		// Comparison (on different digests; specialized versions)
 	public:
 		template <bool IsAlphabetRestricted, bool IsShort>
@@ -1024,6 +1399,14 @@ namespace internal
 		{
 			return 100;
 		}
+
+		template <bool IsAlphabetRestricted>
+		static digest_comparison_score_t compare_identical(
+			const digest_view<IsAlphabetRestricted>& a
+		) noexcept
+		{
+			return 100;
+		}
 	};
 
 	template <>
@@ -1041,6 +1424,14 @@ namespace internal
 		{
 			return digest_comparison_base<comparison_version::v2_9>::compare_identical_2_9(a);
 		}
+
+		template <bool IsAlphabetRestricted>
+		static digest_comparison_score_t compare_identical(
+			const digest_view<IsAlphabetRestricted>& a
+		) noexcept
+		{
+			return digest_comparison_base<comparison_version::v2_9>::compare_identical_2_9(a);
+		}
 	};
 }
 
@@ -1077,6 +1468,138 @@ public:
 		return base_type::compare_near_diff(a, b);
 	}
 
+	template <bool IsAlphabetRestricted>
+	static digest_comparison_score_t compare_near(
+		const digest_view<IsAlphabetRestricted>& a,
+		const digest_view<IsAlphabetRestricted>& b
+	) noexcept
+	{
+		if (a == b)
+			return base_type::compare_identical(b);
+		return base_type::compare_near_diff(a, b);
+	}
+	template <bool IsAlphabetRestricted>
+	static digest_comparison_score_t compare_near(
+		const digest_position_array_base<IsAlphabetRestricted>& a,
+		const digest_view<IsAlphabetRestricted>& b
+	) noexcept
+	{
+		if (digest_position_array_base<IsAlphabetRestricted>::is_eq(a, b))
+			return base_type::compare_identical(b);
+		return base_type::compare_near_diff(a, b);
+	}
+
+	// Comparison (possibly equivalent; with threshold)
+public:
+	/*
+		Returns the same score as compare (or compare_near) if it is
+		min_score or greater. Otherwise, returns zero.
+		Block hash pairs which cannot reach min_score are rejected before
+		computing the edit distance (and the edit distance computation
+		itself stops as soon as min_score becomes unreachable).
+	*/
+	template <bool IsAlphabetRestricted, bool IsShort>
+	static digest_comparison_score_t compare_near_threshold(
+		const digest_data<IsAlphabetRestricted, IsShort>& a,
+		const digest_data<IsAlphabetRestricted, IsShort>& b,
+		digest_comparison_score_t min_score
+	) noexcept
+	{
+		if (a == b)
+		{
+			digest_comparison_score_t score = base_type::compare_identical(b);
+			return score < min_score ? 0 : score;
+		}
+		return base_type::compare_near_diff_threshold(a, b, min_score);
+	}
+	template <bool IsAlphabetRestricted, bool IsShort>
+	static digest_comparison_score_t compare_near_threshold(
+		const digest_position_array_base<IsAlphabetRestricted>& a,
+		const digest_data<IsAlphabetRestricted, IsShort>& b,
+		digest_comparison_score_t min_score
+	) noexcept
+	{
+		if (a == b)
+		{
+			digest_comparison_score_t score = base_type::compare_identical(b);
+			return score < min_score ? 0 : score;
+		}
+		return base_type::compare_near_diff_threshold(a, b, min_score);
+	}
+	template <bool IsAlphabetRestricted, bool IsShort>
+	static digest_comparison_score_t compare_threshold(
+		const digest_data<IsAlphabetRestricted, IsShort>& a,
+		const digest_data<IsAlphabetRestricted, IsShort>& b,
+		digest_comparison_score_t min_score
+	) noexcept
+	{
+		if (!digest_blocksize::is_near(a.blksize, b.blksize))
+			return 0;
+		return compare_near_threshold(a, b, min_score);
+	}
+	template <bool IsAlphabetRestricted, bool IsShort>
+	static digest_comparison_score_t compare_threshold(
+		const digest_position_array_base<IsAlphabetRestricted>& a,
+		const digest_data<IsAlphabetRestricted, IsShort>& b,
+		digest_comparison_score_t min_score
+	) noexcept
+	{
+		if (!digest_blocksize::is_near(a.blksize, b.blksize))
+			return 0;
+		return compare_near_threshold(a, b, min_score);
+	}
+
+	template <bool IsAlphabetRestricted>
+	static digest_comparison_score_t compare_near_threshold(
+		const digest_view<IsAlphabetRestricted>& a,
+		const digest_view<IsAlphabetRestricted>& b,
+		digest_comparison_score_t min_score
+	) noexcept
+	{
+		if (a == b)
+		{
+			digest_comparison_score_t score = base_type::compare_identical(b);
+			return score < min_score ? 0 : score;
+		}
+		return base_type::compare_near_diff_threshold(a, b, min_score);
+	}
+	template <bool IsAlphabetRestricted>
+	static digest_comparison_score_t compare_near_threshold(
+		const digest_position_array_base<IsAlphabetRestricted>& a,
+		const digest_view<IsAlphabetRestricted>& b,
+		digest_comparison_score_t min_score
+	) noexcept
+	{
+		if (digest_position_array_base<IsAlphabetRestricted>::is_eq(a, b))
+		{
+			digest_comparison_score_t score = base_type::compare_identical(b);
+			return score < min_score ? 0 : score;
+		}
+		return base_type::compare_near_diff_threshold(a, b, min_score);
+	}
+	template <bool IsAlphabetRestricted>
+	static digest_comparison_score_t compare_threshold(
+		const digest_view<IsAlphabetRestricted>& a,
+		const digest_view<IsAlphabetRestricted>& b,
+		digest_comparison_score_t min_score
+	) noexcept
+	{
+		if (!digest_blocksize::is_near(a.blocksize(), b.blocksize()))
+			return 0;
+		return compare_near_threshold(a, b, min_score);
+	}
+	template <bool IsAlphabetRestricted>
+	static digest_comparison_score_t compare_threshold(
+		const digest_position_array_base<IsAlphabetRestricted>& a,
+		const digest_view<IsAlphabetRestricted>& b,
+		digest_comparison_score_t min_score
+	) noexcept
+	{
+		if (!digest_blocksize::is_near(a.blksize, b.blocksize()))
+			return 0;
+		return compare_near_threshold(a, b, min_score);
+	}
+
 	// Specialized comparison (possibly equivalent)
 public:
 	template <bool IsAlphabetRestricted, bool IsShort>
@@ -1123,6 +1646,27 @@ public:
 		return compare_near(a, b);
 	}
 
+	template <bool IsAlphabetRestricted>
+	static digest_comparison_score_t compare(
+		const digest_view<IsAlphabetRestricted>& a,
+		const digest_view<IsAlphabetRestricted>& b
+	) noexcept
+	{
+		if (!digest_blocksize::is_near(a.blocksize(), b.blocksize()))
+			return 0;
+		return compare_near(a, b);
+	}
+	template <bool IsAlphabetRestricted>
+	static digest_comparison_score_t compare(
+		const digest_position_array_base<IsAlphabetRestricted>& a,
+		const digest_view<IsAlphabetRestricted>& b
+	) noexcept
+	{
+		if (!digest_blocksize::is_near(a.blksize, b.blocksize()))
+			return 0;
+		return compare_near(a, b);
+	}
+
 	// Comparison (for unnormalized form of digests)
 public:
 	template <bool IsAlphabetRestricted, bool IsShort>
@@ -1131,9 +1675,15 @@ public:
 		const digest_data<IsAlphabetRestricted, IsShort>& b
 	) noexcept
 	{
-		return compare(
-			digest_data<IsAlphabetRestricted, IsShort>::normalize(a),
-			digest_data<IsAlphabetRestricted, IsShort>::normalize(b)
+		// Normalization does not change block sizes
+		if (!digest_blocksize::is_near(a.blksize, b.blksize))
+			return 0;
+		// Only block hashes with long sequences are copied
+		char abuf[digest_params::max_blockhash_len * 2];
+		char bbuf[digest_params::max_blockhash_len * 2];
+		return compare_near(
+			digest_view<IsAlphabetRestricted>::normalize(abuf, a),
+			digest_view<IsAlphabetRestricted>::normalize(bbuf, b)
 		);
 	}
 
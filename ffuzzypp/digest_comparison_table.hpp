@@ -0,0 +1,232 @@
+/*
+
+	ffuzzy++ : C++ implementation of fast fuzzy hashing
+
+	digest_comparison_table.hpp
+	Precomputed score tables for block hash comparison
+
+	Copyright (C) 2026 Tsukasa OI <floss_ssdeep@irq.a4lg.com>
+
+
+	Permission to use, copy, modify, and/or distribute this software for
+	any purpose with or without fee is hereby granted, provided that the
+	above copyright notice and this permission notice appear in all copies.
+
+	THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+	WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+	MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+	ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+	WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+	ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+	OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+
+*/
+#ifndef FFUZZYPP_DIGEST_COMPARISON_TABLE_HPP
+#define FFUZZYPP_DIGEST_COMPARISON_TABLE_HPP
+
+#include <cassert>
+#include <cstddef>
+
+#include <limits>
+
+#include "digest_blocksize.hpp"
+#include "digest_comparison.hpp"
+#include "digest_data.hpp"
+#include "utils/minmax.hpp"
+
+namespace ffuzzy {
+
+namespace internal
+{
+	/*
+		Score tables (independent from comparison_version)
+
+		*	uncapped[len_sum][edit_distance]
+			uncapped score for block hashes whose lengths sum to len_sum
+			(entries unreachable by valid block hash lengths are zero)
+		*	cap[blocksize_index][min_len]
+			score cap for natural block size (clipped to 100)
+			where min_len is the length of the shorter block hash
+			(zero if min_len is less than min_match_len)
+
+		They are built once on the first use.
+	*/
+	class blockhash_score_table_data
+	{
+	public:
+		typedef unsigned char score_type;
+		static_assert(std::numeric_limits<score_type>::max() >= 100,
+			"score_type must be able to represent 100.");
+		static constexpr const size_t max_len_sum = digest_params::max_blockhash_len * 2;
+		static constexpr const size_t max_edit_distance = max_len_sum;
+		static constexpr const size_t max_len = digest_params::max_blockhash_len;
+	public:
+		score_type uncapped[max_len_sum + 1][max_edit_distance + 1];
+		score_type cap[digest_blocksize::number_of_blockhashes][max_len + 1];
+	private:
+		blockhash_score_table_data(const blockhash_score_table_data&) = delete;
+		blockhash_score_table_data(void) noexcept
+		{
+			static constexpr const blockhash_len_t min_len = blockhash_comparison_params::min_match_len;
+			for (size_t len_sum = 0; len_sum <= max_len_sum; len_sum++)
+			{
+				for (size_t d = 0; d <= max_edit_distance; d++)
+				{
+					uncapped[len_sum][d] = 0;
+					if (len_sum < size_t(min_len) * 2 || d > len_sum)
+						continue;
+					// uncapped score depends only on the sum of block hash lengths
+					blockhash_len_t l1 = blockhash_len_t(len_sum / 2);
+					blockhash_len_t l2 = blockhash_len_t(len_sum - len_sum / 2);
+					uncapped[len_sum][d] = score_type(
+						blockhash_comparison_base::uncapped_score(digest_comparison_score_t(d), l1, l2));
+				}
+			}
+			for (unsigned i = 0; i < digest_blocksize::number_of_blockhashes; i++)
+			{
+				digest_blocksize_t blocksize = digest_blocksize::at(i);
+				for (size_t len = 0; len <= max_len; len++)
+				{
+					if (len < min_len)
+						cap[i][len] = 0;
+					else if (!blockhash_comparison_base::is_safe_for_score_capping(blocksize))
+						cap[i][len] = 100;
+					else
+						cap[i][len] = score_type(minmax::min(digest_comparison_score_t(100),
+							blockhash_comparison_base::score_cap_unsafe(
+								blocksize, blockhash_len_t(len), blockhash_len_t(len))));
+				}
+			}
+		}
+	public:
+		static const blockhash_score_table_data& get(void) noexcept
+		{
+			static const blockhash_score_table_data data;
+			return data;
+		}
+	};
+}
+
+/*
+	Table-driven block hash scoring
+
+	The results are the same as blockhash_comparison<Version> but
+	the arithmetic of scoring and capping is replaced by table lookups.
+	Callers which compare many block hashes of fixed length and block size
+	(e.g. digest_query) can keep a row of the uncapped table and the cap
+	so that an edit distance is mapped to the score by a load and a min.
+
+	Tables are shared by all comparison versions because versions only
+	differ in scores of identical block hashes (see score_identical).
+	A table of final (capped) scores would have to be indexed by the
+	block size, the shorter length, the sum of lengths and the edit
+	distance (about 33MiB) and per-query rows of final scores would
+	take 16KiB per query, so the cap is applied by a min instead.
+*/
+template <comparison_version Version = comparison_version::latest>
+class blockhash_score_table
+{
+private:
+	blockhash_score_table(void) = delete;
+	blockhash_score_table(const blockhash_score_table&) = delete;
+	typedef internal::blockhash_score_table_data data_type;
+public:
+	typedef data_type::score_type score_type;
+	static constexpr const size_t max_len_sum = data_type::max_len_sum;
+	static constexpr const size_t max_edit_distance = data_type::max_edit_distance;
+public:
+	// Row of uncapped scores (indexed by the edit distance)
+	static const score_type* uncapped_row(size_t len_sum) noexcept
+	{
+		#ifdef FFUZZYPP_DEBUG
+		assert(len_sum <= max_len_sum);
+		#endif
+		return data_type::get().uncapped[len_sum];
+	}
+	static digest_comparison_score_t uncapped_score(
+		digest_comparison_score_t edit_distance,
+		blockhash_len_t s1len,
+		blockhash_len_t s2len
+	) noexcept
+	{
+		#ifdef FFUZZYPP_DEBUG
+		assert(s1len >= blockhash_comparison_params::min_match_len && s1len <= digest_params::max_blockhash_len);
+		assert(s2len >= blockhash_comparison_params::min_match_len && s2len <= digest_params::max_blockhash_len);
+		assert(edit_distance <= s1len + s2len);
+		#endif
+		return uncapped_row(size_t(s1len) + size_t(s2len))[edit_distance];
+	}
+	// Score cap for block size index (100 if not capped, 0 if too short to match)
+	static digest_comparison_score_t score_cap_by_index(
+		unsigned blocksize_index,
+		blockhash_len_t s1len,
+		blockhash_len_t s2len
+	) noexcept
+	{
+		#ifdef FFUZZYPP_DEBUG
+		assert(blocksize_index < digest_blocksize::number_of_blockhashes);
+		assert(s1len <= digest_params::max_blockhash_len);
+		assert(s2len <= digest_params::max_blockhash_len);
+		#endif
+		return data_type::get().cap[blocksize_index][minmax::min(s1len, s2len)];
+	}
+	// Score cap for any block size (same convention as score_cap_by_index)
+	static digest_comparison_score_t score_cap(
+		digest_blocksize_t blocksize,
+		blockhash_len_t s1len,
+		blockhash_len_t s2len
+	) noexcept
+	{
+		if (s1len < blockhash_comparison_params::min_match_len || s2len < blockhash_comparison_params::min_match_len)
+			return 0;
+		if (!blockhash_comparison_base_type::is_safe_for_score_capping(blocksize))
+			return 100;
+		return minmax::min(digest_comparison_score_t(100),
+			blockhash_comparison_base_type::score_cap_unsafe(blocksize, s1len, s2len));
+	}
+	static digest_comparison_score_t score(
+		digest_comparison_score_t edit_distance,
+		digest_blocksize_t blocksize,
+		blockhash_len_t s1len,
+		blockhash_len_t s2len
+	) noexcept
+	{
+		#ifdef FFUZZYPP_DEBUG
+		assert(s1len >= blockhash_comparison_params::min_match_len && s1len <= digest_params::max_blockhash_len);
+		assert(s2len >= blockhash_comparison_params::min_match_len && s2len <= digest_params::max_blockhash_len);
+		assert(edit_distance <= s1len + s2len);
+		#endif
+		return minmax::min(
+			uncapped_score(edit_distance, s1len, s2len),
+			score_cap(blocksize, s1len, s2len));
+	}
+	static digest_comparison_score_t score_by_index(
+		digest_comparison_score_t edit_distance,
+		unsigned blocksize_index,
+		blockhash_len_t s1len,
+		blockhash_len_t s2len
+	) noexcept
+	{
+		#ifdef FFUZZYPP_DEBUG
+		assert(s1len >= blockhash_comparison_params::min_match_len && s1len <= digest_params::max_blockhash_len);
+		assert(s2len >= blockhash_comparison_params::min_match_len && s2len <= digest_params::max_blockhash_len);
+		assert(edit_distance <= s1len + s2len);
+		#endif
+		return minmax::min(
+			uncapped_score(edit_distance, s1len, s2len),
+			score_cap_by_index(blocksize_index, s1len, s2len));
+	}
+	static digest_comparison_score_t score_identical(
+		blockhash_len_t blockhash_len,
+		digest_blocksize_t blocksize
+	) noexcept
+	{
+		return blockhash_comparison<Version>::score_identical(blockhash_len, blocksize);
+	}
+private:
+	typedef internal::blockhash_comparison_base blockhash_comparison_base_type;
+};
+
+}
+
+#endif
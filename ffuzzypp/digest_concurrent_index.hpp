@@ -0,0 +1,385 @@
+/*
+
+	ffuzzy++ : C++ implementation of fast fuzzy hashing
+
+	digest_concurrent_index.hpp
+	Append-only index with lock-free readers
+
+	Copyright (C) 2026 Tsukasa OI <floss_ssdeep@irq.a4lg.com>
+
+
+	Permission to use, copy, modify, and/or distribute this software for
+	any purpose with or without fee is hereby granted, provided that the
+	above copyright notice and this permission notice appear in all copies.
+
+	THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+	WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+	MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+	ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+	WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+	ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+	OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+
+*/
+#ifndef FFUZZYPP_DIGEST_CONCURRENT_INDEX_HPP
+#define FFUZZYPP_DIGEST_CONCURRENT_INDEX_HPP
+
+#include <cassert>
+#include <cstddef>
+#include <cstring>
+
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "blockhash_signature.hpp"
+#include "digest_blocksize.hpp"
+#include "digest_data.hpp"
+#include "digest_base.hpp"
+#include "digest_comparison.hpp"
+#include "digest_query.hpp"
+#include "digest_view.hpp"
+
+namespace ffuzzy {
+
+namespace internal
+{
+	/*
+		Fixed-capacity chunk of digests with the same block size
+		(with the accessors of digest_store so that digest_query
+		can compare against it).  Slots are written once by the writer
+		before being published and never modified afterwards.
+	*/
+	template <bool IsAlphabetRestricted>
+	class digest_concurrent_chunk
+	{
+	public:
+		static constexpr const size_t blockhash_stride = digest_params::max_blockhash_len;
+		typedef unsigned char len_type;
+	private:
+		digest_blocksize_t blksize;
+		size_t cap;
+		std::unique_ptr<size_t[]> ids;
+		std::unique_ptr<len_type[]> blkhash1_lens;
+		std::unique_ptr<len_type[]> blkhash2_lens;
+		std::unique_ptr<char[]> blkhash1_chars;
+		std::unique_ptr<char[]> blkhash2_chars;
+		std::unique_ptr<blockhash_signature[]> blkhash1_sigs;
+		std::unique_ptr<blockhash_signature[]> blkhash2_sigs;
+	public:
+		digest_concurrent_chunk(digest_blocksize_t blocksize, size_t capacity)
+			: blksize(blocksize)
+			, cap(capacity)
+			, ids(new size_t[capacity])
+			, blkhash1_lens(new len_type[capacity])
+			, blkhash2_lens(new len_type[capacity])
+			, blkhash1_chars(new char[capacity * blockhash_stride])
+			, blkhash2_chars(new char[capacity * blockhash_stride])
+			, blkhash1_sigs(new blockhash_signature[capacity])
+			, blkhash2_sigs(new blockhash_signature[capacity])
+		{}
+		size_t capacity(void) const noexcept { return cap; }
+		size_t id(size_t i) const noexcept { return ids[i]; }
+		digest_blocksize_t blocksize(size_t) const noexcept { return blksize; }
+		blockhash_len_t blockhash1_len(size_t i) const noexcept { return blkhash1_lens[i]; }
+		blockhash_len_t blockhash2_len(size_t i) const noexcept { return blkhash2_lens[i]; }
+		const char* blockhash1(size_t i) const noexcept { return blkhash1_chars.get() + i * blockhash_stride; }
+		const char* blockhash2(size_t i) const noexcept { return blkhash2_chars.get() + i * blockhash_stride; }
+		const blockhash_signature& signature1(size_t i) const noexcept { return blkhash1_sigs[i]; }
+		const blockhash_signature& signature2(size_t i) const noexcept { return blkhash2_sigs[i]; }
+		bool is_eq(
+			size_t i,
+			digest_blocksize_t blocksize,
+			const char* bh1, blockhash_len_t bh1len,
+			const char* bh2, blockhash_len_t bh2len
+		) const noexcept
+		{
+			return
+				blksize == blocksize &&
+				blkhash1_lens[i] == bh1len &&
+				blkhash2_lens[i] == bh2len &&
+				memcmp(blockhash1(i), bh1, bh1len) == 0 &&
+				memcmp(blockhash2(i), bh2, bh2len) == 0;
+		}
+		void set(size_t i, size_t id, const digest_view<IsAlphabetRestricted>& d) noexcept
+		{
+			#ifdef FFUZZYPP_DEBUG
+			assert(i < cap);
+			assert(d.blocksize() == blksize);
+			#endif
+			ids[i] = id;
+			blkhash1_lens[i] = len_type(d.blockhash1_len());
+			blkhash2_lens[i] = len_type(d.blockhash2_len());
+			memcpy(blkhash1_chars.get() + i * blockhash_stride, d.blockhash1(), d.blockhash1_len());
+			memcpy(blkhash2_chars.get() + i * blockhash_stride, d.blockhash2(), d.blockhash2_len());
+			blkhash1_sigs[i].construct(d.blockhash1(), d.blockhash1_len());
+			blkhash2_sigs[i].construct(d.blockhash2(), d.blockhash2_len());
+		}
+	};
+
+	/*
+		Append-only segment of digests with the same block size
+		The k-th chunk has the capacity of (first_chunk_size << k)
+		so that a fixed number of chunk pointers covers any size.
+	*/
+	template <bool IsAlphabetRestricted>
+	class digest_concurrent_segment
+	{
+	public:
+		typedef digest_concurrent_chunk<IsAlphabetRestricted> chunk_type;
+		static constexpr const size_t first_chunk_size = 64;
+		static constexpr const size_t max_chunks = std::numeric_limits<size_t>::digits - 6;
+	private:
+		digest_blocksize_t blksize;
+		std::atomic<size_t> count;
+		std::atomic<chunk_type*> chunks[max_chunks];
+	public:
+		// Next segment with non-natural block size (immutable after publication)
+		digest_concurrent_segment* next;
+	public:
+		explicit digest_concurrent_segment(digest_blocksize_t blocksize) noexcept
+			: blksize(blocksize), count(0), next(nullptr)
+		{
+			for (size_t k = 0; k < max_chunks; k++)
+				chunks[k].store(nullptr, std::memory_order_relaxed);
+		}
+		digest_concurrent_segment(const digest_concurrent_segment&) = delete;
+		digest_concurrent_segment& operator=(const digest_concurrent_segment&) = delete;
+		~digest_concurrent_segment(void)
+		{
+			for (size_t k = 0; k < max_chunks; k++)
+				delete chunks[k].load(std::memory_order_relaxed);
+		}
+		digest_blocksize_t blocksize(void) const noexcept { return blksize; }
+		// Writer only (serialized by the caller)
+		void append(size_t id, const digest_view<IsAlphabetRestricted>& d)
+		{
+			size_t n = count.load(std::memory_order_relaxed);
+			size_t k = 0, begin = 0;
+			while (n >= begin + (first_chunk_size << k))
+				begin += first_chunk_size << k++;
+			chunk_type* chunk = chunks[k].load(std::memory_order_relaxed);
+			if (!chunk)
+			{
+				chunk = new chunk_type(blksize, first_chunk_size << k);
+				chunks[k].store(chunk, std::memory_order_release);
+			}
+			chunk->set(n - begin, id, d);
+			count.store(n + 1, std::memory_order_release);
+		}
+		// callback(chunk, slot) for published digests with IDs less than limit
+		template <typename TCallback>
+		void for_each(size_t limit, TCallback&& callback) const
+		{
+			size_t n = count.load(std::memory_order_acquire);
+			size_t begin = 0;
+			for (size_t k = 0; begin < n; begin += first_chunk_size << k++)
+			{
+				const chunk_type* chunk = chunks[k].load(std::memory_order_acquire);
+				size_t m = std::min(chunk->capacity(), n - begin);
+				for (size_t i = 0; i < m; i++)
+				{
+					// IDs are increasing in a segment
+					if (chunk->id(i) >= limit)
+						return;
+					callback(*chunk, i);
+				}
+			}
+		}
+	};
+}
+
+
+/*
+	Append-only digest index with lock-free readers
+
+	Digests are appended into segments per block size and numbered
+	in the order of insertion.  Writers are serialized by a mutex but
+	readers never lock: a search first reads the number of published
+	digests and ignores digests inserted later, so that it always runs
+	against a consistent snapshot (a prefix of the insertion order)
+	while new digests are being appended.
+
+	Published data is never modified or moved (segments consist of
+	chunks of growing sizes instead of reallocated arrays) and nothing
+	is freed until the index is destroyed.  So, readers need no
+	reclamation scheme such as epochs or RCU.
+
+	A search only visits the segments with "near" block sizes and
+	the result is the same as digest_comparison<Version>::compare.
+*/
+template <bool IsAlphabetRestricted, comparison_version Version = comparison_version::latest>
+class digest_concurrent_index
+{
+public:
+	static constexpr const bool is_alphabet_restricted = IsAlphabetRestricted;
+	static constexpr const comparison_version version = Version;
+	typedef digest_query<IsAlphabetRestricted, Version> query_type;
+	typedef digest_view<IsAlphabetRestricted> view_type;
+private:
+	typedef internal::digest_concurrent_segment<IsAlphabetRestricted> segment_type;
+	typedef typename segment_type::chunk_type chunk_type;
+
+	// Data structure
+private:
+	std::mutex writer_mutex;
+	std::atomic<size_t> published;
+	// Segments of natural block sizes (indexed by digest_blocksize::natural_to_index)
+	std::atomic<segment_type*> naturals[digest_blocksize::number_of_blockhashes];
+	// Segments of other block sizes (linked list)
+	std::atomic<segment_type*> others;
+public:
+	digest_concurrent_index(void) noexcept
+		: published(0), others(nullptr)
+	{
+		for (auto& seg : naturals)
+			seg.store(nullptr, std::memory_order_relaxed);
+	}
+	digest_concurrent_index(const digest_concurrent_index&) = delete;
+	digest_concurrent_index& operator=(const digest_concurrent_index&) = delete;
+	~digest_concurrent_index(void)
+	{
+		for (auto& seg : naturals)
+			delete seg.load(std::memory_order_relaxed);
+		for (segment_type* seg = others.load(std::memory_order_relaxed); seg; )
+		{
+			segment_type* next = seg->next;
+			delete seg;
+			seg = next;
+		}
+	}
+	// Number of published digests
+	size_t size(void) const noexcept { return published.load(std::memory_order_acquire); }
+	bool empty(void) const noexcept { return size() == 0; }
+
+	// Segments
+private:
+	const segment_type* find_segment(digest_blocksize_t bs) const noexcept
+	{
+		if (digest_blocksize::is_natural(bs))
+			return naturals[digest_blocksize::natural_to_index(bs)].load(std::memory_order_acquire);
+		for (const segment_type* seg = others.load(std::memory_order_acquire); seg; seg = seg->next)
+			if (seg->blocksize() == bs)
+				return seg;
+		return nullptr;
+	}
+	// Writer only
+	segment_type* get_segment(digest_blocksize_t bs)
+	{
+		segment_type* seg = const_cast<segment_type*>(find_segment(bs));
+		if (seg)
+			return seg;
+		seg = new segment_type(bs);
+		if (digest_blocksize::is_natural(bs))
+			naturals[digest_blocksize::natural_to_index(bs)].store(seg, std::memory_order_release);
+		else
+		{
+			seg->next = others.load(std::memory_order_relaxed);
+			others.store(seg, std::memory_order_release);
+		}
+		return seg;
+	}
+
+	// Insertion (returns the ID of the digest)
+public:
+	template <bool IsShort, bool IsNormalized>
+	size_t push_back(const digest_base<IsAlphabetRestricted, IsShort, IsNormalized>& d)
+	{
+		#ifdef FFUZZYPP_DEBUG
+		assert(d.is_valid());
+		#endif
+		char buf[digest_params::max_blockhash_len * 2];
+		view_type v = view_type::normalize(buf, d);
+		std::lock_guard<std::mutex> lock(writer_mutex);
+		size_t id = published.load(std::memory_order_relaxed);
+		get_segment(digest_blocksize_t(v.blocksize()))->append(id, v);
+		// publish after the segment so that readers see every digest below the count
+		published.store(id + 1, std::memory_order_release);
+		return id;
+	}
+	size_t push_back(const char* str) noexcept(false)
+	{
+		return push_back(digest_base<IsAlphabetRestricted, false, true>(str));
+	}
+	size_t push_back(const std::string& str)
+	{
+		return push_back(str.c_str());
+	}
+
+	// Search (lock-free)
+private:
+	static bool is_better(const digest_search_result& a, const digest_search_result& b) noexcept
+	{
+		return a.score > b.score || (a.score == b.score && a.index < b.index);
+	}
+public:
+	/*
+		Search all digests with the score of min_score or greater (and nonzero).
+		Results are sorted by the score (descending) and then by the ID (ascending).
+		Returns the number of digests in the snapshot searched.
+	*/
+	size_t search(
+		const view_type& query,
+		std::vector<digest_search_result>& results,
+		digest_comparison_score_t min_score = 1
+	) const
+	{
+		#ifdef FFUZZYPP_DEBUG
+		assert(query.is_valid() && query.is_normalized());
+		#endif
+		results.clear();
+		if (min_score == 0)
+			min_score = 1;
+		size_t limit = size();
+		query_type q(query);
+		digest_blocksize_t bs = digest_blocksize_t(query.blocksize());
+		auto visit = [&](const chunk_type& chunk, size_t i) {
+			digest_comparison_score_t score = q.compare_threshold(chunk, i, min_score);
+			if (score)
+				results.push_back(digest_search_result{ chunk.id(i), score });
+		};
+		if (const segment_type* seg = find_segment(bs))
+			seg->for_each(limit, visit);
+		// (lt and gt relations are disabled if the block size is zero)
+		if (bs != 0 && digest_blocksize::is_safe_to_double(bs))
+			if (const segment_type* seg = find_segment(bs * 2))
+				seg->for_each(limit, visit);
+		if (bs != 0 && bs % 2 == 0)
+			if (const segment_type* seg = find_segment(bs / 2))
+				seg->for_each(limit, visit);
+		std::sort(results.begin(), results.end(), is_better);
+		return limit;
+	}
+	std::vector<digest_search_result> search(
+		const view_type& query,
+		digest_comparison_score_t min_score = 1
+	) const
+	{
+		std::vector<digest_search_result> results;
+		search(query, results, min_score);
+		return results;
+	}
+	std::vector<digest_search_result> search_top_k(
+		const view_type& query,
+		size_t k,
+		digest_comparison_score_t min_score = 1
+	) const
+	{
+		std::vector<digest_search_result> results;
+		search(query, results, min_score);
+		if (results.size() > k)
+			results.resize(k);
+		return results;
+	}
+};
+
+typedef digest_concurrent_index< true> digest_concurrent_index_t;
+typedef digest_concurrent_index<false> digest_concurrent_index_non_ra_t;
+
+}
+
+#endif
@@ -641,6 +641,28 @@ namespace internal
 			strings::nosequences<base64::transform_to_b64>::
 				copy_raw(dest.digest, src.digest, src.blkhash1_len + src.blkhash2_len);
 		}
+		// Remap to the 6-bit alphabet (fails if a character is not in Base64 charset)
+		template <bool IsShort>
+		static bool copy_to_ra(
+			digest_data<true, IsShort>& dest,
+			const digest_data<false, IsShort>& src
+		) noexcept
+		{
+			#ifdef FFUZZYPP_DEBUG
+			assert(src.is_valid());
+			#endif
+			for (blockhash_len_t i = 0; i < src.blkhash1_len + src.blkhash2_len; i++)
+			{
+				char ch = base64::toindex(src.digest[i]);
+				if (ch == base64::invalid_index)
+					return false;
+				dest.digest[i] = ch;
+			}
+			dest.blkhash1_len = src.blkhash1_len;
+			dest.blkhash2_len = src.blkhash2_len;
+			dest.blksize = src.blksize;
+			return true;
+		}
 	};
 }
 
@@ -0,0 +1,327 @@
+/*
+
+	ffuzzy++ : C++ implementation of fast fuzzy hashing
+
+	digest_index.hpp
+	Inverted index of block hash substrings
+
+	Copyright (C) 2026 Tsukasa OI <floss_ssdeep@irq.a4lg.com>
+
+
+	Permission to use, copy, modify, and/or distribute this software for
+	any purpose with or without fee is hereby granted, provided that the
+	above copyright notice and this permission notice appear in all copies.
+
+	THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+	WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+	MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+	ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+	WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+	ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+	OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+
+*/
+#ifndef FFUZZYPP_DIGEST_INDEX_HPP
+#define FFUZZYPP_DIGEST_INDEX_HPP
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+#include <algorithm>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "digest_blocksize.hpp"
+#include "digest_data.hpp"
+#include "digest_base.hpp"
+#include "digest_comparison.hpp"
+#include "digest_posting_list.hpp"
+#include "digest_query.hpp"
+#include "digest_store.hpp"
+#include "digest_view.hpp"
+
+namespace ffuzzy {
+
+/*
+	Inverted index of block hash substrings
+
+	Two block hashes compared at a block size can score nonzero only if
+	they share a substring of blockhash_comparison_params::min_match_len
+	characters.  So, for every digest, substrings of block hash 1 are
+	indexed under its block size and substrings of block hash 2 are
+	indexed under the doubled block size (the "effective" block sizes
+	at which those block hashes are compared).
+
+	A query looks up substrings of its own block hashes at its effective
+	block sizes and only candidates found there (deduplicated) are
+	scored by digest_query.  The lookup cost depends on the number of
+	candidates sharing substrings, not on the size of the corpus.
+
+	Posting lists are delta and variable-byte encoded (see
+	digest_posting_list.hpp) and kept in an open-addressed table per
+	effective block size.  Most substrings have only one or a few
+	postings and such lists take no memory outside the table.
+
+	Digests without any indexed substrings (both block hashes are too
+	short) can only match identical digests and they are kept in a
+	separate table keyed by the digest hash.
+
+	The result is the same as digest_comparison<Version>::compare
+	against every indexed digest (only nonzero scores are reported).
+*/
+template <bool IsAlphabetRestricted, comparison_version Version = comparison_version::latest>
+class digest_index
+{
+public:
+	static constexpr const bool is_alphabet_restricted = IsAlphabetRestricted;
+	static constexpr const comparison_version version = Version;
+	static constexpr const size_t substr_size = blockhash_comparison_params::min_match_len;
+	typedef digest_store<IsAlphabetRestricted> store_type;
+	typedef digest_query<IsAlphabetRestricted, Version> query_type;
+	typedef digest_view<IsAlphabetRestricted> view_type;
+	// Substring packed into an integer (8 bits per character)
+	typedef uint_least64_t gram_type;
+	typedef std::vector<size_t> posting_list;
+	typedef digest_posting_list compressed_posting_list;
+	static_assert(substr_size * 8 <= 64, "substr_size must fit in gram_type.");
+	static constexpr const gram_type gram_mask =
+		substr_size * 8 == 64 ? ~gram_type(0u) : (gram_type(1u) << (substr_size * 8 % 64)) - 1u;
+
+	// Data structure
+private:
+	typedef digest_posting_table gram_map;
+	store_type items;
+	// Posting lists (keyed by effective block size and substring)
+	std::unordered_map<unsigned long, gram_map> buckets;
+	// Digests without indexed substrings (keyed by digest hash)
+	std::unordered_map<size_t, posting_list> unindexed;
+public:
+	size_t size(void) const noexcept { return items.size(); }
+	bool empty(void) const noexcept { return items.empty(); }
+	const store_type& store(void) const noexcept { return items; }
+	void clear(void) noexcept
+	{
+		items.clear();
+		buckets.clear();
+		unindexed.clear();
+	}
+	// Number of posting list entries (for statistics)
+	size_t posting_count(void) const noexcept
+	{
+		size_t n = 0;
+		for (const auto& bucket : buckets)
+			bucket.second.for_each([&](gram_type, const compressed_posting_list& postings) {
+				n += postings.size();
+			});
+		return n;
+	}
+	// Memory used by posting lists and their tables (in bytes)
+	size_t posting_memory_usage(void) const noexcept
+	{
+		size_t n = 0;
+		for (const auto& bucket : buckets)
+			n += bucket.second.memory_usage();
+		return n;
+	}
+
+	// Iteration over the index (for serialization; unordered)
+public:
+	// callback(effective block size, substring, compressed posting list)
+	template <typename TCallback>
+	void for_each_posting_list(TCallback&& callback) const
+	{
+		for (const auto& bucket : buckets)
+		{
+			unsigned long bs = bucket.first;
+			bucket.second.for_each([&](gram_type g, const compressed_posting_list& postings) {
+				callback(bs, g, postings);
+			});
+		}
+	}
+	// callback(digest hash, indices of digests without indexed substrings)
+	template <typename TCallback>
+	void for_each_unindexed(TCallback&& callback) const
+	{
+		for (const auto& entry : unindexed)
+			callback(entry.first, entry.second);
+	}
+
+	// Substrings (calls callback for each packed substring; false if none)
+public:
+	template <typename TCallback>
+	static bool for_each_gram(const char* s, size_t len, TCallback&& callback)
+	{
+		if (len < substr_size)
+			return false;
+		gram_type g = 0;
+		for (size_t i = 0; i < len; i++)
+		{
+			g = ((g << 8) | gram_type(static_cast<unsigned char>(s[i]))) & gram_mask;
+			if (i + 1 >= substr_size)
+				callback(g);
+		}
+		return true;
+	}
+
+	// Insertion
+private:
+	bool index_blockhash(unsigned long bs, const char* s, size_t len, size_t i)
+	{
+		if (len < substr_size)
+			return false;
+		gram_map& grams = buckets[bs];
+		// (a substring may appear more than once in a block hash)
+		return for_each_gram(s, len, [&](gram_type g) {
+			grams.insert(g, i);
+		});
+	}
+	size_t index_last(void)
+	{
+		size_t i = items.size() - 1;
+		view_type v = items.view(i);
+		digest_blocksize_t bs = digest_blocksize_t(v.blocksize());
+		bool indexed = index_blockhash(bs, v.blockhash1(), v.blockhash1_len(), i);
+		if (digest_blocksize::is_safe_to_double(bs))
+			indexed |= index_blockhash(2ul * bs, v.blockhash2(), v.blockhash2_len(), i);
+		if (!indexed)
+			unindexed[v.hash()].push_back(i);
+		return i;
+	}
+public:
+	template <bool IsShort, bool IsNormalized>
+	size_t push_back(const digest_base<IsAlphabetRestricted, IsShort, IsNormalized>& d)
+	{
+		items.push_back(d);
+		return index_last();
+	}
+	size_t push_back(const view_type& d)
+	{
+		items.push_back(d);
+		return index_last();
+	}
+	size_t push_back(const char* str) noexcept(false)
+	{
+		items.push_back(str);
+		return index_last();
+	}
+	size_t push_back(const std::string& str)
+	{
+		return push_back(str.c_str());
+	}
+
+	// Candidate lookup
+private:
+	bool collect(unsigned long bs, const char* s, size_t len, posting_list& out) const
+	{
+		if (len < substr_size)
+			return false;
+		auto bucket = buckets.find(bs);
+		if (bucket == buckets.end())
+			return true;
+		const gram_map& grams = bucket->second;
+		return for_each_gram(s, len, [&](gram_type g) {
+			const compressed_posting_list* postings = grams.find(g);
+			if (postings)
+				postings->decode_append(out);
+		});
+	}
+public:
+	// Indices of digests which may score nonzero against the query (sorted)
+	void candidates(const view_type& query, posting_list& out) const
+	{
+		#ifdef FFUZZYPP_DEBUG
+		assert(query.is_valid() && query.is_normalized());
+		#endif
+		out.clear();
+		digest_blocksize_t bs = digest_blocksize_t(query.blocksize());
+		bool indexed = collect(bs, query.blockhash1(), query.blockhash1_len(), out);
+		if (digest_blocksize::is_safe_to_double(bs))
+			indexed |= collect(2ul * bs, query.blockhash2(), query.blockhash2_len(), out);
+		if (!indexed)
+		{
+			// Identical digests are not indexed either
+			auto entry = unindexed.find(query.hash());
+			if (entry != unindexed.end())
+				for (size_t i : entry->second)
+					if (view_type::is_eq(query, items.view(i)))
+						out.push_back(i);
+		}
+		std::sort(out.begin(), out.end());
+		out.erase(std::unique(out.begin(), out.end()), out.end());
+	}
+	posting_list candidates(const view_type& query) const
+	{
+		posting_list out;
+		candidates(query, out);
+		return out;
+	}
+
+	// Search
+private:
+	static bool is_better(const digest_search_result& a, const digest_search_result& b) noexcept
+	{
+		return a.score > b.score || (a.score == b.score && a.index < b.index);
+	}
+public:
+	/*
+		Search all digests with the score of min_score or greater (and nonzero).
+		Results are sorted by the score (descending) and then by the index (ascending).
+	*/
+	void search(
+		const view_type& query,
+		std::vector<digest_search_result>& results,
+		digest_comparison_score_t min_score = 1
+	) const
+	{
+		results.clear();
+		if (min_score == 0)
+			min_score = 1;
+		posting_list cands;
+		candidates(query, cands);
+		if (cands.empty())
+			return;
+		query_type q(query);
+		for (size_t i : cands)
+		{
+			digest_comparison_score_t score = q.compare_threshold(items, i, min_score);
+			if (score)
+				results.push_back(digest_search_result{ i, score });
+		}
+		std::sort(results.begin(), results.end(), is_better);
+	}
+	std::vector<digest_search_result> search(
+		const view_type& query,
+		digest_comparison_score_t min_score = 1
+	) const
+	{
+		std::vector<digest_search_result> results;
+		search(query, results, min_score);
+		return results;
+	}
+	// Same as search but only k best results are returned
+	std::vector<digest_search_result> search_top_k(
+		const view_type& query,
+		size_t k,
+		digest_comparison_score_t min_score = 1
+	) const
+	{
+		std::vector<digest_search_result> results;
+		search(query, results, min_score);
+		if (results.size() > k)
+			results.resize(k);
+		return results;
+	}
+};
+
+template <bool IsAlphabetRestricted, comparison_version Version>
+constexpr const typename digest_index<IsAlphabetRestricted, Version>::gram_type
+	digest_index<IsAlphabetRestricted, Version>::gram_mask;
+
+typedef digest_index< true> digest_index_t;
+typedef digest_index<false> digest_index_non_ra_t;
+
+}
+
+#endif
@@ -0,0 +1,289 @@
+/*
+
+	ffuzzy++ : C++ implementation of fast fuzzy hashing
+
+	digest_intern.hpp
+	Interning table of identical digests
+
+	Copyright (C) 2026 Tsukasa OI <floss_ssdeep@irq.a4lg.com>
+
+
+	Permission to use, copy, modify, and/or distribute this software for
+	any purpose with or without fee is hereby granted, provided that the
+	above copyright notice and this permission notice appear in all copies.
+
+	THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+	WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+	MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+	ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+	WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+	ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+	OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+
+*/
+#ifndef FFUZZYPP_DIGEST_INTERN_HPP
+#define FFUZZYPP_DIGEST_INTERN_HPP
+
+#include <cassert>
+#include <cstddef>
+
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "digest_base.hpp"
+#include "digest_comparison.hpp"
+#include "digest_store.hpp"
+#include "digest_all_pairs.hpp"
+
+namespace ffuzzy {
+
+/*
+	Interning table of identical digests
+
+	Each inserted digest is mapped to the canonical ID of the
+	first identical digest (keyed by digest_data::hash and equality).
+	Unique digests are numbered from zero in the order of first
+	appearance and the number of identical copies is counted.
+
+	Comparisons can be performed once per unique digest and
+	the results are expanded to all inserted digests
+	(see expand_pair and all_pairs).
+*/
+template <bool IsAlphabetRestricted, bool IsShort = false>
+class digest_intern_table
+{
+public:
+	static constexpr const bool is_alphabet_restricted = IsAlphabetRestricted;
+	static constexpr const bool is_short = IsShort;
+	typedef digest_base<IsAlphabetRestricted, IsShort, true> digest_type;
+	static constexpr const size_t npos = std::numeric_limits<size_t>::max();
+
+	// Data structure
+private:
+	// Unique digests (indexed by canonical ID)
+	std::vector<digest_type> uniques;
+	std::vector<size_t> hashes;
+	std::vector<size_t> counts;
+	std::vector<size_t> first_members;
+	std::vector<size_t> last_members;
+	// Inserted digests (canonical ID and the next member with the same ID)
+	std::vector<size_t> ids;
+	std::vector<size_t> next_members;
+	// Open-addressed hash table of canonical IDs (npos if empty)
+	std::vector<size_t> table;
+public:
+	// Number of unique digests
+	size_t size(void) const noexcept { return uniques.size(); }
+	// Number of inserted digests
+	size_t total(void) const noexcept { return ids.size(); }
+	bool empty(void) const noexcept { return ids.empty(); }
+	void clear(void) noexcept
+	{
+		uniques.clear();
+		hashes.clear();
+		counts.clear();
+		first_members.clear();
+		last_members.clear();
+		ids.clear();
+		next_members.clear();
+		table.clear();
+	}
+
+	// Accessors
+public:
+	const digest_type& get(size_t id) const noexcept
+	{
+		#ifdef FFUZZYPP_DEBUG
+		assert(id < size());
+		#endif
+		return uniques[id];
+	}
+	size_t multiplicity(size_t id) const noexcept
+	{
+		#ifdef FFUZZYPP_DEBUG
+		assert(id < size());
+		#endif
+		return counts[id];
+	}
+	// Canonical ID of the n-th inserted digest
+	size_t canonical_id(size_t n) const noexcept
+	{
+		#ifdef FFUZZYPP_DEBUG
+		assert(n < total());
+		#endif
+		return ids[n];
+	}
+	// Iterate over inserted digests identical to the unique digest (in insertion order)
+	template <typename TCallback>
+	void for_each_member(size_t id, TCallback&& callback) const
+	{
+		#ifdef FFUZZYPP_DEBUG
+		assert(id < size());
+		#endif
+		for (size_t n = first_members[id]; n != npos; n = next_members[n])
+			callback(n);
+	}
+
+	// Lookup and insertion
+private:
+	size_t slot_mask(void) const noexcept { return table.size() - 1; }
+	size_t find_slot(const digest_type& d, size_t h) const noexcept
+	{
+		size_t k = h & slot_mask();
+		while (table[k] != npos)
+		{
+			size_t id = table[k];
+			if (hashes[id] == h && uniques[id] == d)
+				break;
+			k = (k + 1) & slot_mask();
+		}
+		return k;
+	}
+	void rehash(size_t new_size)
+	{
+		table.assign(new_size, npos);
+		for (size_t id = 0; id < uniques.size(); id++)
+		{
+			size_t k = hashes[id] & slot_mask();
+			while (table[k] != npos)
+				k = (k + 1) & slot_mask();
+			table[k] = id;
+		}
+	}
+public:
+	size_t find(const digest_type& d) const noexcept
+	{
+		if (table.empty())
+			return npos;
+		return table[find_slot(d, d.hash())];
+	}
+	// Insert a digest and return its canonical ID
+	size_t insert(const digest_type& d)
+	{
+		#ifdef FFUZZYPP_DEBUG
+		assert(d.is_valid());
+		#endif
+		// keep load factor at most 1/2
+		if ((uniques.size() + 1) * 2 > table.size())
+			rehash(table.empty() ? 16 : table.size() * 2);
+		size_t h = d.hash();
+		size_t k = find_slot(d, h);
+		size_t id = table[k];
+		size_t n = ids.size();
+		if (id == npos)
+		{
+			id = uniques.size();
+			uniques.push_back(d);
+			hashes.push_back(h);
+			counts.push_back(0);
+			first_members.push_back(n);
+			last_members.push_back(npos);
+			table[k] = id;
+		}
+		else
+			next_members[last_members[id]] = n;
+		counts[id]++;
+		last_members[id] = n;
+		ids.push_back(id);
+		next_members.push_back(npos);
+		return id;
+	}
+	size_t insert(const char* str) noexcept(false)
+	{
+		return insert(digest_type(str));
+	}
+	size_t insert(const std::string& str)
+	{
+		return insert(str.c_str());
+	}
+
+	// Expansion of comparison results
+public:
+	/*
+		Expand the result of comparison between unique digests a and b
+		(a != b) to callback(n, m, score) for all inserted digests n and m
+		(n < m) identical to a or b.
+	*/
+	template <typename TCallback>
+	void expand_pair(
+		size_t a, size_t b,
+		digest_comparison_score_t score,
+		TCallback&& callback
+	) const
+	{
+		#ifdef FFUZZYPP_DEBUG
+		assert(a < size() && b < size() && a != b);
+		#endif
+		for (size_t n = first_members[a]; n != npos; n = next_members[n])
+			for (size_t m = first_members[b]; m != npos; m = next_members[m])
+			{
+				if (n < m)
+					callback(n, m, score);
+				else
+					callback(m, n, score);
+			}
+	}
+	/*
+		Expand the result of comparison of the unique digest a against
+		itself to callback(n, m, score) for all pairs of inserted digests
+		identical to a (n < m).
+	*/
+	template <typename TCallback>
+	void expand_self(
+		size_t a,
+		digest_comparison_score_t score,
+		TCallback&& callback
+	) const
+	{
+		#ifdef FFUZZYPP_DEBUG
+		assert(a < size());
+		#endif
+		for (size_t n = first_members[a]; n != npos; n = next_members[n])
+			for (size_t m = next_members[n]; m != npos; m = next_members[m])
+				callback(n, m, score);
+	}
+
+	// All-pairs comparison (once per unique digest)
+public:
+	// Append unique digests to the store (the store index is base + canonical ID)
+	void copy_to(digest_store<IsAlphabetRestricted>& store) const
+	{
+		store.reserve(store.size() + uniques.size());
+		for (const auto& d : uniques)
+			store.push_back(d);
+	}
+	/*
+		Compare all pairs of inserted digests and call callback(n, m, score)
+		(n < m) if the score is equal to or greater than min_score
+		(identical digests are compared only once).
+	*/
+	template <comparison_version Version = comparison_version::latest, typename TCallback>
+	void all_pairs(digest_comparison_score_t min_score, TCallback&& callback) const
+	{
+		if (!min_score)
+			min_score = 1;
+		for (size_t id = 0; id < uniques.size(); id++)
+		{
+			if (counts[id] < 2)
+				continue;
+			digest_comparison_score_t score = digest_comparison<Version>::compare(uniques[id], uniques[id]);
+			if (score >= min_score)
+				expand_self(id, score, callback);
+		}
+		digest_store<IsAlphabetRestricted> store;
+		copy_to(store);
+		digest_all_pairs<IsAlphabetRestricted, Version>(store).run(min_score,
+			[this, &callback](size_t a, size_t b, digest_comparison_score_t score)
+			{
+				expand_pair(a, b, score, callback);
+			});
+	}
+};
+
+template <bool IsAlphabetRestricted, bool IsShort>
+constexpr const size_t digest_intern_table<IsAlphabetRestricted, IsShort>::npos;
+
+}
+
+#endif
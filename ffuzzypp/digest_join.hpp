@@ -0,0 +1,366 @@
+/*
+
+	ffuzzy++ : C++ implementation of fast fuzzy hashing
+
+	digest_join.hpp
+	Set-versus-set similarity join
+
+	Copyright (C) 2026 Tsukasa OI <floss_ssdeep@irq.a4lg.com>
+
+
+	Permission to use, copy, modify, and/or distribute this software for
+	any purpose with or without fee is hereby granted, provided that the
+	above copyright notice and this permission notice appear in all copies.
+
+	THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+	WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+	MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+	ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+	WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+	ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+	OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+
+*/
+#ifndef FFUZZYPP_DIGEST_JOIN_HPP
+#define FFUZZYPP_DIGEST_JOIN_HPP
+
+#include <cassert>
+#include <cstddef>
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include "digest_blocksize.hpp"
+#include "digest_comparison.hpp"
+#include "digest_query.hpp"
+#include "digest_store.hpp"
+#include "digest_view.hpp"
+
+namespace ffuzzy {
+
+class digest_join_params
+{
+private:
+	digest_join_params(void) = delete;
+	digest_join_params(const digest_join_params&) = delete;
+public:
+	// Number of compiled queries (right side) per work unit
+	static constexpr const size_t query_tile_size = 16;
+	// Number of candidates (left side) compared against a query tile at once
+	static constexpr const size_t candidate_tile_size = 128;
+	static_assert(query_tile_size != 0, "query_tile_size must not be zero.");
+	static_assert(candidate_tile_size != 0, "candidate_tile_size must not be zero.");
+};
+
+struct digest_join_result
+{
+	size_t left;
+	size_t right;
+	digest_comparison_score_t score;
+};
+
+/*
+	Set-versus-set similarity join
+
+	The left side is a digest_store (e.g. a large list of known
+	digests) which is grouped by block size once on construction.
+	The right side is any random access source of digest views
+	(an object with size() and view(i) returning digest_view;
+	digest_store or a view list over memory-mapped data)
+	and may be changed on every run.
+
+	For each block size of the right side, only left buckets with
+	the same, doubled or halved block size (the only ones where
+	digest_blocksize::is_near can hold) are compared.
+	The work is split into tiles of right-side queries (compiled as
+	digest_query objects) and distributed to worker threads.
+
+	Pairs are reported as callback(left, right, score) if the score
+	is equal to or greater than the threshold.  The callback is
+	invoked from worker threads but never concurrently (calls are
+	serialized by an internal lock).  The order of results is not
+	specified if more than one thread is used.
+
+	The left store and the right source must not be modified
+	while running the join.
+*/
+template <bool IsAlphabetRestricted, comparison_version Version = comparison_version::latest>
+class digest_join
+{
+public:
+	static constexpr const bool is_alphabet_restricted = IsAlphabetRestricted;
+	typedef digest_store<IsAlphabetRestricted> store_type;
+	typedef digest_query<IsAlphabetRestricted, Version> query_type;
+	typedef digest_view<IsAlphabetRestricted> view_type;
+
+	// Bucket of digests with the same block size (order[begin..end))
+	struct bucket
+	{
+		digest_blocksize_t blocksize;
+		size_t begin;
+		size_t end;
+	};
+
+	// Data structure (left side)
+private:
+	const store_type* left;
+	std::vector<size_t> left_order;
+	std::vector<bucket> left_buckets;
+public:
+	const store_type& left_store(void) const noexcept { return *left; }
+	const std::vector<size_t>& sorted_left_indices(void) const noexcept { return left_order; }
+	const std::vector<bucket>& left_bucket_list(void) const noexcept { return left_buckets; }
+
+	// Bucketing
+private:
+	template <typename TBlocksizeOf>
+	static void make_buckets(
+		size_t n, TBlocksizeOf blocksize_of,
+		std::vector<size_t>& order, std::vector<bucket>& buckets
+	)
+	{
+		order.resize(n);
+		for (size_t i = 0; i < n; i++)
+			order[i] = i;
+		std::sort(order.begin(), order.end(),
+			[&blocksize_of](size_t a, size_t b)
+			{
+				digest_blocksize_t ba = blocksize_of(a), bb = blocksize_of(b);
+				return ba != bb ? ba < bb : a < b;
+			});
+		buckets.clear();
+		for (size_t k = 0; k < n; )
+		{
+			digest_blocksize_t bs = blocksize_of(order[k]);
+			size_t e = k + 1;
+			while (e < n && blocksize_of(order[e]) == bs)
+				e++;
+			buckets.push_back(bucket{ bs, k, e });
+			k = e;
+		}
+	}
+	// Index of the left bucket with given block size (or left_buckets.size() if not found)
+	size_t find_left_bucket(digest_blocksize_t bs) const noexcept
+	{
+		auto it = std::lower_bound(left_buckets.begin(), left_buckets.end(), bs,
+			[](const bucket& x, digest_blocksize_t v) { return x.blocksize < v; });
+		if (it == left_buckets.end() || it->blocksize != bs)
+			return left_buckets.size();
+		return size_t(it - left_buckets.begin());
+	}
+
+	// Construction (the store must not be modified while this object is in use)
+public:
+	explicit digest_join(const store_type& st)
+		: left(&st)
+	{
+		make_buckets(st.size(),
+			[&st](size_t i) { return st.blocksize(i); },
+			left_order, left_buckets);
+	}
+
+	// Work units (a tile of right-side queries with the same block size)
+private:
+	struct work_unit
+	{
+		size_t begin; // range of the sorted right indices
+		size_t end;
+		size_t near_buckets[3]; // left buckets to compare (eq, double, half)
+		size_t near_count;
+	};
+	template <typename TSource>
+	std::vector<work_unit> make_work_units(
+		const TSource& right,
+		std::vector<size_t>& right_order
+	) const
+	{
+		static constexpr const size_t qtile = digest_join_params::query_tile_size;
+		std::vector<bucket> right_buckets;
+		make_buckets(right.size(),
+			[&right](size_t i) { return digest_blocksize_t(right.view(i).blocksize()); },
+			right_order, right_buckets);
+		std::vector<work_unit> units;
+		for (const bucket& rb : right_buckets)
+		{
+			work_unit u;
+			u.near_count = 0;
+			size_t lb = find_left_bucket(rb.blocksize);
+			if (lb != left_buckets.size())
+				u.near_buckets[u.near_count++] = lb;
+			if (rb.blocksize != 0 && digest_blocksize::is_safe_to_double(rb.blocksize))
+			{
+				lb = find_left_bucket(rb.blocksize * 2);
+				if (lb != left_buckets.size())
+					u.near_buckets[u.near_count++] = lb;
+			}
+			if (rb.blocksize != 0 && rb.blocksize % 2 == 0)
+			{
+				lb = find_left_bucket(rb.blocksize / 2);
+				if (lb != left_buckets.size())
+					u.near_buckets[u.near_count++] = lb;
+			}
+			// Skip right buckets without any near left buckets
+			if (!u.near_count)
+				continue;
+			for (size_t q = rb.begin; q < rb.end; q += qtile)
+			{
+				u.begin = q;
+				u.end = std::min(q + qtile, rb.end);
+				units.push_back(u);
+			}
+		}
+		return units;
+	}
+
+	// Tiled kernel
+private:
+	template <typename TSource>
+	void run_unit(
+		const TSource& right,
+		const std::vector<size_t>& right_order,
+		const work_unit& u,
+		digest_comparison_score_t min_score,
+		std::vector<digest_join_result>& results
+	) const
+	{
+		static constexpr const size_t qtile = digest_join_params::query_tile_size;
+		static constexpr const size_t ctile = digest_join_params::candidate_tile_size;
+		query_type queries[qtile];
+		for (size_t q = u.begin; q < u.end; q++)
+			queries[q - u.begin].construct(view_type(right.view(right_order[q])));
+		for (size_t n = 0; n < u.near_count; n++)
+		{
+			const bucket& lb = left_buckets[u.near_buckets[n]];
+			for (size_t c = lb.begin; c < lb.end; c += ctile)
+			{
+				size_t cend = std::min(c + ctile, lb.end);
+				for (size_t q = u.begin; q < u.end; q++)
+				{
+					const query_type& query = queries[q - u.begin];
+					for (size_t k = c; k < cend; k++)
+					{
+						size_t j = left_order[k];
+						digest_comparison_score_t score = query.compare_threshold(*left, j, min_score);
+						if (score)
+							results.push_back(digest_join_result{ j, right_order[q], score });
+					}
+				}
+			}
+		}
+	}
+
+	// Join
+public:
+	/*
+		Compare all pairs between the left store and the right source
+		and call callback(left, right, score) for each pair with the
+		score of min_score or greater (min_score of zero is treated as 1).
+		If threads is zero, std::thread::hardware_concurrency() is used.
+		An exception thrown by the callback stops the join and is
+		rethrown from this function.
+	*/
+	template <typename TSource, typename TCallback>
+	void run(
+		const TSource& right,
+		digest_comparison_score_t min_score,
+		TCallback&& callback,
+		unsigned threads = 0
+	) const
+	{
+		if (!min_score)
+			min_score = 1;
+		std::vector<size_t> right_order;
+		std::vector<work_unit> units = make_work_units(right, right_order);
+		if (!threads)
+			threads = std::max(1u, std::thread::hardware_concurrency());
+		threads = unsigned(std::min(size_t(threads), std::max(size_t(1), units.size())));
+		if (threads == 1)
+		{
+			std::vector<digest_join_result> results;
+			for (const work_unit& u : units)
+			{
+				results.clear();
+				run_unit(right, right_order, u, min_score, results);
+				for (const digest_join_result& r : results)
+					callback(r.left, r.right, r.score);
+			}
+			return;
+		}
+		std::atomic<size_t> next_unit(0);
+		std::atomic<bool> is_aborted(false);
+		std::mutex callback_mutex;
+		std::exception_ptr error;
+		auto worker = [&](void)
+		{
+			std::vector<digest_join_result> results;
+			try
+			{
+				for (;;)
+				{
+					size_t k = next_unit.fetch_add(1, std::memory_order_relaxed);
+					if (k >= units.size() || is_aborted.load(std::memory_order_relaxed))
+						break;
+					results.clear();
+					run_unit(right, right_order, units[k], min_score, results);
+					if (results.empty())
+						continue;
+					std::lock_guard<std::mutex> lock(callback_mutex);
+					if (is_aborted.load(std::memory_order_relaxed))
+						break;
+					for (const digest_join_result& r : results)
+						callback(r.left, r.right, r.score);
+				}
+			}
+			catch (...)
+			{
+				std::lock_guard<std::mutex> lock(callback_mutex);
+				if (!error)
+					error = std::current_exception();
+				is_aborted.store(true, std::memory_order_relaxed);
+			}
+		};
+		std::vector<std::thread> pool;
+		pool.reserve(threads - 1);
+		for (unsigned t = 1; t < threads; t++)
+		{
+			// Continue with fewer threads if no more threads can be created
+			try { pool.emplace_back(worker); }
+			catch (const std::system_error&) { break; }
+		}
+		worker();
+		for (std::thread& th : pool)
+			th.join();
+		if (error)
+			std::rethrow_exception(error);
+	}
+	// Collect all results (sorted by left and right indices)
+	template <typename TSource>
+	std::vector<digest_join_result> collect(
+		const TSource& right,
+		digest_comparison_score_t min_score,
+		unsigned threads = 0
+	) const
+	{
+		std::vector<digest_join_result> results;
+		run(right, min_score,
+			[&results](size_t i, size_t j, digest_comparison_score_t score)
+			{
+				results.push_back(digest_join_result{ i, j, score });
+			}, threads);
+		std::sort(results.begin(), results.end(),
+			[](const digest_join_result& a, const digest_join_result& b)
+			{
+				return a.left != b.left ? a.left < b.left : a.right < b.right;
+			});
+		return results;
+	}
+};
+
+}
+
+#endif
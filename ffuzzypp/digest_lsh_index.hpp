@@ -0,0 +1,352 @@
+/*
+
+	ffuzzy++ : C++ implementation of fast fuzzy hashing
+
+	digest_lsh_index.hpp
+	MinHash/LSH approximate candidate index
+
+	Copyright (C) 2026 Tsukasa OI <floss_ssdeep@irq.a4lg.com>
+
+
+	Permission to use, copy, modify, and/or distribute this software for
+	any purpose with or without fee is hereby granted, provided that the
+	above copyright notice and this permission notice appear in all copies.
+
+	THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+	WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+	MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+	ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+	WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+	ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+	OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+
+*/
+#ifndef FFUZZYPP_DIGEST_LSH_INDEX_HPP
+#define FFUZZYPP_DIGEST_LSH_INDEX_HPP
+
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+#include <algorithm>
+#include <limits>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "digest_blocksize.hpp"
+#include "digest_base.hpp"
+#include "digest_comparison.hpp"
+#include "digest_index.hpp"
+#include "digest_posting_list.hpp"
+#include "digest_query.hpp"
+#include "digest_store.hpp"
+#include "digest_view.hpp"
+
+namespace ffuzzy {
+
+/*
+	Approximate candidate index by MinHash and LSH (locality-sensitive hashing)
+
+	For very large corpora, posting lists of common substrings in
+	digest_index get too long.  This index reduces each block hash to
+	a MinHash signature of its set of substrings (the same substrings
+	as digest_index) which consists of (bands * rows) minimum hash
+	values.  The signature is split into bands of rows values and each
+	band is indexed under the effective block size (the same as
+	digest_index).  So each block hash takes exactly `bands` posting
+	list entries regardless of its length.  Posting lists are compressed
+	and kept in open-addressed tables (see digest_posting_list.hpp) per
+	effective block size and band, as in digest_index.
+
+	Two block hashes share a band with the probability of
+	1 - (1 - J^rows)^bands where J is the Jaccard similarity of their
+	substring sets (see expected_recall).  More bands increase recall
+	(and the number of candidates); more rows make candidates more
+	similar.  Because block hashes are short and a few edits break many
+	substrings, single-row bands are the default.  Candidates are scored
+	exactly by digest_query.
+
+	Every result is also a result of digest_index (with the same score)
+	because sharing a band implies sharing a substring.  Identical
+	digests are always found.
+*/
+template <bool IsAlphabetRestricted, comparison_version Version = comparison_version::latest>
+class digest_lsh_index
+{
+public:
+	static constexpr const bool is_alphabet_restricted = IsAlphabetRestricted;
+	static constexpr const comparison_version version = Version;
+	static constexpr const size_t substr_size = blockhash_comparison_params::min_match_len;
+	static constexpr const unsigned default_bands = 24;
+	static constexpr const unsigned default_rows = 1;
+	typedef digest_store<IsAlphabetRestricted> store_type;
+	typedef digest_query<IsAlphabetRestricted, Version> query_type;
+	typedef digest_view<IsAlphabetRestricted> view_type;
+	typedef uint_least64_t hash_type;
+	typedef std::vector<size_t> posting_list;
+	typedef digest_posting_list compressed_posting_list;
+private:
+	typedef digest_index<IsAlphabetRestricted, Version> exact_index_type;
+
+	// Data structure
+private:
+	typedef digest_posting_table band_map;
+	static_assert(sizeof(hash_type) <= sizeof(band_map::key_type), "band hashes must fit in band_map keys.");
+	unsigned nbands;
+	unsigned nrows;
+	store_type items;
+	// Posting lists (keyed by effective block size, band and band hash)
+	std::unordered_map<unsigned long, std::vector<band_map>> buckets;
+	// Digests without indexed substrings (keyed by digest hash)
+	std::unordered_map<size_t, posting_list> unindexed;
+public:
+	explicit digest_lsh_index(unsigned bands = default_bands, unsigned rows = default_rows) noexcept
+		: nbands(bands), nrows(rows)
+	{
+		#ifdef FFUZZYPP_DEBUG
+		assert(bands != 0 && rows != 0);
+		#endif
+	}
+	unsigned bands(void) const noexcept { return nbands; }
+	unsigned rows(void) const noexcept { return nrows; }
+	size_t size(void) const noexcept { return items.size(); }
+	bool empty(void) const noexcept { return items.empty(); }
+	const store_type& store(void) const noexcept { return items; }
+	void clear(void) noexcept
+	{
+		items.clear();
+		buckets.clear();
+		unindexed.clear();
+	}
+	size_t posting_count(void) const noexcept
+	{
+		size_t n = 0;
+		for (const auto& bucket : buckets)
+			for (const band_map& band : bucket.second)
+				band.for_each([&](hash_type, const compressed_posting_list& postings) {
+					n += postings.size();
+				});
+		return n;
+	}
+	// Memory used by posting lists and their tables (in bytes)
+	size_t posting_memory_usage(void) const noexcept
+	{
+		size_t n = 0;
+		for (const auto& bucket : buckets)
+			for (const band_map& band : bucket.second)
+				n += band.memory_usage();
+		return n;
+	}
+
+	// Expected recall
+public:
+	// Probability that two block hashes with given Jaccard similarity share a band
+	double expected_recall(double similarity) const noexcept
+	{
+		return 1.0 - std::pow(1.0 - std::pow(similarity, double(nrows)), double(nbands));
+	}
+	// Similarity where the recall curve is the steepest (approximately)
+	double threshold(void) const noexcept
+	{
+		return std::pow(1.0 / double(nbands), 1.0 / double(nrows));
+	}
+
+	// MinHash
+private:
+	static hash_type mix(hash_type x) noexcept
+	{
+		// Finalizer of SplitMix64
+		x = (x ^ (x >> 30)) * hash_type(0xbf58476d1ce4e5b9ull);
+		x = (x ^ (x >> 27)) * hash_type(0x94d049bb133111ebull);
+		return x ^ (x >> 31);
+	}
+	// Computes band hashes of a block hash (false if it has no substrings)
+	bool band_hashes(const char* s, size_t len, std::vector<hash_type>& out) const
+	{
+		size_t n = size_t(nbands) * nrows;
+		std::vector<hash_type> sig(n, std::numeric_limits<hash_type>::max());
+		bool indexed = exact_index_type::for_each_gram(s, len, [&](typename exact_index_type::gram_type g) {
+			hash_type h = mix(hash_type(g));
+			for (size_t k = 0; k < n; k++)
+			{
+				// k-th hash function
+				hash_type v = mix(h + hash_type(k) * hash_type(0x9e3779b97f4a7c15ull));
+				if (v < sig[k])
+					sig[k] = v;
+			}
+		});
+		if (!indexed)
+			return false;
+		out.resize(nbands);
+		for (size_t b = 0; b < nbands; b++)
+		{
+			hash_type h = hash_type(b);
+			for (size_t r = 0; r < nrows; r++)
+				h = mix(h ^ sig[b * nrows + r]);
+			out[b] = h;
+		}
+		return true;
+	}
+
+	// Insertion
+private:
+	bool index_blockhash(unsigned long bs, const char* s, size_t len, size_t i)
+	{
+		std::vector<hash_type> hashes;
+		if (!band_hashes(s, len, hashes))
+			return false;
+		std::vector<band_map>& bands = buckets[bs];
+		bands.resize(nbands);
+		// block hashes 1 and 2 may share the effective block size
+		// (insert skips i if it is already the last posting)
+		for (size_t b = 0; b < nbands; b++)
+			bands[b].insert(hashes[b], i);
+		return true;
+	}
+	size_t index_last(void)
+	{
+		size_t i = items.size() - 1;
+		view_type v = items.view(i);
+		digest_blocksize_t bs = digest_blocksize_t(v.blocksize());
+		bool indexed = index_blockhash(bs, v.blockhash1(), v.blockhash1_len(), i);
+		if (digest_blocksize::is_safe_to_double(bs))
+			indexed |= index_blockhash(2ul * bs, v.blockhash2(), v.blockhash2_len(), i);
+		if (!indexed)
+			unindexed[v.hash()].push_back(i);
+		return i;
+	}
+public:
+	template <bool IsShort, bool IsNormalized>
+	size_t push_back(const digest_base<IsAlphabetRestricted, IsShort, IsNormalized>& d)
+	{
+		items.push_back(d);
+		return index_last();
+	}
+	size_t push_back(const view_type& d)
+	{
+		items.push_back(d);
+		return index_last();
+	}
+	size_t push_back(const char* str) noexcept(false)
+	{
+		items.push_back(str);
+		return index_last();
+	}
+	size_t push_back(const std::string& str)
+	{
+		return push_back(str.c_str());
+	}
+
+	// Candidate lookup
+private:
+	bool collect(unsigned long bs, const char* s, size_t len, posting_list& out) const
+	{
+		std::vector<hash_type> hashes;
+		if (!band_hashes(s, len, hashes))
+			return false;
+		auto bucket = buckets.find(bs);
+		if (bucket == buckets.end())
+			return true;
+		const std::vector<band_map>& bands = bucket->second;
+		for (size_t b = 0; b < nbands; b++)
+		{
+			const compressed_posting_list* postings = bands[b].find(hashes[b]);
+			if (postings)
+				postings->decode_append(out);
+		}
+		return true;
+	}
+public:
+	// Indices of digests sharing a band with the query (sorted)
+	void candidates(const view_type& query, posting_list& out) const
+	{
+		#ifdef FFUZZYPP_DEBUG
+		assert(query.is_valid() && query.is_normalized());
+		#endif
+		out.clear();
+		digest_blocksize_t bs = digest_blocksize_t(query.blocksize());
+		bool indexed = collect(bs, query.blockhash1(), query.blockhash1_len(), out);
+		if (digest_blocksize::is_safe_to_double(bs))
+			indexed |= collect(2ul * bs, query.blockhash2(), query.blockhash2_len(), out);
+		if (!indexed)
+		{
+			auto entry = unindexed.find(query.hash());
+			if (entry != unindexed.end())
+				for (size_t i : entry->second)
+					if (view_type::is_eq(query, items.view(i)))
+						out.push_back(i);
+		}
+		std::sort(out.begin(), out.end());
+		out.erase(std::unique(out.begin(), out.end()), out.end());
+	}
+	posting_list candidates(const view_type& query) const
+	{
+		posting_list out;
+		candidates(query, out);
+		return out;
+	}
+
+	// Search
+private:
+	static bool is_better(const digest_search_result& a, const digest_search_result& b) noexcept
+	{
+		return a.score > b.score || (a.score == b.score && a.index < b.index);
+	}
+public:
+	/*
+		Search candidates with the score of min_score or greater (and nonzero).
+		Results are sorted by the score (descending) and then by the index (ascending).
+	*/
+	void search(
+		const view_type& query,
+		std::vector<digest_search_result>& results,
+		digest_comparison_score_t min_score = 1
+	) const
+	{
+		results.clear();
+		if (min_score == 0)
+			min_score = 1;
+		posting_list cands;
+		candidates(query, cands);
+		if (cands.empty())
+			return;
+		query_type q(query);
+		for (size_t i : cands)
+		{
+			digest_comparison_score_t score = q.compare_threshold(items, i, min_score);
+			if (score)
+				results.push_back(digest_search_result{ i, score });
+		}
+		std::sort(results.begin(), results.end(), is_better);
+	}
+	std::vector<digest_search_result> search(
+		const view_type& query,
+		digest_comparison_score_t min_score = 1
+	) const
+	{
+		std::vector<digest_search_result> results;
+		search(query, results, min_score);
+		return results;
+	}
+	std::vector<digest_search_result> search_top_k(
+		const view_type& query,
+		size_t k,
+		digest_comparison_score_t min_score = 1
+	) const
+	{
+		std::vector<digest_search_result> results;
+		search(query, results, min_score);
+		if (results.size() > k)
+			results.resize(k);
+		return results;
+	}
+};
+
+typedef digest_lsh_index< true> digest_lsh_index_t;
+typedef digest_lsh_index<false> digest_lsh_index_non_ra_t;
+
+}
+
+#endif
@@ -0,0 +1,896 @@
+/*
+
+	ffuzzy++ : C++ implementation of fast fuzzy hashing
+
+	digest_lsm_index.hpp
+	Log-structured (tiered) on-disk index
+
+	Copyright (C) 2026 Tsukasa OI <floss_ssdeep@irq.a4lg.com>
+
+
+	Permission to use, copy, modify, and/or distribute this software for
+	any purpose with or without fee is hereby granted, provided that the
+	above copyright notice and this permission notice appear in all copies.
+
+	THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+	WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+	MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+	ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+	WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+	ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+	OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+
+*/
+#ifndef FFUZZYPP_DIGEST_LSM_INDEX_HPP
+#define FFUZZYPP_DIGEST_LSM_INDEX_HPP
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <unordered_set>
+#include <vector>
+
+#include "digest_base.hpp"
+#include "digest_comparison.hpp"
+#include "digest_index.hpp"
+#include "digest_query.hpp"
+#include "digest_snapshot.hpp"
+#include "digest_view.hpp"
+#include "utils/mapped_file.hpp"
+
+// fsync is available on POSIX systems only
+#ifndef FFUZZYPP_DISABLE_FSYNC
+#if !(defined(__unix__) || defined(__unix) || (defined(__APPLE__) && defined(__MACH__)))
+#define FFUZZYPP_DISABLE_FSYNC 1
+#endif
+#endif
+
+#ifndef FFUZZYPP_DISABLE_FSYNC
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace ffuzzy {
+
+// Thrown when index files cannot be read or written
+struct digest_lsm_io_error {};
+
+// Runtime options of digest_lsm_index
+struct digest_lsm_options
+{
+	// Number of digests in the memtable which triggers a flush
+	size_t memtable_limit;
+	// Number of digests in the active memtable segment (searched with the state locked)
+	size_t memtable_segment_size;
+	// Number of runs in a tier which triggers merging them into the next tier
+	size_t tier_fanout;
+	// Compact in a background thread (otherwise, in the thread which flushed)
+	bool background_compaction;
+	digest_lsm_options(void) noexcept
+		: memtable_limit(4096), memtable_segment_size(256), tier_fanout(4), background_compaction(false) {}
+};
+
+// Statistics of digest_lsm_index
+struct digest_lsm_stats
+{
+	uint_least64_t inserted;
+	uint_least64_t erased;
+	uint_least64_t flushes;
+	uint_least64_t compactions;
+	// Background compactions failed by errors (retried on the next request)
+	uint_least64_t compaction_failures;
+	uint_least64_t bytes_flushed;
+	uint_least64_t bytes_compacted;
+	uint_least64_t queries;
+	uint_least64_t query_nanoseconds;
+	uint_least64_t max_query_nanoseconds;
+	size_t runs;
+	size_t memtable_size;
+	// Bytes written to runs per byte flushed from the memtable
+	double write_amplification(void) const noexcept
+	{
+		return bytes_flushed ? double(bytes_flushed + bytes_compacted) / double(bytes_flushed) : 0.0;
+	}
+	double mean_query_microseconds(void) const noexcept
+	{
+		return queries ? double(query_nanoseconds) / double(queries) / 1000.0 : 0.0;
+	}
+};
+
+
+namespace internal
+{
+	class digest_lsm_files
+	{
+	private:
+		digest_lsm_files(void) = delete;
+		digest_lsm_files(const digest_lsm_files&) = delete;
+	public:
+		// Writes the whole file and syncs it to the disk
+		static void write(const std::string& path, const void* data, size_t size) noexcept(false)
+		{
+			FILE* fp = fopen(path.c_str(), "wb");
+			if (!fp)
+				throw digest_lsm_io_error();
+			bool ok = fwrite(data, 1, size, fp) == size && fflush(fp) == 0;
+			#ifndef FFUZZYPP_DISABLE_FSYNC
+			ok = ok && fsync(fileno(fp)) == 0;
+			#endif
+			if (fclose(fp) != 0 || !ok)
+				throw digest_lsm_io_error();
+		}
+		// Syncs directory entries (created and renamed files) to the disk
+		static void sync_directory(const std::string& path) noexcept(false)
+		{
+			#ifndef FFUZZYPP_DISABLE_FSYNC
+			int fd = ::open(path.c_str(), O_RDONLY);
+			if (fd < 0)
+				throw digest_lsm_io_error();
+			bool ok = fsync(fd) == 0;
+			if (::close(fd) != 0 || !ok)
+				throw digest_lsm_io_error();
+			#else
+			(void)path;
+			#endif
+		}
+		// Reads the whole file into 8-byte aligned storage
+		static std::vector<uint64_t> read(const std::string& path, size_t& size) noexcept(false)
+		{
+			FILE* fp = fopen(path.c_str(), "rb");
+			if (!fp)
+				throw digest_lsm_io_error();
+			std::vector<uint64_t> buf;
+			size = 0;
+			while (true)
+			{
+				buf.resize(size / sizeof(uint64_t) + 4096);
+				size_t avail = buf.size() * sizeof(uint64_t) - size;
+				size_t n = fread(reinterpret_cast<unsigned char*>(buf.data()) + size, 1, avail, fp);
+				size += n;
+				if (n < avail)
+					break;
+			}
+			bool ok = !ferror(fp);
+			fclose(fp);
+			if (!ok)
+				throw digest_lsm_io_error();
+			buf.resize((size + sizeof(uint64_t) - 1) / sizeof(uint64_t));
+			return buf;
+		}
+	};
+
+	/*
+		Immutable on-disk run
+		(snapshot of the index and global IDs of its digests in ascending order)
+	*/
+	template <bool IsAlphabetRestricted, comparison_version Version>
+	class digest_lsm_run
+	{
+	public:
+		typedef digest_snapshot<IsAlphabetRestricted, Version> snapshot_type;
+		typedef digest_index<IsAlphabetRestricted, Version> index_type;
+	private:
+		#ifndef FFUZZYPP_DISABLE_MAPPED_FILE
+		mapped_file file;
+		#else
+		std::vector<uint64_t> buffer;
+		#endif
+		snapshot_type snap;
+		std::vector<uint64_t> id_list;
+		uint_least64_t seq;
+		unsigned lvl;
+		uint_least64_t nbytes;
+	public:
+		const snapshot_type& snapshot(void) const noexcept { return snap; }
+		const std::vector<uint64_t>& ids(void) const noexcept { return id_list; }
+		uint_least64_t sequence(void) const noexcept { return seq; }
+		unsigned level(void) const noexcept { return lvl; }
+		uint_least64_t bytes(void) const noexcept { return nbytes; }
+		bool contains(uint64_t id) const noexcept
+		{
+			return std::binary_search(id_list.begin(), id_list.end(), id);
+		}
+	public:
+		static std::string snapshot_path(const std::string& dir, uint_least64_t seq)
+		{
+			return dir + "/run-" + std::to_string(seq) + ".snap";
+		}
+		static std::string ids_path(const std::string& dir, uint_least64_t seq)
+		{
+			return dir + "/run-" + std::to_string(seq) + ".ids";
+		}
+		// Writes the run files and returns the number of bytes written
+		static uint_least64_t write(
+			const std::string& dir, uint_least64_t seq,
+			const index_type& index, const std::vector<uint64_t>& ids
+		) noexcept(false)
+		{
+			#ifdef FFUZZYPP_DEBUG
+			assert(index.size() == ids.size());
+			assert(std::is_sorted(ids.begin(), ids.end()));
+			#endif
+			std::vector<unsigned char> buf;
+			snapshot_type::write(index, buf);
+			digest_lsm_files::write(snapshot_path(dir, seq), buf.data(), buf.size());
+			digest_lsm_files::write(ids_path(dir, seq), ids.data(), ids.size() * sizeof(uint64_t));
+			return buf.size() + ids.size() * sizeof(uint64_t);
+		}
+		void remove(const std::string& dir) const noexcept
+		{
+			std::remove(snapshot_path(dir, seq).c_str());
+			std::remove(ids_path(dir, seq).c_str());
+		}
+		digest_lsm_run(const std::string& dir, uint_least64_t sequence, unsigned level) noexcept(false)
+			: seq(sequence), lvl(level)
+		{
+			std::string path = snapshot_path(dir, seq);
+			size_t size;
+			#ifndef FFUZZYPP_DISABLE_MAPPED_FILE
+			if (!file.open(path.c_str()))
+				throw digest_lsm_io_error();
+			size = file.size();
+			const void* data = file.data();
+			#else
+			buffer = digest_lsm_files::read(path, size);
+			const void* data = buffer.data();
+			#endif
+			if (!snap.open(data, size) || !snap.verify())
+				throw digest_lsm_io_error();
+			size_t idsize;
+			id_list = digest_lsm_files::read(ids_path(dir, seq), idsize);
+			if (idsize != snap.size() * sizeof(uint64_t))
+				throw digest_lsm_io_error();
+			id_list.resize(snap.size());
+			nbytes = size + idsize;
+		}
+		digest_lsm_run(const digest_lsm_run&) = delete;
+		digest_lsm_run& operator=(const digest_lsm_run&) = delete;
+	};
+}
+
+
+/*
+	Log-structured (tiered) digest index on disk
+
+	New digests go into the memtable (digest_index) and are numbered
+	with global IDs in the order of insertion.  When the memtable gets
+	full, it is flushed into an immutable run (digest_snapshot file,
+	whose posting lists are sorted by effective block size, and the
+	list of global IDs) of tier 0.  When a tier has tier_fanout runs,
+	they are merged into one run of the next tier (size-tiered
+	compaction, optionally in a background thread).
+
+	Deletion adds a tombstone (global ID).  Deleted digests are hidden
+	from searches and physically dropped (with their tombstones) when
+	their run is merged or the memtable is flushed.
+
+	A search fans out to the memtable and all runs and merges results.
+	Searches and compaction run concurrently (runs are shared through
+	reference-counted pointers and removed files stay readable while
+	mapped).
+
+	The list of runs and tombstones is kept in the MANIFEST file in the
+	directory (which must exist) and replaced atomically.  Run files and
+	the new MANIFEST are synced before the rename and the directory is
+	synced after it.  There is no write-ahead log: digests in the
+	memtable are lost unless flushed.
+
+	The memtable consists of immutable segments and the active one.
+	When the active segment gets memtable_segment_size digests, it is
+	sealed.  Searches lock the state only to take the list of segments
+	(and runs) and to search the active segment.  A flush moves sealed
+	segments aside (where searches still see them), writes their run
+	without locking the state and then publishes the run.
+*/
+template <bool IsAlphabetRestricted, comparison_version Version = comparison_version::latest>
+class digest_lsm_index
+{
+public:
+	static constexpr const bool is_alphabet_restricted = IsAlphabetRestricted;
+	static constexpr const comparison_version version = Version;
+	typedef digest_view<IsAlphabetRestricted> view_type;
+	typedef digest_index<IsAlphabetRestricted, Version> index_type;
+private:
+	typedef internal::digest_lsm_run<IsAlphabetRestricted, Version> run_type;
+	typedef std::shared_ptr<const run_type> run_ptr;
+	typedef std::unordered_set<uint64_t> tombstone_set;
+	typedef std::shared_ptr<const tombstone_set> tombstone_ptr;
+
+	// Data structure
+private:
+	const std::string dir;
+	const digest_lsm_options opts;
+	// Sealed memtable segment (immutable; searched without locks)
+	struct frozen_memtable
+	{
+		index_type index;
+		std::vector<uint64_t> ids;
+	};
+	typedef std::shared_ptr<const frozen_memtable> frozen_ptr;
+	// Protects everything below (except atomic counters)
+	mutable std::mutex state_mutex;
+	// Active memtable segment
+	index_type memtable;
+	std::vector<uint64_t> memtable_ids;
+	// Sealed memtable segments (older ones first)
+	std::vector<frozen_ptr> sealed;
+	// Number of digests in the active and sealed segments
+	size_t memtable_count;
+	// Segments being flushed (searched until their run is published)
+	std::vector<frozen_ptr> flushing;
+	std::vector<run_ptr> runs;
+	tombstone_ptr tombstones; // copy-on-write
+	uint_least64_t next_id;
+	uint_least64_t next_seq;
+	digest_lsm_stats counters;
+	// Query statistics (updated without locks)
+	mutable std::atomic<uint_least64_t> queries;
+	mutable std::atomic<uint_least64_t> query_ns;
+	mutable std::atomic<uint_least64_t> max_query_ns;
+	// Flush (one at a time)
+	std::mutex flush_mutex;
+	// Compaction (one at a time)
+	std::mutex compaction_mutex;
+	std::mutex worker_mutex;
+	std::condition_variable worker_cv;
+	bool worker_stopping;
+	bool worker_requested;
+	bool worker_busy;
+	std::thread worker;
+
+	// Manifest
+private:
+	std::string manifest_path(void) const { return dir + "/MANIFEST"; }
+	// (state_mutex must be held)
+	void write_manifest(void) noexcept(false)
+	{
+		std::string s = "ffuzzypp-lsm 1\n";
+		s += "next_id " + std::to_string(next_id) + "\n";
+		s += "next_seq " + std::to_string(next_seq) + "\n";
+		for (const run_ptr& r : runs)
+			s += "run " + std::to_string(r->sequence()) + " " + std::to_string(r->level()) + "\n";
+		for (uint64_t id : *tombstones)
+			s += "tombstone " + std::to_string(id) + "\n";
+		std::string tmp = manifest_path() + ".tmp";
+		internal::digest_lsm_files::write(tmp, s.data(), s.size());
+		if (std::rename(tmp.c_str(), manifest_path().c_str()) != 0)
+			throw digest_lsm_io_error();
+		// (also makes new run files in the directory durable)
+		internal::digest_lsm_files::sync_directory(dir);
+	}
+	void read_manifest(void) noexcept(false)
+	{
+		FILE* fp = fopen(manifest_path().c_str(), "rb");
+		if (!fp)
+			return; // new index
+		char key[32];
+		unsigned long long a, b;
+		tombstone_set ts;
+		if (fscanf(fp, "%31s %llu", key, &a) != 2 || std::string(key) != "ffuzzypp-lsm" || a != 1)
+		{
+			fclose(fp);
+			throw digest_lsm_io_error();
+		}
+		bool ok = true;
+		while (ok && fscanf(fp, "%31s %llu", key, &a) == 2)
+		{
+			std::string k(key);
+			if (k == "next_id")
+				next_id = a;
+			else if (k == "next_seq")
+				next_seq = a;
+			else if (k == "tombstone")
+				ts.insert(a);
+			else if (k == "run" && fscanf(fp, "%llu", &b) == 1)
+			{
+				try { runs.push_back(run_ptr(new run_type(dir, a, unsigned(b)))); }
+				catch (...) { ok = false; }
+			}
+			else
+				ok = false;
+		}
+		ok = ok && !ferror(fp);
+		fclose(fp);
+		if (!ok)
+			throw digest_lsm_io_error();
+		// Tombstones of lost (unflushed) digests are no longer needed.
+		std::shared_ptr<tombstone_set> live = std::make_shared<tombstone_set>();
+		for (uint64_t id : ts)
+			for (const run_ptr& r : runs)
+				if (r->contains(id))
+				{
+					live->insert(id);
+					break;
+				}
+		tombstones = live;
+	}
+
+	// Construction
+public:
+	explicit digest_lsm_index(
+		const std::string& directory,
+		const digest_lsm_options& options = digest_lsm_options()
+	) noexcept(false)
+		: dir(directory)
+		, opts(options)
+		, memtable_count(0)
+		, tombstones(std::make_shared<const tombstone_set>())
+		, next_id(0)
+		, next_seq(0)
+		, counters()
+		, queries(0)
+		, query_ns(0)
+		, max_query_ns(0)
+		, worker_stopping(false)
+		, worker_requested(false)
+		, worker_busy(false)
+	{
+		#ifdef FFUZZYPP_DEBUG
+		assert(opts.memtable_limit != 0);
+		assert(opts.memtable_segment_size != 0);
+		assert(opts.tier_fanout >= 2);
+		#endif
+		read_manifest();
+		if (opts.background_compaction)
+			worker = std::thread([this] { worker_main(); });
+	}
+	digest_lsm_index(const digest_lsm_index&) = delete;
+	digest_lsm_index& operator=(const digest_lsm_index&) = delete;
+	~digest_lsm_index(void)
+	{
+		if (worker.joinable())
+		{
+			{
+				std::lock_guard<std::mutex> lock(worker_mutex);
+				worker_stopping = true;
+			}
+			worker_cv.notify_all();
+			worker.join();
+		}
+	}
+
+	// Statistics
+public:
+	digest_lsm_stats stats(void) const
+	{
+		std::lock_guard<std::mutex> lock(state_mutex);
+		digest_lsm_stats s = counters;
+		s.queries = queries.load();
+		s.query_nanoseconds = query_ns.load();
+		s.max_query_nanoseconds = max_query_ns.load();
+		s.runs = runs.size();
+		s.memtable_size = memtable_count;
+		for (const frozen_ptr& seg : flushing)
+			s.memtable_size += seg->ids.size();
+		return s;
+	}
+	size_t run_count(void) const
+	{
+		std::lock_guard<std::mutex> lock(state_mutex);
+		return runs.size();
+	}
+
+	// Insertion and deletion
+public:
+	template <bool IsShort, bool IsNormalized>
+	uint64_t push_back(const digest_base<IsAlphabetRestricted, IsShort, IsNormalized>& d) noexcept(false)
+	{
+		bool full;
+		uint64_t id;
+		{
+			std::lock_guard<std::mutex> lock(state_mutex);
+			id = next_id++;
+			memtable.push_back(d);
+			memtable_ids.push_back(id);
+			memtable_count++;
+			counters.inserted++;
+			if (memtable.size() >= opts.memtable_segment_size)
+				seal_memtable();
+			full = memtable_count >= opts.memtable_limit;
+		}
+		if (full && flush_memtable(opts.memtable_limit))
+			request_compaction();
+		return id;
+	}
+	uint64_t push_back(const char* str) noexcept(false)
+	{
+		return push_back(digest_base<IsAlphabetRestricted, false, true>(str));
+	}
+	uint64_t push_back(const std::string& str) noexcept(false)
+	{
+		return push_back(str.c_str());
+	}
+	// Returns false if the digest does not exist (or is already deleted)
+	bool erase(uint64_t id) noexcept(false)
+	{
+		std::lock_guard<std::mutex> lock(state_mutex);
+		if (tombstones->count(id))
+			return false;
+		bool in_memory = std::binary_search(memtable_ids.begin(), memtable_ids.end(), id);
+		for (size_t k = 0; !in_memory && k < sealed.size(); k++)
+			in_memory = std::binary_search(sealed[k]->ids.begin(), sealed[k]->ids.end(), id);
+		for (size_t k = 0; !in_memory && k < flushing.size(); k++)
+			in_memory = std::binary_search(flushing[k]->ids.begin(), flushing[k]->ids.end(), id);
+		bool found = in_memory;
+		for (size_t k = 0; !found && k < runs.size(); k++)
+			found = runs[k]->contains(id);
+		if (!found)
+			return false;
+		std::shared_ptr<tombstone_set> ts = std::make_shared<tombstone_set>(*tombstones);
+		ts->insert(id);
+		tombstones = ts;
+		counters.erased++;
+		// Tombstones of runs must survive restarts
+		// (the manifest is written when the memtable is flushed)
+		if (in_memory)
+			return true;
+		write_manifest();
+		return true;
+	}
+
+	// Flush
+private:
+	// (state_mutex must be held) seals the active memtable segment
+	void seal_memtable(void) noexcept(false)
+	{
+		if (memtable_ids.empty())
+			return;
+		std::shared_ptr<frozen_memtable> seg = std::make_shared<frozen_memtable>();
+		sealed.reserve(sealed.size() + 1);
+		std::swap(seg->index, memtable);
+		seg->ids.swap(memtable_ids);
+		sealed.push_back(seg);
+	}
+	/*
+		Flushes the memtable if it has min_size digests or more
+		and returns true if a run is added.
+
+		The run is written without holding state_mutex.  On failure,
+		the memtable is restored (as if the flush did not happen).
+	*/
+	bool flush_memtable(size_t min_size) noexcept(false)
+	{
+		std::lock_guard<std::mutex> flush_lock(flush_mutex);
+		std::vector<frozen_ptr> frozen;
+		uint_least64_t seq;
+		tombstone_ptr ts;
+		{
+			std::lock_guard<std::mutex> lock(state_mutex);
+			if (memtable_count == 0 || memtable_count < min_size)
+				return false;
+			seal_memtable();
+			flushing = sealed;
+			frozen.swap(sealed);
+			memtable_count = 0;
+			seq = next_seq++;
+			ts = tombstones;
+		}
+		// Drop deleted digests (and their tombstones)
+		index_type live;
+		std::vector<uint64_t> live_ids;
+		std::vector<uint64_t> dropped;
+		for (const frozen_ptr& seg : frozen)
+		{
+			for (size_t i = 0; i < seg->ids.size(); i++)
+			{
+				if (ts->count(seg->ids[i]))
+				{
+					dropped.push_back(seg->ids[i]);
+					continue;
+				}
+				live.push_back(seg->index.store().view(i));
+				live_ids.push_back(seg->ids[i]);
+			}
+		}
+		run_ptr result;
+		uint_least64_t nbytes = 0;
+		try
+		{
+			if (!live_ids.empty())
+			{
+				nbytes = run_type::write(dir, seq, live, live_ids);
+				result = run_ptr(new run_type(dir, seq, 0));
+			}
+		}
+		catch (...)
+		{
+			std::lock_guard<std::mutex> lock(state_mutex);
+			// Segments sealed during the flush follow the frozen ones.
+			for (const frozen_ptr& seg : frozen)
+				memtable_count += seg->ids.size();
+			frozen.insert(frozen.end(), sealed.begin(), sealed.end());
+			sealed.swap(frozen);
+			flushing.clear();
+			throw;
+		}
+		std::lock_guard<std::mutex> lock(state_mutex);
+		if (result)
+		{
+			runs.push_back(result);
+			counters.bytes_flushed += nbytes;
+			counters.flushes++;
+		}
+		if (!dropped.empty())
+		{
+			std::shared_ptr<tombstone_set> nts = std::make_shared<tombstone_set>(*tombstones);
+			for (uint64_t id : dropped)
+				nts->erase(id);
+			tombstones = nts;
+		}
+		flushing.clear();
+		write_manifest();
+		return bool(result);
+	}
+public:
+	void flush(void) noexcept(false)
+	{
+		if (flush_memtable(1))
+			request_compaction();
+	}
+
+	// Compaction
+private:
+	// (state_mutex must be held) runs of the lowest full tier (empty if none)
+	std::vector<run_ptr> select_tier(void) const
+	{
+		std::vector<run_ptr> selected;
+		unsigned max_level = 0;
+		for (const run_ptr& r : runs)
+			max_level = std::max(max_level, r->level());
+		for (unsigned level = 0; level <= max_level; level++)
+		{
+			selected.clear();
+			for (const run_ptr& r : runs)
+				if (r->level() == level)
+					selected.push_back(r);
+			if (selected.size() >= opts.tier_fanout)
+				return selected;
+		}
+		selected.clear();
+		return selected;
+	}
+	// Merges given runs into one (of the given level)
+	void merge(const std::vector<run_ptr>& selected, unsigned level) noexcept(false)
+	{
+		std::lock_guard<std::mutex> compaction_lock(compaction_mutex);
+		uint_least64_t seq;
+		tombstone_ptr ts;
+		{
+			std::lock_guard<std::mutex> lock(state_mutex);
+			// runs may have been merged by another compaction
+			for (const run_ptr& r : selected)
+				if (std::find(runs.begin(), runs.end(), r) == runs.end())
+					return;
+			seq = next_seq++;
+			ts = tombstones;
+		}
+		// Merge by global IDs (without locking the state)
+		typedef std::tuple<uint64_t, const run_type*, size_t> entry_type;
+		std::vector<entry_type> entries;
+		for (const run_ptr& r : selected)
+			for (size_t i = 0; i < r->ids().size(); i++)
+				entries.push_back(entry_type(r->ids()[i], r.get(), i));
+		std::sort(entries.begin(), entries.end());
+		index_type merged;
+		std::vector<uint64_t> merged_ids;
+		std::vector<uint64_t> dropped;
+		for (const entry_type& e : entries)
+		{
+			uint64_t id = std::get<0>(e);
+			if (ts->count(id))
+			{
+				dropped.push_back(id);
+				continue;
+			}
+			merged.push_back(std::get<1>(e)->snapshot().view(std::get<2>(e)));
+			merged_ids.push_back(id);
+		}
+		run_ptr result;
+		uint_least64_t nbytes = 0;
+		if (!merged_ids.empty())
+		{
+			nbytes = run_type::write(dir, seq, merged, merged_ids);
+			result = run_ptr(new run_type(dir, seq, level));
+		}
+		{
+			std::lock_guard<std::mutex> lock(state_mutex);
+			std::vector<run_ptr> remaining;
+			for (const run_ptr& r : runs)
+				if (std::find(selected.begin(), selected.end(), r) == selected.end())
+					remaining.push_back(r);
+			if (result)
+				remaining.push_back(result);
+			runs.swap(remaining);
+			if (!dropped.empty())
+			{
+				std::shared_ptr<tombstone_set> nts = std::make_shared<tombstone_set>(*tombstones);
+				for (uint64_t id : dropped)
+					nts->erase(id);
+				tombstones = nts;
+			}
+			counters.bytes_compacted += nbytes;
+			counters.compactions++;
+			write_manifest();
+		}
+		// Mapped runs stay readable by ongoing searches after removal.
+		for (const run_ptr& r : selected)
+			r->remove(dir);
+	}
+	// Merges full tiers until none remain
+	void compact_tiers(void) noexcept(false)
+	{
+		while (true)
+		{
+			std::vector<run_ptr> selected;
+			{
+				std::lock_guard<std::mutex> lock(state_mutex);
+				selected = select_tier();
+			}
+			if (selected.empty())
+				return;
+			merge(selected, selected.front()->level() + 1);
+		}
+	}
+	void request_compaction(void) noexcept(false)
+	{
+		if (!opts.background_compaction)
+		{
+			compact_tiers();
+			return;
+		}
+		{
+			std::lock_guard<std::mutex> lock(worker_mutex);
+			worker_requested = true;
+		}
+		worker_cv.notify_all();
+	}
+	void worker_main(void) noexcept
+	{
+		std::unique_lock<std::mutex> lock(worker_mutex);
+		while (true)
+		{
+			worker_cv.wait(lock, [this] { return worker_stopping || worker_requested; });
+			if (worker_stopping)
+				return;
+			worker_requested = false;
+			worker_busy = true;
+			lock.unlock();
+			// Errors are counted and retried on the next request.
+			try { compact_tiers(); }
+			catch (...)
+			{
+				std::lock_guard<std::mutex> state_lock(state_mutex);
+				counters.compaction_failures++;
+			}
+			lock.lock();
+			worker_busy = false;
+			worker_cv.notify_all();
+		}
+	}
+public:
+	// Merges all runs into one (dropping all deleted digests in runs)
+	void compact(void) noexcept(false)
+	{
+		std::vector<run_ptr> selected;
+		unsigned level = 0;
+		{
+			std::lock_guard<std::mutex> lock(state_mutex);
+			selected = runs;
+			for (const run_ptr& r : runs)
+				level = std::max(level, r->level() + 1);
+		}
+		if (!selected.empty())
+			merge(selected, level);
+	}
+	// Waits until the background compaction becomes idle
+	void wait_for_compaction(void)
+	{
+		std::unique_lock<std::mutex> lock(worker_mutex);
+		worker_cv.wait(lock, [this] { return !worker_requested && !worker_busy; });
+	}
+
+	// Search
+private:
+	static bool is_better(const digest_search_result& a, const digest_search_result& b) noexcept
+	{
+		return a.score > b.score || (a.score == b.score && a.index < b.index);
+	}
+	// Search a memtable segment (results are appended with global IDs)
+	static void search_segment(
+		const index_type& index, const std::vector<uint64_t>& ids,
+		const tombstone_set& ts,
+		const view_type& query,
+		std::vector<digest_search_result>& partial,
+		std::vector<digest_search_result>& results,
+		digest_comparison_score_t min_score
+	)
+	{
+		index.search(query, partial, min_score);
+		for (const digest_search_result& r : partial)
+			if (!ts.count(ids[r.index]))
+				results.push_back(digest_search_result{ size_t(ids[r.index]), r.score });
+	}
+public:
+	/*
+		Search all live digests with the score of min_score or greater (and nonzero).
+		Results (with global IDs as indices) are sorted by the score (descending)
+		and then by the ID (ascending).
+	*/
+	void search(
+		const view_type& query,
+		std::vector<digest_search_result>& results,
+		digest_comparison_score_t min_score = 1
+	) const
+	{
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		results.clear();
+		std::vector<digest_search_result> partial;
+		std::vector<run_ptr> current_runs;
+		std::vector<frozen_ptr> frozen;
+		tombstone_ptr ts;
+		{
+			std::lock_guard<std::mutex> lock(state_mutex);
+			current_runs = runs;
+			frozen = flushing;
+			frozen.insert(frozen.end(), sealed.begin(), sealed.end());
+			ts = tombstones;
+			// (the active segment is small; see memtable_segment_size)
+			search_segment(memtable, memtable_ids, *ts, query, partial, results, min_score);
+		}
+		for (const frozen_ptr& seg : frozen)
+			search_segment(seg->index, seg->ids, *ts, query, partial, results, min_score);
+		for (const run_ptr& run : current_runs)
+		{
+			run->snapshot().search(query, partial, min_score);
+			for (const digest_search_result& r : partial)
+				if (!ts->count(run->ids()[r.index]))
+					results.push_back(digest_search_result{ size_t(run->ids()[r.index]), r.score });
+		}
+		std::sort(results.begin(), results.end(), is_better);
+		uint_least64_t ns = uint_least64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now() - start).count());
+		queries++;
+		query_ns += ns;
+		uint_least64_t prev = max_query_ns.load();
+		while (prev < ns && !max_query_ns.compare_exchange_weak(prev, ns)) {}
+	}
+	std::vector<digest_search_result> search(
+		const view_type& query,
+		digest_comparison_score_t min_score = 1
+	) const
+	{
+		std::vector<digest_search_result> results;
+		search(query, results, min_score);
+		return results;
+	}
+	std::vector<digest_search_result> search_top_k(
+		const view_type& query,
+		size_t k,
+		digest_comparison_score_t min_score = 1
+	) const
+	{
+		std::vector<digest_search_result> results;
+		search(query, results, min_score);
+		if (results.size() > k)
+			results.resize(k);
+		return results;
+	}
+};
+
+typedef digest_lsm_index< true> digest_lsm_index_t;
+typedef digest_lsm_index<false> digest_lsm_index_non_ra_t;
+
+}
+
+#endif
@@ -0,0 +1,454 @@
+/*
+
+	ffuzzy++ : C++ implementation of fast fuzzy hashing
+
+	digest_parallel_all_pairs.hpp
+	Parallel all-pairs comparison (work-stealing tile scheduler)
+
+	Copyright (C) 2026 Tsukasa OI <floss_ssdeep@irq.a4lg.com>
+
+
+	Permission to use, copy, modify, and/or distribute this software for
+	any purpose with or without fee is hereby granted, provided that the
+	above copyright notice and this permission notice appear in all copies.
+
+	THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+	WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+	MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+	ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+	WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+	ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+	OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+
+*/
+#ifndef FFUZZYPP_DIGEST_PARALLEL_ALL_PAIRS_HPP
+#define FFUZZYPP_DIGEST_PARALLEL_ALL_PAIRS_HPP
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include "digest_all_pairs.hpp"
+#include "digest_comparison.hpp"
+#include "digest_store.hpp"
+
+namespace ffuzzy {
+
+// Runtime options of digest_parallel_all_pairs
+struct digest_parallel_all_pairs_options
+{
+	// Number of worker threads (0: std::thread::hardware_concurrency())
+	unsigned threads;
+	// Number of queries (rows) per tile
+	size_t tile_queries;
+	// Number of candidates (columns) per tile
+	size_t tile_candidates;
+	// Number of edges buffered by a worker before they are passed to the callback
+	size_t edge_buffer_size;
+	digest_parallel_all_pairs_options(void) noexcept
+		: threads(0), tile_queries(64), tile_candidates(2048), edge_buffer_size(4096) {}
+};
+
+// Result of the all-pairs comparison (i < j)
+struct digest_all_pairs_edge
+{
+	size_t i;
+	size_t j;
+	digest_comparison_score_t score;
+};
+
+// Tile (queries [qbegin, qend) against candidates [cbegin, cend) of sorted indices)
+struct digest_all_pairs_tile
+{
+	size_t bucket;
+	size_t qbegin;
+	size_t qend;
+	size_t cbegin;
+	size_t cend;
+	bool is_same_bucket;
+	// Number of pairs compared in this tile
+	uint_least64_t comparisons;
+};
+
+// Statistics of a tile on the last run
+struct digest_all_pairs_tile_stats
+{
+	uint_least64_t nanoseconds;
+	uint_least64_t edges;
+	unsigned worker;
+};
+
+// Statistics of a worker on the last run
+struct digest_all_pairs_worker_stats
+{
+	uint_least64_t tiles;
+	uint_least64_t steals;
+	uint_least64_t busy_nanoseconds;
+};
+
+// Progress passed to the progress callback
+struct digest_all_pairs_progress
+{
+	size_t tiles_done;
+	size_t tiles_total;
+	uint_least64_t comparisons_done;
+	uint_least64_t comparisons_total;
+	uint_least64_t edges;
+	double fraction(void) const noexcept
+	{
+		return comparisons_total ? double(comparisons_done) / double(comparisons_total) : 1.0;
+	}
+};
+
+/*
+	Edge writer (a callback for digest_parallel_all_pairs::run)
+
+	Each edge is written as a text line "i,j,score".
+*/
+class digest_edge_writer
+{
+private:
+	FILE* fp;
+	bool is_failed;
+public:
+	explicit digest_edge_writer(FILE* fp) noexcept : fp(fp), is_failed(false) {}
+	void operator()(size_t i, size_t j, digest_comparison_score_t score) noexcept
+	{
+		if (fprintf(fp, "%llu,%llu,%u\n",
+				static_cast<unsigned long long>(i),
+				static_cast<unsigned long long>(j),
+				unsigned(score)) < 0)
+			is_failed = true;
+	}
+	bool is_ok(void) const noexcept { return !is_failed && !ferror(fp); }
+};
+
+/*
+	Parallel all-pairs comparison
+
+	Buckets of block sizes are usually skewed (small block sizes hold
+	most digests), so running digest_all_pairs::run_bucket per thread
+	leaves most threads idle.  Instead, every bucket and every pair of
+	a bucket and the bucket with the doubled block size are split into
+	tiles of at most tile_queries by tile_candidates digests, which are
+	run by digest_all_pairs::run_tile.
+
+	Tiles are split into contiguous ranges of about the same number of
+	comparisons, one per worker.  A worker runs tiles from the front
+	of its own range and, when it runs out of tiles, steals the latter
+	half of the remaining tiles of another worker.  The imbalance at
+	the end is about one tile, whatever the distribution of buckets.
+
+	Edges are buffered in each worker and passed to the callback as
+	callback(i, j, score) (i < j), never concurrently (calls are
+	serialized by an internal lock).  Edges are not kept after they
+	are passed and their order is not specified.
+
+	progress(const digest_all_pairs_progress&) is called after tiles
+	(never concurrently; a report is skipped while another one is in
+	progress) and once after all tiles are done.  Per-tile timings
+	and per-worker statistics of the last run are available after run.
+
+	The store must not be modified while this object is in use.
+*/
+template <bool IsAlphabetRestricted, comparison_version Version = comparison_version::latest>
+class digest_parallel_all_pairs
+{
+public:
+	static constexpr const bool is_alphabet_restricted = IsAlphabetRestricted;
+	typedef digest_all_pairs<IsAlphabetRestricted, Version> all_pairs_type;
+	typedef typename all_pairs_type::store_type store_type;
+	typedef digest_parallel_all_pairs_options options_type;
+
+	// Data structure
+private:
+	all_pairs_type pairs;
+	options_type opts;
+	std::vector<digest_all_pairs_tile> tile_list;
+	uint_least64_t total_comparisons;
+	std::vector<digest_all_pairs_tile_stats> tile_stats_list;
+	std::vector<digest_all_pairs_worker_stats> worker_stats_list;
+public:
+	const all_pairs_type& all_pairs(void) const noexcept { return pairs; }
+	const options_type& options(void) const noexcept { return opts; }
+	const std::vector<digest_all_pairs_tile>& tiles(void) const noexcept { return tile_list; }
+	uint_least64_t comparison_count(void) const noexcept { return total_comparisons; }
+	// Statistics of the last run (indexed by tile and worker)
+	const std::vector<digest_all_pairs_tile_stats>& tile_stats(void) const noexcept { return tile_stats_list; }
+	const std::vector<digest_all_pairs_worker_stats>& worker_stats(void) const noexcept { return worker_stats_list; }
+
+	// Tiling
+private:
+	void add_tile(size_t b, size_t qbegin, size_t qend, size_t cbegin, size_t cend, bool is_same_bucket)
+	{
+		uint_least64_t n = 0;
+		if (is_same_bucket)
+		{
+			// only candidates after each query
+			for (size_t q = qbegin; q < qend; q++)
+			{
+				size_t c = std::max(cbegin, q + 1);
+				if (c < cend)
+					n += cend - c;
+			}
+		}
+		else
+			n = uint_least64_t(qend - qbegin) * (cend - cbegin);
+		if (n)
+			tile_list.push_back(digest_all_pairs_tile{ b, qbegin, qend, cbegin, cend, is_same_bucket, n });
+		total_comparisons += n;
+	}
+	void make_tiles(void)
+	{
+		size_t qsize = std::max(size_t(1), opts.tile_queries);
+		size_t csize = std::max(size_t(1), opts.tile_candidates);
+		const auto& buckets = pairs.bucket_list();
+		for (size_t b = 0; b < buckets.size(); b++)
+		{
+			const auto& bk = buckets[b];
+			size_t d = pairs.double_bucket_of(b);
+			for (size_t q = bk.begin; q < bk.end; q += qsize)
+			{
+				size_t qend = std::min(q + qsize, bk.end);
+				for (size_t c = q + 1; c < bk.end; c += csize)
+					add_tile(b, q, qend, c, std::min(c + csize, bk.end), true);
+				if (d == buckets.size())
+					continue;
+				for (size_t c = buckets[d].begin; c < buckets[d].end; c += csize)
+					add_tile(b, q, qend, c, std::min(c + csize, buckets[d].end), false);
+			}
+		}
+	}
+
+	// Construction
+public:
+	explicit digest_parallel_all_pairs(
+		const store_type& st,
+		const options_type& options = options_type()
+	)
+		: pairs(st), opts(options), total_comparisons(0)
+	{
+		make_tiles();
+	}
+
+	// Scheduling
+private:
+	struct worker_queue
+	{
+		std::mutex mutex;
+		std::deque<size_t> tiles;
+	};
+	// Split tiles into contiguous ranges of about the same number of comparisons
+	void assign_tiles(std::vector<std::unique_ptr<worker_queue>>& queues) const
+	{
+		size_t w = 0;
+		uint_least64_t acc = 0;
+		for (size_t k = 0; k < tile_list.size(); k++)
+		{
+			// the worker w takes tiles starting before (w + 1) / n of all comparisons
+			while (w + 1 < queues.size() && acc * queues.size() >= total_comparisons * (w + 1))
+				w++;
+			queues[w]->tiles.push_back(k);
+			acc += tile_list[k].comparisons;
+		}
+	}
+	static bool next_tile(
+		std::vector<std::unique_ptr<worker_queue>>& queues,
+		unsigned w, size_t& k,
+		digest_all_pairs_worker_stats& stats
+	)
+	{
+		worker_queue& own = *queues[w];
+		{
+			std::lock_guard<std::mutex> lock(own.mutex);
+			if (!own.tiles.empty())
+			{
+				k = own.tiles.front();
+				own.tiles.pop_front();
+				return true;
+			}
+		}
+		for (size_t n = 1; n < queues.size(); n++)
+		{
+			worker_queue& victim = *queues[(w + n) % queues.size()];
+			std::vector<size_t> stolen;
+			{
+				std::lock_guard<std::mutex> lock(victim.mutex);
+				size_t m = victim.tiles.size();
+				if (!m)
+					continue;
+				size_t take = (m + 1) / 2;
+				stolen.assign(victim.tiles.end() - take, victim.tiles.end());
+				victim.tiles.erase(victim.tiles.end() - take, victim.tiles.end());
+			}
+			stats.steals++;
+			k = stolen.front();
+			if (stolen.size() > 1)
+			{
+				std::lock_guard<std::mutex> lock(own.mutex);
+				own.tiles.insert(own.tiles.end(), stolen.begin() + 1, stolen.end());
+			}
+			return true;
+		}
+		return false;
+	}
+
+	// All-pairs comparison
+public:
+	/*
+		Compare all pairs and call callback(i, j, score) (i < j) for each
+		pair with the score of min_score or greater (min_score of zero is
+		treated as 1).  An exception thrown by a callback stops the run
+		and is rethrown from this function.
+	*/
+	template <typename TCallback, typename TProgress>
+	void run(
+		digest_comparison_score_t min_score,
+		TCallback&& callback,
+		TProgress&& progress
+	)
+	{
+		typedef std::chrono::steady_clock clock_type;
+		if (!min_score)
+			min_score = 1;
+		unsigned threads = opts.threads;
+		if (!threads)
+			threads = std::max(1u, std::thread::hardware_concurrency());
+		threads = unsigned(std::min(size_t(threads), std::max(size_t(1), tile_list.size())));
+		tile_stats_list.assign(tile_list.size(), digest_all_pairs_tile_stats{ 0, 0, 0 });
+		worker_stats_list.assign(threads, digest_all_pairs_worker_stats{ 0, 0, 0 });
+		std::vector<std::unique_ptr<worker_queue>> queues;
+		for (unsigned w = 0; w < threads; w++)
+			queues.push_back(std::unique_ptr<worker_queue>(new worker_queue));
+		assign_tiles(queues);
+		size_t buffer_size = std::max(size_t(1), opts.edge_buffer_size);
+		std::atomic<size_t> tiles_done(0);
+		std::atomic<uint_least64_t> comparisons_done(0);
+		std::atomic<uint_least64_t> edges_done(0);
+		std::atomic<bool> is_aborted(false);
+		std::mutex callback_mutex;
+		std::mutex progress_mutex;
+		std::exception_ptr error;
+		auto report = [&](void)
+		{
+			digest_all_pairs_progress p;
+			p.tiles_done = tiles_done.load();
+			p.tiles_total = tile_list.size();
+			p.comparisons_done = comparisons_done.load();
+			p.comparisons_total = total_comparisons;
+			p.edges = edges_done.load();
+			progress(p);
+		};
+		auto worker = [&](unsigned w)
+		{
+			digest_all_pairs_worker_stats& ws = worker_stats_list[w];
+			std::vector<digest_all_pairs_edge> edges;
+			auto flush = [&](void)
+			{
+				std::lock_guard<std::mutex> lock(callback_mutex);
+				try
+				{
+					if (!is_aborted.load(std::memory_order_relaxed))
+						for (const digest_all_pairs_edge& e : edges)
+							callback(e.i, e.j, e.score);
+				}
+				catch (...)
+				{
+					// no more callbacks after this one
+					is_aborted.store(true, std::memory_order_relaxed);
+					throw;
+				}
+				edges.clear();
+			};
+			try
+			{
+				size_t k;
+				while (!is_aborted.load(std::memory_order_relaxed) && next_tile(queues, w, k, ws))
+				{
+					const digest_all_pairs_tile& t = tile_list[k];
+					clock_type::time_point start = clock_type::now();
+					uint_least64_t n = 0;
+					pairs.run_tile(t.qbegin, t.qend, t.cbegin, t.cend, t.is_same_bucket, min_score,
+						[&](size_t i, size_t j, digest_comparison_score_t score)
+						{
+							edges.push_back(digest_all_pairs_edge{ i, j, score });
+							n++;
+							if (edges.size() >= buffer_size)
+								flush();
+						});
+					uint_least64_t ns = uint_least64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+						clock_type::now() - start).count());
+					tile_stats_list[k] = digest_all_pairs_tile_stats{ ns, n, w };
+					ws.tiles++;
+					ws.busy_nanoseconds += ns;
+					edges_done.fetch_add(n);
+					comparisons_done.fetch_add(t.comparisons);
+					tiles_done.fetch_add(1);
+					std::unique_lock<std::mutex> lock(progress_mutex, std::try_to_lock);
+					if (lock.owns_lock())
+						report();
+				}
+				if (!edges.empty())
+					flush();
+			}
+			catch (...)
+			{
+				std::lock_guard<std::mutex> lock(callback_mutex);
+				if (!error)
+					error = std::current_exception();
+				is_aborted.store(true, std::memory_order_relaxed);
+			}
+		};
+		std::vector<std::thread> pool;
+		pool.reserve(threads - 1);
+		for (unsigned w = 1; w < threads; w++)
+		{
+			// Continue with fewer threads (tiles of missing workers are stolen)
+			try { pool.emplace_back(worker, w); }
+			catch (const std::system_error&) { break; }
+		}
+		worker(0);
+		for (std::thread& th : pool)
+			th.join();
+		if (error)
+			std::rethrow_exception(error);
+		report();
+	}
+	template <typename TCallback>
+	void run(digest_comparison_score_t min_score, TCallback&& callback)
+	{
+		run(min_score, callback, [](const digest_all_pairs_progress&) {});
+	}
+	// Collect all edges (sorted by i and j)
+	std::vector<digest_all_pairs_edge> collect(digest_comparison_score_t min_score)
+	{
+		std::vector<digest_all_pairs_edge> results;
+		run(min_score,
+			[&results](size_t i, size_t j, digest_comparison_score_t score)
+			{
+				results.push_back(digest_all_pairs_edge{ i, j, score });
+			});
+		std::sort(results.begin(), results.end(),
+			[](const digest_all_pairs_edge& a, const digest_all_pairs_edge& b)
+			{
+				return a.i != b.i ? a.i < b.i : a.j < b.j;
+			});
+		return results;
+	}
+};
+
+}
+
+#endif
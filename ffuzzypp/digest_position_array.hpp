@@ -29,6 +29,7 @@
 
 #include "digest_base.hpp"
 #include "digest_position_array_base.hpp"
+#include "digest_view.hpp"
 #include "digest_comparison.hpp"
 
 namespace ffuzzy {
@@ -80,6 +81,20 @@ public:
 		digest_position_array_base<IsAlphabetRestricted>::construct(dest, digest_data<IsAlphabetRestricted, IsShort>::normalize(src));
 	}
 
+	// Initialization by digest view (must be normalized)
+public:
+	explicit digest_position_array(const digest_view<IsAlphabetRestricted>& src) noexcept
+	{
+		digest_position_array_base<IsAlphabetRestricted>::construct(*this, src);
+	}
+	static void construct(
+		digest_position_array& dest,
+		const digest_view<IsAlphabetRestricted>& src
+	) noexcept
+	{
+		digest_position_array_base<IsAlphabetRestricted>::construct(dest, src);
+	}
+
 	// Initialization by digest string
 public:
 	explicit digest_position_array(const char* str) noexcept(false)
@@ -125,6 +140,22 @@ public:
 		return digest_comparison<Version>::compare(b, a);
 	}
 	template <comparison_version Version = comparison_version::latest>
+	static digest_comparison_score_t compare(
+		const digest_position_array& a,
+		const digest_view<IsAlphabetRestricted>& b
+	) noexcept
+	{
+		return digest_comparison<Version>::compare(a, b);
+	}
+	template <comparison_version Version = comparison_version::latest>
+	static digest_comparison_score_t compare(
+		const digest_view<IsAlphabetRestricted>& a,
+		const digest_position_array& b
+	) noexcept
+	{
+		return digest_comparison<Version>::compare(b, a);
+	}
+	template <comparison_version Version = comparison_version::latest>
 	static digest_comparison_score_t compare_near(
 		const digest_position_array& a,
 		const digest_base<IsAlphabetRestricted, false, true>& b
@@ -220,6 +251,42 @@ public:
 	{
 		return digest_comparison<Version>::compare_near_lt(a, b);
 	}
+	template <comparison_version Version = comparison_version::latest>
+	static digest_comparison_score_t compare_threshold(
+		const digest_position_array& a,
+		const digest_base<IsAlphabetRestricted, false, true>& b,
+		digest_comparison_score_t min_score
+	) noexcept
+	{
+		return digest_comparison<Version>::compare_threshold(a, b, min_score);
+	}
+	template <comparison_version Version = comparison_version::latest>
+	static digest_comparison_score_t compare_threshold(
+		const digest_position_array& a,
+		const digest_base<IsAlphabetRestricted, true, true>& b,
+		digest_comparison_score_t min_score
+	) noexcept
+	{
+		return digest_comparison<Version>::compare_threshold(a, b, min_score);
+	}
+	template <comparison_version Version = comparison_version::latest>
+	static digest_comparison_score_t compare_threshold(
+		const digest_base<IsAlphabetRestricted, false, true>& a,
+		const digest_position_array& b,
+		digest_comparison_score_t min_score
+	) noexcept
+	{
+		return digest_comparison<Version>::compare_threshold(b, a, min_score);
+	}
+	template <comparison_version Version = comparison_version::latest>
+	static digest_comparison_score_t compare_threshold(
+		const digest_base<IsAlphabetRestricted, true, true>& a,
+		const digest_position_array& b,
+		digest_comparison_score_t min_score
+	) noexcept
+	{
+		return digest_comparison<Version>::compare_threshold(b, a, min_score);
+	}
 public:
 	template <comparison_version Version = comparison_version::latest>
 	digest_comparison_score_t compare(const digest_base<IsAlphabetRestricted, false, true>& other) const noexcept
@@ -271,6 +338,22 @@ public:
 	{
 		return compare_near_lt<Version>(other, *this);
 	}
+	template <comparison_version Version = comparison_version::latest>
+	digest_comparison_score_t compare_threshold(
+		const digest_base<IsAlphabetRestricted, false, true>& other,
+		digest_comparison_score_t min_score
+	) const noexcept
+	{
+		return compare_threshold<Version>(*this, other, min_score);
+	}
+	template <comparison_version Version = comparison_version::latest>
+	digest_comparison_score_t compare_threshold(
+		const digest_base<IsAlphabetRestricted, true, true>& other,
+		digest_comparison_score_t min_score
+	) const noexcept
+	{
+		return compare_threshold<Version>(*this, other, min_score);
+	}
 
 	// Comparison (on different digests)
 public:
@@ -33,6 +33,7 @@
 #include "base64.hpp"
 #include "digest_blocksize.hpp"
 #include "digest_data.hpp"
+#include "digest_view.hpp"
 #include "strings/position_array.hpp"
 
 namespace ffuzzy {
@@ -147,6 +148,23 @@ protected:
 		construct(src);
 	}
 
+	// Construction by digest view
+protected:
+	static void construct(
+		digest_position_array_base& dest,
+		const digest_view<IsAlphabetRestricted>& src
+	) noexcept
+	{
+		#ifdef FFUZZYPP_DEBUG
+		assert(src.is_valid() && src.is_normalized());
+		#endif
+		dest.blkhash1.construct(src.blockhash1(), src.blockhash1_len());
+		dest.blkhash2.construct(src.blockhash2(), src.blockhash2_len());
+		dest.blkhash1_len = blockhash_len_t(src.blockhash1_len());
+		dest.blkhash2_len = blockhash_len_t(src.blockhash2_len());
+		dest.blksize = digest_blocksize_t(src.blocksize());
+	}
+
 	// Validators (for its validness and naturality)
 private:
 	bool is_valid_blockhash_position_array(const pa_type& parray, blockhash_len_t len) const noexcept
@@ -332,6 +350,42 @@ public:
 			return false;
 		return is_eq_except_blocksize(a, b);
 	}
+	static bool is_eq_except_blocksize(
+		const digest_position_array_base& a,
+		const digest_view<IsAlphabetRestricted>& b
+	) noexcept
+	{
+		#ifdef FFUZZYPP_DEBUG
+		assert(a.is_valid());
+		assert(b.is_valid());
+		#endif
+		if (a.blkhash1_len != b.blockhash1_len())
+			return false;
+		if (a.blkhash2_len != b.blockhash2_len())
+			return false;
+		const char* p = b.blockhash1();
+		for (blockhash_len_t i = 0; i < a.blkhash1_len; i++)
+		{
+			if (!(a.blkhash1[*p++] & (int_type(1u) << i)))
+				return false;
+		}
+		p = b.blockhash2();
+		for (blockhash_len_t i = 0; i < a.blkhash2_len; i++)
+		{
+			if (!(a.blkhash2[*p++] & (int_type(1u) << i)))
+				return false;
+		}
+		return true;
+	}
+	static bool is_eq(
+		const digest_position_array_base& a,
+		const digest_view<IsAlphabetRestricted>& b
+	) noexcept
+	{
+		if (a.blksize != b.blocksize())
+			return false;
+		return is_eq_except_blocksize(a, b);
+	}
 public:
 	friend bool operator==(const digest_position_array_base& a, const digest_position_array_base& b) noexcept { return  is_eq(a, b); }
 	friend bool operator!=(const digest_position_array_base& a, const digest_position_array_base& b) noexcept { return !is_eq(a, b); }
@@ -0,0 +1,572 @@
+/*
+
+	ffuzzy++ : C++ implementation of fast fuzzy hashing
+
+	digest_posting_list.hpp
+	Compressed posting lists (delta and variable-byte encoding)
+
+	Copyright (C) 2026 Tsukasa OI <floss_ssdeep@irq.a4lg.com>
+
+
+	Permission to use, copy, modify, and/or distribute this software for
+	any purpose with or without fee is hereby granted, provided that the
+	above copyright notice and this permission notice appear in all copies.
+
+	THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+	WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+	MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+	ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+	WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+	ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+	OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+
+*/
+#ifndef FFUZZYPP_DIGEST_POSTING_LIST_HPP
+#define FFUZZYPP_DIGEST_POSTING_LIST_HPP
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <algorithm>
+#include <iterator>
+#include <limits>
+#include <new>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "utils/bits.hpp"
+#include "utils/likely.hpp"
+
+namespace ffuzzy {
+
+/*
+	Compressed posting list
+
+	A sorted list of digest indices is stored as the first index and
+	differences between adjacent indices, each in the variable-byte form
+	(7 bits per byte, the most significant bit set on all bytes but the
+	last one).  Digests are indexed in the insertion order, so postings
+	of one substring are usually close and most differences take a byte.
+
+	The list object itself is one 64-bit word.  Up to max_inline_bytes
+	encoded bytes (one or a few postings) are kept in the word and longer
+	lists are moved to a heap block, which also keeps the last index and
+	the number of postings so that appending takes constant time.
+
+	Lists are decoded sequentially (by decode_append or iterators).
+	Set operations (intersect and unite) read two encoded lists at once
+	without decoding them to temporary arrays.
+*/
+class digest_posting_list
+{
+public:
+	static constexpr const size_t max_inline_bytes = 7;
+	static constexpr const size_t max_encoded_size = (sizeof(size_t) * 8 + 6) / 7;
+	typedef uint_least32_t length_type;
+
+	// Data structure
+private:
+	struct block
+	{
+		size_t last;
+		length_type len;
+		length_type cap;
+		length_type count;
+		unsigned char* bytes(void) noexcept
+		{
+			return reinterpret_cast<unsigned char*>(this + 1);
+		}
+		const unsigned char* bytes(void) const noexcept
+		{
+			return reinterpret_cast<const unsigned char*>(this + 1);
+		}
+	};
+	static_assert(sizeof(uintptr_t) <= sizeof(uint_least64_t), "pointers must fit in the list word.");
+	static_assert(alignof(block) >= 2, "the lowest bit of block pointers must be zero.");
+	/*
+		0         : empty list
+		bit 0 set : inline list (bits 1-3: number of bytes, bits 8-63: bytes)
+		otherwise : pointer to the heap block
+	*/
+	uint_least64_t word;
+
+	// Encoding
+private:
+	static size_t encode(unsigned char* out, size_t x) noexcept
+	{
+		size_t n = 0;
+		while (x >= 0x80u)
+		{
+			out[n++] = static_cast<unsigned char>(x | 0x80u);
+			x >>= 7;
+		}
+		out[n++] = static_cast<unsigned char>(x);
+		return n;
+	}
+	static const unsigned char* decode(const unsigned char* p, size_t& x) noexcept
+	{
+		size_t v = *p++;
+		if (FFUZZYPP_LIKELY(v < 0x80u))
+		{
+			x = v;
+			return p;
+		}
+		v &= 0x7fu;
+		for (unsigned shift = 7;; shift += 7)
+		{
+			size_t b = *p++;
+			v |= (b & 0x7fu) << shift;
+			if (b < 0x80u)
+				break;
+		}
+		x = v;
+		return p;
+	}
+
+	// Storage
+private:
+	bool is_inline(void) const noexcept { return (word & 1u) != 0; }
+	bool is_heap(void) const noexcept { return word != 0 && !is_inline(); }
+	size_t inline_len(void) const noexcept { return size_t(word >> 1) & 7u; }
+	block* heap(void) const noexcept
+	{
+		return reinterpret_cast<block*>(static_cast<uintptr_t>(word));
+	}
+	void unpack_inline(unsigned char* out) const noexcept
+	{
+		for (size_t k = 0, len = inline_len(); k < len; k++)
+			out[k] = static_cast<unsigned char>(word >> (8 * (k + 1)));
+	}
+	void pack_inline(const unsigned char* bytes, size_t len) noexcept
+	{
+		#ifdef FFUZZYPP_DEBUG
+		assert(0 < len && len <= max_inline_bytes);
+		#endif
+		word = 1u | (uint_least64_t(len) << 1);
+		for (size_t k = 0; k < len; k++)
+			word |= uint_least64_t(bytes[k]) << (8 * (k + 1));
+	}
+	static size_t block_capacity(size_t len) noexcept
+	{
+		size_t cap = len <= 16 ? 16 : size_t(2) << bits::floor_log2(len - 1);
+		return std::min(cap, size_t(std::numeric_limits<length_type>::max()));
+	}
+	static block* allocate_block(size_t cap)
+	{
+		block* b = new (::operator new(sizeof(block) + cap)) block;
+		b->cap = length_type(cap);
+		return b;
+	}
+	static void free_block(block* b) noexcept
+	{
+		::operator delete(b);
+	}
+	void set_heap(block* b) noexcept
+	{
+		word = uint_least64_t(reinterpret_cast<uintptr_t>(b));
+	}
+	// Make room for len bytes (may move the block)
+	block* reserve_heap(size_t len)
+	{
+		block* b = heap();
+		if (len <= b->cap)
+			return b;
+		if (len > std::numeric_limits<length_type>::max())
+			throw std::length_error("posting list is too long");
+		block* nb = allocate_block(block_capacity(len));
+		nb->last = b->last;
+		nb->len = b->len;
+		nb->count = b->count;
+		memcpy(nb->bytes(), b->bytes(), b->len);
+		free_block(b);
+		set_heap(nb);
+		return nb;
+	}
+
+	// Accessors
+public:
+	bool empty(void) const noexcept { return word == 0; }
+	size_t size(void) const noexcept
+	{
+		if (is_heap())
+			return heap()->count;
+		size_t n = 0;
+		for (size_t k = 0, len = inline_len(); k < len; k++)
+			if (static_cast<unsigned char>(word >> (8 * (k + 1))) < 0x80u)
+				n++;
+		return n;
+	}
+	// The last (largest) index (the list must not be empty)
+	size_t back(void) const noexcept
+	{
+		#ifdef FFUZZYPP_DEBUG
+		assert(!empty());
+		#endif
+		if (is_heap())
+			return heap()->last;
+		unsigned char buf[max_inline_bytes];
+		unpack_inline(buf);
+		const unsigned char* p = buf;
+		const unsigned char* e = buf + inline_len();
+		size_t x = 0, v;
+		while (p != e)
+		{
+			p = decode(p, v);
+			x += v;
+		}
+		return x;
+	}
+	// Number of encoded bytes
+	size_t byte_size(void) const noexcept
+	{
+		return is_heap() ? size_t(heap()->len) : inline_len();
+	}
+	// Memory allocated outside the list object (in bytes)
+	size_t heap_usage(void) const noexcept
+	{
+		return is_heap() ? sizeof(block) + heap()->cap : 0;
+	}
+
+	// Modification
+public:
+	void clear(void) noexcept
+	{
+		if (is_heap())
+			free_block(heap());
+		word = 0;
+	}
+	void swap(digest_posting_list& other) noexcept
+	{
+		std::swap(word, other.word);
+	}
+	// Append an index (greater than all indices in the list)
+	void push_back(size_t i)
+	{
+		#ifdef FFUZZYPP_DEBUG
+		assert(empty() || back() < i);
+		#endif
+		if (is_heap())
+		{
+			unsigned char buf[max_encoded_size];
+			block* b = heap();
+			size_t n = encode(buf, i - b->last);
+			b = reserve_heap(size_t(b->len) + n);
+			memcpy(b->bytes() + b->len, buf, n);
+			b->len += length_type(n);
+			b->count++;
+			b->last = i;
+			return;
+		}
+		unsigned char buf[max_inline_bytes + max_encoded_size];
+		size_t len = inline_len(), count = 0, last = 0;
+		if (!empty())
+		{
+			unpack_inline(buf);
+			const unsigned char* p = buf;
+			size_t v;
+			while (p != buf + len)
+			{
+				p = decode(p, v);
+				last += v;
+				count++;
+			}
+		}
+		else
+			len = 0;
+		len += encode(buf + len, i - last);
+		if (len <= max_inline_bytes)
+		{
+			pack_inline(buf, len);
+			return;
+		}
+		block* b = allocate_block(block_capacity(len));
+		memcpy(b->bytes(), buf, len);
+		b->last = i;
+		b->len = length_type(len);
+		b->count = length_type(count + 1);
+		set_heap(b);
+	}
+
+	// Decoding
+public:
+	// Append all indices to out (in ascending order)
+	void decode_append(std::vector<size_t>& out) const
+	{
+		if (empty())
+			return;
+		unsigned char buf[max_inline_bytes];
+		const unsigned char* p;
+		const unsigned char* e;
+		if (is_inline())
+		{
+			unpack_inline(buf);
+			p = buf;
+			e = buf + inline_len();
+		}
+		else
+		{
+			p = heap()->bytes();
+			e = p + heap()->len;
+		}
+		size_t x = 0, v;
+		do
+		{
+			p = decode(p, v);
+			x += v;
+			out.push_back(x);
+		} while (p != e);
+	}
+	class const_iterator
+	{
+	public:
+		typedef std::forward_iterator_tag iterator_category;
+		typedef size_t value_type;
+		typedef std::ptrdiff_t difference_type;
+		typedef const size_t* pointer;
+		typedef const size_t& reference;
+	private:
+		// Remaining bytes (from p on heap lists, from the low byte of w on inline lists)
+		const unsigned char* p;
+		uint_least64_t w;
+		size_t rem;
+		size_t value;
+		bool at_end;
+		unsigned char next_byte(void) noexcept
+		{
+			rem--;
+			if (p)
+				return *p++;
+			unsigned char b = static_cast<unsigned char>(w);
+			w >>= 8;
+			return b;
+		}
+		void advance(void) noexcept
+		{
+			if (!rem)
+			{
+				at_end = true;
+				return;
+			}
+			size_t v = 0;
+			unsigned char b;
+			unsigned shift = 0;
+			do
+			{
+				b = next_byte();
+				v |= size_t(b & 0x7fu) << shift;
+				shift += 7;
+			} while (b & 0x80u);
+			value += v;
+		}
+	public:
+		const_iterator(void) noexcept
+			: p(nullptr), w(0), rem(0), value(0), at_end(true) {}
+		explicit const_iterator(const digest_posting_list& list) noexcept
+			: p(nullptr), w(0), rem(0), value(0), at_end(false)
+		{
+			if (list.is_heap())
+			{
+				p = list.heap()->bytes();
+				rem = list.heap()->len;
+			}
+			else if (!list.empty())
+			{
+				w = list.word >> 8;
+				rem = list.inline_len();
+			}
+			advance();
+		}
+		reference operator*(void) const noexcept { return value; }
+		pointer operator->(void) const noexcept { return &value; }
+		const_iterator& operator++(void) noexcept
+		{
+			advance();
+			return *this;
+		}
+		const_iterator operator++(int) noexcept
+		{
+			const_iterator old = *this;
+			advance();
+			return old;
+		}
+		// Only iterators of the same list can be compared
+		bool operator==(const const_iterator& other) const noexcept
+		{
+			return at_end == other.at_end && rem == other.rem;
+		}
+		bool operator!=(const const_iterator& other) const noexcept
+		{
+			return !(*this == other);
+		}
+	};
+	const_iterator begin(void) const noexcept { return const_iterator(*this); }
+	const_iterator end(void) const noexcept { return const_iterator(); }
+
+	// Set operations (out is overwritten and sorted)
+public:
+	static void intersect(
+		const digest_posting_list& a,
+		const digest_posting_list& b,
+		std::vector<size_t>& out
+	)
+	{
+		out.clear();
+		std::set_intersection(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(out));
+	}
+	static void unite(
+		const digest_posting_list& a,
+		const digest_posting_list& b,
+		std::vector<size_t>& out
+	)
+	{
+		out.clear();
+		std::set_union(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(out));
+	}
+
+public:
+	digest_posting_list(void) noexcept : word(0) {}
+	digest_posting_list(const digest_posting_list& other) : word(other.word)
+	{
+		if (other.is_heap())
+		{
+			const block* b = other.heap();
+			block* nb = allocate_block(b->cap);
+			nb->last = b->last;
+			nb->len = b->len;
+			nb->count = b->count;
+			memcpy(nb->bytes(), b->bytes(), b->len);
+			set_heap(nb);
+		}
+	}
+	digest_posting_list(digest_posting_list&& other) noexcept : word(other.word)
+	{
+		other.word = 0;
+	}
+	digest_posting_list& operator=(const digest_posting_list& other)
+	{
+		digest_posting_list tmp(other);
+		swap(tmp);
+		return *this;
+	}
+	digest_posting_list& operator=(digest_posting_list&& other) noexcept
+	{
+		digest_posting_list tmp(std::move(other));
+		swap(tmp);
+		return *this;
+	}
+	~digest_posting_list(void) { clear(); }
+};
+
+
+/*
+	Open-addressed table of posting lists (keyed by packed substrings)
+
+	Keys and lists are kept in separate arrays and collisions are
+	resolved by linear probing (the load factor is kept at most 3/4).
+	An empty list marks an unused slot, so every key in the table
+	has at least one posting.
+*/
+class digest_posting_table
+{
+public:
+	typedef uint_least64_t key_type;
+
+	// Data structure
+private:
+	std::vector<key_type> keys;
+	std::vector<digest_posting_list> lists;
+	size_t count;
+	unsigned shift;
+public:
+	size_t size(void) const noexcept { return count; }
+	bool empty(void) const noexcept { return count == 0; }
+	void clear(void) noexcept
+	{
+		keys.clear();
+		lists.clear();
+		count = 0;
+		shift = 64;
+	}
+	// Memory used by the table and its lists (in bytes)
+	size_t memory_usage(void) const noexcept
+	{
+		size_t n = keys.capacity() * sizeof(key_type) + lists.capacity() * sizeof(digest_posting_list);
+		for (const auto& list : lists)
+			n += list.heap_usage();
+		return n;
+	}
+	// callback(key, posting list) (unordered)
+	template <typename TCallback>
+	void for_each(TCallback&& callback) const
+	{
+		for (size_t s = 0; s < lists.size(); s++)
+			if (!lists[s].empty())
+				callback(keys[s], lists[s]);
+	}
+
+	// Lookup and insertion
+private:
+	size_t find_slot(key_type key) const noexcept
+	{
+		size_t mask = lists.size() - 1;
+		size_t s = size_t(((key * 0x9e3779b97f4a7c15ull) & 0xffffffffffffffffull) >> shift);
+		while (!lists[s].empty() && keys[s] != key)
+			s = (s + 1) & mask;
+		return s;
+	}
+	void rehash(size_t new_size)
+	{
+		std::vector<key_type> old_keys(new_size);
+		std::vector<digest_posting_list> old_lists(new_size);
+		keys.swap(old_keys);
+		lists.swap(old_lists);
+		shift = 64u - bits::floor_log2(new_size);
+		for (size_t s = 0; s < old_lists.size(); s++)
+		{
+			if (old_lists[s].empty())
+				continue;
+			size_t t = find_slot(old_keys[s]);
+			keys[t] = old_keys[s];
+			lists[t] = std::move(old_lists[s]);
+		}
+	}
+public:
+	const digest_posting_list* find(key_type key) const noexcept
+	{
+		if (lists.empty())
+			return nullptr;
+		const digest_posting_list& list = lists[find_slot(key)];
+		return list.empty() ? nullptr : &list;
+	}
+	// Append index i to the list of the key (unless i is the last one)
+	void insert(key_type key, size_t i)
+	{
+		if ((count + 1) * 4 > lists.size() * 3)
+			rehash(lists.empty() ? 16 : lists.size() * 2);
+		size_t s = find_slot(key);
+		digest_posting_list& list = lists[s];
+		if (list.empty())
+		{
+			keys[s] = key;
+			count++;
+		}
+		else if (list.back() == i)
+			return;
+		list.push_back(i);
+	}
+
+public:
+	digest_posting_table(void) noexcept : count(0), shift(64) {}
+};
+
+#ifdef FFUZZYPP_DECLARATIONS
+constexpr const size_t digest_posting_list::max_inline_bytes;
+constexpr const size_t digest_posting_list::max_encoded_size;
+#endif
+
+}
+
+#endif
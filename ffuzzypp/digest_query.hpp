@@ -0,0 +1,834 @@
+/*
+
+	ffuzzy++ : C++ implementation of fast fuzzy hashing
+
+	digest_query.hpp
+	Compiled query for one-vs-many comparison
+
+	Copyright (C) 2026 Tsukasa OI <floss_ssdeep@irq.a4lg.com>
+
+
+	Permission to use, copy, modify, and/or distribute this software for
+	any purpose with or without fee is hereby granted, provided that the
+	above copyright notice and this permission notice appear in all copies.
+
+	THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+	WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+	MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+	ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+	WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+	ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+	OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+
+*/
+#ifndef FFUZZYPP_DIGEST_QUERY_HPP
+#define FFUZZYPP_DIGEST_QUERY_HPP
+
+#include <cassert>
+#include <cstddef>
+#include <cstring>
+
+#include <algorithm>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "blockhash_signature.hpp"
+#include "digest_blocksize.hpp"
+#include "digest_data.hpp"
+#include "digest_base.hpp"
+#include "digest_comparison.hpp"
+#include "digest_comparison_table.hpp"
+#include "digest_position_array_base.hpp"
+#include "digest_store.hpp"
+#include "digest_view.hpp"
+#include "utils/likely.hpp"
+#include "utils/prefetch.hpp"
+
+namespace ffuzzy {
+
+class digest_query_params
+{
+private:
+	digest_query_params(void) = delete;
+	digest_query_params(const digest_query_params&) = delete;
+public:
+	// Number of candidates filtered at once (before scoring)
+	static constexpr const size_t filter_block_size = 256;
+	// Number of candidates to prefetch ahead of scoring
+	static constexpr const size_t prefetch_distance = 4;
+	// Number of block hashes compared at once by the edit distance kernel
+	static constexpr const size_t edit_dist_lanes = 8;
+	/*
+		Whether edit distances are computed in batches (edit_dist_lanes at once).
+		The multi-lane kernel (which cannot stop early) is only faster than
+		the scalar bounded one when the compiler can use 512-bit vector
+		registers (it is still slower with AVX2 alone).
+		Otherwise, each block hash pair is scored on the spot.
+	*/
+#if defined(FFUZZYPP_ENABLE_BATCHED_EDIT_DIST) || \
+	(defined(__AVX512F__) && !defined(FFUZZYPP_DISABLE_BATCHED_EDIT_DIST))
+	static constexpr const bool is_edit_dist_batched = true;
+#else
+	static constexpr const bool is_edit_dist_batched = false;
+#endif
+	static_assert(filter_block_size != 0, "filter_block_size must not be zero.");
+	static_assert(edit_dist_lanes != 0, "edit_dist_lanes must not be zero.");
+};
+
+
+namespace internal
+{
+	// Compiled block hash (position array if available)
+	template <bool IsAlphabetRestricted, bool IsPositionArrayAvailable>
+	class digest_query_blockhash;
+
+	template <bool IsAlphabetRestricted>
+	class digest_query_blockhash<IsAlphabetRestricted, true>
+	{
+	private:
+		typename digest_position_array_base<IsAlphabetRestricted>::pa_type parray;
+		blockhash_signature sig;
+		blockhash_len_t len;
+	public:
+		blockhash_len_t length(void) const noexcept { return len; }
+		void construct(const char* str, blockhash_len_t length) noexcept
+		{
+			parray.construct(str, length);
+			sig.construct(str, length);
+			len = length;
+		}
+		bool may_match(const blockhash_signature& s2sig) const noexcept
+		{
+			return blockhash_signature::may_match(sig, s2sig);
+		}
+		digest_comparison_score_t score(
+			const char* s2, blockhash_len_t s2len,
+			const blockhash_signature& s2sig,
+			digest_blocksize_t blocksize
+		) const noexcept
+		{
+			if (!may_match(s2sig))
+				return 0;
+			return blockhash_comparison<>::score(parray, len, s2, s2len, blocksize);
+		}
+		digest_comparison_score_t score_threshold(
+			const char* s2, blockhash_len_t s2len,
+			const blockhash_signature& s2sig,
+			digest_blocksize_t blocksize,
+			digest_comparison_score_t min_score
+		) const noexcept
+		{
+			if (!may_match(s2sig))
+				return 0;
+			return blockhash_comparison<>::score_threshold(parray, len, s2, s2len, blocksize, min_score);
+		}
+		bool has_common_substring(const char* s2, blockhash_len_t s2len) const noexcept
+		{
+			typedef typename digest_position_array_base<IsAlphabetRestricted>::pa_type pa_type;
+			return strings::common_substr_bitparallel<
+				typename pa_type::bitmap_type, pa_type::char_min, pa_type::char_max,
+				digest_params::max_blockhash_len, blockhash_comparison_params::min_match_len
+			>::match(parray, s2, size_t(s2len));
+		}
+		// Edit distances against s2[0..Lanes) (all lanes at once)
+		template <size_t Lanes>
+		void edit_distances(
+			const char* const* s2, const size_t* s2len,
+			digest_comparison_score_t* out
+		) const noexcept
+		{
+			strings::edit_dist_nonempty_bitparallel_multi<
+				digest_comparison_score_t, digest_params::max_blockhash_len, Lanes
+			>::cost(parray, size_t(len), s2, s2len, out);
+		}
+	};
+
+	template <bool IsAlphabetRestricted>
+	class digest_query_blockhash<IsAlphabetRestricted, false>
+	{
+	private:
+		char str[digest_params::max_blockhash_len];
+		blockhash_signature sig;
+		blockhash_len_t len;
+	public:
+		blockhash_len_t length(void) const noexcept { return len; }
+		void construct(const char* s, blockhash_len_t length) noexcept
+		{
+			memcpy(str, s, length);
+			sig.construct(s, length);
+			len = length;
+		}
+		bool may_match(const blockhash_signature& s2sig) const noexcept
+		{
+			return blockhash_signature::may_match(sig, s2sig);
+		}
+		digest_comparison_score_t score(
+			const char* s2, blockhash_len_t s2len,
+			const blockhash_signature& s2sig,
+			digest_blocksize_t blocksize
+		) const noexcept
+		{
+			if (!may_match(s2sig))
+				return 0;
+			return blockhash_comparison<>::score(str, len, s2, s2len, blocksize);
+		}
+		digest_comparison_score_t score_threshold(
+			const char* s2, blockhash_len_t s2len,
+			const blockhash_signature& s2sig,
+			digest_blocksize_t blocksize,
+			digest_comparison_score_t min_score
+		) const noexcept
+		{
+			if (!may_match(s2sig))
+				return 0;
+			return blockhash_comparison<>::score_threshold(str, len, s2, s2len, blocksize, min_score);
+		}
+		bool has_common_substring(const char* s2, blockhash_len_t s2len) const noexcept
+		{
+			return strings::common_substr_fast<
+				digest_params::max_blockhash_len, blockhash_comparison_params::min_match_len
+			>::match(str, size_t(len), s2, size_t(s2len));
+		}
+		// Edit distances against s2[0..Lanes) (one by one)
+		template <size_t Lanes>
+		void edit_distances(
+			const char* const* s2, const size_t* s2len,
+			digest_comparison_score_t* out
+		) const noexcept
+		{
+			for (size_t k = 0; k < Lanes; k++)
+				out[k] = blockhash_comparison<>::edit_dist_t::cost(str, size_t(len), s2[k], s2len[k]);
+		}
+	};
+
+	/*
+		Pending block hash pairs (against one of query block hashes)
+		whose edit distances are computed at once.
+	*/
+	template <size_t Lanes>
+	struct digest_query_batch
+	{
+		const char* strs[Lanes];
+		size_t lens[Lanes];
+		size_t slots[Lanes];
+		digest_comparison_score_t max_dists[Lanes];
+		size_t count;
+	};
+}
+
+
+// Result of top-K search (see digest_query::search_top_k)
+struct digest_search_result
+{
+	size_t index;
+	digest_comparison_score_t score;
+};
+
+
+/*
+	Compiled query for one-vs-many comparison
+
+	This class precomputes everything which depends only on the query digest:
+
+	*	position arrays for both block hashes
+	*	block sizes which are "near" to the query
+	*	the score on identical digests
+	*	upper bounds of the score for each candidate block hash length
+
+	Then it compares itself against the candidates in digest_store.
+	Candidates are first filtered by block size in blocks
+	(a tight loop over contiguous block sizes only),
+	then block hash pairs of survivors are filtered by signatures
+	(see blockhash_signature.hpp) and common substrings
+	(while block hashes of following survivors are being prefetched).
+	Remaining pairs are scored with the bounded edit distance or,
+	if digest_query_params::is_edit_dist_batched is true, queued per query
+	block hash and their edit distances are computed in batches of
+	digest_query_params::edit_dist_lanes
+	(one query position array against multiple candidates at once).
+
+	The result is the same as digest_comparison<Version>::compare.
+*/
+template <bool IsAlphabetRestricted, comparison_version Version = comparison_version::latest>
+class digest_query
+{
+public:
+	static constexpr const bool is_alphabet_restricted = IsAlphabetRestricted;
+	typedef digest_store<IsAlphabetRestricted> store_type;
+private:
+	typedef internal::digest_query_blockhash<IsAlphabetRestricted,
+		digest_position_array_params<IsAlphabetRestricted>::is_available> blockhash_type;
+
+	// Relation of the candidate's block size against the query
+	enum : unsigned char
+	{
+		rel_none = 0,
+		rel_eq   = 1, // candidate.blksize == query.blksize
+		rel_lt   = 2, // candidate.blksize == query.blksize * 2
+		rel_gt   = 3, // candidate.blksize == query.blksize / 2
+	};
+
+	// Data structure
+private:
+	blockhash_type blkhash1;
+	blockhash_type blkhash2;
+	char digest[digest_params::max_blockhash_len * 2];
+	digest_blocksize_t blksize;
+	digest_blocksize_t blksize_double;
+	digest_blocksize_t blksize_half;
+	bool is_double_valid;
+	bool is_half_valid;
+	digest_comparison_score_t score_on_identical;
+	// Upper bound of the score for given candidate block hash length
+	// (ub1: against the query block hash 1, ub2: against the query block hash 2)
+	digest_comparison_score_t ub1[digest_params::max_blockhash_len + 1];
+	digest_comparison_score_t ub2[digest_params::max_blockhash_len + 1];
+	// Score cap for given candidate block hash length (used by batched scoring)
+	typedef typename blockhash_score_table<Version>::score_type cap_type;
+	cap_type cap1[digest_params::max_blockhash_len + 1];
+	cap_type cap2[digest_params::max_blockhash_len + 1];
+public:
+	unsigned long blocksize(void) const noexcept { return blksize; }
+	size_t blockhash1_len(void) const noexcept { return blkhash1.length(); }
+	size_t blockhash2_len(void) const noexcept { return blkhash2.length(); }
+
+	// Construction
+private:
+	static digest_comparison_score_t upper_bound_for(
+		digest_blocksize_t blocksize,
+		blockhash_len_t s1len,
+		blockhash_len_t s2len
+	) noexcept
+	{
+		if (s1len < blockhash_comparison_params::min_match_len)
+			return 0;
+		if (s2len < blockhash_comparison_params::min_match_len)
+			return 0;
+		return blockhash_comparison<Version>::max_matching_score(blocksize, s1len, s2len);
+	}
+	void construct_internal(
+		digest_blocksize_t blocksize,
+		const char* bh1, blockhash_len_t bh1len,
+		const char* bh2, blockhash_len_t bh2len
+	) noexcept
+	{
+		#ifdef FFUZZYPP_DEBUG
+		assert(bh1len <= digest_params::max_blockhash_len);
+		assert(bh2len <= digest_params::max_blockhash_len);
+		#endif
+		blkhash1.construct(bh1, bh1len);
+		blkhash2.construct(bh2, bh2len);
+		memcpy(digest, bh1, bh1len);
+		memcpy(digest + bh1len, bh2, bh2len);
+		blksize = blocksize;
+		is_double_valid = blocksize != 0 && digest_blocksize::is_safe_to_double(blocksize);
+		is_half_valid   = blocksize != 0 && blocksize % 2 == 0;
+		blksize_double  = is_double_valid ? blocksize * 2 : 0;
+		blksize_half    = is_half_valid   ? blocksize / 2 : 0;
+		// Score on identical digests (see digest_comparison::compare_identical)
+		if (Version == comparison_version::v2_9)
+		{
+			score_on_identical = blockhash_comparison<Version>::score_identical(bh1len, blocksize);
+			if (digest_blocksize::is_safe_to_double(blocksize))
+				score_on_identical = std::max(score_on_identical,
+					blockhash_comparison<Version>::score_identical(bh2len, blocksize * 2));
+		}
+		else
+			score_on_identical = 100;
+		// Upper bounds (block hash 2 never matches if the block size is not safe to double)
+		for (blockhash_len_t l = 0; l <= digest_params::max_blockhash_len; l++)
+		{
+			ub1[l] = upper_bound_for(blocksize, bh1len, l);
+			ub2[l] = digest_blocksize::is_safe_to_double(blocksize)
+				? upper_bound_for(blocksize * 2, bh2len, l) : 0;
+			cap1[l] = cap_type(blockhash_score_table<Version>::score_cap(blocksize, bh1len, l));
+			cap2[l] = digest_blocksize::is_safe_to_double(blocksize)
+				? cap_type(blockhash_score_table<Version>::score_cap(blocksize * 2, bh2len, l)) : 0;
+		}
+	}
+public:
+	digest_query(void) noexcept = default; // initialize to undefined state
+	template <bool IsShort>
+	explicit digest_query(const digest_base<IsAlphabetRestricted, IsShort, true>& src) noexcept
+	{
+		#ifdef FFUZZYPP_DEBUG
+		assert(src.is_valid());
+		#endif
+		construct_internal(
+			digest_blocksize_t(src.blocksize()),
+			src.digest_buffer(), src.blockhash1_len(),
+			src.digest_buffer() + src.blockhash1_len(), src.blockhash2_len());
+	}
+	explicit digest_query(const char* str) noexcept(false)
+		: digest_query(digest_base<IsAlphabetRestricted, false, true>(str)) {}
+	explicit digest_query(const std::string& str)
+		: digest_query(str.c_str()) {}
+	// Construct from the digest in the store
+	digest_query(const store_type& store, size_t i) noexcept
+	{
+		construct(store, i);
+	}
+	void construct(const store_type& store, size_t i) noexcept
+	{
+		construct_internal(
+			store.blocksize(i),
+			store.blockhash1(i), store.blockhash1_len(i),
+			store.blockhash2(i), store.blockhash2_len(i));
+	}
+	// Construct from the digest view
+	explicit digest_query(const digest_view<IsAlphabetRestricted>& src) noexcept
+	{
+		construct(src);
+	}
+	void construct(const digest_view<IsAlphabetRestricted>& src) noexcept
+	{
+		#ifdef FFUZZYPP_DEBUG
+		assert(src.is_valid());
+		#endif
+		construct_internal(
+			digest_blocksize_t(src.blocksize()),
+			src.blockhash1(), src.blockhash1_len(),
+			src.blockhash2(), src.blockhash2_len());
+	}
+
+	// Block size filtering
+private:
+	unsigned char relation(digest_blocksize_t b) const noexcept
+	{
+		// eq, lt and gt are mutually exclusive unless the block size is zero
+		// (lt and gt are disabled in that case).
+		return
+			(b == blksize ? rel_eq : 0) |
+			(is_double_valid && b == blksize_double ? rel_lt : 0) |
+			(is_half_valid   && b == blksize_half   ? rel_gt : 0);
+	}
+
+	// Scoring (TStore: digest_store or any store with the same accessors)
+private:
+	template <typename TStore>
+	digest_comparison_score_t score_near(
+		const TStore& store, size_t i, unsigned char rel
+	) const noexcept
+	{
+		switch (rel)
+		{
+			case rel_eq:
+				if (store.is_eq(i, blksize,
+						digest, blkhash1.length(),
+						digest + blkhash1.length(), blkhash2.length()))
+					return score_on_identical;
+				if (digest_blocksize::is_safe_to_double(blksize))
+					return std::max(
+						blkhash1.score(store.blockhash1(i), store.blockhash1_len(i), store.signature1(i), blksize),
+						blkhash2.score(store.blockhash2(i), store.blockhash2_len(i), store.signature2(i), blksize * 2));
+				return blkhash1.score(store.blockhash1(i), store.blockhash1_len(i), store.signature1(i), blksize);
+			case rel_lt:
+				return blkhash2.score(store.blockhash1(i), store.blockhash1_len(i), store.signature1(i), blksize_double);
+			case rel_gt:
+				return blkhash1.score(store.blockhash2(i), store.blockhash2_len(i), store.signature2(i), blksize);
+			default:
+				return 0;
+		}
+	}
+	// Same as score_near but returns zero if the score is less than min_score
+	template <typename TStore>
+	digest_comparison_score_t score_near_threshold(
+		const TStore& store, size_t i, unsigned char rel,
+		digest_comparison_score_t min_score
+	) const noexcept
+	{
+		switch (rel)
+		{
+			case rel_eq:
+			{
+				if (store.is_eq(i, blksize,
+						digest, blkhash1.length(),
+						digest + blkhash1.length(), blkhash2.length()))
+					return score_on_identical < min_score ? 0 : score_on_identical;
+				digest_comparison_score_t score1 = blkhash1.score_threshold(
+					store.blockhash1(i), store.blockhash1_len(i), store.signature1(i), blksize, min_score);
+				if (!digest_blocksize::is_safe_to_double(blksize))
+					return score1;
+				// Only scores exceeding score1 are interesting.
+				digest_comparison_score_t score2 = blkhash2.score_threshold(
+					store.blockhash2(i), store.blockhash2_len(i), store.signature2(i), blksize * 2,
+					score1 ? score1 + 1 : min_score);
+				return std::max(score1, score2);
+			}
+			case rel_lt:
+				return blkhash2.score_threshold(
+					store.blockhash1(i), store.blockhash1_len(i), store.signature1(i), blksize_double, min_score);
+			case rel_gt:
+				return blkhash1.score_threshold(
+					store.blockhash2(i), store.blockhash2_len(i), store.signature2(i), blksize, min_score);
+			default:
+				return 0;
+		}
+	}
+	// Batched scoring (used by compare_range and compare_indices)
+private:
+	static constexpr const size_t lanes = digest_query_params::edit_dist_lanes;
+	// Batching without position arrays computes edit distances one by one (no gain)
+	static constexpr const bool is_batched =
+		digest_query_params::is_edit_dist_batched &&
+		digest_position_array_params<IsAlphabetRestricted>::is_available;
+	typedef internal::digest_query_batch<lanes> batch_type;
+	static void flush(
+		const blockhash_type& qbh, batch_type& batch,
+		const cap_type* caps,
+		digest_comparison_score_t* out
+	) noexcept
+	{
+		if (!batch.count)
+			return;
+		// Fill unused lanes with the first entry (results are ignored)
+		for (size_t k = batch.count; k < lanes; k++)
+		{
+			batch.strs[k] = batch.strs[0];
+			batch.lens[k] = batch.lens[0];
+		}
+		digest_comparison_score_t dists[lanes];
+		qbh.template edit_distances<lanes>(batch.strs, batch.lens, dists);
+		for (size_t k = 0; k < batch.count; k++)
+		{
+			if (dists[k] > batch.max_dists[k])
+				continue;
+			// Table-driven equivalent of blockhash_comparison::score
+			digest_comparison_score_t score = std::min(
+				digest_comparison_score_t(blockhash_score_table<Version>::uncapped_row(
+					size_t(qbh.length()) + batch.lens[k])[dists[k]]),
+				digest_comparison_score_t(caps[batch.lens[k]]));
+			digest_comparison_score_t& dest = out[batch.slots[k]];
+			dest = std::max(dest, score);
+		}
+		batch.count = 0;
+	}
+	static void enqueue(
+		const blockhash_type& qbh, batch_type& batch,
+		digest_blocksize_t blocksize, const cap_type* caps,
+		const char* s2, blockhash_len_t s2len,
+		const blockhash_signature& s2sig,
+		size_t slot,
+		digest_comparison_score_t min_score,
+		digest_comparison_score_t* out
+	) noexcept
+	{
+		digest_comparison_score_t& dest = out[slot];
+		if (!is_batched)
+		{
+			// Score on the spot (skip if the current score is not exceeded)
+			dest = std::max(dest, qbh.score_threshold(
+				s2, s2len, s2sig, blocksize, dest ? dest + 1 : min_score));
+			return;
+		}
+		// No common substrings (no false negatives; see blockhash_signature.hpp)
+		if (!qbh.may_match(s2sig))
+			return;
+		digest_comparison_score_t max_dist;
+		if (!blockhash_comparison<Version>::threshold_max_edit_distance(
+				max_dist, min_score, blocksize, qbh.length(), s2len))
+			return;
+		if (!qbh.has_common_substring(s2, s2len))
+			return;
+		size_t k = batch.count++;
+		batch.strs[k] = s2;
+		batch.lens[k] = s2len;
+		batch.slots[k] = slot;
+		batch.max_dists[k] = max_dist;
+		if (batch.count == lanes)
+			flush(qbh, batch, caps, out);
+	}
+	void prefetch(const store_type& store, size_t i, unsigned char rel) const noexcept
+	{
+		if (rel != rel_lt)
+		{
+			FFUZZYPP_PREFETCH(&store.signature1(i));
+			FFUZZYPP_PREFETCH(store.blockhash1(i));
+		}
+		if (rel != rel_gt)
+		{
+			FFUZZYPP_PREFETCH(&store.signature2(i));
+			FFUZZYPP_PREFETCH(store.blockhash2(i));
+		}
+	}
+public:
+	// Upper bound of the comparison score against i-th candidate
+	template <typename TStore>
+	digest_comparison_score_t upper_bound(const TStore& store, size_t i) const noexcept
+	{
+		switch (relation(store.blocksize(i)))
+		{
+			case rel_eq:
+				// identical digests may have short block hashes
+				if (store.blockhash1_len(i) == blkhash1.length() &&
+					store.blockhash2_len(i) == blkhash2.length())
+					return std::max(score_on_identical,
+						std::max(ub1[store.blockhash1_len(i)], ub2[store.blockhash2_len(i)]));
+				return std::max(ub1[store.blockhash1_len(i)], ub2[store.blockhash2_len(i)]);
+			case rel_lt:
+				return ub2[store.blockhash1_len(i)];
+			case rel_gt:
+				return ub1[store.blockhash2_len(i)];
+			default:
+				return 0;
+		}
+	}
+	// Compare against i-th candidate
+	template <typename TStore>
+	digest_comparison_score_t compare(const TStore& store, size_t i) const noexcept
+	{
+		return score_near(store, i, relation(store.blocksize(i)));
+	}
+	// Compare against i-th candidate (returns zero if the score is less than min_score)
+	template <typename TStore>
+	digest_comparison_score_t compare_threshold(
+		const TStore& store, size_t i,
+		digest_comparison_score_t min_score
+	) const noexcept
+	{
+		return score_near_threshold(store, i, relation(store.blocksize(i)), min_score);
+	}
+	// Candidate range scoring (used by compare_range and compare_indices)
+private:
+	template <typename TIndexOf>
+	void compare_candidates(
+		const store_type& store,
+		size_t count, TIndexOf index_of,
+		digest_comparison_score_t* out,
+		digest_comparison_score_t min_score
+	) const noexcept
+	{
+		static constexpr const size_t block_size = digest_query_params::filter_block_size;
+		static constexpr const size_t pf_distance = digest_query_params::prefetch_distance;
+		const digest_blocksize_t* blksizes = store.blocksize_data();
+		unsigned char rels[block_size];
+		size_t survivors[block_size];
+		batch_type batch1; // against the query block hash 1 (at blksize)
+		batch_type batch2; // against the query block hash 2 (at blksize_double)
+		batch1.count = 0;
+		batch2.count = 0;
+		for (size_t base = 0; base < count; base += block_size)
+		{
+			size_t n = std::min(block_size, count - base);
+			// Pass 1: filter by block size (touches block sizes only)
+			for (size_t k = 0; k < n; k++)
+				rels[k] = relation(blksizes[index_of(base + k)]);
+			// Pass 2: collect survivors (and filter by upper bounds)
+			size_t m = 0;
+			for (size_t k = 0; k < n; k++)
+			{
+				out[base + k] = 0;
+				if (FFUZZYPP_LIKELY(rels[k] == rel_none))
+					continue;
+				if (min_score && upper_bound(store, index_of(base + k)) < min_score)
+					continue;
+				survivors[m++] = k;
+			}
+			// Pass 3: queue block hash pairs of survivors while prefetching following ones
+			for (size_t k = 0; k < m && k < pf_distance; k++)
+				prefetch(store, index_of(base + survivors[k]), rels[survivors[k]]);
+			for (size_t k = 0; k < m; k++)
+			{
+				if (k + pf_distance < m)
+				{
+					size_t kp = survivors[k + pf_distance];
+					prefetch(store, index_of(base + kp), rels[kp]);
+				}
+				size_t kc = survivors[k];
+				size_t i = index_of(base + kc);
+				size_t slot = base + kc;
+				switch (rels[kc])
+				{
+					case rel_eq:
+						if (store.is_eq(i, blksize,
+								digest, blkhash1.length(),
+								digest + blkhash1.length(), blkhash2.length()))
+						{
+							if (score_on_identical >= min_score)
+								out[slot] = score_on_identical;
+							break;
+						}
+						enqueue(blkhash1, batch1, blksize, cap1,
+							store.blockhash1(i), store.blockhash1_len(i), store.signature1(i),
+							slot, min_score, out);
+						if (is_double_valid)
+							enqueue(blkhash2, batch2, blksize_double, cap2,
+								store.blockhash2(i), store.blockhash2_len(i), store.signature2(i),
+								slot, min_score, out);
+						break;
+					case rel_lt:
+						enqueue(blkhash2, batch2, blksize_double, cap2,
+							store.blockhash1(i), store.blockhash1_len(i), store.signature1(i),
+							slot, min_score, out);
+						break;
+					case rel_gt:
+						enqueue(blkhash1, batch1, blksize, cap1,
+							store.blockhash2(i), store.blockhash2_len(i), store.signature2(i),
+							slot, min_score, out);
+						break;
+				}
+			}
+		}
+		flush(blkhash1, batch1, cap1, out);
+		flush(blkhash2, batch2, cap2, out);
+	}
+public:
+	/*
+		Compare against candidates [begin, end) and write the scores to out[0..end-begin).
+		If min_score is given, candidates which cannot reach min_score are not scored
+		(and the score of zero is written instead).  Candidates are skipped before
+		the edit distance computation if their block hash lengths or block size
+		make min_score unreachable.  Edit distances are bounded as in
+		compare_threshold unless they are batched
+		(digest_query_params::is_edit_dist_batched), in which case they are
+		computed in full and discarded if they exceed the maximum for min_score.
+	*/
+	void compare_range(
+		const store_type& store,
+		size_t begin, size_t end,
+		digest_comparison_score_t* out,
+		digest_comparison_score_t min_score = 0
+	) const noexcept
+	{
+		#ifdef FFUZZYPP_DEBUG
+		assert(begin <= end);
+		assert(end <= store.size());
+		#endif
+		compare_candidates(store, end - begin,
+			[begin](size_t k) { return begin + k; }, out, min_score);
+	}
+	/*
+		Compare against candidates indices[0..count) and write the scores to
+		out[0..count) (same as compare_range but candidates need not be contiguous).
+	*/
+	void compare_indices(
+		const store_type& store,
+		const size_t* indices, size_t count,
+		digest_comparison_score_t* out,
+		digest_comparison_score_t min_score = 0
+	) const noexcept
+	{
+		#ifdef FFUZZYPP_DEBUG
+		for (size_t k = 0; k < count; k++)
+			assert(indices[k] < store.size());
+		#endif
+		compare_candidates(store, count,
+			[indices](size_t k) { return indices[k]; }, out, min_score);
+	}
+	// Compare against all candidates and write the scores to out[0..store.size())
+	void compare_all(
+		const store_type& store,
+		digest_comparison_score_t* out,
+		digest_comparison_score_t min_score = 0
+	) const noexcept
+	{
+		compare_range(store, 0, store.size(), out, min_score);
+	}
+
+	// Top-K search
+private:
+	// Comparator for heaps (the "greatest" element is the worst result)
+	static bool is_better(const digest_search_result& a, const digest_search_result& b) noexcept
+	{
+		return a.score > b.score || (a.score == b.score && a.index < b.index);
+	}
+public:
+	/*
+		Search k candidates with the highest scores (ties are broken by smaller indices).
+		Only candidates with the score of min_score or greater (and nonzero) are returned.
+		Results are sorted by the score (descending) and then by the index (ascending).
+
+		Candidates are visited in descending order of their upper bounds
+		(see upper_bound) while the current k-th result is kept on the
+		top of a heap. The search stops once no remaining candidate
+		can beat the k-th result and candidates which can reach the
+		k-th score only are compared with the threshold-aware path.
+	*/
+	void search_top_k(
+		const store_type& store,
+		size_t k,
+		std::vector<digest_search_result>& results,
+		digest_comparison_score_t min_score = 1
+	) const
+	{
+		results.clear();
+		if (k == 0 || min_score > 100)
+			return;
+		if (min_score == 0)
+			min_score = 1;
+		// Bucket candidates by upper bounds (stable; indices are ascending in each bucket)
+		static constexpr const size_t max_bound = 100;
+		size_t counts[max_bound + 2] = {};
+		std::vector<std::pair<size_t, digest_comparison_score_t>> candidates;
+		const digest_blocksize_t* blksizes = store.blocksize_data();
+		for (size_t i = 0; i < store.size(); i++)
+		{
+			if (FFUZZYPP_LIKELY(relation(blksizes[i]) == rel_none))
+				continue;
+			digest_comparison_score_t ub = upper_bound(store, i);
+			if (ub < min_score)
+				continue;
+			#ifdef FFUZZYPP_DEBUG
+			assert(ub <= max_bound);
+			#endif
+			candidates.push_back(std::make_pair(i, ub));
+			counts[max_bound - ub + 1]++;
+		}
+		for (size_t b = 1; b <= max_bound + 1; b++)
+			counts[b] += counts[b - 1];
+		std::vector<std::pair<size_t, digest_comparison_score_t>> order(candidates.size());
+		for (const auto& c : candidates)
+			order[counts[max_bound - c.second]++] = c;
+		// Visit candidates in descending order of upper bounds
+		results.reserve(k);
+		for (size_t n = 0; n < order.size(); n++)
+		{
+			size_t i = order[n].first;
+			digest_comparison_score_t threshold = min_score;
+			if (results.size() == k)
+			{
+				const digest_search_result& worst = results.front();
+				digest_comparison_score_t ub = order[n].second;
+				// Remaining candidates have the same or lower bounds.
+				if (ub < worst.score || (ub == worst.score && i > worst.index))
+				{
+					if (ub < worst.score)
+						break;
+					continue;
+				}
+				threshold = worst.score;
+			}
+			digest_comparison_score_t score = compare_threshold(store, i, threshold);
+			if (!score)
+				continue;
+			digest_search_result r = { i, score };
+			if (results.size() < k)
+			{
+				results.push_back(r);
+				std::push_heap(results.begin(), results.end(), is_better);
+			}
+			else if (is_better(r, results.front()))
+			{
+				std::pop_heap(results.begin(), results.end(), is_better);
+				results.back() = r;
+				std::push_heap(results.begin(), results.end(), is_better);
+			}
+		}
+		std::sort_heap(results.begin(), results.end(), is_better);
+	}
+	std::vector<digest_search_result> search_top_k(
+		const store_type& store,
+		size_t k,
+		digest_comparison_score_t min_score = 1
+	) const
+	{
+		std::vector<digest_search_result> results;
+		search_top_k(store, k, results, min_score);
+		return results;
+	}
+};
+
+}
+
+#endif
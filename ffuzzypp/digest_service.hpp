@@ -0,0 +1,450 @@
+/*
+
+	ffuzzy++ : C++ implementation of fast fuzzy hashing
+
+	digest_service.hpp
+	Similarity search service (protocol, handler, server and client)
+
+	Copyright (C) 2026 Tsukasa OI <floss_ssdeep@irq.a4lg.com>
+
+
+	Permission to use, copy, modify, and/or distribute this software for
+	any purpose with or without fee is hereby granted, provided that the
+	above copyright notice and this permission notice appear in all copies.
+
+	THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+	WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+	MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+	ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+	WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+	ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+	OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+
+*/
+#ifndef FFUZZYPP_DIGEST_SERVICE_HPP
+#define FFUZZYPP_DIGEST_SERVICE_HPP
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "digest_base.hpp"
+#include "digest_comparison.hpp"
+#include "digest_query.hpp"
+#include "digest_shard.hpp"
+#include "digest_view.hpp"
+#include "digest_wire.hpp"
+#include "utils/socket_stream.hpp"
+
+namespace ffuzzy {
+
+// Query of the service (top_k of zero means all matches)
+struct digest_service_query
+{
+	std::string digest;
+	digest_comparison_score_t min_score;
+	size_t top_k;
+};
+
+// Reply to a query (is_valid is false if the digest cannot be parsed)
+struct digest_service_reply
+{
+	bool is_valid;
+	std::vector<digest_search_result> matches;
+};
+
+/*
+	Service protocol
+
+	Requests and replies are frames (see digest_shard_protocol) and
+	integers are little-endian.  A request carries a batch of queries
+	and its reply carries results of all of them in the same order.
+	Replies on a connection may come in any order (a client may send
+	many requests before reading replies) and are matched by the
+	request ID.
+
+	Request:
+		request ID (u64), number of queries (u32), then for each query:
+		min_score (u32), top_k (u32; zero for all matches),
+		digest length (u16), digest (text form)
+	Reply:
+		request ID (u64), number of queries (u32), then for each query:
+		status (u8; 0 if valid, 1 if the digest is invalid),
+		number of matches (u32), then for each match:
+		ID (u64), score (u32)
+*/
+class digest_service_protocol
+{
+private:
+	digest_service_protocol(void) = delete;
+	digest_service_protocol(const digest_service_protocol&) = delete;
+	typedef internal::digest_wire wire;
+public:
+	static constexpr const uint_least32_t max_queries = 65536;
+	static constexpr const size_t max_digest_length = 1024;
+	static constexpr const unsigned status_ok = 0;
+	static constexpr const unsigned status_invalid_digest = 1;
+public:
+	static void encode_request(
+		uint_least64_t request_id,
+		const std::vector<digest_service_query>& queries,
+		std::vector<unsigned char>& buf
+	)
+	{
+		#ifdef FFUZZYPP_DEBUG
+		assert(queries.size() <= max_queries);
+		#endif
+		buf.clear();
+		wire::put_u64(buf, request_id);
+		wire::put_u32(buf, uint_least32_t(queries.size()));
+		for (const digest_service_query& q : queries)
+		{
+			size_t len = std::min(q.digest.size(), max_digest_length);
+			wire::put_u32(buf, uint_least32_t(q.min_score));
+			wire::put_u32(buf, uint_least32_t(std::min(q.top_k, size_t(0xfffffffful))));
+			wire::put_u8(buf, unsigned(len & 0xff));
+			wire::put_u8(buf, unsigned(len >> 8));
+			buf.insert(buf.end(), q.digest.data(), q.digest.data() + len);
+		}
+	}
+	static bool decode_reply(
+		const unsigned char* data, size_t size,
+		uint_least64_t& request_id,
+		std::vector<digest_service_reply>& replies
+	)
+	{
+		const unsigned char* end = data + size;
+		if (size < 12)
+			return false;
+		request_id = wire::get_u64(data);
+		uint_least32_t count = wire::get_u32(data + 8);
+		if (count > max_queries)
+			return false;
+		const unsigned char* p = data + 12;
+		replies.resize(count);
+		for (digest_service_reply& r : replies)
+		{
+			if (end - p < 5)
+				return false;
+			r.is_valid = p[0] == status_ok;
+			size_t n = wire::get_u32(p + 1);
+			p += 5;
+			if (size_t(end - p) / 12 < n)
+				return false;
+			r.matches.resize(n);
+			for (digest_search_result& m : r.matches)
+			{
+				m.index = size_t(wire::get_u64(p));
+				m.score = digest_comparison_score_t(wire::get_u32(p + 8));
+				p += 12;
+			}
+		}
+		return p == end;
+	}
+};
+
+
+/*
+	Request handler (independent from the transport)
+
+	TIndex is an index with search(view, results, min_score) const
+	(such as digest_index or digest_snapshot) and it must not be
+	modified while requests are being handled.  handle is thread-safe.
+*/
+template <typename TIndex>
+class digest_service_handler
+{
+public:
+	typedef TIndex index_type;
+	typedef typename TIndex::view_type view_type;
+	static constexpr const bool is_alphabet_restricted = TIndex::is_alphabet_restricted;
+private:
+	typedef internal::digest_wire wire;
+	const TIndex* idx;
+public:
+	explicit digest_service_handler(const TIndex& index) noexcept : idx(&index) {}
+	const TIndex& index(void) const noexcept { return *idx; }
+	// Makes a reply (false if the request is malformed)
+	bool handle(
+		const unsigned char* data, size_t size,
+		std::vector<unsigned char>& reply,
+		std::vector<digest_search_result>& results
+	) const
+	{
+		reply.clear();
+		const unsigned char* end = data + size;
+		if (size < 12)
+			return false;
+		uint_least32_t count = wire::get_u32(data + 8);
+		if (count > digest_service_protocol::max_queries)
+			return false;
+		wire::put_u64(reply, wire::get_u64(data));
+		wire::put_u32(reply, count);
+		const unsigned char* p = data + 12;
+		char str[digest_service_protocol::max_digest_length + 1];
+		for (uint_least32_t n = 0; n < count; n++)
+		{
+			if (end - p < 10)
+				return false;
+			digest_comparison_score_t min_score = digest_comparison_score_t(wire::get_u32(p));
+			size_t top_k = wire::get_u32(p + 4);
+			size_t len = size_t(p[8]) | (size_t(p[9]) << 8);
+			p += 10;
+			if (len > digest_service_protocol::max_digest_length || size_t(end - p) < len)
+				return false;
+			memcpy(str, p, len);
+			str[len] = '\0';
+			p += len;
+			digest_base<is_alphabet_restricted, false, true> d;
+			if (!decltype(d)::parse(d, str))
+			{
+				wire::put_u8(reply, digest_service_protocol::status_invalid_digest);
+				wire::put_u32(reply, 0);
+				continue;
+			}
+			idx->search(view_type(d), results, min_score);
+			if (top_k && results.size() > top_k)
+				results.resize(top_k);
+			wire::put_u8(reply, digest_service_protocol::status_ok);
+			wire::put_u32(reply, uint_least32_t(results.size()));
+			for (const digest_search_result& r : results)
+			{
+				wire::put_u64(reply, r.index);
+				wire::put_u32(reply, uint_least32_t(r.score));
+			}
+		}
+		return p == end;
+	}
+};
+
+
+#ifndef FFUZZYPP_DISABLE_SOCKETS
+
+/*
+	Service client
+
+	Requests can be pipelined: send any number of requests and then
+	receive replies (possibly in a different order).
+*/
+class digest_service_client
+{
+private:
+	socket_stream sock;
+	std::vector<unsigned char> buf;
+public:
+	explicit digest_service_client(socket_stream&& s) noexcept : sock(std::move(s)) {}
+	explicit digest_service_client(const char* path) noexcept : sock(socket_stream::connect_unix(path)) {}
+	bool is_open(void) const noexcept { return sock.is_open(); }
+	bool send(uint_least64_t request_id, const std::vector<digest_service_query>& queries)
+	{
+		digest_service_protocol::encode_request(request_id, queries, buf);
+		return digest_shard_protocol::write_frame(sock, buf);
+	}
+	bool receive(uint_least64_t& request_id, std::vector<digest_service_reply>& replies)
+	{
+		return digest_shard_protocol::read_frame(sock, buf)
+			&& digest_service_protocol::decode_reply(buf.data(), buf.size(), request_id, replies);
+	}
+};
+
+/*
+	Service server (on a Unix domain socket)
+
+	Each connection has a reader thread which reads requests and puts
+	them into the queue shared by worker threads.  Workers handle
+	requests and write replies as soon as they are ready so that
+	pipelined requests on a connection are processed in parallel.
+	Each connection can have up to max_pending requests in flight
+	(then the reader stops reading until replies are sent).
+*/
+template <typename TIndex>
+class digest_service_server
+{
+public:
+	typedef digest_service_handler<TIndex> handler_type;
+	static constexpr const size_t max_pending = 64;
+private:
+	struct connection
+	{
+		socket_stream sock;
+		std::mutex write_mutex;
+		size_t pending; // (guarded by queue_mutex)
+		explicit connection(socket_stream&& s) : sock(std::move(s)), pending(0) {}
+	};
+	struct job
+	{
+		std::shared_ptr<connection> conn;
+		std::vector<unsigned char> request;
+	};
+	handler_type handler;
+	unsigned worker_count;
+	socket_listener listener;
+	std::mutex queue_mutex;
+	std::condition_variable queue_cv;  // jobs or stopping
+	std::condition_variable space_cv;  // pending decreased or stopping
+	std::condition_variable reader_cv; // a reader exited
+	std::deque<job> jobs;
+	std::vector<std::weak_ptr<connection>> connections;
+	size_t reader_count;
+	bool stopping;
+private:
+	void worker_main(void)
+	{
+		std::vector<unsigned char> reply;
+		std::vector<digest_search_result> results;
+		std::unique_lock<std::mutex> lock(queue_mutex);
+		while (true)
+		{
+			queue_cv.wait(lock, [this] { return stopping || !jobs.empty(); });
+			if (stopping)
+				return;
+			job j = std::move(jobs.front());
+			jobs.pop_front();
+			lock.unlock();
+			bool ok = false;
+			try { ok = handler.handle(j.request.data(), j.request.size(), reply, results); }
+			catch (...) {}
+			if (ok)
+			{
+				std::lock_guard<std::mutex> write_lock(j.conn->write_mutex);
+				digest_shard_protocol::write_frame(j.conn->sock, reply);
+			}
+			else
+			{
+				// malformed request: drop the connection
+				j.conn->sock.shutdown();
+			}
+			lock.lock();
+			j.conn->pending--;
+			space_cv.notify_all();
+		}
+	}
+	void reader_main(std::shared_ptr<connection> conn)
+	{
+		std::vector<unsigned char> request;
+		while (true)
+		{
+			bool ok = false;
+			try { ok = digest_shard_protocol::read_frame(conn->sock, request); }
+			catch (...) {}
+			if (!ok)
+				break;
+			std::unique_lock<std::mutex> lock(queue_mutex);
+			space_cv.wait(lock, [&] { return stopping || conn->pending < max_pending; });
+			if (stopping)
+				break;
+			conn->pending++;
+			jobs.push_back(job{ conn, std::move(request) });
+			request = std::vector<unsigned char>();
+			queue_cv.notify_one();
+		}
+		std::lock_guard<std::mutex> lock(queue_mutex);
+		reader_count--;
+		reader_cv.notify_all();
+	}
+public:
+	/*
+		The index must outlive the server and must not be modified while
+		serving.  If workers is zero, std::thread::hardware_concurrency()
+		is used.
+	*/
+	explicit digest_service_server(const TIndex& index, unsigned workers = 0)
+		: handler(index)
+		, worker_count(workers ? workers : std::max(1u, std::thread::hardware_concurrency()))
+		, reader_count(0)
+		, stopping(false)
+	{}
+	digest_service_server(const digest_service_server&) = delete;
+	digest_service_server& operator=(const digest_service_server&) = delete;
+	bool listen(const std::string& path)
+	{
+		return listener.listen_unix(path);
+	}
+	/*
+		Accepts connections until stop is called (from another thread)
+		and waits for all threads to exit.  Returns false if no worker
+		threads could be created.
+	*/
+	bool run(void)
+	{
+		std::vector<std::thread> workers;
+		for (unsigned t = 0; t < worker_count; t++)
+		{
+			try { workers.push_back(std::thread([this] { worker_main(); })); }
+			catch (const std::system_error&) { break; }
+		}
+		bool ok = !workers.empty();
+		while (ok)
+		{
+			socket_stream s = listener.accept();
+			std::unique_lock<std::mutex> lock(queue_mutex);
+			if (stopping)
+				break;
+			if (!s.is_open())
+			{
+				// (such as running out of descriptors)
+				lock.unlock();
+				std::this_thread::sleep_for(std::chrono::milliseconds(10));
+				continue;
+			}
+			std::shared_ptr<connection> conn = std::make_shared<connection>(std::move(s));
+			try
+			{
+				std::thread([this, conn] { reader_main(conn); }).detach();
+				reader_count++;
+			}
+			catch (const std::system_error&) { continue; }
+			connections.erase(std::remove_if(connections.begin(), connections.end(),
+				[](const std::weak_ptr<connection>& c) { return c.expired(); }), connections.end());
+			connections.push_back(conn);
+		}
+		if (!ok)
+			stop();
+		for (std::thread& t : workers)
+			t.join();
+		std::unique_lock<std::mutex> lock(queue_mutex);
+		reader_cv.wait(lock, [this] { return reader_count == 0; });
+		jobs.clear();
+		listener.close();
+		return ok;
+	}
+	// Stops the server (thread-safe; pending requests are dropped)
+	void stop(void)
+	{
+		std::lock_guard<std::mutex> lock(queue_mutex);
+		stopping = true;
+		listener.shutdown();
+		for (const std::weak_ptr<connection>& c : connections)
+			if (std::shared_ptr<connection> conn = c.lock())
+				conn->sock.shutdown();
+		queue_cv.notify_all();
+		space_cv.notify_all();
+	}
+};
+
+#endif
+
+
+#ifdef FFUZZYPP_DECLARATIONS
+constexpr const uint_least32_t digest_service_protocol::max_queries;
+constexpr const size_t digest_service_protocol::max_digest_length;
+constexpr const unsigned digest_service_protocol::status_ok;
+constexpr const unsigned digest_service_protocol::status_invalid_digest;
+#endif
+
+}
+
+#endif
@@ -0,0 +1,493 @@
+/*
+
+	ffuzzy++ : C++ implementation of fast fuzzy hashing
+
+	digest_shard.hpp
+	Sharding by block size and query routing
+
+	Copyright (C) 2026 Tsukasa OI <floss_ssdeep@irq.a4lg.com>
+
+
+	Permission to use, copy, modify, and/or distribute this software for
+	any purpose with or without fee is hereby granted, provided that the
+	above copyright notice and this permission notice appear in all copies.
+
+	THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+	WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+	MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+	ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+	WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+	ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+	OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+
+*/
+#ifndef FFUZZYPP_DIGEST_SHARD_HPP
+#define FFUZZYPP_DIGEST_SHARD_HPP
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <algorithm>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "digest_blocksize.hpp"
+#include "digest_base.hpp"
+#include "digest_comparison.hpp"
+#include "digest_index.hpp"
+#include "digest_query.hpp"
+#include "digest_view.hpp"
+#include "digest_wire.hpp"
+#include "utils/socket_stream.hpp"
+
+namespace ffuzzy {
+
+// Thrown when a remote shard fails (connection or protocol error)
+struct digest_shard_io_error {};
+
+/*
+	Assignment of digests to shards
+
+	Digests are only compared if their block sizes are "near" and so,
+	digests are partitioned by block size index (non-natural block
+	sizes are in an extra slot since they are never near to natural
+	ones).  slots_per_group consecutive slots make a group and each
+	group is a shard unless it is split into sub-shards (by the digest
+	hash) because it holds too many digests.
+
+	A query only needs shards of its own slot and neighboring slots.
+*/
+class digest_shard_map
+{
+public:
+	static constexpr const unsigned slot_count = digest_blocksize::number_of_blockhashes + 1;
+	static constexpr const unsigned non_natural_slot = digest_blocksize::number_of_blockhashes;
+private:
+	unsigned slots_per_grp;
+	std::vector<unsigned> subs;  // number of sub-shards (per group)
+	std::vector<unsigned> first; // first shard (per group)
+	void update(void)
+	{
+		first.resize(subs.size());
+		unsigned n = 0;
+		for (size_t g = 0; g < subs.size(); g++)
+		{
+			first[g] = n;
+			n += subs[g];
+		}
+	}
+	unsigned group_of_slot(unsigned slot) const noexcept { return slot / slots_per_grp; }
+	void append_group(unsigned g, std::vector<unsigned>& out) const
+	{
+		for (unsigned k = 0; k < subs[g]; k++)
+			out.push_back(first[g] + k);
+	}
+public:
+	explicit digest_shard_map(unsigned slots_per_group = 1)
+		: slots_per_grp(slots_per_group)
+		, subs((slot_count + slots_per_group - 1) / slots_per_group, 1u)
+	{
+		#ifdef FFUZZYPP_DEBUG
+		assert(slots_per_group != 0);
+		#endif
+		update();
+	}
+	static unsigned slot_of(digest_blocksize_t blocksize) noexcept
+	{
+		if (!digest_blocksize::is_natural(blocksize))
+			return non_natural_slot;
+		return digest_blocksize::natural_to_index(blocksize);
+	}
+	unsigned slots_per_group(void) const noexcept { return slots_per_grp; }
+	unsigned group_count(void) const noexcept { return unsigned(subs.size()); }
+	unsigned shard_count(void) const noexcept { return first.back() + subs.back(); }
+	unsigned sub_shards(digest_blocksize_t blocksize) const noexcept
+	{
+		return subs[group_of_slot(slot_of(blocksize))];
+	}
+	// Splits the group holding given block size into n sub-shards
+	digest_shard_map& split(digest_blocksize_t blocksize, unsigned n)
+	{
+		#ifdef FFUZZYPP_DEBUG
+		assert(n != 0);
+		#endif
+		subs[group_of_slot(slot_of(blocksize))] = n;
+		update();
+		return *this;
+	}
+public:
+	template <bool IsAlphabetRestricted>
+	unsigned shard_of(const digest_view<IsAlphabetRestricted>& d) const noexcept
+	{
+		unsigned g = group_of_slot(slot_of(digest_blocksize_t(d.blocksize())));
+		if (subs[g] == 1)
+			return first[g];
+		return first[g] + unsigned(d.hash() % subs[g]);
+	}
+	// Shards which may hold digests near to given block size (sorted)
+	void shards_near(digest_blocksize_t blocksize, std::vector<unsigned>& out) const
+	{
+		out.clear();
+		unsigned slot = slot_of(blocksize);
+		unsigned lo = slot, hi = slot;
+		if (slot != non_natural_slot)
+		{
+			if (lo != 0)
+				lo--;
+			if (hi + 1 < non_natural_slot)
+				hi++;
+		}
+		for (unsigned g = group_of_slot(lo); g <= group_of_slot(hi); g++)
+			append_group(g, out);
+	}
+	std::vector<unsigned> shards_near(digest_blocksize_t blocksize) const
+	{
+		std::vector<unsigned> out;
+		shards_near(blocksize, out);
+		return out;
+	}
+};
+
+
+/*
+	In-process shard
+
+	Shards used by digest_shard_router provide:
+		size_t push_back(const view_type&);  // returns the local index
+		void begin_search(const view_type&, digest_comparison_score_t min_score);
+		void end_search(std::vector<digest_search_result>&);
+	Every begin_search is followed by end_search so that remote shards
+	can process a query in parallel.
+*/
+template <bool IsAlphabetRestricted, comparison_version Version = comparison_version::latest>
+class digest_local_shard
+{
+public:
+	typedef digest_view<IsAlphabetRestricted> view_type;
+	typedef digest_index<IsAlphabetRestricted, Version> index_type;
+private:
+	index_type idx;
+	view_type pending_query;
+	char pending_buf[digest_params::max_blockhash_len * 2];
+	digest_comparison_score_t pending_min_score;
+public:
+	const index_type& index(void) const noexcept { return idx; }
+	size_t push_back(const view_type& d) { return idx.push_back(d); }
+	void begin_search(const view_type& query, digest_comparison_score_t min_score)
+	{
+		// the query may not outlive this call
+		memcpy(pending_buf, query.blockhash1(), query.blockhash1_len());
+		memcpy(pending_buf + digest_params::max_blockhash_len, query.blockhash2(), query.blockhash2_len());
+		pending_query = view_type(digest_blocksize_t(query.blocksize()),
+			pending_buf, blockhash_len_t(query.blockhash1_len()),
+			pending_buf + digest_params::max_blockhash_len, blockhash_len_t(query.blockhash2_len()));
+		pending_min_score = min_score;
+	}
+	void end_search(std::vector<digest_search_result>& results)
+	{
+		idx.search(pending_query, results, pending_min_score);
+	}
+};
+
+
+#ifndef FFUZZYPP_DISABLE_SOCKETS
+
+/*
+	Shard protocol (over a stream socket)
+
+	Each request and reply is a frame: payload length (u32) and payload
+	(integers and digests are encoded as in digest_wire.hpp).
+
+	Requests (the first byte of payload is the operation):
+		insert : digest                 -> local index (u64)
+		search : min_score (u32), digest -> count (u32), then
+		         count * (local index (u64), score (u32))
+*/
+class digest_shard_protocol
+{
+private:
+	digest_shard_protocol(void) = delete;
+	digest_shard_protocol(const digest_shard_protocol&) = delete;
+public:
+	static constexpr const unsigned op_insert = 1;
+	static constexpr const unsigned op_search = 2;
+	static constexpr const uint_least32_t max_frame_size = 1u << 30;
+	static bool write_frame(socket_stream& s, const std::vector<unsigned char>& payload) noexcept
+	{
+		unsigned char header[4];
+		for (unsigned i = 0; i < 4; i++)
+			header[i] = static_cast<unsigned char>(uint_least32_t(payload.size()) >> (i * 8));
+		return s.write_all(header, 4) && s.write_all(payload.data(), payload.size());
+	}
+	static bool read_frame(socket_stream& s, std::vector<unsigned char>& payload)
+	{
+		unsigned char header[4];
+		if (!s.read_all(header, 4))
+			return false;
+		uint_least32_t size = internal::digest_wire::get_u32(header);
+		if (size > max_frame_size)
+			return false;
+		payload.resize(size);
+		return s.read_all(payload.data(), size);
+	}
+};
+
+/*
+	Shard served by another process (client side)
+*/
+template <bool IsAlphabetRestricted>
+class digest_remote_shard
+{
+public:
+	typedef digest_view<IsAlphabetRestricted> view_type;
+private:
+	typedef internal::digest_wire wire;
+	socket_stream sock;
+	std::vector<unsigned char> buf;
+public:
+	explicit digest_remote_shard(socket_stream&& s) noexcept : sock(std::move(s)) {}
+	digest_remote_shard(digest_remote_shard&&) = default;
+	digest_remote_shard& operator=(digest_remote_shard&&) = default;
+	socket_stream& stream(void) noexcept { return sock; }
+public:
+	size_t push_back(const view_type& d) noexcept(false)
+	{
+		buf.clear();
+		wire::put_u8(buf, digest_shard_protocol::op_insert);
+		wire::put_view(buf, d);
+		if (!digest_shard_protocol::write_frame(sock, buf) ||
+			!digest_shard_protocol::read_frame(sock, buf) || buf.size() != 8)
+			throw digest_shard_io_error();
+		return size_t(wire::get_u64(buf.data()));
+	}
+	void begin_search(const view_type& query, digest_comparison_score_t min_score) noexcept(false)
+	{
+		buf.clear();
+		wire::put_u8(buf, digest_shard_protocol::op_search);
+		wire::put_u32(buf, uint_least32_t(min_score));
+		wire::put_view(buf, query);
+		if (!digest_shard_protocol::write_frame(sock, buf))
+			throw digest_shard_io_error();
+	}
+	void end_search(std::vector<digest_search_result>& results) noexcept(false)
+	{
+		results.clear();
+		if (!digest_shard_protocol::read_frame(sock, buf) || buf.size() < 4)
+			throw digest_shard_io_error();
+		size_t count = wire::get_u32(buf.data());
+		if ((buf.size() - 4) / 12 != count || (buf.size() - 4) % 12 != 0)
+			throw digest_shard_io_error();
+		for (size_t n = 0; n < count; n++)
+		{
+			const unsigned char* p = buf.data() + 4 + n * 12;
+			results.push_back(digest_search_result{
+				size_t(wire::get_u64(p)), digest_comparison_score_t(wire::get_u32(p + 8)) });
+		}
+	}
+};
+
+/*
+	Shard server (holds an index and serves one connection)
+*/
+template <bool IsAlphabetRestricted, comparison_version Version = comparison_version::latest>
+class digest_shard_server
+{
+public:
+	typedef digest_view<IsAlphabetRestricted> view_type;
+	typedef digest_index<IsAlphabetRestricted, Version> index_type;
+private:
+	typedef internal::digest_wire wire;
+	index_type idx;
+	std::vector<unsigned char> request;
+	std::vector<unsigned char> reply;
+	std::vector<digest_search_result> results;
+public:
+	const index_type& index(void) const noexcept { return idx; }
+	// Serves one request (false on the end of stream or errors)
+	bool serve_one(socket_stream& s)
+	{
+		if (!digest_shard_protocol::read_frame(s, request) || request.empty())
+			return false;
+		const unsigned char* p = request.data() + 1;
+		const unsigned char* end = request.data() + request.size();
+		view_type d;
+		reply.clear();
+		switch (request[0])
+		{
+			case digest_shard_protocol::op_insert:
+				if (!wire::get_view(p, end, d) || p != end)
+					return false;
+				wire::put_u64(reply, idx.push_back(d));
+				break;
+			case digest_shard_protocol::op_search:
+			{
+				if (end - p < 4)
+					return false;
+				digest_comparison_score_t min_score = digest_comparison_score_t(wire::get_u32(p));
+				p += 4;
+				if (!wire::get_view(p, end, d) || p != end)
+					return false;
+				idx.search(d, results, min_score);
+				wire::put_u32(reply, uint_least32_t(results.size()));
+				for (const digest_search_result& r : results)
+				{
+					wire::put_u64(reply, r.index);
+					wire::put_u32(reply, uint_least32_t(r.score));
+				}
+				break;
+			}
+			default:
+				return false;
+		}
+		return digest_shard_protocol::write_frame(s, reply);
+	}
+	// Serves requests until the end of stream
+	void serve(socket_stream& s)
+	{
+		while (serve_one(s)) {}
+	}
+};
+
+#endif
+
+
+/*
+	Query router over shards
+
+	Assigns global IDs (in the order of insertion) to digests, sends
+	each digest to its shard and each query only to shards which may
+	hold near block sizes.  Queries are sent to all those shards before
+	any reply is awaited and results are merged (sorted by the score
+	[descending] and then by the global ID [ascending]).
+
+	If a shard throws an exception, the router must not be used again
+	(replies from other shards may be left unread).
+*/
+template <typename TShard, bool IsAlphabetRestricted>
+class digest_shard_router
+{
+public:
+	typedef TShard shard_type;
+	typedef digest_view<IsAlphabetRestricted> view_type;
+private:
+	digest_shard_map map;
+	std::vector<TShard> shards;
+	std::vector<std::vector<uint_least64_t>> global_ids; // per shard
+	uint_least64_t next_id;
+	std::vector<unsigned> targets;
+	std::vector<digest_search_result> partial;
+public:
+	digest_shard_router(const digest_shard_map& shard_map, std::vector<TShard>&& shard_list)
+		: map(shard_map)
+		, shards(std::move(shard_list))
+		, global_ids(shards.size())
+		, next_id(0)
+	{
+		#ifdef FFUZZYPP_DEBUG
+		assert(shards.size() == map.shard_count());
+		#endif
+	}
+	const digest_shard_map& shard_map(void) const noexcept { return map; }
+	size_t shard_count(void) const noexcept { return shards.size(); }
+	TShard& shard(size_t i) noexcept { return shards[i]; }
+	size_t size(void) const noexcept { return size_t(next_id); }
+	size_t shard_size(size_t i) const noexcept { return global_ids[i].size(); }
+
+	// Insertion
+public:
+	uint_least64_t push_back(const view_type& d)
+	{
+		unsigned s = map.shard_of(d);
+		size_t local = shards[s].push_back(d);
+		#ifdef FFUZZYPP_DEBUG
+		assert(local == global_ids[s].size());
+		#else
+		(void)local;
+		#endif
+		global_ids[s].push_back(next_id);
+		return next_id++;
+	}
+	template <bool IsShort, bool IsNormalized>
+	uint_least64_t push_back(const digest_base<IsAlphabetRestricted, IsShort, IsNormalized>& d)
+	{
+		char buf[digest_params::max_blockhash_len * 2];
+		return push_back(view_type::normalize(buf, d));
+	}
+	uint_least64_t push_back(const char* str) noexcept(false)
+	{
+		return push_back(digest_base<IsAlphabetRestricted, false, true>(str));
+	}
+	uint_least64_t push_back(const std::string& str)
+	{
+		return push_back(str.c_str());
+	}
+
+	// Search
+private:
+	static bool is_better(const digest_search_result& a, const digest_search_result& b) noexcept
+	{
+		return a.score > b.score || (a.score == b.score && a.index < b.index);
+	}
+public:
+	void search(
+		const view_type& query,
+		std::vector<digest_search_result>& results,
+		digest_comparison_score_t min_score = 1
+	)
+	{
+		results.clear();
+		map.shards_near(digest_blocksize_t(query.blocksize()), targets);
+		for (unsigned s : targets)
+			shards[s].begin_search(query, min_score);
+		for (unsigned s : targets)
+		{
+			shards[s].end_search(partial);
+			for (const digest_search_result& r : partial)
+			{
+				if (r.index >= global_ids[s].size())
+					throw digest_shard_io_error();
+				results.push_back(digest_search_result{ size_t(global_ids[s][r.index]), r.score });
+			}
+		}
+		std::sort(results.begin(), results.end(), is_better);
+	}
+	std::vector<digest_search_result> search(
+		const view_type& query,
+		digest_comparison_score_t min_score = 1
+	)
+	{
+		std::vector<digest_search_result> results;
+		search(query, results, min_score);
+		return results;
+	}
+	std::vector<digest_search_result> search_top_k(
+		const view_type& query,
+		size_t k,
+		digest_comparison_score_t min_score = 1
+	)
+	{
+		std::vector<digest_search_result> results;
+		search(query, results, min_score);
+		if (results.size() > k)
+			results.resize(k);
+		return results;
+	}
+};
+
+
+#ifdef FFUZZYPP_DECLARATIONS
+constexpr const unsigned digest_shard_map::slot_count;
+constexpr const unsigned digest_shard_map::non_natural_slot;
+#ifndef FFUZZYPP_DISABLE_SOCKETS
+constexpr const unsigned digest_shard_protocol::op_insert;
+constexpr const unsigned digest_shard_protocol::op_search;
+constexpr const uint_least32_t digest_shard_protocol::max_frame_size;
+#endif
+#endif
+
+}
+
+#endif
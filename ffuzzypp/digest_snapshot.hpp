@@ -0,0 +1,544 @@
+/*
+
+	ffuzzy++ : C++ implementation of fast fuzzy hashing
+
+	digest_snapshot.hpp
+	Position-independent snapshot of the inverted index
+
+	Copyright (C) 2026 Tsukasa OI <floss_ssdeep@irq.a4lg.com>
+
+
+	Permission to use, copy, modify, and/or distribute this software for
+	any purpose with or without fee is hereby granted, provided that the
+	above copyright notice and this permission notice appear in all copies.
+
+	THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+	WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+	MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+	ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+	WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+	ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+	OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+
+*/
+#ifndef FFUZZYPP_DIGEST_SNAPSHOT_HPP
+#define FFUZZYPP_DIGEST_SNAPSHOT_HPP
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+#include <algorithm>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+#include "digest_blocksize.hpp"
+#include "digest_data.hpp"
+#include "digest_comparison.hpp"
+#include "digest_index.hpp"
+#include "digest_position_array.hpp"
+#include "digest_query.hpp"
+#include "digest_view.hpp"
+
+namespace ffuzzy {
+
+namespace internal
+{
+	/*
+		Snapshot layout (all integers in the native byte order)
+
+		header
+		uint32_t  blocksizes     [digest_count]
+		uint8_t   blkhash1_lens  [digest_count]
+		uint8_t   blkhash2_lens  [digest_count]
+		char      blkhash_chars  [digest_count][2][max_blockhash_len]
+		bucket    buckets        [bucket_count + 1]   (sorted by block size; last one is a sentinel)
+		uint64_t  grams          [gram_count]         (sorted in each bucket)
+		uint64_t  posting_begins [gram_count + 1]
+		uint32_t  postings       [posting_count]      (sorted in each posting list)
+		unindexed unindexed      [unindexed_count]    (sorted by hash and index)
+
+		Each section starts at an 8-byte boundary.  Everything is
+		addressed by offsets from the beginning of the snapshot.
+	*/
+	struct digest_snapshot_header
+	{
+		char magic[8];
+		uint32_t format_version;
+		uint32_t byte_order;
+		uint32_t flags;
+		uint32_t max_blockhash_len;
+		uint32_t substr_size;
+		uint32_t hash_size;
+		uint64_t digest_count;
+		uint64_t bucket_count;
+		uint64_t gram_count;
+		uint64_t posting_count;
+		uint64_t unindexed_count;
+	};
+	struct digest_snapshot_bucket
+	{
+		uint64_t blocksize;
+		uint64_t gram_begin;
+	};
+	struct digest_snapshot_unindexed
+	{
+		uint64_t hash;
+		uint64_t index;
+	};
+
+	class digest_snapshot_layout
+	{
+	public:
+		static const char* magic(void) noexcept { return "ffzpsnap"; }
+		static constexpr const uint32_t format_version = 1;
+		static constexpr const uint32_t byte_order = 0x01020304ul;
+		static constexpr const uint32_t flag_alphabet_restricted = 1;
+		static constexpr const size_t blkhash_stride = digest_params::max_blockhash_len * 2;
+	public:
+		uint64_t blocksizes;
+		uint64_t blkhash1_lens;
+		uint64_t blkhash2_lens;
+		uint64_t blkhash_chars;
+		uint64_t buckets;
+		uint64_t grams;
+		uint64_t posting_begins;
+		uint64_t postings;
+		uint64_t unindexed;
+		uint64_t total;
+	private:
+		static uint64_t align(uint64_t x) noexcept { return (x + 7u) & ~uint64_t(7u); }
+	public:
+		// Returns false if the counts cannot fit in the size (prevents overflows)
+		static bool is_bounded(const digest_snapshot_header& h, uint64_t size) noexcept
+		{
+			return
+				size <= (~uint64_t(0u) >> 8) &&
+				h.digest_count <= size / blkhash_stride &&
+				h.bucket_count < size / sizeof(digest_snapshot_bucket) &&
+				h.gram_count < size / sizeof(uint64_t) &&
+				h.posting_count <= size / sizeof(uint32_t) &&
+				h.unindexed_count <= size / sizeof(digest_snapshot_unindexed);
+		}
+		void compute(const digest_snapshot_header& h) noexcept
+		{
+			blocksizes     = align(sizeof(digest_snapshot_header));
+			blkhash1_lens  = align(blocksizes     + h.digest_count * sizeof(uint32_t));
+			blkhash2_lens  = align(blkhash1_lens  + h.digest_count);
+			blkhash_chars  = align(blkhash2_lens  + h.digest_count);
+			buckets        = align(blkhash_chars  + h.digest_count * blkhash_stride);
+			grams          = align(buckets        + (h.bucket_count + 1) * sizeof(digest_snapshot_bucket));
+			posting_begins = align(grams          + h.gram_count * sizeof(uint64_t));
+			postings       = align(posting_begins + (h.gram_count + 1) * sizeof(uint64_t));
+			unindexed      = align(postings       + h.posting_count * sizeof(uint32_t));
+			total          = align(unindexed      + h.unindexed_count * sizeof(digest_snapshot_unindexed));
+		}
+	};
+}
+
+
+/*
+	Immutable snapshot of digest_index (queried in place)
+
+	A snapshot holds digests (in fixed strides), posting lists sorted
+	by effective block size and substring, and the table of digests
+	without indexed substrings.  It contains no pointers and can be
+	used at any address: typically, a file mapped by mapped_file
+	(see utils/mapped_file.hpp) so that all processes opening
+	the same snapshot share one copy in the page cache.
+
+	open only checks the header and section sizes (constant time).
+	If the snapshot is not trusted, call verify (linear time) before
+	querying.
+
+	Search results are the same as digest_index.
+*/
+template <bool IsAlphabetRestricted, comparison_version Version = comparison_version::latest>
+class digest_snapshot
+{
+public:
+	static constexpr const bool is_alphabet_restricted = IsAlphabetRestricted;
+	static constexpr const comparison_version version = Version;
+	typedef digest_index<IsAlphabetRestricted, Version> index_type;
+	typedef digest_view<IsAlphabetRestricted> view_type;
+	typedef typename index_type::gram_type gram_type;
+	typedef typename index_type::posting_list posting_list;
+	typedef typename index_type::compressed_posting_list compressed_posting_list;
+private:
+	typedef internal::digest_snapshot_header header_type;
+	typedef internal::digest_snapshot_bucket bucket_type;
+	typedef internal::digest_snapshot_unindexed unindexed_type;
+	typedef internal::digest_snapshot_layout layout_type;
+	static constexpr const size_t blkhash_stride = layout_type::blkhash_stride;
+
+	// Data structure (pointers into the snapshot)
+private:
+	const header_type* header;
+	const uint32_t* blksizes;
+	const unsigned char* blkhash1_lens;
+	const unsigned char* blkhash2_lens;
+	const char* blkhash_chars;
+	const bucket_type* buckets;
+	const uint64_t* grams;
+	const uint64_t* posting_begins;
+	const uint32_t* postings;
+	const unindexed_type* unindexed;
+public:
+	bool is_open(void) const noexcept { return header != nullptr; }
+	size_t size(void) const noexcept { return header ? size_t(header->digest_count) : 0; }
+	bool empty(void) const noexcept { return size() == 0; }
+	size_t posting_count(void) const noexcept { return header ? size_t(header->posting_count) : 0; }
+	view_type view(size_t i) const noexcept
+	{
+		#ifdef FFUZZYPP_DEBUG
+		assert(i < size());
+		#endif
+		const char* chars = blkhash_chars + i * blkhash_stride;
+		return view_type(digest_blocksize_t(blksizes[i]),
+			chars, blockhash_len_t(blkhash1_lens[i]),
+			chars + digest_params::max_blockhash_len, blockhash_len_t(blkhash2_lens[i]));
+	}
+
+	// Opening
+public:
+	void close(void) noexcept
+	{
+		header = nullptr;
+	}
+	bool open(const void* data, size_t size) noexcept
+	{
+		close();
+		if (!data || size < sizeof(header_type))
+			return false;
+		if (reinterpret_cast<uintptr_t>(data) % alignof(uint64_t) != 0)
+			return false;
+		const unsigned char* base = static_cast<const unsigned char*>(data);
+		const header_type* h = reinterpret_cast<const header_type*>(base);
+		if (memcmp(h->magic, layout_type::magic(), sizeof(h->magic)) != 0 ||
+			h->format_version != layout_type::format_version ||
+			h->byte_order != layout_type::byte_order ||
+			h->flags != (IsAlphabetRestricted ? uint32_t(layout_type::flag_alphabet_restricted) : uint32_t(0)) ||
+			h->max_blockhash_len != digest_params::max_blockhash_len ||
+			h->substr_size != index_type::substr_size ||
+			h->hash_size != sizeof(size_t))
+			return false;
+		if (!layout_type::is_bounded(*h, size))
+			return false;
+		layout_type layout;
+		layout.compute(*h);
+		if (layout.total != size)
+			return false;
+		blksizes       = reinterpret_cast<const uint32_t*>(base + layout.blocksizes);
+		blkhash1_lens  = base + layout.blkhash1_lens;
+		blkhash2_lens  = base + layout.blkhash2_lens;
+		blkhash_chars  = reinterpret_cast<const char*>(base + layout.blkhash_chars);
+		buckets        = reinterpret_cast<const bucket_type*>(base + layout.buckets);
+		grams          = reinterpret_cast<const uint64_t*>(base + layout.grams);
+		posting_begins = reinterpret_cast<const uint64_t*>(base + layout.posting_begins);
+		postings       = reinterpret_cast<const uint32_t*>(base + layout.postings);
+		unindexed      = reinterpret_cast<const unindexed_type*>(base + layout.unindexed);
+		header = h;
+		return true;
+	}
+	// Checks every structural invariant (so that queries never read out of bounds)
+	bool verify(void) const noexcept
+	{
+		if (!header)
+			return false;
+		size_t n = size();
+		for (size_t i = 0; i < n; i++)
+		{
+			if (blkhash1_lens[i] > digest_params::max_blockhash_len ||
+				blkhash2_lens[i] > digest_params::max_blockhash_len)
+				return false;
+			view_type v = view(i);
+			if (!v.is_valid() || !v.is_normalized())
+				return false;
+		}
+		uint64_t nb = header->bucket_count, ng = header->gram_count;
+		if (buckets[0].gram_begin != 0 || buckets[nb].gram_begin != ng)
+			return false;
+		for (uint64_t b = 0; b < nb; b++)
+		{
+			if (b != 0 && buckets[b - 1].blocksize >= buckets[b].blocksize)
+				return false;
+			if (buckets[b].gram_begin > buckets[b + 1].gram_begin)
+				return false;
+			for (uint64_t g = buckets[b].gram_begin + 1; g < buckets[b + 1].gram_begin; g++)
+				if (grams[g - 1] >= grams[g])
+					return false;
+		}
+		if (posting_begins[0] != 0 || posting_begins[ng] != header->posting_count)
+			return false;
+		for (uint64_t g = 0; g < ng; g++)
+			if (posting_begins[g] > posting_begins[g + 1])
+				return false;
+		for (uint64_t p = 0; p < header->posting_count; p++)
+			if (postings[p] >= n)
+				return false;
+		for (uint64_t u = 0; u < header->unindexed_count; u++)
+		{
+			if (unindexed[u].index >= n)
+				return false;
+			if (u != 0 && unindexed[u - 1].hash > unindexed[u].hash)
+				return false;
+		}
+		return true;
+	}
+
+	// Candidate lookup
+private:
+	bool collect(unsigned long bs, const char* s, size_t len, posting_list& out) const
+	{
+		if (len < index_type::substr_size)
+			return false;
+		const bucket_type* bend = buckets + header->bucket_count;
+		const bucket_type* bucket = std::lower_bound(buckets, bend, bs,
+			[](const bucket_type& b, unsigned long x) { return b.blocksize < x; });
+		if (bucket == bend || bucket->blocksize != bs)
+			return true;
+		const uint64_t* gbegin = grams + bucket[0].gram_begin;
+		const uint64_t* gend   = grams + bucket[1].gram_begin;
+		return index_type::for_each_gram(s, len, [&](gram_type g) {
+			const uint64_t* it = std::lower_bound(gbegin, gend, uint64_t(g));
+			if (it == gend || *it != g)
+				return;
+			size_t k = size_t(it - grams);
+			out.insert(out.end(), postings + posting_begins[k], postings + posting_begins[k + 1]);
+		});
+	}
+public:
+	// Indices of digests which may score nonzero against the query (sorted)
+	void candidates(const view_type& query, posting_list& out) const
+	{
+		#ifdef FFUZZYPP_DEBUG
+		assert(is_open());
+		assert(query.is_valid() && query.is_normalized());
+		#endif
+		out.clear();
+		digest_blocksize_t bs = digest_blocksize_t(query.blocksize());
+		bool indexed = collect(bs, query.blockhash1(), query.blockhash1_len(), out);
+		if (digest_blocksize::is_safe_to_double(bs))
+			indexed |= collect(2ul * bs, query.blockhash2(), query.blockhash2_len(), out);
+		if (!indexed)
+		{
+			// Identical digests are not indexed either
+			uint64_t h = query.hash();
+			const unindexed_type* uend = unindexed + header->unindexed_count;
+			const unindexed_type* it = std::lower_bound(unindexed, uend, h,
+				[](const unindexed_type& u, uint64_t x) { return u.hash < x; });
+			for (; it != uend && it->hash == h; ++it)
+				if (view_type::is_eq(query, view(size_t(it->index))))
+					out.push_back(size_t(it->index));
+		}
+		std::sort(out.begin(), out.end());
+		out.erase(std::unique(out.begin(), out.end()), out.end());
+	}
+	posting_list candidates(const view_type& query) const
+	{
+		posting_list out;
+		candidates(query, out);
+		return out;
+	}
+
+	// Search (see digest_index::search)
+private:
+	static bool is_better(const digest_search_result& a, const digest_search_result& b) noexcept
+	{
+		return a.score > b.score || (a.score == b.score && a.index < b.index);
+	}
+	template <typename TQuery>
+	void score_candidates(
+		const TQuery& query,
+		const posting_list& cands,
+		std::vector<digest_search_result>& results,
+		digest_comparison_score_t min_score
+	) const
+	{
+		for (size_t i : cands)
+		{
+			digest_comparison_score_t score =
+				digest_comparison<Version>::compare_threshold(query, view(i), min_score);
+			if (score)
+				results.push_back(digest_search_result{ i, score });
+		}
+	}
+	// Compile the query to position arrays once (if available)
+	void score_candidates(
+		const view_type& query,
+		const posting_list& cands,
+		std::vector<digest_search_result>& results,
+		digest_comparison_score_t min_score,
+		std::true_type
+	) const
+	{
+		score_candidates(digest_position_array<IsAlphabetRestricted>(query), cands, results, min_score);
+	}
+	void score_candidates(
+		const view_type& query,
+		const posting_list& cands,
+		std::vector<digest_search_result>& results,
+		digest_comparison_score_t min_score,
+		std::false_type
+	) const
+	{
+		score_candidates(query, cands, results, min_score);
+	}
+public:
+	void search(
+		const view_type& query,
+		std::vector<digest_search_result>& results,
+		digest_comparison_score_t min_score = 1
+	) const
+	{
+		results.clear();
+		if (min_score == 0)
+			min_score = 1;
+		posting_list cands;
+		candidates(query, cands);
+		if (cands.empty())
+			return;
+		score_candidates(query, cands, results, min_score,
+			std::integral_constant<bool, digest_position_array_params<IsAlphabetRestricted>::is_available>());
+		std::sort(results.begin(), results.end(), is_better);
+	}
+	std::vector<digest_search_result> search(
+		const view_type& query,
+		digest_comparison_score_t min_score = 1
+	) const
+	{
+		std::vector<digest_search_result> results;
+		search(query, results, min_score);
+		return results;
+	}
+	std::vector<digest_search_result> search_top_k(
+		const view_type& query,
+		size_t k,
+		digest_comparison_score_t min_score = 1
+	) const
+	{
+		std::vector<digest_search_result> results;
+		search(query, results, min_score);
+		if (results.size() > k)
+			results.resize(k);
+		return results;
+	}
+
+	// Serialization
+public:
+	template <comparison_version IndexVersion>
+	static void write(
+		const digest_index<IsAlphabetRestricted, IndexVersion>& index,
+		std::vector<unsigned char>& out
+	) noexcept(false)
+	{
+		typedef std::tuple<unsigned long, gram_type, const compressed_posting_list*> entry_type;
+		const typename index_type::store_type& store = index.store();
+		if (store.size() > 0xfffffffful)
+			throw std::length_error("too many digests for a snapshot");
+		// Sort posting lists by effective block size and substring
+		std::vector<entry_type> entries;
+		index.for_each_posting_list([&](unsigned long bs, gram_type g, const compressed_posting_list& pl) {
+			entries.push_back(entry_type(bs, g, &pl));
+		});
+		std::sort(entries.begin(), entries.end(), [](const entry_type& a, const entry_type& b) {
+			return std::get<0>(a) < std::get<0>(b) ||
+				(std::get<0>(a) == std::get<0>(b) && std::get<1>(a) < std::get<1>(b));
+		});
+		std::vector<unindexed_type> unidx;
+		index.for_each_unindexed([&](size_t h, const posting_list& pl) {
+			for (size_t i : pl)
+				unidx.push_back(unindexed_type{ uint64_t(h), uint64_t(i) });
+		});
+		std::sort(unidx.begin(), unidx.end(), [](const unindexed_type& a, const unindexed_type& b) {
+			return a.hash < b.hash || (a.hash == b.hash && a.index < b.index);
+		});
+		// Header
+		header_type h;
+		memset(&h, 0, sizeof(h));
+		memcpy(h.magic, layout_type::magic(), sizeof(h.magic));
+		h.format_version = layout_type::format_version;
+		h.byte_order = layout_type::byte_order;
+		h.flags = IsAlphabetRestricted ? uint32_t(layout_type::flag_alphabet_restricted) : uint32_t(0);
+		h.max_blockhash_len = digest_params::max_blockhash_len;
+		h.substr_size = index_type::substr_size;
+		h.hash_size = sizeof(size_t);
+		h.digest_count = store.size();
+		h.bucket_count = 0;
+		h.gram_count = entries.size();
+		h.posting_count = 0;
+		for (size_t k = 0; k < entries.size(); k++)
+		{
+			if (k == 0 || std::get<0>(entries[k - 1]) != std::get<0>(entries[k]))
+				h.bucket_count++;
+			h.posting_count += std::get<2>(entries[k])->size();
+		}
+		h.unindexed_count = unidx.size();
+		// Sections
+		layout_type layout;
+		layout.compute(h);
+		out.assign(size_t(layout.total), 0);
+		unsigned char* base = out.data();
+		memcpy(base, &h, sizeof(h));
+		uint32_t* o_blksizes = reinterpret_cast<uint32_t*>(base + layout.blocksizes);
+		for (size_t i = 0; i < store.size(); i++)
+		{
+			o_blksizes[i] = uint32_t(store.blocksize(i));
+			base[layout.blkhash1_lens + i] = static_cast<unsigned char>(store.blockhash1_len(i));
+			base[layout.blkhash2_lens + i] = static_cast<unsigned char>(store.blockhash2_len(i));
+			char* chars = reinterpret_cast<char*>(base + layout.blkhash_chars + i * blkhash_stride);
+			memcpy(chars, store.blockhash1(i), store.blockhash1_len(i));
+			memcpy(chars + digest_params::max_blockhash_len, store.blockhash2(i), store.blockhash2_len(i));
+		}
+		bucket_type* o_buckets = reinterpret_cast<bucket_type*>(base + layout.buckets);
+		uint64_t* o_grams = reinterpret_cast<uint64_t*>(base + layout.grams);
+		uint64_t* o_posting_begins = reinterpret_cast<uint64_t*>(base + layout.posting_begins);
+		uint32_t* o_postings = reinterpret_cast<uint32_t*>(base + layout.postings);
+		size_t nb = 0, np = 0;
+		for (size_t k = 0; k < entries.size(); k++)
+		{
+			if (k == 0 || std::get<0>(entries[k - 1]) != std::get<0>(entries[k]))
+				o_buckets[nb++] = bucket_type{ uint64_t(std::get<0>(entries[k])), uint64_t(k) };
+			o_grams[k] = std::get<1>(entries[k]);
+			o_posting_begins[k] = np;
+			for (size_t i : *std::get<2>(entries[k]))
+				o_postings[np++] = uint32_t(i);
+		}
+		o_buckets[nb] = bucket_type{ 0, uint64_t(entries.size()) };
+		o_posting_begins[entries.size()] = np;
+		if (!unidx.empty())
+			memcpy(base + layout.unindexed, unidx.data(), unidx.size() * sizeof(unindexed_type));
+	}
+	// Returns false on I/O errors
+	template <comparison_version IndexVersion>
+	static bool write(
+		const digest_index<IsAlphabetRestricted, IndexVersion>& index,
+		const char* filename
+	) noexcept(false)
+	{
+		std::vector<unsigned char> buf;
+		write(index, buf);
+		FILE* fp = fopen(filename, "wb");
+		if (!fp)
+			return false;
+		bool ok = fwrite(buf.data(), 1, buf.size(), fp) == buf.size();
+		if (fclose(fp) != 0)
+			ok = false;
+		return ok;
+	}
+
+public:
+	digest_snapshot(void) noexcept : header(nullptr) {}
+	digest_snapshot(const void* data, size_t size) noexcept : header(nullptr) { open(data, size); }
+};
+
+typedef digest_snapshot< true> digest_snapshot_t;
+typedef digest_snapshot<false> digest_snapshot_non_ra_t;
+
+}
+
+#endif
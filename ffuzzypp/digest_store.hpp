@@ -0,0 +1,268 @@
+/*
+
+	ffuzzy++ : C++ implementation of fast fuzzy hashing
+
+	digest_store.hpp
+	Candidate store for one-vs-many comparison (structure of arrays)
+
+	Copyright (C) 2026 Tsukasa OI <floss_ssdeep@irq.a4lg.com>
+
+
+	Permission to use, copy, modify, and/or distribute this software for
+	any purpose with or without fee is hereby granted, provided that the
+	above copyright notice and this permission notice appear in all copies.
+
+	THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+	WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+	MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+	ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+	WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+	ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+	OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+
+*/
+#ifndef FFUZZYPP_DIGEST_STORE_HPP
+#define FFUZZYPP_DIGEST_STORE_HPP
+
+#include <cassert>
+#include <cstddef>
+#include <cstring>
+
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "blockhash_signature.hpp"
+#include "digest_blocksize.hpp"
+#include "digest_data.hpp"
+#include "digest_base.hpp"
+#include "digest_view.hpp"
+
+namespace ffuzzy {
+
+/*
+	Candidate store (structure of arrays)
+
+	Each digest is split into block size, block hash lengths and
+	block hash characters and stored in separate contiguous arrays.
+	Block hash characters are stored in fixed strides of
+	digest_params::max_blockhash_len so that the i-th block hash
+	can be located without any indirection.
+
+	This layout allows one-vs-many comparison (see digest_query.hpp)
+	to filter candidates by block size without touching any
+	block hash data.
+
+	Signatures of block hashes (see blockhash_signature.hpp) are
+	computed on insertion and stored in separate arrays so that
+	candidates without any common substrings can be rejected
+	before reading block hash characters.
+
+	All digests in the store are normalized (unnormalized digests are
+	normalized on insertion so that comparison needs no copies).
+*/
+template <bool IsAlphabetRestricted>
+class digest_store
+{
+public:
+	static constexpr const bool is_alphabet_restricted = IsAlphabetRestricted;
+	static constexpr const size_t blockhash_stride = digest_params::max_blockhash_len;
+	typedef unsigned char len_type;
+	static_assert(digest_params::max_blockhash_len <= std::numeric_limits<len_type>::max(),
+		"max_blockhash_len must be in range of len_type.");
+
+	// Data structure
+private:
+	std::vector<digest_blocksize_t> blksizes;
+	std::vector<len_type> blkhash1_lens;
+	std::vector<len_type> blkhash2_lens;
+	std::vector<char> blkhash1_chars;
+	std::vector<char> blkhash2_chars;
+	std::vector<blockhash_signature> blkhash1_sigs;
+	std::vector<blockhash_signature> blkhash2_sigs;
+public:
+	size_t size(void) const noexcept { return blksizes.size(); }
+	bool empty(void) const noexcept { return blksizes.empty(); }
+	void clear(void) noexcept
+	{
+		blksizes.clear();
+		blkhash1_lens.clear();
+		blkhash2_lens.clear();
+		blkhash1_chars.clear();
+		blkhash2_chars.clear();
+		blkhash1_sigs.clear();
+		blkhash2_sigs.clear();
+	}
+	void reserve(size_t n)
+	{
+		blksizes.reserve(n);
+		blkhash1_lens.reserve(n);
+		blkhash2_lens.reserve(n);
+		blkhash1_chars.reserve(n * blockhash_stride);
+		blkhash2_chars.reserve(n * blockhash_stride);
+		blkhash1_sigs.reserve(n);
+		blkhash2_sigs.reserve(n);
+	}
+
+	// Accessors (per digest)
+public:
+	digest_blocksize_t blocksize(size_t i) const noexcept
+	{
+		#ifdef FFUZZYPP_DEBUG
+		assert(i < size());
+		#endif
+		return blksizes[i];
+	}
+	blockhash_len_t blockhash1_len(size_t i) const noexcept
+	{
+		#ifdef FFUZZYPP_DEBUG
+		assert(i < size());
+		#endif
+		return blkhash1_lens[i];
+	}
+	blockhash_len_t blockhash2_len(size_t i) const noexcept
+	{
+		#ifdef FFUZZYPP_DEBUG
+		assert(i < size());
+		#endif
+		return blkhash2_lens[i];
+	}
+	const char* blockhash1(size_t i) const noexcept
+	{
+		#ifdef FFUZZYPP_DEBUG
+		assert(i < size());
+		#endif
+		return blkhash1_chars.data() + i * blockhash_stride;
+	}
+	const char* blockhash2(size_t i) const noexcept
+	{
+		#ifdef FFUZZYPP_DEBUG
+		assert(i < size());
+		#endif
+		return blkhash2_chars.data() + i * blockhash_stride;
+	}
+	const blockhash_signature& signature1(size_t i) const noexcept
+	{
+		#ifdef FFUZZYPP_DEBUG
+		assert(i < size());
+		#endif
+		return blkhash1_sigs[i];
+	}
+	const blockhash_signature& signature2(size_t i) const noexcept
+	{
+		#ifdef FFUZZYPP_DEBUG
+		assert(i < size());
+		#endif
+		return blkhash2_sigs[i];
+	}
+	digest_view<IsAlphabetRestricted> view(size_t i) const noexcept
+	{
+		#ifdef FFUZZYPP_DEBUG
+		assert(i < size());
+		#endif
+		return digest_view<IsAlphabetRestricted>(blksizes[i],
+			blockhash1(i), blkhash1_lens[i],
+			blockhash2(i), blkhash2_lens[i]);
+	}
+
+	// Accessors (raw arrays)
+public:
+	const digest_blocksize_t* blocksize_data(void) const noexcept { return blksizes.data(); }
+	const len_type* blockhash1_len_data(void) const noexcept { return blkhash1_lens.data(); }
+	const len_type* blockhash2_len_data(void) const noexcept { return blkhash2_lens.data(); }
+	const char* blockhash1_data(void) const noexcept { return blkhash1_chars.data(); }
+	const char* blockhash2_data(void) const noexcept { return blkhash2_chars.data(); }
+
+	// Insertion
+private:
+	size_t push_back_internal(
+		digest_blocksize_t blocksize,
+		const char* bh1, blockhash_len_t bh1len,
+		const char* bh2, blockhash_len_t bh2len
+	)
+	{
+		#ifdef FFUZZYPP_DEBUG
+		assert(bh1len <= blockhash_stride);
+		assert(bh2len <= blockhash_stride);
+		#endif
+		size_t i = blksizes.size();
+		blkhash1_chars.resize((i + 1) * blockhash_stride);
+		blkhash2_chars.resize((i + 1) * blockhash_stride);
+		memcpy(blkhash1_chars.data() + i * blockhash_stride, bh1, bh1len);
+		memcpy(blkhash2_chars.data() + i * blockhash_stride, bh2, bh2len);
+		blksizes.push_back(blocksize);
+		blkhash1_lens.push_back(len_type(bh1len));
+		blkhash2_lens.push_back(len_type(bh2len));
+		blkhash1_sigs.push_back(blockhash_signature(bh1, bh1len));
+		blkhash2_sigs.push_back(blockhash_signature(bh2, bh2len));
+		return i;
+	}
+public:
+	template <bool IsShort>
+	size_t push_back(const digest_base<IsAlphabetRestricted, IsShort, true>& d)
+	{
+		#ifdef FFUZZYPP_DEBUG
+		assert(d.is_valid());
+		#endif
+		return push_back_internal(
+			digest_blocksize_t(d.blocksize()),
+			d.digest_buffer(), d.blockhash1_len(),
+			d.digest_buffer() + d.blockhash1_len(), d.blockhash2_len());
+	}
+	// Unnormalized digests are normalized once on insertion
+	template <bool IsShort>
+	size_t push_back(const digest_base<IsAlphabetRestricted, IsShort, false>& d)
+	{
+		char buf[digest_params::max_blockhash_len * 2];
+		digest_view<IsAlphabetRestricted> v = digest_view<IsAlphabetRestricted>::normalize(buf, d);
+		return push_back_internal(
+			digest_blocksize_t(v.blocksize()),
+			v.blockhash1(), blockhash_len_t(v.blockhash1_len()),
+			v.blockhash2(), blockhash_len_t(v.blockhash2_len()));
+	}
+	size_t push_back(const digest_view<IsAlphabetRestricted>& d)
+	{
+		#ifdef FFUZZYPP_DEBUG
+		assert(d.is_valid() && d.is_normalized());
+		#endif
+		return push_back_internal(
+			digest_blocksize_t(d.blocksize()),
+			d.blockhash1(), blockhash_len_t(d.blockhash1_len()),
+			d.blockhash2(), blockhash_len_t(d.blockhash2_len()));
+	}
+	size_t push_back(const char* str) noexcept(false)
+	{
+		return push_back(digest_base<IsAlphabetRestricted, false, true>(str));
+	}
+	size_t push_back(const std::string& str)
+	{
+		return push_back(str.c_str());
+	}
+
+	// Equality against the stored digest
+public:
+	bool is_eq(
+		size_t i,
+		digest_blocksize_t blocksize,
+		const char* bh1, blockhash_len_t bh1len,
+		const char* bh2, blockhash_len_t bh2len
+	) const noexcept
+	{
+		#ifdef FFUZZYPP_DEBUG
+		assert(i < size());
+		#endif
+		return
+			blksizes[i] == blocksize &&
+			blkhash1_lens[i] == bh1len &&
+			blkhash2_lens[i] == bh2len &&
+			memcmp(blockhash1(i), bh1, bh1len) == 0 &&
+			memcmp(blockhash2(i), bh2, bh2len) == 0;
+	}
+};
+
+typedef digest_store< true> digest_store_t;
+typedef digest_store<false> digest_store_non_ra_t;
+
+}
+
+#endif
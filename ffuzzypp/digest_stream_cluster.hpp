@@ -0,0 +1,381 @@
+/*
+
+	ffuzzy++ : C++ implementation of fast fuzzy hashing
+
+	digest_stream_cluster.hpp
+	Online (incremental) clustering
+
+	Copyright (C) 2026 Tsukasa OI <floss_ssdeep@irq.a4lg.com>
+
+
+	Permission to use, copy, modify, and/or distribute this software for
+	any purpose with or without fee is hereby granted, provided that the
+	above copyright notice and this permission notice appear in all copies.
+
+	THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+	WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+	MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+	ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+	WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+	ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+	OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+
+*/
+#ifndef FFUZZYPP_DIGEST_STREAM_CLUSTER_HPP
+#define FFUZZYPP_DIGEST_STREAM_CLUSTER_HPP
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+#include <atomic>
+#include <limits>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "digest_base.hpp"
+#include "digest_comparison.hpp"
+#include "digest_index.hpp"
+#include "digest_query.hpp"
+#include "digest_view.hpp"
+#include "digest_wire.hpp"
+#include "utils/bits.hpp"
+
+namespace ffuzzy {
+
+namespace internal
+{
+	/*
+		Concurrent (lock-free) union-find
+
+		The root of a set is always its smallest element (a root is only
+		linked under a smaller root) so that concurrent unions cannot
+		make cycles and the representative is deterministic.  find uses
+		path halving by compare-and-swap.
+
+		Elements are added by a single writer at a time and stored in
+		chunks of growing sizes (never moved) so that find and unite on
+		published elements need no locks.
+	*/
+	class digest_union_find
+	{
+	public:
+		static constexpr const size_t first_chunk_size = 64;
+		static constexpr const size_t max_chunks = std::numeric_limits<size_t>::digits - 6;
+	private:
+		std::atomic<size_t> count;
+		std::atomic<size_t> sets;
+		std::atomic<std::atomic<size_t>*> chunks[max_chunks];
+		std::atomic<size_t>& parent(size_t i) const noexcept
+		{
+			// chunk k holds [first_chunk_size * (2^k - 1), first_chunk_size * (2^(k+1) - 1))
+			unsigned k = bits::floor_log2(uint_least64_t(i / first_chunk_size + 1));
+			size_t begin = first_chunk_size * ((size_t(1) << k) - 1);
+			return chunks[k].load(std::memory_order_acquire)[i - begin];
+		}
+	public:
+		digest_union_find(void) noexcept : count(0), sets(0)
+		{
+			for (size_t k = 0; k < max_chunks; k++)
+				chunks[k].store(nullptr, std::memory_order_relaxed);
+		}
+		digest_union_find(const digest_union_find&) = delete;
+		digest_union_find& operator=(const digest_union_find&) = delete;
+		~digest_union_find(void)
+		{
+			for (size_t k = 0; k < max_chunks; k++)
+				delete[] chunks[k].load(std::memory_order_relaxed);
+		}
+		size_t size(void) const noexcept { return count.load(std::memory_order_acquire); }
+		size_t set_count(void) const noexcept { return sets.load(std::memory_order_acquire); }
+		// Writer only (serialized by the caller); root must be the new element or a root before it
+		size_t add(size_t root)
+		{
+			size_t i = count.load(std::memory_order_relaxed);
+			#ifdef FFUZZYPP_DEBUG
+			assert(root == i || (root < i && find(root) == root));
+			#endif
+			unsigned k = bits::floor_log2(uint_least64_t(i / first_chunk_size + 1));
+			if (!chunks[k].load(std::memory_order_relaxed))
+			{
+				std::atomic<size_t>* chunk = new std::atomic<size_t>[first_chunk_size << k];
+				chunks[k].store(chunk, std::memory_order_release);
+			}
+			parent(i).store(root, std::memory_order_relaxed);
+			if (root == i)
+				sets.fetch_add(1, std::memory_order_relaxed);
+			count.store(i + 1, std::memory_order_release);
+			return i;
+		}
+		size_t find(size_t x) const noexcept
+		{
+			#ifdef FFUZZYPP_DEBUG
+			assert(x < size());
+			#endif
+			while (true)
+			{
+				size_t p = parent(x).load(std::memory_order_acquire);
+				if (p == x)
+					return x;
+				size_t gp = parent(p).load(std::memory_order_acquire);
+				if (gp != p)
+					parent(x).compare_exchange_weak(p, gp, std::memory_order_acq_rel);
+				x = p;
+			}
+		}
+		/*
+			Unites sets of a and b and returns true if they were different.
+			survivor and absorbed are set to the roots before the union.
+		*/
+		bool unite(size_t a, size_t b, size_t& survivor, size_t& absorbed) noexcept
+		{
+			while (true)
+			{
+				size_t ra = find(a), rb = find(b);
+				if (ra == rb)
+					return false;
+				if (ra > rb)
+					std::swap(ra, rb);
+				size_t expected = rb;
+				if (parent(rb).compare_exchange_strong(expected, ra, std::memory_order_acq_rel))
+				{
+					sets.fetch_sub(1, std::memory_order_relaxed);
+					survivor = ra;
+					absorbed = rb;
+					return true;
+				}
+				// rb was linked by another thread
+			}
+		}
+	};
+}
+
+
+// Cluster change by an insertion
+struct digest_cluster_event
+{
+	enum event_kind
+	{
+		created, // new digest makes a new cluster (cluster == digest)
+		merged,  // cluster `absorbed` is merged into cluster `cluster`
+	};
+	event_kind kind;
+	// Digest inserted
+	size_t digest;
+	// Representative (smallest ID) of the resulting cluster
+	size_t cluster;
+	// Representative of the merged cluster (if kind == merged)
+	size_t absorbed;
+};
+
+/*
+	Online (incremental) clustering
+
+	Each new digest is searched against digest_index for neighbors
+	with the score of threshold or greater and then merged with their
+	clusters (single linkage).  The cost of an insertion depends on
+	the number of candidates sharing substrings with the digest, not
+	on the number of digests clustered.
+
+	Searches and insertions into the index are serialized but cluster
+	merges run outside the lock on a lock-free union-find, so multiple
+	threads can add digests and cluster membership can be read without
+	locks.  Every pair of digests with the score of threshold or greater
+	ends up in the same cluster (whichever of them is added later finds
+	the other in its search).  The representative of a cluster is its
+	smallest digest ID.
+
+	Callbacks get cluster changes (digest_cluster_event) caused by the
+	insertion: created first, then merged for each cluster merged
+	(a new digest joining an existing cluster is reported as the merge
+	of its own cluster).  Callbacks run without locks in the adding
+	thread after all merges of the insertion are done, so the digest
+	is clustered even if a callback throws.
+
+	The state (digests and their clusters) can be saved to and loaded
+	from a checkpoint.  Checkpoints are consistent if no digests are
+	being added.
+*/
+template <bool IsAlphabetRestricted, comparison_version Version = comparison_version::latest>
+class digest_stream_cluster
+{
+public:
+	static constexpr const bool is_alphabet_restricted = IsAlphabetRestricted;
+	static constexpr const comparison_version version = Version;
+	typedef digest_view<IsAlphabetRestricted> view_type;
+	typedef digest_index<IsAlphabetRestricted, Version> index_type;
+
+	// Data structure
+private:
+	const digest_comparison_score_t min_score;
+	mutable std::mutex index_mutex;
+	index_type idx;
+	internal::digest_union_find uf;
+public:
+	explicit digest_stream_cluster(digest_comparison_score_t threshold) noexcept
+		: min_score(threshold ? threshold : 1)
+	{}
+	digest_stream_cluster(const digest_stream_cluster&) = delete;
+	digest_stream_cluster& operator=(const digest_stream_cluster&) = delete;
+	digest_comparison_score_t threshold(void) const noexcept { return min_score; }
+	// Number of added digests (lock-free)
+	size_t size(void) const noexcept { return uf.size(); }
+	bool empty(void) const noexcept { return size() == 0; }
+	// Number of clusters (lock-free)
+	size_t cluster_count(void) const noexcept { return uf.set_count(); }
+	// Representative of the cluster (lock-free)
+	size_t find(size_t id) const noexcept { return uf.find(id); }
+	bool is_same_cluster(size_t a, size_t b) const noexcept { return uf.find(a) == uf.find(b); }
+
+	// Insertion
+public:
+	template <typename TCallback>
+	size_t add(const view_type& d, TCallback&& callback)
+	{
+		#ifdef FFUZZYPP_DEBUG
+		assert(d.is_valid() && d.is_normalized());
+		#endif
+		std::vector<digest_search_result> neighbors;
+		std::vector<digest_cluster_event> events;
+		size_t id;
+		{
+			std::lock_guard<std::mutex> lock(index_mutex);
+			idx.search(d, neighbors, min_score);
+			// nothing may throw between insertion and merges below
+			events.reserve(neighbors.size() + 1);
+			id = idx.push_back(d);
+			uf.add(id);
+		}
+		events.push_back(digest_cluster_event{ digest_cluster_event::created, id, id, id });
+		for (const digest_search_result& r : neighbors)
+		{
+			size_t survivor, absorbed;
+			if (uf.unite(id, r.index, survivor, absorbed))
+				events.push_back(digest_cluster_event{ digest_cluster_event::merged, id, survivor, absorbed });
+		}
+		for (const digest_cluster_event& e : events)
+			callback(e);
+		return id;
+	}
+	template <bool IsShort, bool IsNormalized, typename TCallback>
+	size_t add(const digest_base<IsAlphabetRestricted, IsShort, IsNormalized>& d, TCallback&& callback)
+	{
+		char buf[digest_params::max_blockhash_len * 2];
+		return add(view_type::normalize(buf, d), callback);
+	}
+	template <typename TCallback>
+	size_t add(const char* str, TCallback&& callback) noexcept(false)
+	{
+		return add(digest_base<IsAlphabetRestricted, false, true>(str), callback);
+	}
+	template <typename TCallback>
+	size_t add(const std::string& str, TCallback&& callback)
+	{
+		return add(str.c_str(), callback);
+	}
+	size_t add(const view_type& d)
+	{
+		return add(d, [](const digest_cluster_event&) {});
+	}
+	template <bool IsShort, bool IsNormalized>
+	size_t add(const digest_base<IsAlphabetRestricted, IsShort, IsNormalized>& d)
+	{
+		return add(d, [](const digest_cluster_event&) {});
+	}
+	size_t add(const char* str) noexcept(false)
+	{
+		return add(str, [](const digest_cluster_event&) {});
+	}
+	size_t add(const std::string& str)
+	{
+		return add(str.c_str());
+	}
+
+	// Checkpoints
+private:
+	typedef internal::digest_wire wire;
+	static const char* checkpoint_magic(void) noexcept { return "ffzpclst"; }
+	static constexpr const uint_least32_t checkpoint_version = 1;
+public:
+	// Serializes the state (with digests)
+	void save(std::vector<unsigned char>& out) const
+	{
+		out.clear();
+		out.insert(out.end(), checkpoint_magic(), checkpoint_magic() + 8);
+		wire::put_u32(out, checkpoint_version);
+		std::lock_guard<std::mutex> lock(index_mutex);
+		wire::put_u64(out, idx.size());
+		for (size_t i = 0; i < idx.size(); i++)
+		{
+			wire::put_u64(out, uf.find(i));
+			wire::put_view(out, idx.store().view(i));
+		}
+	}
+	bool save(const char* filename) const
+	{
+		std::vector<unsigned char> buf;
+		save(buf);
+		FILE* fp = fopen(filename, "wb");
+		if (!fp)
+			return false;
+		bool ok = fwrite(buf.data(), 1, buf.size(), fp) == buf.size();
+		if (fclose(fp) != 0)
+			ok = false;
+		return ok;
+	}
+	/*
+		Restores the state (digests keep their IDs).
+		This object must be empty and it is left partially loaded on failure.
+	*/
+	bool load(const unsigned char* data, size_t size)
+	{
+		std::lock_guard<std::mutex> lock(index_mutex);
+		if (!idx.empty() || size < 20 || memcmp(data, checkpoint_magic(), 8) != 0 ||
+			wire::get_u32(data + 8) != checkpoint_version)
+			return false;
+		uint_least64_t count = wire::get_u64(data + 12);
+		const unsigned char* p = data + 20;
+		const unsigned char* end = data + size;
+		for (uint_least64_t i = 0; i < count; i++)
+		{
+			if (end - p < 8)
+				return false;
+			uint_least64_t root = wire::get_u64(p);
+			p += 8;
+			view_type v;
+			if (!wire::get_view(p, end, v))
+				return false;
+			// the representative is the smallest ID in the cluster
+			if (root > i || (root < i && uf.find(size_t(root)) != size_t(root)))
+				return false;
+			idx.push_back(v);
+			uf.add(size_t(root));
+		}
+		return p == end;
+	}
+	bool load(const char* filename)
+	{
+		FILE* fp = fopen(filename, "rb");
+		if (!fp)
+			return false;
+		std::vector<unsigned char> buf;
+		unsigned char tmp[4096];
+		size_t n;
+		while ((n = fread(tmp, 1, sizeof(tmp), fp)) != 0)
+			buf.insert(buf.end(), tmp, tmp + n);
+		bool ok = !ferror(fp);
+		fclose(fp);
+		return ok && load(buf.data(), buf.size());
+	}
+};
+
+typedef digest_stream_cluster< true> digest_stream_cluster_t;
+typedef digest_stream_cluster<false> digest_stream_cluster_non_ra_t;
+
+}
+
+#endif
@@ -0,0 +1,211 @@
+/*
+
+	ffuzzy++ : C++ implementation of fast fuzzy hashing
+
+	digest_view.hpp
+	Non-owning view of a digest
+
+	Copyright (C) 2026 Tsukasa OI <floss_ssdeep@irq.a4lg.com>
+
+
+	Permission to use, copy, modify, and/or distribute this software for
+	any purpose with or without fee is hereby granted, provided that the
+	above copyright notice and this permission notice appear in all copies.
+
+	THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+	WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+	MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+	ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+	WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+	ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+	OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+
+*/
+#ifndef FFUZZYPP_DIGEST_VIEW_HPP
+#define FFUZZYPP_DIGEST_VIEW_HPP
+
+#include <cassert>
+#include <cstddef>
+#include <cstring>
+
+#include <limits>
+#include <type_traits>
+
+#include "digest_blocksize.hpp"
+#include "digest_data.hpp"
+#include "strings/sequences.hpp"
+
+namespace ffuzzy {
+
+/*
+	Non-owning view of a normalized digest
+
+	It consists of the block size and pointers to (and lengths of)
+	two block hashes which are stored elsewhere (e.g. a digest object,
+	digest_store or a memory-mapped file).  Block hashes are not
+	required to be adjacent.  The referenced memory must outlive
+	the view.
+
+	Block hashes must be normalized and, if IsAlphabetRestricted,
+	represented in the 6-bit form (as in digest_data).
+	A view can be implicitly created from a normalized digest
+	(use normalize for unnormalized ones).
+*/
+template <bool IsAlphabetRestricted>
+class digest_view
+{
+public:
+	static constexpr const bool is_alphabet_restricted = IsAlphabetRestricted;
+
+	// Data structure
+private:
+	const char* blkhash1;
+	const char* blkhash2;
+	blockhash_len_t blkhash1_len;
+	blockhash_len_t blkhash2_len;
+	digest_blocksize_t blksize;
+public:
+	unsigned long blocksize(void) const noexcept { return blksize; }
+	size_t blockhash1_len(void) const noexcept { return blkhash1_len; }
+	size_t blockhash2_len(void) const noexcept { return blkhash2_len; }
+	const char* blockhash1(void) const noexcept { return blkhash1; }
+	const char* blockhash2(void) const noexcept { return blkhash2; }
+
+	// Construction
+public:
+	digest_view(void) noexcept = default; // initialize to undefined state
+	digest_view(
+		digest_blocksize_t blocksize,
+		const char* bh1, blockhash_len_t bh1len,
+		const char* bh2, blockhash_len_t bh2len
+	) noexcept
+		: blkhash1(bh1)
+		, blkhash2(bh2)
+		, blkhash1_len(bh1len)
+		, blkhash2_len(bh2len)
+		, blksize(blocksize)
+	{}
+	template <bool IsShort>
+	digest_view(const digest_data<IsAlphabetRestricted, IsShort>& d) noexcept
+		: blkhash1(d.digest_buffer())
+		, blkhash2(d.digest_buffer() + d.blockhash1_len())
+		, blkhash1_len(blockhash_len_t(d.blockhash1_len()))
+		, blkhash2_len(blockhash_len_t(d.blockhash2_len()))
+		, blksize(digest_blocksize_t(d.blocksize()))
+	{}
+
+	/*
+		Normalization without copying
+
+		Returns the view of the normalized form of d.
+		Block hashes without long sequences (the most common case)
+		are referenced in place.  Only the other ones are normalized
+		into buf (which must have 2 * digest_params::max_blockhash_len
+		characters and outlive the view).
+	*/
+	template <bool IsShort>
+	static digest_view normalize(char* buf, const digest_data<IsAlphabetRestricted, IsShort>& d) noexcept
+	{
+		typedef strings::sequences<digest_params::max_blockhash_sequence> seq_type;
+		#ifdef FFUZZYPP_DEBUG
+		assert(d.is_valid());
+		#endif
+		digest_view v(d);
+		if (seq_type::has_sequences(v.blkhash1, v.blkhash1_len))
+		{
+			v.blkhash1_len = blockhash_len_t(seq_type::copy_elim_sequences(buf, v.blkhash1, v.blkhash1_len));
+			v.blkhash1 = buf;
+		}
+		if (seq_type::has_sequences(v.blkhash2, v.blkhash2_len))
+		{
+			char* buf2 = buf + digest_params::max_blockhash_len;
+			v.blkhash2_len = blockhash_len_t(seq_type::copy_elim_sequences(buf2, v.blkhash2, v.blkhash2_len));
+			v.blkhash2 = buf2;
+		}
+		return v;
+	}
+
+	// Validators
+public:
+	bool is_valid(void) const noexcept
+	{
+		if (blkhash1_len > digest_params::max_blockhash_len)
+			return false;
+		if (blkhash2_len > digest_params::max_blockhash_len)
+			return false;
+		if (IsAlphabetRestricted)
+		{
+			for (blockhash_len_t i = 0; i < blkhash1_len; i++)
+				if (blkhash1[i] < char(0) || 64 <= blkhash1[i])
+					return false;
+			for (blockhash_len_t i = 0; i < blkhash2_len; i++)
+				if (blkhash2[i] < char(0) || 64 <= blkhash2[i])
+					return false;
+		}
+		return true;
+	}
+	bool is_normalized(void) const noexcept
+	{
+		#ifdef FFUZZYPP_DEBUG
+		assert(is_valid());
+		#endif
+		return
+			!strings::sequences<digest_params::max_blockhash_sequence>
+				::has_sequences(blkhash1, blkhash1_len) &&
+			!strings::sequences<digest_params::max_blockhash_sequence>
+				::has_sequences(blkhash2, blkhash2_len);
+	}
+
+	// Equality
+public:
+	static bool is_eq_except_blocksize(const digest_view& a, const digest_view& b) noexcept
+	{
+		return
+			a.blkhash1_len == b.blkhash1_len &&
+			a.blkhash2_len == b.blkhash2_len &&
+			memcmp(a.blkhash1, b.blkhash1, a.blkhash1_len) == 0 &&
+			memcmp(a.blkhash2, b.blkhash2, a.blkhash2_len) == 0;
+	}
+	static bool is_eq(const digest_view& a, const digest_view& b) noexcept
+	{
+		return a.blksize == b.blksize && is_eq_except_blocksize(a, b);
+	}
+	friend bool operator==(const digest_view& a, const digest_view& b) noexcept { return  is_eq(a, b); }
+	friend bool operator!=(const digest_view& a, const digest_view& b) noexcept { return !is_eq(a, b); }
+
+	// Hash (same as digest_data::hash of the viewed digest)
+public:
+	size_t hash(void) const noexcept
+	{
+		typedef typename std::conditional<
+			(std::numeric_limits<size_t>::max() >= 0xfffffffful),
+			size_t, uint_least32_t
+		>::type hash_t;
+		static constexpr const hash_t fnv_init  = 2166136261ul;
+		static constexpr const hash_t fnv_prime = 16777619ul;
+		hash_t h = fnv_init;
+		h ^= hash_t(blksize);      h *= fnv_prime;
+		h ^= hash_t(blkhash1_len); h *= fnv_prime;
+		h ^= hash_t(blkhash2_len); h *= fnv_prime;
+		for (blockhash_len_t i = 0; i < blkhash1_len; i++)
+		{
+			h ^= hash_t(static_cast<unsigned char>(blkhash1[i]));
+			h *= fnv_prime;
+		}
+		for (blockhash_len_t i = 0; i < blkhash2_len; i++)
+		{
+			h ^= hash_t(static_cast<unsigned char>(blkhash2[i]));
+			h *= fnv_prime;
+		}
+		if (std::numeric_limits<size_t>::max() < 0xfffffffful)
+			h ^= (h >> 16);
+		return size_t(h);
+	}
+};
+
+typedef digest_view< true> digest_view_ra_t;
+typedef digest_view<false> digest_view_t;
+
+}
+
+#endif
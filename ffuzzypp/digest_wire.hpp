@@ -0,0 +1,117 @@
+/*
+
+	ffuzzy++ : C++ implementation of fast fuzzy hashing
+
+	digest_wire.hpp
+	Binary encoding of digests (for protocols and checkpoints)
+
+	Copyright (C) 2026 Tsukasa OI <floss_ssdeep@irq.a4lg.com>
+
+
+	Permission to use, copy, modify, and/or distribute this software for
+	any purpose with or without fee is hereby granted, provided that the
+	above copyright notice and this permission notice appear in all copies.
+
+	THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+	WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+	MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+	ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+	WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+	ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+	OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+
+*/
+#ifndef FFUZZYPP_DIGEST_WIRE_HPP
+#define FFUZZYPP_DIGEST_WIRE_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+#include <vector>
+
+#include "digest_blocksize.hpp"
+#include "digest_data.hpp"
+#include "digest_view.hpp"
+
+namespace ffuzzy {
+
+namespace internal
+{
+	/*
+		Little-endian encoding of integers and digests
+
+		Digests are encoded as block size (u32), length of block hash 1
+		(u8), block hash 1, length of block hash 2 (u8) and block hash 2
+		(normalized, internal representation).
+	*/
+	class digest_wire
+	{
+	private:
+		digest_wire(void) = delete;
+		digest_wire(const digest_wire&) = delete;
+	public:
+		static void put_u8(std::vector<unsigned char>& buf, unsigned v)
+		{
+			buf.push_back(static_cast<unsigned char>(v));
+		}
+		static void put_u32(std::vector<unsigned char>& buf, uint_least32_t v)
+		{
+			for (unsigned i = 0; i < 4; i++)
+				buf.push_back(static_cast<unsigned char>(v >> (i * 8)));
+		}
+		static void put_u64(std::vector<unsigned char>& buf, uint_least64_t v)
+		{
+			for (unsigned i = 0; i < 8; i++)
+				buf.push_back(static_cast<unsigned char>(v >> (i * 8)));
+		}
+		static uint_least32_t get_u32(const unsigned char* p) noexcept
+		{
+			uint_least32_t v = 0;
+			for (unsigned i = 0; i < 4; i++)
+				v |= uint_least32_t(p[i]) << (i * 8);
+			return v;
+		}
+		static uint_least64_t get_u64(const unsigned char* p) noexcept
+		{
+			uint_least64_t v = 0;
+			for (unsigned i = 0; i < 8; i++)
+				v |= uint_least64_t(p[i]) << (i * 8);
+			return v;
+		}
+		template <bool IsAlphabetRestricted>
+		static void put_view(std::vector<unsigned char>& buf, const digest_view<IsAlphabetRestricted>& d)
+		{
+			put_u32(buf, uint_least32_t(d.blocksize()));
+			put_u8(buf, unsigned(d.blockhash1_len()));
+			buf.insert(buf.end(), d.blockhash1(), d.blockhash1() + d.blockhash1_len());
+			put_u8(buf, unsigned(d.blockhash2_len()));
+			buf.insert(buf.end(), d.blockhash2(), d.blockhash2() + d.blockhash2_len());
+		}
+		// Decodes a view (referring to buffer contents; false if malformed)
+		template <bool IsAlphabetRestricted>
+		static bool get_view(const unsigned char*& p, const unsigned char* end, digest_view<IsAlphabetRestricted>& d) noexcept
+		{
+			if (end - p < 5)
+				return false;
+			digest_blocksize_t bs = digest_blocksize_t(get_u32(p));
+			size_t len1 = p[4];
+			p += 5;
+			if (len1 > digest_params::max_blockhash_len || size_t(end - p) < len1 + 1)
+				return false;
+			const char* bh1 = reinterpret_cast<const char*>(p);
+			p += len1;
+			size_t len2 = *p++;
+			if (len2 > digest_params::max_blockhash_len || size_t(end - p) < len2)
+				return false;
+			const char* bh2 = reinterpret_cast<const char*>(p);
+			p += len2;
+			d = digest_view<IsAlphabetRestricted>(bs,
+				bh1, blockhash_len_t(len1), bh2, blockhash_len_t(len2));
+			return d.is_valid() && d.is_normalized();
+		}
+	};
+}
+
+}
+
+#endif
@@ -108,6 +108,109 @@ namespace internal
 		}
 	};
 
+	/*
+		Hash set variant of common_substr_hasharray_impl
+
+		Rolling hashes of s1 are inserted into a small open-addressed
+		hash table (linear probing) so that each position of s2
+		is checked by a single probe sequence (instead of scanning
+		all hashes of s1).  Every hash hit is still confirmed by memcmp.
+	*/
+	template <size_t SubstrSize, size_t MaxSize>
+	class common_substr_hashset_impl
+	{
+	private:
+		common_substr_hashset_impl(void) = delete;
+		common_substr_hashset_impl(const common_substr_hashset_impl&) = delete;
+	public:
+		static constexpr const size_t substr_size = SubstrSize;
+		static constexpr const size_t max_size = MaxSize;
+		static_assert(0 < substr_size, "substr_size must be nonzero.");
+		static_assert(substr_size <= max_size, "substring size must not be greater than the maximum size.");
+		static_assert(substr_size >= rolling_hash::window_size,
+			"substr_size must be equal or greater than window_size.");
+		static_assert(max_size <= std::numeric_limits<size_t>::max() / 4,
+			"max_size is too large to construct the hash table.");
+	private:
+		static constexpr size_t CONST_table_bits(size_t n, size_t bits = 0) noexcept
+		{
+			return (size_t(1) << bits) >= n ? bits : CONST_table_bits(n, bits + 1);
+		}
+	public:
+		static constexpr const size_t max_hashes = max_size - (substr_size - 1);
+		// load factor is kept at most 1/2
+		static constexpr const size_t table_bits = CONST_table_bits(max_hashes * 2);
+		static constexpr const size_t table_size = size_t(1) << table_bits;
+		static_assert(table_bits < 32, "table_bits must be less than 32.");
+		// Smallest type to hold (index of s1) + 1 (one byte on block hashes)
+		typedef typename std::conditional<
+			max_hashes <= std::numeric_limits<uint_least8_t>::max(), uint_least8_t,
+			typename std::conditional<
+				max_hashes <= std::numeric_limits<uint_least16_t>::max(), uint_least16_t,
+				size_t
+			>::type
+		>::type position_type;
+		struct table_type
+		{
+			uint_least32_t hashes[table_size];
+			// (index of s1) + 1 or 0 if the slot is empty
+			position_type positions[table_size];
+		};
+	private:
+		static size_t slot_for(uint_least32_t h) noexcept
+		{
+			return size_t((uint_least32_t(h * uint_least32_t(0x9e3779b1u)) & 0xffffffffu) >> (32 - table_bits))
+				& (table_size - 1);
+		}
+	public:
+		static bool match_long_buf(
+			const char* s1, size_t s1len,
+			const char* s2, size_t s2len,
+			table_type& table
+		) noexcept
+		{
+			#ifdef FFUZZYPP_DEBUG
+			assert(s1);
+			assert(s2);
+			assert(s1len >= substr_size);
+			assert(s2len >= substr_size);
+			assert(s1len <= max_size);
+			#endif
+			for (size_t k = 0; k < table_size; k++)
+				table.positions[k] = 0;
+			rolling_hash r;
+			// insert rolling hashes for each index of s1
+			for (size_t i = 0; i < substr_size - 1; i++)
+				r.update(static_cast<unsigned char>(s1[i]));
+			for (size_t i = substr_size - 1; i < s1len; i++)
+			{
+				r.update(static_cast<unsigned char>(s1[i]));
+				uint_least32_t h = r.sum();
+				size_t k = slot_for(h);
+				while (table.positions[k])
+					k = (k + 1) & (table_size - 1);
+				table.hashes[k] = h;
+				table.positions[k] = position_type(i - (substr_size - 1) + 1);
+			}
+			// probe rolling hashes for each index of s2
+			r.reset();
+			for (size_t j = 0; j < substr_size - 1; j++)
+				r.update(static_cast<unsigned char>(s2[j]));
+			for (size_t j = 0; j < s2len - (substr_size - 1); j++)
+			{
+				r.update(static_cast<unsigned char>(s2[j + (substr_size - 1)]));
+				uint_least32_t h = r.sum();
+				for (size_t k = slot_for(h); table.positions[k]; k = (k + 1) & (table_size - 1))
+				{
+					// make sure we actually have common substring if hash matches
+					if (table.hashes[k] == h && !memcmp(s1 + (table.positions[k] - 1), s2 + j, substr_size))
+						return true;
+				}
+			}
+			return false;
+		}
+	};
+
 	template <
 		size_t SubstrSize,
 		size_t MaxSize = std::numeric_limits<size_t>::max()
@@ -207,6 +310,38 @@ public:
 	}
 };
 
+template <size_t MaxSize, size_t SubstrSize>
+class common_substr_hashset
+{
+private:
+	common_substr_hashset(void) = delete;
+	common_substr_hashset(const common_substr_hashset&) = delete;
+public:
+	static constexpr const size_t max_size = MaxSize;
+	static constexpr const size_t substr_size = SubstrSize;
+	static_assert(0 < substr_size, "substr_size must be nonzero.");
+	static_assert(substr_size <= max_size, "substring size must not be greater than the maximum size.");
+public:
+	static bool match(
+		const char* s1, size_t s1len,
+		const char* s2, size_t s2len
+	) noexcept
+	{
+		#ifdef FFUZZYPP_DEBUG
+		assert(s1);
+		assert(s2);
+		assert(s1len <= max_size);
+		#endif
+		if (s1len < substr_size)
+			return false;
+		if (s2len < substr_size)
+			return false;
+		typedef internal::common_substr_hashset_impl<substr_size, max_size> impl_type;
+		typename impl_type::table_type table;
+		return impl_type::match_long_buf(s1, s1len, s2, s2len, table);
+	}
+};
+
 template <typename TBitmap, char CMin, char CMax, size_t MaxSize, size_t SubstrSize>
 class common_substr_bitparallel
 {
@@ -307,7 +442,7 @@ namespace internal
 			const char* s2, size_t s2len
 		) noexcept
 		{
-			return common_substr_hasharray<MaxSize, SubstrSize>::match(s1, s1len, s2, s2len);
+			return common_substr_hashset<MaxSize, SubstrSize>::match(s1, s1len, s2, s2len);
 		}
 	};
 }
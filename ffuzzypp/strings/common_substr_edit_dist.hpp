@@ -0,0 +1,272 @@
+/*
+
+	ffuzzy++ : C++ implementation of fast fuzzy hashing
+
+	strings/common_substr_edit_dist.hpp
+	Fused common substring and edit distance (bit-parallel)
+
+	Copyright (C) 2026 Tsukasa OI <floss_ssdeep@irq.a4lg.com>
+
+
+	Permission to use, copy, modify, and/or distribute this software for
+	any purpose with or without fee is hereby granted, provided that the
+	above copyright notice and this permission notice appear in all copies.
+
+	THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+	WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+	MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+	ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+	WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+	ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+	OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+
+*/
+#ifndef FFUZZYPP_STRINGS_COMMON_SUBSTR_EDIT_DIST_HPP
+#define FFUZZYPP_STRINGS_COMMON_SUBSTR_EDIT_DIST_HPP
+
+#include <cassert>
+#include <cstddef>
+
+#include "position_array.hpp"
+#include "../utils/safe_int.hpp"
+
+namespace ffuzzy {
+namespace strings {
+
+namespace internal
+{
+	// AND of diagonally shifted bitmaps cache[i-K..i-(N-1)] (unrolled; stops at zero)
+	template <size_t K, size_t N>
+	class common_substr_diagonal
+	{
+	private:
+		common_substr_diagonal(void) = delete;
+		common_substr_diagonal(const common_substr_diagonal&) = delete;
+	public:
+		template <typename TBitmap>
+		static TBitmap apply(TBitmap D, const TBitmap* cache, size_t i) noexcept
+		{
+			D &= cache[i - K] << K;
+			if (!D)
+				return D;
+			return common_substr_diagonal<K + 1, N>::apply(D, cache, i);
+		}
+	};
+	template <size_t N>
+	class common_substr_diagonal<N, N>
+	{
+	private:
+		common_substr_diagonal(void) = delete;
+		common_substr_diagonal(const common_substr_diagonal&) = delete;
+	public:
+		template <typename TBitmap>
+		static TBitmap apply(TBitmap D, const TBitmap*, size_t) noexcept
+		{
+			return D;
+		}
+	};
+
+	/*
+		Fused common substring test and edit distance
+
+		common_substr_bitparallel and edit_dist_bitparallel both walk
+		s2 and look up s1[s2[i]] bitmaps.  This kernel walks s2 once:
+
+		1.  Each bitmap is looked up and kept in a local cache while
+		    searching for a common substring.  A substring of length
+		    SubstrSize ending at s2[i] exists if the diagonal
+		    AND of the last SubstrSize bitmaps (shifted) is nonzero.
+		    The AND chain stops at the first zero (which is the
+		    common case on unrelated block hashes).
+		2.  Once a common substring is found, the edit distance state
+		    catches up using the cached bitmaps and then continues
+		    with the rest of s2 (looking up each remaining bitmap once).
+
+		If no common substrings are found, no edit distance work is
+		performed at all.
+	*/
+	template <typename Tcost, size_t MaxSize, size_t SubstrSize>
+	class common_substr_edit_dist_bitparallel_impl
+	{
+	private:
+		common_substr_edit_dist_bitparallel_impl(void) = delete;
+		common_substr_edit_dist_bitparallel_impl(const common_substr_edit_dist_bitparallel_impl&) = delete;
+	public:
+		typedef Tcost cost_type;
+		static constexpr const size_t max_size = MaxSize;
+		static constexpr const size_t substr_size = SubstrSize;
+		static_assert(0 < substr_size, "substr_size must be nonzero.");
+		static_assert(substr_size <= max_size, "substring size must not be greater than the maximum size.");
+
+		// Common substring search (returns the number of consumed characters or 0 if not found)
+	private:
+		template <typename TBitmap, char CMin, char CMax>
+		static size_t search(
+			const position_array<TBitmap, char, CMin, CMax>& s1,
+			const char* s2, size_t s2len,
+			TBitmap* cache
+		) noexcept
+		{
+			size_t i = 0;
+			for (; i < substr_size - 1; i++)
+				cache[i] = s1[s2[i]];
+			for (; i < s2len; i++)
+			{
+				cache[i] = s1[s2[i]];
+				if (common_substr_diagonal<1, substr_size>::apply(cache[i], cache, i))
+					return i + 1;
+			}
+			return 0;
+		}
+
+		// One column of the edit distance (same recurrence as edit_dist_bitparallel_impl)
+	private:
+		template <typename TBitmap>
+		static void step(
+			TBitmap mt, TBitmap msb,
+			TBitmap& pv, TBitmap& nv, cost_type& cur
+		) noexcept
+		{
+			TBitmap zd = (((mt & pv) + pv) ^ pv) | mt | nv;
+			TBitmap nh = pv & zd;
+			if (nh & msb)
+				--cur;
+			TBitmap x  = nv | ~(pv | zd) | (pv & ~mt & TBitmap(1ull));
+			TBitmap y  = (pv - nh) >> 1;
+			TBitmap ph = (x + y) ^ y;
+			if (ph & msb)
+				++cur;
+			TBitmap t = (ph << 1) + TBitmap(1ull);
+			nv = t & zd;
+			pv = (nh << 1) | ~(t | zd) | (t & (pv - nh));
+		}
+
+	public:
+		template <typename TBitmap, char CMin, char CMax>
+		static bool cost(
+			cost_type& out,
+			const position_array<TBitmap, char, CMin, CMax>& s1, size_t s1len,
+			const char* s2, size_t s2len
+		) noexcept
+		{
+			TBitmap cache[max_size];
+			size_t n = search(s1, s2, s2len, cache);
+			if (!n)
+				return false;
+			cost_type cur = s1len;
+			TBitmap msb = TBitmap(1ull) << (s1len - 1);
+			TBitmap pv = -1;
+			TBitmap nv = 0;
+			for (size_t i = 0; i < n; i++)
+				step(cache[i], msb, pv, nv, cur);
+			for (size_t i = n; i < s2len; i++)
+				step(s1[s2[i]], msb, pv, nv, cur);
+			out = cur;
+			return true;
+		}
+		template <typename TBitmap, char CMin, char CMax>
+		static bool cost_bounded(
+			cost_type& out,
+			const position_array<TBitmap, char, CMin, CMax>& s1, size_t s1len,
+			const char* s2, size_t s2len,
+			cost_type max_cost
+		) noexcept
+		{
+			TBitmap cache[max_size];
+			size_t n = search(s1, s2, s2len, cache);
+			if (!n)
+				return false;
+			cost_type cur = s1len;
+			// limit == max_cost + (number of remaining columns)
+			cost_type limit = max_cost + cost_type(s2len);
+			TBitmap msb = TBitmap(1ull) << (s1len - 1);
+			TBitmap pv = -1;
+			TBitmap nv = 0;
+			for (size_t i = 0; i < n; i++)
+			{
+				step(cache[i], msb, pv, nv, cur);
+				if (--limit < cur)
+				{
+					out = max_cost + 1;
+					return true;
+				}
+			}
+			for (size_t i = n; i < s2len; i++)
+			{
+				step(s1[s2[i]], msb, pv, nv, cur);
+				if (--limit < cur)
+				{
+					out = max_cost + 1;
+					return true;
+				}
+			}
+			out = cur;
+			return true;
+		}
+	};
+}
+
+/*
+	Returns false if s1 and s2 have no common substrings of SubstrSize.
+	Otherwise, returns true and stores the edit distance to out
+	(or, on cost_bounded, a value greater than max_cost if the
+	edit distance exceeds max_cost; see edit_dist_bitparallel_impl).
+*/
+template <typename Tcost, typename TBitmap, char CMin, char CMax, size_t MaxSize, size_t SubstrSize>
+class common_substr_edit_dist_bitparallel
+{
+private:
+	common_substr_edit_dist_bitparallel(void) = delete;
+	common_substr_edit_dist_bitparallel(const common_substr_edit_dist_bitparallel&) = delete;
+public:
+	static constexpr const size_t max_size = MaxSize;
+	static constexpr const size_t substr_size = SubstrSize;
+	static_assert(0 < substr_size, "substr_size must be nonzero.");
+	static_assert(substr_size <= max_size, "substring size must not be greater than the maximum size.");
+	static_assert(max_size <= position_array<TBitmap, char, CMin, CMax>::max_strlen,
+		"max_size must not be greater than max_strlen of corresponding position_matrix for efficiency.");
+	typedef Tcost cost_type;
+	static_assert(safe_int::safe_mul<
+			safe_int::uvalue<cost_type, max_size>,
+			safe_int::uvalue<cost_type, 2>
+		>::is_valid,
+		"max_size * 2 must be in range of cost_type.");
+private:
+	typedef internal::common_substr_edit_dist_bitparallel_impl<Tcost, MaxSize, SubstrSize> impl_type;
+public:
+	static bool cost(
+		cost_type& out,
+		const position_array<TBitmap, char, CMin, CMax>& s1, size_t s1len,
+		const char* s2, size_t s2len
+	) noexcept
+	{
+		#ifdef FFUZZYPP_DEBUG
+		assert(s2);
+		assert(s1len <= max_size);
+		assert(s2len <= max_size);
+		#endif
+		if (s1len < substr_size || s2len < substr_size)
+			return false;
+		return impl_type::cost(out, s1, s1len, s2, s2len);
+	}
+	static bool cost_bounded(
+		cost_type& out,
+		const position_array<TBitmap, char, CMin, CMax>& s1, size_t s1len,
+		const char* s2, size_t s2len,
+		cost_type max_cost
+	) noexcept
+	{
+		#ifdef FFUZZYPP_DEBUG
+		assert(s2);
+		assert(s1len <= max_size);
+		assert(s2len <= max_size);
+		#endif
+		if (s1len < substr_size || s2len < substr_size)
+			return false;
+		return impl_type::cost_bounded(out, s1, s1len, s2, s2len, max_cost);
+	}
+};
+
+}}
+
+#endif
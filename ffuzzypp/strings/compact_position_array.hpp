@@ -0,0 +1,153 @@
+/*
+
+	ffuzzy++ : C++ implementation of fast fuzzy hashing
+
+	strings/compact_position_array.hpp
+	Compact (sparse) position array
+
+	Copyright (C) 2026 Tsukasa OI <floss_ssdeep@irq.a4lg.com>
+
+
+	Permission to use, copy, modify, and/or distribute this software for
+	any purpose with or without fee is hereby granted, provided that the
+	above copyright notice and this permission notice appear in all copies.
+
+	THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+	WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+	MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+	ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+	WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+	ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+	OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+
+*/
+#ifndef FFUZZYPP_STRINGS_COMPACT_POSITION_ARRAY_HPP
+#define FFUZZYPP_STRINGS_COMPACT_POSITION_ARRAY_HPP
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+#include <limits>
+
+#include "position_array.hpp"
+#include "../utils/bits.hpp"
+
+namespace ffuzzy {
+namespace strings {
+
+/*
+	Compact position array (non-owning view)
+
+	A position_array holds a bitmap for every character in [CMin, CMax]
+	but a string of length N has at most N distinct characters.
+	This representation consists of a presence mask (one bit per
+	character in the range) and bitmaps of present characters only,
+	in the character order.  The bitmap for a character is located by
+	the number of present characters below it (population count).
+
+	Bitmaps are stored by the owner (e.g. a pool of a container) and
+	this class only refers to them.  Because the range is limited to
+	64 characters, the presence mask is a single 64-bit word.
+*/
+template <
+	typename TBitmap = unsigned long long,
+	typename TChar = char,
+	TChar CMin = 0,
+	TChar CMax = 63
+>
+class compact_position_array
+{
+public:
+	typedef position_array<TBitmap, TChar, CMin, CMax> dense_type;
+	typedef TBitmap bitmap_type;
+	typedef TChar char_type;
+	typedef uint_least64_t mask_type;
+	static constexpr const char_type char_min = CMin;
+	static constexpr const char_type char_max = CMax;
+	static constexpr const size_t array_size = dense_type::array_size;
+	static constexpr const size_t max_strlen = dense_type::max_strlen;
+	static_assert(array_size <= 64, "compact_position_array only supports up to 64 characters.");
+private:
+	mask_type mask;
+	const bitmap_type* bitmaps;
+private:
+	static size_t index_of(mask_type mask, size_t offset) noexcept
+	{
+		return bits::popcount(mask & ((mask_type(1u) << offset) - 1u));
+	}
+public:
+	compact_position_array(void) noexcept = default; // initialize to undefined state
+	compact_position_array(mask_type mask, const bitmap_type* bitmaps) noexcept
+		: mask(mask), bitmaps(bitmaps) {}
+	mask_type presence_mask(void) const noexcept { return mask; }
+	const bitmap_type* bitmap_data(void) const noexcept { return bitmaps; }
+	// Number of distinct characters (number of stored bitmaps)
+	size_t size(void) const noexcept { return bits::popcount(mask); }
+public:
+	bitmap_type bitmap_for(char_type ch) const noexcept
+	{
+		#ifdef FFUZZYPP_DEBUG
+		assert(char_min <= ch && ch <= char_max);
+		#endif
+		size_t offset = size_t(ch) - size_t(char_min);
+		if (!((mask >> offset) & 1u))
+			return bitmap_type(0u);
+		return bitmaps[index_of(mask, offset)];
+	}
+	bitmap_type bitmap_for_safe(char_type ch) const noexcept
+	{
+		if (ch < char_min || char_max < ch)
+			return bitmap_type(0u);
+		return bitmap_for(ch);
+	}
+	bitmap_type operator[](char_type ch) const noexcept
+	{
+		return bitmap_for(ch);
+	}
+	// Expand to the ordinary position array (for bit-parallel algorithms)
+	void expand(dense_type& dest) const noexcept
+	{
+		dest.reset();
+		bitmap_type* out = dest.bitmap_data();
+		mask_type m = mask;
+		for (const bitmap_type* p = bitmaps; m; m &= m - 1u)
+		{
+			out[bits::count_trailing_zeros(m)] = *p++;
+		}
+	}
+public:
+	/*
+		Encode given string to the presence mask and bitmaps
+		(out must have room for min(len, array_size) bitmaps)
+		and return the number of bitmaps written.
+	*/
+	static size_t encode(
+		mask_type& mask, bitmap_type* out,
+		const char_type* str, size_t len
+	) noexcept
+	{
+		#ifdef FFUZZYPP_DEBUG
+		assert(len <= max_strlen);
+		#endif
+		mask_type m = 0;
+		for (size_t i = 0; i < len; i++)
+		{
+			#ifdef FFUZZYPP_DEBUG
+			assert(char_min <= str[i] && str[i] <= char_max);
+			#endif
+			m |= mask_type(1u) << (size_t(str[i]) - size_t(char_min));
+		}
+		size_t count = bits::popcount(m);
+		for (size_t k = 0; k < count; k++)
+			out[k] = bitmap_type(0u);
+		for (size_t i = 0; i < len; i++)
+			out[index_of(m, size_t(str[i]) - size_t(char_min))] |= bitmap_type(1u) << i;
+		mask = m;
+		return count;
+	}
+};
+
+}}
+
+#endif
@@ -95,6 +95,35 @@ namespace internal
 				update_cost_inner(s1, s2, s2len, i, row1, row2);
 			return row1[s2len];
 		}
+		/*
+			Bounded variant: returns the exact cost if it does not exceed max_cost.
+			Otherwise, returns a value greater than max_cost
+			(not necessarily the exact cost).
+		*/
+		static cost_type cost_bounded_nonempty(
+			const char* s1, size_t s1len,
+			const char* s2, size_t s2len,
+			cost_type max_cost,
+			cost_type* row1, cost_type* row2
+		) noexcept
+		{
+			#ifdef FFUZZYPP_DEBUG
+			assert(s1len > 0);
+			assert(s2len > 0);
+			#endif
+			if ((s1len < s2len ? s2len - s1len : s1len - s2len) > size_t(max_cost))
+				return max_cost + 1;
+			for (size_t j = 0; j <= s2len; j++)
+				row1[j] = static_cast<cost_type>(j);
+			for (size_t i = 0; i < s1len; i++)
+			{
+				update_cost_inner(s1, s2, s2len, i, row1, row2);
+				// Every path to the last cell goes through this row.
+				if (*std::min_element(row1, row1 + s2len + 1) > max_cost)
+					return max_cost + 1;
+			}
+			return row1[s2len];
+		}
 	};
 
 	template <typename Tcost, size_t MaxSize>
@@ -139,6 +168,50 @@ namespace internal
 			}
 			return cur;
 		}
+		/*
+			Bounded variant: returns the exact cost if it does not exceed max_cost.
+			Otherwise, returns a value greater than max_cost
+			(not necessarily the exact cost).
+
+			The cost on the last row changes at most by 1 per column.
+			So, if the current cost exceeds max_cost plus the number of
+			remaining columns, the final cost cannot be max_cost or less.
+		*/
+		template <typename TBitmap, char CMin, char CMax>
+		static cost_type cost_bounded_nonempty(
+			const position_array<TBitmap, char, CMin, CMax>& s1, size_t s1len,
+			const char* s2, size_t s2len,
+			cost_type max_cost
+		) noexcept
+		{
+			if ((s1len < s2len ? s2len - s1len : s1len - s2len) > size_t(max_cost))
+				return max_cost + 1;
+			cost_type cur = s1len;
+			cost_type limit = max_cost + cost_type(s2len);
+			TBitmap msb = TBitmap(1ull) << (s1len - 1);
+			TBitmap pv = -1;
+			TBitmap nv = 0;
+			for (size_t i = 0; i < s2len; i++)
+			{
+				TBitmap mt = s1[s2[i]];
+				TBitmap zd = (((mt & pv) + pv) ^ pv) | mt | nv;
+				TBitmap nh = pv & zd;
+				if (nh & msb)
+					--cur;
+				TBitmap x  = nv | ~(pv | zd) | (pv & ~mt & TBitmap(1ull));
+				TBitmap y  = (pv - nh) >> 1;
+				TBitmap ph = (x + y) ^ y;
+				if (ph & msb)
+					++cur;
+				// limit == max_cost + (number of remaining columns)
+				if (--limit < cur)
+					return max_cost + 1;
+				TBitmap t = (ph << 1) + TBitmap(1ull);
+				nv = t & zd;
+				pv = (nh << 1) | ~(t | zd) | (t & (pv - nh));
+			}
+			return cur;
+		}
 		template <typename TBitmap, char CMin, char CMax>
 		static cost_type cost(
 			const position_array<TBitmap, char, CMin, CMax>& s1, size_t s1len,
@@ -152,6 +225,91 @@ namespace internal
 	};
 }
 
+namespace internal
+{
+	/*
+		Bit-parallel indel distance (one pattern against multiple texts)
+
+		The recurrence is the same as edit_dist_bitparallel_impl but
+		the state for Lanes texts is kept in arrays and updated in
+		lockstep (one text character per lane per step).
+		Lanes whose texts are already consumed are masked out
+		(without branches) so that inner loops over lanes are
+		straight-line code which compilers can vectorize.
+		Note that this is slower than the scalar recurrence unless
+		wide vector registers are available (e.g. AVX2 or AVX-512).
+	*/
+	template <typename Tcost, size_t MaxSize, size_t Lanes>
+	class edit_dist_bitparallel_multi_impl
+	{
+	private:
+		edit_dist_bitparallel_multi_impl(void) = delete;
+		edit_dist_bitparallel_multi_impl(const edit_dist_bitparallel_multi_impl&) = delete;
+	public:
+		typedef Tcost cost_type;
+		static constexpr const size_t lanes = Lanes;
+		static_assert(lanes > 0, "lanes must not be zero.");
+	public:
+		template <typename TBitmap, char CMin, char CMax>
+		static void cost_nonempty(
+			const position_array<TBitmap, char, CMin, CMax>& s1, size_t s1len,
+			const char* const* s2, const size_t* s2len,
+			cost_type* out
+		) noexcept
+		{
+			TBitmap msb = TBitmap(1ull) << (s1len - 1);
+			TBitmap pv[lanes];
+			TBitmap nv[lanes];
+			TBitmap mt[lanes];
+			TBitmap active[lanes];
+			cost_type cur[lanes];
+			size_t maxlen = 0;
+			for (size_t k = 0; k < lanes; k++)
+			{
+				#ifdef FFUZZYPP_DEBUG
+				assert(s2len[k] > 0);
+				#endif
+				pv[k] = TBitmap(-1);
+				nv[k] = 0;
+				cur[k] = cost_type(s1len);
+				maxlen = std::max(maxlen, s2len[k]);
+			}
+			for (size_t i = 0; i < maxlen; i++)
+			{
+				// Gather (consumed lanes read their last character and are masked out)
+				for (size_t k = 0; k < lanes; k++)
+				{
+					bool is_active = i < s2len[k];
+					active[k] = TBitmap(0u) - TBitmap(is_active);
+					mt[k] = s1[s2[k][is_active ? i : s2len[k] - 1]];
+				}
+				for (size_t k = 0; k < lanes; k++)
+				{
+					TBitmap p  = pv[k];
+					TBitmap n  = nv[k];
+					TBitmap m  = mt[k];
+					TBitmap zd = (((m & p) + p) ^ p) | m | n;
+					TBitmap nh = p & zd;
+					TBitmap x  = n | ~(p | zd) | (p & ~m & TBitmap(1ull));
+					TBitmap y  = (p - nh) >> 1;
+					TBitmap ph = (x + y) ^ y;
+					TBitmap t  = (ph << 1) + TBitmap(1ull);
+					TBitmap nn = t & zd;
+					TBitmap np = (nh << 1) | ~(t | zd) | (t & (p - nh));
+					TBitmap a  = active[k];
+					cur[k] = cur[k]
+						+ cost_type((ph & msb & a) != 0)
+						- cost_type((nh & msb & a) != 0);
+					nv[k] = (nn & a) | (n & ~a);
+					pv[k] = (np & a) | (p & ~a);
+				}
+			}
+			for (size_t k = 0; k < lanes; k++)
+				out[k] = cur[k];
+		}
+	};
+}
+
 template <typename Tcost, size_t MaxSize>
 class edit_dist_dp
 {
@@ -220,6 +378,20 @@ public:
 		cost_type rows[2][max_size + 1];
 		return internal::edit_dist_dp_impl<cost_type>::cost_nonempty(s1, s1len, s2, s2len, rows[0], rows[1]);
 	}
+	static cost_type cost_bounded(
+		const char* s1, size_t s1len,
+		const char* s2, size_t s2len,
+		cost_type max_cost
+	) noexcept
+	{
+		#ifdef FFUZZYPP_DEBUG
+		assert(s1len <= max_size);
+		assert(s2len <= max_size);
+		#endif
+		cost_type rows[2][max_size + 1];
+		return internal::edit_dist_dp_impl<cost_type>::cost_bounded_nonempty(
+			s1, s1len, s2, s2len, max_cost, rows[0], rows[1]);
+	}
 };
 
 template <typename Tcost, typename TBitmap, char CMin, char CMax, size_t MaxSize>
@@ -323,6 +495,19 @@ public:
 		#endif
 		return internal::edit_dist_bitparallel_impl<Tcost, MaxSize>::cost_nonempty(s1, s1len, s2, s2len);
 	}
+	static cost_type cost_bounded(
+		const position_array<TBitmap, char, CMin, CMax>& s1, size_t s1len,
+		const char* s2, size_t s2len,
+		cost_type max_cost
+	) noexcept
+	{
+		#ifdef FFUZZYPP_DEBUG
+		assert(s1len <= max_size);
+		assert(s2len <= max_size);
+		#endif
+		return internal::edit_dist_bitparallel_impl<Tcost, MaxSize>::cost_bounded_nonempty(
+			s1, s1len, s2, s2len, max_cost);
+	}
 };
 
 template <typename Tcost, typename TBitmap, char CMin, char CMax, size_t MaxSize>
@@ -358,9 +543,64 @@ public:
 		position_array<TBitmap, char, CMin, CMax> parray(s1, s1len);
 		return internal::edit_dist_bitparallel_impl<Tcost, MaxSize>::cost_nonempty(parray, s1len, s2, s2len);
 	}
+	static cost_type cost_bounded(
+		const char* s1, size_t s1len,
+		const char* s2, size_t s2len,
+		cost_type max_cost
+	) noexcept
+	{
+		#ifdef FFUZZYPP_DEBUG
+		assert(s1len <= max_size);
+		assert(s2len <= max_size);
+		#endif
+		position_array<TBitmap, char, CMin, CMax> parray(s1, s1len);
+		return internal::edit_dist_bitparallel_impl<Tcost, MaxSize>::cost_bounded_nonempty(
+			parray, s1len, s2, s2len, max_cost);
+	}
 };
 
 
+template <typename Tcost, size_t MaxSize, size_t Lanes>
+class edit_dist_nonempty_bitparallel_multi
+{
+private:
+	edit_dist_nonempty_bitparallel_multi(void) = delete;
+	edit_dist_nonempty_bitparallel_multi(const edit_dist_nonempty_bitparallel_multi&) = delete;
+public:
+	static constexpr const size_t max_size = MaxSize;
+	static constexpr const size_t lanes = Lanes;
+	static_assert(max_size > 0, "max_size must not be zero.");
+	typedef Tcost cost_type;
+	static_assert(safe_int::safe_mul<
+			safe_int::uvalue<cost_type, max_size>,
+			safe_int::uvalue<cost_type, 2>
+		>::is_valid,
+		"max_size * 2 must be in range of cost_type.");
+public:
+	/*
+		Computes indel distances between s1 and each of s2[0..lanes)
+		and writes them to out[0..lanes).
+		All strings must be nonempty.
+	*/
+	template <typename TBitmap, char CMin, char CMax>
+	static void cost(
+		const position_array<TBitmap, char, CMin, CMax>& s1, size_t s1len,
+		const char* const* s2, const size_t* s2len,
+		cost_type* out
+	) noexcept
+	{
+		static_assert(max_size <= position_array<TBitmap, char, CMin, CMax>::max_strlen,
+			"max_size must not be greater than max_strlen of corresponding position_array.");
+		#ifdef FFUZZYPP_DEBUG
+		assert(s1len > 0);
+		assert(s1len <= max_size);
+		for (size_t k = 0; k < lanes; k++)
+			assert(s2len[k] <= max_size);
+		#endif
+		internal::edit_dist_bitparallel_multi_impl<Tcost, MaxSize, Lanes>::cost_nonempty(s1, s1len, s2, s2len, out);
+	}
+};
+
 
 namespace internal
 {
@@ -392,6 +632,17 @@ namespace internal
 			return edit_dist_nonempty_bitparallel<Tcost,
 				typename decltype(parray)::bitmap_type, CMin, CMax, MaxSize>::cost(parray, s1len, s2, s2len);
 		}
+		static Tcost cost_bounded_nonempty(
+			const char* s1, size_t s1len,
+			const char* s2, size_t s2len,
+			Tcost max_cost
+		) noexcept
+		{
+			typename auto_position_array<MaxSize, char, CMin, CMax>::type parray(s1, s1len);
+			return edit_dist_nonempty_bitparallel<Tcost,
+				typename decltype(parray)::bitmap_type, CMin, CMax, MaxSize>::cost_bounded(
+					parray, s1len, s2, s2len, max_cost);
+		}
 	};
 
 	template <typename Tcost, char CMin, char CMax, size_t MaxSize>
@@ -415,6 +666,14 @@ namespace internal
 		{
 			return edit_dist_nonempty_dp<Tcost, MaxSize>::cost(s1, s1len, s2, s2len);
 		}
+		static Tcost cost_bounded_nonempty(
+			const char* s1, size_t s1len,
+			const char* s2, size_t s2len,
+			Tcost max_cost
+		) noexcept
+		{
+			return edit_dist_nonempty_dp<Tcost, MaxSize>::cost_bounded(s1, s1len, s2, s2len, max_cost);
+		}
 	};
 }
 
@@ -470,6 +729,21 @@ public:
 			is_auto_position_array_available<MaxSize, char, CMin, CMax>::value
 		>::cost_nonempty(s1, s1len, s2, s2len);
 	}
+	template <
+		char CMin = std::numeric_limits<char>::min(),
+		char CMax = std::numeric_limits<char>::max()
+	>
+	static Tcost cost_bounded(
+		const char* s1, size_t s1len,
+		const char* s2, size_t s2len,
+		Tcost max_cost
+	) noexcept
+	{
+		return internal::edit_dist_impl_selector<
+			cost_type, CMin, CMax, max_size,
+			is_auto_position_array_available<MaxSize, char, CMin, CMax>::value
+		>::cost_bounded_nonempty(s1, s1len, s2, s2len, max_cost);
+	}
 };
 
 
@@ -493,6 +767,17 @@ public:
 		else
 			return Tedit_dist::cost(s2, s2len, s1, s1len);
 	}
+	static cost_type cost_bounded(
+		const char* s1, size_t s1len,
+		const char* s2, size_t s2len,
+		cost_type max_cost
+	) noexcept
+	{
+		if (s1len <= s2len)
+			return Tedit_dist::cost_bounded(s1, s1len, s2, s2len, max_cost);
+		else
+			return Tedit_dist::cost_bounded(s2, s2len, s1, s1len, max_cost);
+	}
 };
 
 template <typename Tedit_dist>
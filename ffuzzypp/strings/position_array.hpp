@@ -272,6 +272,10 @@ public:
 	{
 		return bitmap;
 	}
+	bitmap_type* bitmap_data(void) noexcept
+	{
+		return bitmap;
+	}
 public:
 	position_array(void) noexcept = default; // initialize to undefined state
 	position_array(const position_array& other) noexcept
@@ -0,0 +1,78 @@
+/*
+
+	ffuzzy++ : C++ implementation of fast fuzzy hashing
+
+	utils/bits.hpp
+	Bit manipulation utilities
+
+	Copyright (C) 2026 Tsukasa OI <floss_ssdeep@irq.a4lg.com>
+
+
+	Permission to use, copy, modify, and/or distribute this software for
+	any purpose with or without fee is hereby granted, provided that the
+	above copyright notice and this permission notice appear in all copies.
+
+	THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+	WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+	MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+	ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+	WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+	ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+	OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+
+*/
+#ifndef FFUZZYPP_UTILS_BITS_HPP
+#define FFUZZYPP_UTILS_BITS_HPP
+
+#include <cstdint>
+
+// FFUZZYPP_DISABLE_COMPILER_BUILTINS is determined here
+#include "likely.hpp"
+
+namespace ffuzzy {
+namespace bits {
+
+inline unsigned popcount_portable(uint_least64_t x) noexcept
+{
+	x &= 0xffffffffffffffffull;
+	x = x - ((x >> 1) & 0x5555555555555555ull);
+	x = (x & 0x3333333333333333ull) + ((x >> 2) & 0x3333333333333333ull);
+	x = (x + (x >> 4)) & 0x0f0f0f0f0f0f0f0full;
+	return unsigned(((x * 0x0101010101010101ull) & 0xffffffffffffffffull) >> 56);
+}
+
+inline unsigned popcount(uint_least64_t x) noexcept
+{
+	#ifdef FFUZZYPP_DISABLE_COMPILER_BUILTINS
+	return popcount_portable(x);
+	#else
+	return unsigned(__builtin_popcountll(x));
+	#endif
+}
+
+// Number of trailing zero bits (x must not be zero)
+inline unsigned count_trailing_zeros(uint_least64_t x) noexcept
+{
+	#ifdef FFUZZYPP_DISABLE_COMPILER_BUILTINS
+	return popcount_portable((x & (~x + 1u)) - 1u);
+	#else
+	return unsigned(__builtin_ctzll(x));
+	#endif
+}
+
+// Position of the most significant set bit (x must not be zero)
+inline unsigned floor_log2(uint_least64_t x) noexcept
+{
+	#ifdef FFUZZYPP_DISABLE_COMPILER_BUILTINS
+	unsigned n = 0;
+	while (x >>= 1)
+		n++;
+	return n;
+	#else
+	return 63u - unsigned(__builtin_clzll(x));
+	#endif
+}
+
+}}
+
+#endif
@@ -0,0 +1,120 @@
+/*
+
+	ffuzzy++ : C++ implementation of fast fuzzy hashing
+
+	utils/mapped_file.hpp
+	Read-only memory-mapped files
+
+	Copyright (C) 2026 Tsukasa OI <floss_ssdeep@irq.a4lg.com>
+
+
+	Permission to use, copy, modify, and/or distribute this software for
+	any purpose with or without fee is hereby granted, provided that the
+	above copyright notice and this permission notice appear in all copies.
+
+	THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+	WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+	MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+	ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+	WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+	ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+	OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+
+*/
+#ifndef FFUZZYPP_UTILS_MAPPED_FILE_HPP
+#define FFUZZYPP_UTILS_MAPPED_FILE_HPP
+
+// Memory-mapped files are available on POSIX systems only
+#ifndef FFUZZYPP_DISABLE_MAPPED_FILE
+#if !(defined(__unix__) || defined(__unix) || (defined(__APPLE__) && defined(__MACH__)))
+#define FFUZZYPP_DISABLE_MAPPED_FILE 1
+#endif
+#endif
+
+#ifndef FFUZZYPP_DISABLE_MAPPED_FILE
+
+#include <cstddef>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace ffuzzy {
+
+/*
+	Read-only, shared mapping of a whole file
+
+	Pages are shared with the page cache (and so, with all processes
+	mapping the same file).  Empty files cannot be mapped.
+*/
+class mapped_file
+{
+private:
+	const void* ptr;
+	size_t len;
+public:
+	const void* data(void) const noexcept { return ptr; }
+	size_t size(void) const noexcept { return len; }
+	bool is_open(void) const noexcept { return ptr != nullptr; }
+public:
+	void close(void) noexcept
+	{
+		if (ptr)
+			munmap(const_cast<void*>(ptr), len);
+		ptr = nullptr;
+		len = 0;
+	}
+	bool open(const char* filename) noexcept
+	{
+		close();
+		int fd = ::open(filename, O_RDONLY);
+		if (fd < 0)
+			return false;
+		struct stat st;
+		if (fstat(fd, &st) != 0 || st.st_size <= 0 ||
+			static_cast<unsigned long long>(st.st_size) > static_cast<size_t>(-1))
+		{
+			::close(fd);
+			return false;
+		}
+		size_t n = static_cast<size_t>(st.st_size);
+		void* p = mmap(nullptr, n, PROT_READ, MAP_SHARED, fd, 0);
+		// the mapping is kept after closing the descriptor
+		::close(fd);
+		if (p == MAP_FAILED)
+			return false;
+		ptr = p;
+		len = n;
+		return true;
+	}
+public:
+	mapped_file(void) noexcept : ptr(nullptr), len(0) {}
+	explicit mapped_file(const char* filename) noexcept : ptr(nullptr), len(0) { open(filename); }
+	mapped_file(const mapped_file&) = delete;
+	mapped_file& operator=(const mapped_file&) = delete;
+	mapped_file(mapped_file&& other) noexcept : ptr(other.ptr), len(other.len)
+	{
+		other.ptr = nullptr;
+		other.len = 0;
+	}
+	mapped_file& operator=(mapped_file&& other) noexcept
+	{
+		if (this != &other)
+		{
+			close();
+			ptr = other.ptr;
+			len = other.len;
+			other.ptr = nullptr;
+			other.len = 0;
+		}
+		return *this;
+	}
+	~mapped_file(void) { close(); }
+};
+
+}
+
+#endif
+
+#endif
@@ -0,0 +1,43 @@
+/*
+
+	ffuzzy++ : C++ implementation of fast fuzzy hashing
+
+	utils/prefetch.hpp
+	Memory prefetching hints
+
+	Copyright (C) 2026 Tsukasa OI <floss_ssdeep@irq.a4lg.com>
+
+
+	Permission to use, copy, modify, and/or distribute this software for
+	any purpose with or without fee is hereby granted, provided that the
+	above copyright notice and this permission notice appear in all copies.
+
+	THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+	WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+	MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+	ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+	WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+	ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+	OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+
+*/
+#ifndef FFUZZYPP_UTILS_PREFETCH_HPP
+#define FFUZZYPP_UTILS_PREFETCH_HPP
+
+// FFUZZYPP_DISABLE_COMPILER_BUILTINS is determined here
+#include "likely.hpp"
+
+#define FFUZZYPP_PREFETCH_PORTABLE(addr) ((void)(addr))
+
+#ifdef  FFUZZYPP_PREFETCH
+#undef  FFUZZYPP_PREFETCH
+#endif
+
+#ifdef  FFUZZYPP_DISABLE_COMPILER_BUILTINS
+#define FFUZZYPP_PREFETCH FFUZZYPP_PREFETCH_PORTABLE
+#else
+// read-only access, moderate temporal locality
+#define FFUZZYPP_PREFETCH(addr) (__builtin_prefetch((addr), 0, 1))
+#endif
+
+#endif
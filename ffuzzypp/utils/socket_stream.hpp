@@ -0,0 +1,241 @@
+/*
+
+	ffuzzy++ : C++ implementation of fast fuzzy hashing
+
+	utils/socket_stream.hpp
+	Stream sockets (Unix domain)
+
+	Copyright (C) 2026 Tsukasa OI <floss_ssdeep@irq.a4lg.com>
+
+
+	Permission to use, copy, modify, and/or distribute this software for
+	any purpose with or without fee is hereby granted, provided that the
+	above copyright notice and this permission notice appear in all copies.
+
+	THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+	WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+	MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+	ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+	WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+	ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+	OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+
+*/
+#ifndef FFUZZYPP_UTILS_SOCKET_STREAM_HPP
+#define FFUZZYPP_UTILS_SOCKET_STREAM_HPP
+
+// Unix domain sockets are available on POSIX systems only
+#ifndef FFUZZYPP_DISABLE_SOCKETS
+#if !(defined(__unix__) || defined(__unix) || (defined(__APPLE__) && defined(__MACH__)))
+#define FFUZZYPP_DISABLE_SOCKETS 1
+#endif
+#endif
+
+#ifndef FFUZZYPP_DISABLE_SOCKETS
+
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+
+#include <string>
+
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace ffuzzy {
+
+/*
+	Connected stream socket (owns the descriptor)
+
+	read_all and write_all transfer whole buffers (retrying on
+	interruption) and return false on errors or at the end of stream.
+	Writing to a closed peer does not raise SIGPIPE where possible.
+*/
+class socket_stream
+{
+private:
+	int sock;
+public:
+	int fd(void) const noexcept { return sock; }
+	bool is_open(void) const noexcept { return sock >= 0; }
+	void close(void) noexcept
+	{
+		if (sock >= 0)
+			::close(sock);
+		sock = -1;
+	}
+	// Stops further writes (the peer reads the end of stream)
+	void shutdown_write(void) noexcept
+	{
+		if (sock >= 0)
+			::shutdown(sock, SHUT_WR);
+	}
+	// Stops both directions (wakes up threads blocked on this socket)
+	void shutdown(void) noexcept
+	{
+		if (sock >= 0)
+			::shutdown(sock, SHUT_RDWR);
+	}
+public:
+	bool read_all(void* buf, size_t size) noexcept
+	{
+		unsigned char* p = static_cast<unsigned char*>(buf);
+		while (size)
+		{
+			ssize_t n = ::recv(sock, p, size, 0);
+			if (n < 0 && errno == EINTR)
+				continue;
+			if (n <= 0)
+				return false;
+			p += n;
+			size -= size_t(n);
+		}
+		return true;
+	}
+	bool write_all(const void* buf, size_t size) noexcept
+	{
+		const unsigned char* p = static_cast<const unsigned char*>(buf);
+		while (size)
+		{
+			#ifdef MSG_NOSIGNAL
+			ssize_t n = ::send(sock, p, size, MSG_NOSIGNAL);
+			#else
+			ssize_t n = ::send(sock, p, size, 0);
+			#endif
+			if (n < 0 && errno == EINTR)
+				continue;
+			if (n <= 0)
+				return false;
+			p += n;
+			size -= size_t(n);
+		}
+		return true;
+	}
+public:
+	socket_stream(void) noexcept : sock(-1) {}
+	explicit socket_stream(int fd) noexcept : sock(fd)
+	{
+		#ifdef SO_NOSIGPIPE
+		int one = 1;
+		if (sock >= 0)
+			setsockopt(sock, SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof(one));
+		#endif
+	}
+	socket_stream(const socket_stream&) = delete;
+	socket_stream& operator=(const socket_stream&) = delete;
+	socket_stream(socket_stream&& other) noexcept : sock(other.sock) { other.sock = -1; }
+	socket_stream& operator=(socket_stream&& other) noexcept
+	{
+		if (this != &other)
+		{
+			close();
+			sock = other.sock;
+			other.sock = -1;
+		}
+		return *this;
+	}
+	~socket_stream(void) { close(); }
+public:
+	// Connects to a listening Unix domain socket (not open on failure)
+	static socket_stream connect_unix(const char* path) noexcept
+	{
+		struct sockaddr_un addr;
+		if (strlen(path) >= sizeof(addr.sun_path))
+			return socket_stream();
+		memset(&addr, 0, sizeof(addr));
+		addr.sun_family = AF_UNIX;
+		strcpy(addr.sun_path, path);
+		socket_stream s(::socket(AF_UNIX, SOCK_STREAM, 0));
+		if (s.is_open() && ::connect(s.sock, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) != 0)
+			s.close();
+		return s;
+	}
+	// Creates a pair of connected sockets (not open on failure)
+	static bool make_pair(socket_stream& a, socket_stream& b) noexcept
+	{
+		int fds[2];
+		if (::socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0)
+			return false;
+		a = socket_stream(fds[0]);
+		b = socket_stream(fds[1]);
+		return true;
+	}
+};
+
+/*
+	Listening Unix domain socket
+
+	The socket file is created on listen and removed on close.
+*/
+class socket_listener
+{
+private:
+	int sock;
+	std::string sock_path;
+public:
+	bool is_open(void) const noexcept { return sock >= 0; }
+	const std::string& path(void) const noexcept { return sock_path; }
+	void close(void) noexcept
+	{
+		if (sock >= 0)
+		{
+			::close(sock);
+			::unlink(sock_path.c_str());
+		}
+		sock = -1;
+		sock_path.clear();
+	}
+	bool listen_unix(const std::string& path, int backlog = 64)
+	{
+		close();
+		std::string p(path);
+		struct sockaddr_un addr;
+		if (p.size() >= sizeof(addr.sun_path))
+			return false;
+		memset(&addr, 0, sizeof(addr));
+		addr.sun_family = AF_UNIX;
+		strcpy(addr.sun_path, p.c_str());
+		int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+		if (fd < 0)
+			return false;
+		if (::bind(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) != 0 ||
+			::listen(fd, backlog) != 0)
+		{
+			::close(fd);
+			return false;
+		}
+		sock = fd;
+		sock_path.swap(p);
+		return true;
+	}
+	// Waits for a connection (not open on failure)
+	socket_stream accept(void) noexcept
+	{
+		while (true)
+		{
+			int fd = ::accept(sock, nullptr, nullptr);
+			if (fd < 0 && errno == EINTR)
+				continue;
+			return socket_stream(fd);
+		}
+	}
+	// Wakes up threads blocked in accept (they get a closed stream)
+	void shutdown(void) noexcept
+	{
+		if (sock >= 0)
+			::shutdown(sock, SHUT_RDWR);
+	}
+public:
+	socket_listener(void) noexcept : sock(-1) {}
+	socket_listener(const socket_listener&) = delete;
+	socket_listener& operator=(const socket_listener&) = delete;
+	~socket_listener(void) { close(); }
+};
+
+}
+
+#endif
+
+#endif
@@ -0,0 +1,136 @@
+/*
+
+	ffuzzy++ : C++ implementation of fast fuzzy hasing
+
+	tests/cases/common/digest_corpus.hpp
+	Pseudo-random corpus of related digests (for one-vs-many tests)
+
+	Copyright (C) 2026 Tsukasa OI <floss_ssdeep@irq.a4lg.com>
+
+
+	Permission to use, copy, modify, and/or distribute this software for
+	any purpose with or without fee is hereby granted, provided that the
+	above copyright notice and this permission notice appear in all copies.
+
+	THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+	WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+	MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+	ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+	WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+	ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+	OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+
+*/
+#ifndef FFUZZYPP_TESTCASES_COMMON_DIGEST_CORPUS_HPP
+#define FFUZZYPP_TESTCASES_COMMON_DIGEST_CORPUS_HPP
+
+#include <cstddef>
+#include <random>
+#include <string>
+#include <vector>
+
+
+/*
+	Generates digest strings in "families".
+	Members of a family share (slightly modified) block hashes and
+	some of them are shifted to the neighboring block size
+	so that every kind of "near" relation is exercised.
+	Identical digests, short block hashes and large block sizes
+	(not safe to double) are also generated.
+*/
+class DigestCorpus
+{
+private:
+	DigestCorpus(void) = delete;
+	DigestCorpus(const DigestCorpus&) = delete;
+private:
+	static char random_char(std::mt19937& rng)
+	{
+		static const char b64[] =
+			"ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+		return b64[rng() % 64];
+	}
+	static std::string random_blockhash(std::mt19937& rng, size_t len)
+	{
+		std::string s;
+		for (size_t i = 0; i < len; i++)
+			s.push_back(random_char(rng));
+		return s;
+	}
+	static std::string mutate(std::mt19937& rng, std::string s, size_t max_len)
+	{
+		unsigned edits = rng() % 8;
+		for (unsigned e = 0; e < edits; e++)
+		{
+			size_t pos = s.empty() ? 0 : rng() % s.size();
+			switch (rng() % 3)
+			{
+				case 0:
+					if (!s.empty())
+						s[pos] = random_char(rng);
+					break;
+				case 1:
+					if (s.size() < max_len)
+						s.insert(s.begin() + pos, random_char(rng));
+					break;
+				default:
+					if (!s.empty())
+						s.erase(s.begin() + pos);
+					break;
+			}
+		}
+		return s;
+	}
+	static std::string make(unsigned long bs, const std::string& b1, const std::string& b2)
+	{
+		return std::to_string(bs) + ":" + b1 + ":" + b2;
+	}
+public:
+	static std::vector<std::string> generate(size_t count, unsigned seed = 1)
+	{
+		static const size_t max_len = 64;
+		std::mt19937 rng(seed);
+		std::vector<std::string> out;
+		while (out.size() < count)
+		{
+			unsigned idx = rng() % 12;
+			unsigned long bs = 3ul << idx;
+			if (rng() % 16 == 0)
+				bs = 3ul << 30; // not safe to double
+			std::string b1 = random_blockhash(rng, 1 + rng() % max_len);
+			std::string b2 = random_blockhash(rng, 1 + rng() % (max_len / 2));
+			size_t members = 1 + rng() % 8;
+			for (size_t m = 0; m < members && out.size() < count; m++)
+			{
+				switch (rng() % 6)
+				{
+					case 0: // exact copy
+						out.push_back(make(bs, b1, b2));
+						break;
+					case 1: // shifted to larger block size
+						if (bs <= 0x7ffffffful)
+						{
+							out.push_back(make(bs * 2, mutate(rng, b2, max_len),
+								random_blockhash(rng, rng() % (max_len / 2))));
+							break;
+						}
+						// fall through
+					case 2: // shifted to smaller block size
+						if (bs % 2 == 0)
+						{
+							out.push_back(make(bs / 2,
+								random_blockhash(rng, rng() % max_len), mutate(rng, b1, max_len / 2)));
+							break;
+						}
+						// fall through
+					default:
+						out.push_back(make(bs, mutate(rng, b1, max_len), mutate(rng, b2, max_len / 2)));
+						break;
+				}
+			}
+		}
+		return out;
+	}
+};
+
+#endif
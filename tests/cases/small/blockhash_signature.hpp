@@ -0,0 +1,82 @@
+/*
+
+	ffuzzy++ : C++ implementation of fast fuzzy hasing
+
+	tests/cases/small/blockhash_signature.hpp
+	Block hash signature (common substring prefilter) tests
+
+	Copyright (C) 2026 Tsukasa OI <floss_ssdeep@irq.a4lg.com>
+
+
+	Permission to use, copy, modify, and/or distribute this software for
+	any purpose with or without fee is hereby granted, provided that the
+	above copyright notice and this permission notice appear in all copies.
+
+	THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+	WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+	MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+	ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+	WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+	ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+	OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+
+*/
+#ifndef FFUZZYPP_TESTCASES_SMALL_BLOCKHASH_SIGNATURE_HPP
+#define FFUZZYPP_TESTCASES_SMALL_BLOCKHASH_SIGNATURE_HPP
+
+#include <cstddef>
+#include <random>
+#include <string>
+
+
+TEST(BlockhashSignatureTests, ShortStringsAreEmpty)
+{
+	static const char str[] = "ABCDEFGHIJ";
+	for (size_t len = 0; len < blockhash_comparison_params::min_match_len; len++)
+	{
+		blockhash_signature sig(str, len);
+		EXPECT_TRUE(sig.empty()) << "signature is not empty on length " << len << ".";
+		EXPECT_FALSE(sig.may_match(sig)) << "empty signature matched on length " << len << ".";
+	}
+	blockhash_signature sig(str, blockhash_comparison_params::min_match_len);
+	EXPECT_FALSE(sig.empty());
+	EXPECT_TRUE(sig.may_match(sig));
+}
+
+TEST(BlockhashSignatureTests, NoFalseNegatives)
+{
+	static const char b64[] =
+		"ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+	std::mt19937 rng(1);
+	size_t rejected = 0, total = 0;
+	for (unsigned n = 0; n < 20000; n++)
+	{
+		// small alphabet on some strings to make common substrings
+		unsigned alphabet = n % 2 ? 64 : 3;
+		string strA(1 + rng() % digest_params::max_blockhash_len, 'A');
+		string strB(1 + rng() % digest_params::max_blockhash_len, 'A');
+		for (auto& ch : strA)
+			ch = b64[rng() % alphabet];
+		for (auto& ch : strB)
+			ch = b64[rng() % alphabet];
+		blockhash_signature sigA(strA.data(), strA.size());
+		blockhash_signature sigB(strB.data(), strB.size());
+		bool matched = strings::common_substr_hasharray<digest_params::max_blockhash_len,
+			blockhash_comparison_params::min_match_len>::match(strA.data(), strA.size(), strB.data(), strB.size());
+		if (matched)
+		{
+			ASSERT_TRUE(blockhash_signature::may_match(sigA, sigB))
+				<< "signature test failed on <" << strA << "> and <" << strB << ">.";
+		}
+		else if (alphabet == 64 && strA.size() <= 16 && strB.size() <= 16)
+		{
+			total++;
+			if (!blockhash_signature::may_match(sigA, sigB))
+				rejected++;
+		}
+	}
+	// Most unrelated pairs of short block hashes must be rejected
+	EXPECT_LT(total / 2, rejected);
+}
+
+#endif
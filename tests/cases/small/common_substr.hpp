@@ -25,6 +25,8 @@
 #define FFUZZYPP_TESTCASES_SMALL_COMMON_SUBSTR_HPP
 
 #include <cstring>
+#include <random>
+#include <string>
 
 
 class CommonSubstringTestParams
@@ -90,6 +92,10 @@ typedef ::testing::Types<
 		CommonSubstringTestParams::MaxSize,
 		CommonSubstringTestParams::SubstringSizeToTest
 	>,
+	strings::common_substr_hashset<
+		CommonSubstringTestParams::MaxSize,
+		CommonSubstringTestParams::SubstringSizeToTest
+	>,
 	strings::common_substr_bitparallel_wrapper<
 		unsigned long long, '0', '9',
 		CommonSubstringTestParams::MaxSize,
@@ -123,4 +129,87 @@ TYPED_TEST(CommonSubstringTests, MatchCommutativityTest)
 	}
 }
 
+template <size_t max_size>
+static void CommonSubstringHashSetTests_CompareWithHashArray(size_t iterations)
+{
+	// Small alphabets to cause many repeated substrings (and probe chains)
+	static const size_t substr_size = CommonSubstringTestParams::SubstringSizeToTest;
+	std::mt19937 rng(1);
+	for (unsigned alphabet : {2u, 3u, 16u})
+	{
+		for (size_t n = 0; n < iterations; n++)
+		{
+			char s1[max_size], s2[max_size];
+			size_t l1 = rng() % (max_size + 1), l2 = rng() % (max_size + 1);
+			for (size_t i = 0; i < l1; i++)
+				s1[i] = char('A' + rng() % alphabet);
+			for (size_t i = 0; i < l2; i++)
+				s2[i] = char('A' + rng() % alphabet);
+			ASSERT_EQ(
+				(strings::common_substr_hasharray<max_size, substr_size>::match(s1, l1, s2, l2)),
+				(strings::common_substr_hashset<max_size, substr_size>::match(s1, l1, s2, l2)))
+				<< "hash set test failed on <" << string(s1, l1) << "> and <" << string(s2, l2) << ">.";
+		}
+	}
+}
+
+TEST(CommonSubstringHashSetTests, MatchesHashArray)
+{
+	static const size_t substr_size = CommonSubstringTestParams::SubstringSizeToTest;
+	// positions in the table take one byte on short strings (two bytes on longer ones)
+	EXPECT_EQ(1u, sizeof(strings::internal::common_substr_hashset_impl<
+		substr_size, CommonSubstringTestParams::MaxSize>::position_type));
+	EXPECT_EQ(2u, sizeof(strings::internal::common_substr_hashset_impl<substr_size, 300>::position_type));
+	CommonSubstringHashSetTests_CompareWithHashArray<CommonSubstringTestParams::MaxSize>(20000);
+	CommonSubstringHashSetTests_CompareWithHashArray<300>(2000);
+}
+
+TEST(CommonSubstringEditDistTests, MatchesSeparateKernels)
+{
+	static const size_t max_size = CommonSubstringTestParams::MaxSize;
+	static const size_t substr_size = CommonSubstringTestParams::SubstringSizeToTest;
+	typedef strings::position_array<unsigned long long, char, 'A', 'P'> pa_type;
+	typedef strings::common_substr_edit_dist_bitparallel<
+		unsigned, unsigned long long, 'A', 'P', max_size, substr_size> fused_type;
+	std::mt19937 rng(2);
+	for (unsigned alphabet : {2u, 3u, 16u})
+	{
+		for (size_t n = 0; n < 20000; n++)
+		{
+			char s1[max_size], s2[max_size];
+			size_t l1 = rng() % (max_size + 1), l2 = rng() % (max_size + 1);
+			for (size_t i = 0; i < l1; i++)
+				s1[i] = char('A' + rng() % alphabet);
+			for (size_t i = 0; i < l2; i++)
+				s2[i] = char('A' + rng() % alphabet);
+			pa_type pa(s1, l1);
+			bool expected_match =
+				strings::common_substr_bitparallel<unsigned long long, 'A', 'P', max_size, substr_size>
+					::match(pa, s2, l2);
+			unsigned cost = 0;
+			ASSERT_EQ(expected_match, fused_type::cost(cost, pa, l1, s2, l2))
+				<< "fused test failed on <" << string(s1, l1) << "> and <" << string(s2, l2) << ">.";
+			if (!expected_match)
+				continue;
+			unsigned expected_cost =
+				strings::edit_dist_bitparallel<unsigned, unsigned long long, 'A', 'P', max_size>
+					::cost(pa, l1, s2, l2);
+			ASSERT_EQ(expected_cost, cost)
+				<< "fused test failed on <" << string(s1, l1) << "> and <" << string(s2, l2) << ">.";
+			for (unsigned max_cost : {0u, expected_cost / 2, expected_cost, expected_cost + 3})
+			{
+				ASSERT_TRUE(fused_type::cost_bounded(cost, pa, l1, s2, l2, max_cost));
+				if (expected_cost <= max_cost)
+				{
+					ASSERT_EQ(expected_cost, cost);
+				}
+				else
+				{
+					ASSERT_LT(max_cost, cost);
+				}
+			}
+		}
+	}
+}
+
 #endif
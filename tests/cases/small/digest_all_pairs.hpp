@@ -0,0 +1,121 @@
+/*
+
+	ffuzzy++ : C++ implementation of fast fuzzy hasing
+
+	tests/cases/small/digest_all_pairs.hpp
+	Cache-blocked all-pairs comparison tests
+
+	Copyright (C) 2026 Tsukasa OI <floss_ssdeep@irq.a4lg.com>
+
+
+	Permission to use, copy, modify, and/or distribute this software for
+	any purpose with or without fee is hereby granted, provided that the
+	above copyright notice and this permission notice appear in all copies.
+
+	THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+	WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+	MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+	ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+	WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+	ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+	OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+
+*/
+#ifndef FFUZZYPP_TESTCASES_SMALL_DIGEST_ALL_PAIRS_HPP
+#define FFUZZYPP_TESTCASES_SMALL_DIGEST_ALL_PAIRS_HPP
+
+#include <cstddef>
+#include <algorithm>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "../common/digest_corpus.hpp"
+
+
+template <bool IsAlphabetRestricted, comparison_version Version>
+struct DigestAllPairsTestParam
+{
+	static constexpr const bool is_alphabet_restricted = IsAlphabetRestricted;
+	static constexpr const comparison_version version = Version;
+};
+
+template <typename T>
+class DigestAllPairsTests : public ::testing::Test {};
+
+typedef ::testing::Types<
+	DigestAllPairsTestParam<true,  comparison_version::v2_13>,
+	DigestAllPairsTestParam<true,  comparison_version::v2_9>,
+	DigestAllPairsTestParam<false, comparison_version::v2_13>
+> DigestAllPairsTypes;
+TYPED_TEST_CASE(DigestAllPairsTests, DigestAllPairsTypes);
+
+TYPED_TEST(DigestAllPairsTests, MatchesBruteForce)
+{
+	static constexpr const bool ra = TypeParam::is_alphabet_restricted;
+	static constexpr const comparison_version version = TypeParam::version;
+	typedef std::tuple<size_t, size_t, digest_comparison_score_t> result_type;
+	// large enough to have multiple tiles in a bucket
+	vector<string> corpus = DigestCorpus::generate(900, 6);
+	vector<digest<ra, false, true>> digests;
+	digest_store<ra> store;
+	for (const auto& str : corpus)
+	{
+		digests.push_back(digest<ra, false, true>(str));
+		store.push_back(digests.back());
+	}
+	digest_all_pairs<ra, version> all_pairs(store);
+	for (digest_comparison_score_t min_score : {0u, 1u, 50u, 100u})
+	{
+		vector<result_type> expected;
+		for (size_t i = 0; i < digests.size(); i++)
+		{
+			for (size_t j = i + 1; j < digests.size(); j++)
+			{
+				digest_comparison_score_t score = digest_comparison<version>::compare(digests[i], digests[j]);
+				if (score && score >= min_score)
+					expected.push_back(result_type(i, j, score));
+			}
+		}
+		vector<result_type> results;
+		all_pairs.run(min_score,
+			[&results](size_t i, size_t j, digest_comparison_score_t score)
+			{
+				results.push_back(result_type(i, j, score));
+			});
+		sort(results.begin(), results.end());
+		ASSERT_EQ(expected.size(), results.size()) << "all-pairs test failed (min_score=" << min_score << ").";
+		for (size_t n = 0; n < expected.size(); n++)
+		{
+			ASSERT_EQ(expected[n], results[n])
+				<< "all-pairs test failed on <" << corpus[std::get<0>(expected[n])]
+				<< "> and <" << corpus[std::get<1>(expected[n])] << "> (min_score=" << min_score << ").";
+		}
+		// make sure that the corpus is meaningful
+		if (min_score <= 1)
+		{
+			EXPECT_LT(100u, results.size());
+		}
+	}
+}
+
+TEST(DigestAllPairsUsageTests, Buckets)
+{
+	digest_store_t store;
+	store.push_back("6:ABCDEFGH:IJKLMNOP");
+	store.push_back("3:ABCDEFGH:IJKLMNOP");
+	store.push_back("6:ABCDEFGH:IJKLMNOQ");
+	store.push_back("24:ABCDEFGH:IJKLMNOP");
+	digest_all_pairs<true> all_pairs(store);
+	ASSERT_EQ(3u, all_pairs.bucket_list().size());
+	EXPECT_EQ(3u, all_pairs.bucket_list()[0].blocksize);
+	EXPECT_EQ(6u, all_pairs.bucket_list()[1].blocksize);
+	EXPECT_EQ(24u, all_pairs.bucket_list()[2].blocksize);
+	EXPECT_EQ(1u, all_pairs.double_bucket_of(0));
+	EXPECT_EQ(3u, all_pairs.double_bucket_of(1));
+	EXPECT_EQ(3u, all_pairs.double_bucket_of(2));
+	vector<size_t> expected_order = { 1, 0, 2, 3 };
+	EXPECT_EQ(expected_order, all_pairs.sorted_indices());
+}
+
+#endif
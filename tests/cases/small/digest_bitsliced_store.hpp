@@ -0,0 +1,139 @@
+/*
+
+	ffuzzy++ : C++ implementation of fast fuzzy hasing
+
+	tests/cases/small/digest_bitsliced_store.hpp
+	Bit-sliced store tests
+
+	Copyright (C) 2026 Tsukasa OI <floss_ssdeep@irq.a4lg.com>
+
+
+	Permission to use, copy, modify, and/or distribute this software for
+	any purpose with or without fee is hereby granted, provided that the
+	above copyright notice and this permission notice appear in all copies.
+
+	THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+	WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+	MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+	ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+	WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+	ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+	OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+
+*/
+#ifndef FFUZZYPP_TESTCASES_SMALL_DIGEST_BITSLICED_STORE_HPP
+#define FFUZZYPP_TESTCASES_SMALL_DIGEST_BITSLICED_STORE_HPP
+
+#include <cstddef>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../common/digest_corpus.hpp"
+
+
+TEST(DigestBitslicedStoreTests, CommonSubstringMatchesScalar)
+{
+	// Small alphabets to cause many partial matches
+	static const size_t max_len = digest_params::max_blockhash_len;
+	std::mt19937 rng(3);
+	for (unsigned alphabet : {2u, 4u, 64u})
+	{
+		digest_bitsliced_store store(3);
+		vector<string> bhs;
+		for (size_t n = 0; n < 200; n++)
+		{
+			string bh;
+			size_t len = rng() % (max_len + 1);
+			for (size_t i = 0; i < len; i++)
+				bh.push_back(char(rng() % alphabet));
+			bhs.push_back(bh);
+			store.push_back(digest_view_ra_t(3, bh.data(), bh.size(), "", 0));
+		}
+		ASSERT_EQ(4u, store.slice_count());
+		for (size_t n = 0; n < 100; n++)
+		{
+			string q;
+			size_t qlen = rng() % (max_len + 1);
+			for (size_t i = 0; i < qlen; i++)
+				q.push_back(char(rng() % alphabet));
+			for (size_t s = 0; s < store.slice_count(); s++)
+			{
+				digest_bitsliced_store::word_type mask = store.common_substr_mask(s, 0, q.data(), q.size());
+				for (size_t k = 0; k < 64 && s * 64 + k < bhs.size(); k++)
+				{
+					const string& c = bhs[s * 64 + k];
+					bool expected = strings::common_substr_fast<max_len,
+						blockhash_comparison_params::min_match_len>::match(q.data(), q.size(), c.data(), c.size());
+					ASSERT_EQ(expected, bool((mask >> k) & 1u))
+						<< "common substring test failed on alphabet=" << alphabet << ", n=" << n << ", k=" << (s * 64 + k);
+				}
+			}
+		}
+	}
+}
+
+TEST(DigestBitslicedStoreTests, CompareMatchesDigestComparison)
+{
+	vector<string> corpus = DigestCorpus::generate(1500, 10);
+	vector<digest_ra_long_t> digests;
+	std::map<unsigned long, digest_bitsliced_store> stores;
+	std::map<unsigned long, vector<size_t>> members;
+	for (const auto& str : corpus)
+	{
+		digests.push_back(digest_ra_long_t(str));
+		unsigned long bs = digests.back().blocksize();
+		stores.emplace(bs, digest_bitsliced_store(digest_blocksize_t(bs)));
+		stores.at(bs).push_back(digests.back());
+		members[bs].push_back(digests.size() - 1);
+	}
+	size_t nonzero = 0;
+	for (size_t q = 0; q < digests.size(); q += 3)
+	{
+		for (const auto& entry : stores)
+		{
+			const digest_bitsliced_store& store = entry.second;
+			const vector<size_t>& idx = members[entry.first];
+			vector<digest_comparison_score_t> scores13(store.size()), scores9(store.size());
+			store.compare_all<comparison_version::v2_13>(digests[q], scores13.data());
+			store.compare_all<comparison_version::v2_9>(digests[q], scores9.data());
+			for (size_t i = 0; i < store.size(); i++)
+			{
+				ASSERT_EQ(digest_comparison<comparison_version::v2_13>::compare(digests[q], digests[idx[i]]), scores13[i])
+					<< "comparison failed on <" << corpus[q] << "> and <" << corpus[idx[i]] << ">.";
+				ASSERT_EQ(digest_comparison<comparison_version::v2_9>::compare(digests[q], digests[idx[i]]), scores9[i])
+					<< "comparison failed on <" << corpus[q] << "> and <" << corpus[idx[i]] << ">.";
+				if (scores13[i])
+					nonzero++;
+			}
+		}
+	}
+	// make sure that the corpus is meaningful
+	EXPECT_LT(100u, nonzero);
+}
+
+TEST(DigestBitslicedStoreTests, IdenticalEmptyBlockhashes)
+{
+	// Identical digests with empty block hashes (v2_9 scores them as 0)
+	static const char* const strs[] = { "3::", "3:ABCDEFGHIJ:", "3::ABCDEFGHIJ" };
+	digest_bitsliced_store store(3);
+	for (const char* str : strs)
+		store.push_back(digest_ra_t(str));
+	for (const char* q : strs)
+	{
+		digest_ra_t query(q);
+		digest_comparison_score_t scores13[3], scores9[3];
+		store.compare_all<comparison_version::v2_13>(query, scores13);
+		store.compare_all<comparison_version::v2_9>(query, scores9);
+		for (size_t i = 0; i < store.size(); i++)
+		{
+			EXPECT_EQ(digest_comparison<comparison_version::v2_13>::compare(query, digest_ra_t(strs[i])), scores13[i])
+				<< "comparison failed on <" << q << "> and <" << strs[i] << ">.";
+			EXPECT_EQ(digest_comparison<comparison_version::v2_9>::compare(query, digest_ra_t(strs[i])), scores9[i])
+				<< "comparison failed on <" << q << "> and <" << strs[i] << ">.";
+		}
+	}
+}
+
+#endif
@@ -0,0 +1,123 @@
+/*
+
+	ffuzzy++ : C++ implementation of fast fuzzy hasing
+
+	tests/cases/small/digest_compact_store.hpp
+	Compact position array and compact store tests
+
+	Copyright (C) 2026 Tsukasa OI <floss_ssdeep@irq.a4lg.com>
+
+
+	Permission to use, copy, modify, and/or distribute this software for
+	any purpose with or without fee is hereby granted, provided that the
+	above copyright notice and this permission notice appear in all copies.
+
+	THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+	WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+	MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+	ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+	WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+	ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+	OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+
+*/
+#ifndef FFUZZYPP_TESTCASES_SMALL_DIGEST_COMPACT_STORE_HPP
+#define FFUZZYPP_TESTCASES_SMALL_DIGEST_COMPACT_STORE_HPP
+
+#include <cstddef>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../common/digest_corpus.hpp"
+
+
+TEST(CompactPositionArrayTests, MatchesPositionArray)
+{
+	typedef strings::position_array<unsigned long long, char, 0, 63> dense_type;
+	typedef strings::compact_position_array<unsigned long long, char, 0, 63> compact_type;
+	std::mt19937 rng(1);
+	for (unsigned alphabet : {1u, 4u, 64u})
+	{
+		for (size_t n = 0; n < 2000; n++)
+		{
+			char str[64];
+			size_t len = rng() % 65;
+			for (size_t i = 0; i < len; i++)
+				str[i] = char(rng() % alphabet);
+			dense_type dense(str, len);
+			compact_type::mask_type mask;
+			unsigned long long bitmaps[64];
+			size_t count = compact_type::encode(mask, bitmaps, str, len);
+			compact_type compact(mask, bitmaps);
+			ASSERT_EQ(count, compact.size());
+			ASSERT_LE(count, len);
+			for (char ch = 0; ch < 64; ch++)
+				ASSERT_EQ(dense[ch], compact[ch]);
+			dense_type expanded;
+			compact.expand(expanded);
+			for (char ch = 0; ch < 64; ch++)
+				ASSERT_EQ(dense[ch], expanded[ch]);
+		}
+	}
+}
+
+TEST(DigestCompactStoreTests, CompareMatchesDigestComparison)
+{
+	vector<string> corpus = DigestCorpus::generate(400, 4);
+	vector<digest<true, false, true>> digests;
+	vector<digest<false, false, true>> digests_non_ra;
+	digest_compact_store store;
+	for (size_t i = 0; i < corpus.size(); i++)
+	{
+		digests.push_back(digest<true, false, true>(corpus[i]));
+		digests_non_ra.push_back(digest<false, false, true>(corpus[i]));
+		// both representations are stored in the 6-bit form
+		if (i % 2)
+			EXPECT_EQ(i, store.push_back(digests.back()));
+		else
+			EXPECT_EQ(i, store.push_back(digests_non_ra.back()));
+	}
+	for (size_t q = 0; q < digests.size(); q += 5)
+	{
+		for (size_t i = 0; i < digests.size(); i++)
+		{
+			ASSERT_EQ(
+				digest_comparison<comparison_version::v2_13>::compare(digests[i], digests[q]),
+				store.compare<comparison_version::v2_13>(i, digests[q]))
+				<< "compare test failed on <" << corpus[i] << "> and <" << corpus[q] << ">.";
+			ASSERT_EQ(
+				digest_comparison<comparison_version::v2_9>::compare(digests[i], digests[q]),
+				store.compare<comparison_version::v2_9>(i, digests[q]))
+				<< "compare test failed on <" << corpus[i] << "> and <" << corpus[q] << ">.";
+			ASSERT_EQ(
+				digest_comparison<>::compare(digests_non_ra[i], digests_non_ra[q]),
+				store.compare(i, digests_non_ra[q]))
+				<< "compare (non-RA) test failed on <" << corpus[i] << "> and <" << corpus[q] << ">.";
+		}
+	}
+}
+
+#ifndef FFUZZYPP_DISABLE_POSITION_ARRAY
+TEST(DigestCompactStoreTests, MemoryUsage)
+{
+	vector<string> corpus = DigestCorpus::generate(1000, 5);
+	digest_compact_store store;
+	for (const auto& str : corpus)
+		store.push_back(str);
+	EXPECT_EQ(corpus.size(), store.size());
+	// much smaller than position arrays (about one tenth of non-RA variant)
+	EXPECT_GT(sizeof(digest_position_array<false>) * store.size() / 8, store.memory_usage());
+	EXPECT_GT(sizeof(digest_position_array<true>) * store.size(), store.memory_usage());
+}
+#endif
+
+TEST(DigestCompactStoreTests, RemappingFailure)
+{
+	digest_compact_store store;
+	digest<false, false, true> d("3:ABC.DEFGH:IJK");
+	EXPECT_THROW(store.push_back(d), digest_parse_error);
+	EXPECT_TRUE(store.empty());
+}
+
+#endif
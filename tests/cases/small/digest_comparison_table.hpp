@@ -0,0 +1,113 @@
+/*
+
+	ffuzzy++ : C++ implementation of fast fuzzy hasing
+
+	tests/cases/small/digest_comparison_table.hpp
+	Precomputed score table tests
+
+	Copyright (C) 2026 Tsukasa OI <floss_ssdeep@irq.a4lg.com>
+
+
+	Permission to use, copy, modify, and/or distribute this software for
+	any purpose with or without fee is hereby granted, provided that the
+	above copyright notice and this permission notice appear in all copies.
+
+	THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+	WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+	MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+	ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+	WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+	ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+	OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+
+*/
+#ifndef FFUZZYPP_TESTCASES_SMALL_DIGEST_COMPARISON_TABLE_HPP
+#define FFUZZYPP_TESTCASES_SMALL_DIGEST_COMPARISON_TABLE_HPP
+
+#include <cstddef>
+
+
+template <comparison_version Version>
+struct DigestComparisonTableTestParam
+{
+	static constexpr const comparison_version version = Version;
+};
+
+template <typename T>
+class DigestComparisonTableTests : public ::testing::Test {};
+
+typedef ::testing::Types<
+	DigestComparisonTableTestParam<comparison_version::v2_13>,
+	DigestComparisonTableTestParam<comparison_version::v2_9>
+> DigestComparisonTableTypes;
+TYPED_TEST_CASE(DigestComparisonTableTests, DigestComparisonTableTypes);
+
+TYPED_TEST(DigestComparisonTableTests, MatchesArithmeticByIndex)
+{
+	static constexpr const comparison_version version = TypeParam::version;
+	typedef blockhash_score_table<version> table;
+	static constexpr const blockhash_len_t min_len = blockhash_comparison_params::min_match_len;
+	for (unsigned idx = 0; idx < digest_blocksize::number_of_blockhashes; idx++)
+	{
+		digest_blocksize_t bs = digest_blocksize::at(idx);
+		for (blockhash_len_t l1 = min_len; l1 <= digest_params::max_blockhash_len; l1++)
+		{
+			for (blockhash_len_t l2 = min_len; l2 <= digest_params::max_blockhash_len; l2++)
+			{
+				ASSERT_EQ(
+					blockhash_comparison<version>::is_safe_for_score_capping(bs)
+						? std::min(digest_comparison_score_t(100), blockhash_comparison<version>::score_cap(bs, l1, l2))
+						: 100u,
+					table::score_cap_by_index(idx, l1, l2))
+					<< "score_cap_by_index test failed at (" << bs << ", " << l1 << ", " << l2 << ").";
+				for (digest_comparison_score_t d = 0; d <= digest_comparison_score_t(l1 + l2); d++)
+				{
+					digest_comparison_score_t expected = blockhash_comparison<version>::score(d, bs, l1, l2);
+					ASSERT_EQ(expected, table::score_by_index(d, idx, l1, l2))
+						<< "score_by_index test failed at (" << d << ", " << bs << ", " << l1 << ", " << l2 << ").";
+					ASSERT_EQ(expected, table::score(d, bs, l1, l2))
+						<< "score test failed at (" << d << ", " << bs << ", " << l1 << ", " << l2 << ").";
+				}
+			}
+		}
+		for (blockhash_len_t l = 0; l <= digest_params::max_blockhash_len; l++)
+		{
+			ASSERT_EQ(blockhash_comparison<version>::score_identical(l, bs), table::score_identical(l, bs))
+				<< "score_identical test failed at (" << bs << ", " << l << ").";
+		}
+	}
+}
+
+TYPED_TEST(DigestComparisonTableTests, MatchesArithmeticNonNatural)
+{
+	static constexpr const comparison_version version = TypeParam::version;
+	typedef blockhash_score_table<version> table;
+	static constexpr const blockhash_len_t min_len = blockhash_comparison_params::min_match_len;
+	for (digest_blocksize_t bs : {0u, 1u, 2u, 4u, 5u, 7u, 10u, 11u, 29u, 32u, 33u, 35u, 44u, 45u, 1000u, 0xffffffffu})
+	{
+		for (blockhash_len_t l1 = min_len; l1 <= digest_params::max_blockhash_len; l1++)
+		{
+			for (blockhash_len_t l2 = min_len; l2 <= digest_params::max_blockhash_len; l2++)
+			{
+				for (digest_comparison_score_t d = 0; d <= digest_comparison_score_t(l1 + l2); d++)
+				{
+					ASSERT_EQ(blockhash_comparison<version>::score(d, bs, l1, l2), table::score(d, bs, l1, l2))
+						<< "score test failed at (" << d << ", " << bs << ", " << l1 << ", " << l2 << ").";
+				}
+			}
+		}
+	}
+}
+
+TEST(DigestComparisonTableUsageTests, ShortBlockHashesAreNotCapped)
+{
+	// Too short to match (cap is zero on any block size)
+	for (blockhash_len_t l = 0; l < blockhash_comparison_params::min_match_len; l++)
+	{
+		EXPECT_EQ(0u, blockhash_score_table<>::score_cap_by_index(0, l, digest_params::max_blockhash_len));
+		EXPECT_EQ(0u, blockhash_score_table<>::score_cap(3u << 20, digest_params::max_blockhash_len, l));
+	}
+	EXPECT_EQ(100u, blockhash_score_table<>::score_cap_by_index(20, 7, 7));
+}
+
+#endif
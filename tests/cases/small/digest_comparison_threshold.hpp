@@ -0,0 +1,156 @@
+/*
+
+	ffuzzy++ : C++ implementation of fast fuzzy hasing
+
+	tests/cases/small/digest_comparison_threshold.hpp
+	Threshold-aware comparison tests
+
+	Copyright (C) 2026 Tsukasa OI <floss_ssdeep@irq.a4lg.com>
+
+
+	Permission to use, copy, modify, and/or distribute this software for
+	any purpose with or without fee is hereby granted, provided that the
+	above copyright notice and this permission notice appear in all copies.
+
+	THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+	WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+	MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+	ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+	WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+	ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+	OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+
+*/
+#ifndef FFUZZYPP_TESTCASES_SMALL_DIGEST_COMPARISON_THRESHOLD_HPP
+#define FFUZZYPP_TESTCASES_SMALL_DIGEST_COMPARISON_THRESHOLD_HPP
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "../common/digest_corpus.hpp"
+
+
+TEST(DigestComparisonThresholdTests, MaxEditDistanceForUncappedScore)
+{
+	for (blockhash_len_t l1 = blockhash_comparison_params::min_match_len; l1 <= digest_params::max_blockhash_len; l1++)
+	{
+		for (blockhash_len_t l2 = blockhash_comparison_params::min_match_len; l2 <= digest_params::max_blockhash_len; l2++)
+		{
+			for (digest_comparison_score_t min_score = 0; min_score <= 100; min_score++)
+			{
+				// Brute force: maximum edit distance with uncapped score of min_score or more
+				digest_comparison_score_t expected = 0;
+				for (digest_comparison_score_t d = 0; d <= digest_comparison_score_t(l1 + l2); d++)
+				{
+					if (blockhash_comparison<>::uncapped_score(d, l1, l2) >= min_score)
+						expected = d;
+				}
+				ASSERT_EQ(expected, blockhash_comparison<>::max_edit_distance_for_uncapped_score(min_score, l1, l2))
+					<< "max_edit_distance_for_uncapped_score test failed on lengths "
+					<< unsigned(l1) << " and " << unsigned(l2) << " (min_score=" << min_score << ").";
+			}
+		}
+	}
+}
+
+
+template <bool IsAlphabetRestricted, comparison_version Version>
+struct DigestComparisonThresholdTestParam
+{
+	static constexpr const bool is_alphabet_restricted = IsAlphabetRestricted;
+	static constexpr const comparison_version version = Version;
+};
+
+template <typename T>
+class DigestComparisonThresholdTypedTests : public ::testing::Test {};
+
+typedef ::testing::Types<
+	DigestComparisonThresholdTestParam<true,  comparison_version::v2_13>,
+	DigestComparisonThresholdTestParam<true,  comparison_version::v2_9>,
+	DigestComparisonThresholdTestParam<false, comparison_version::v2_13>,
+	DigestComparisonThresholdTestParam<false, comparison_version::v2_9>
+> DigestComparisonThresholdTypes;
+TYPED_TEST_CASE(DigestComparisonThresholdTypedTests, DigestComparisonThresholdTypes);
+
+TYPED_TEST(DigestComparisonThresholdTypedTests, MatchesCompare)
+{
+	static constexpr const bool ra = TypeParam::is_alphabet_restricted;
+	static constexpr const comparison_version version = TypeParam::version;
+	vector<string> corpus = DigestCorpus::generate(300, 3);
+	vector<digest<ra, false, true>> digests;
+	for (const auto& str : corpus)
+		digests.push_back(digest<ra, false, true>(str));
+	size_t nonzero = 0;
+	for (size_t i = 0; i < digests.size(); i++)
+	{
+		for (size_t j = 0; j < digests.size(); j++)
+		{
+			digest_comparison_score_t score = digest_comparison<version>::compare(digests[i], digests[j]);
+			if (score)
+				nonzero++;
+			for (digest_comparison_score_t min_score : {0u, 1u, 25u, 50u, 75u, 90u, 100u, 101u})
+			{
+				digest_comparison_score_t expected = score < min_score ? 0 : score;
+				ASSERT_EQ(expected, digest_comparison<version>::compare_threshold(digests[i], digests[j], min_score))
+					<< "compare_threshold test failed on <" << corpus[i] << "> and <" << corpus[j]
+					<< "> (min_score=" << min_score << ").";
+			}
+		}
+	}
+	EXPECT_LT(100u, nonzero);
+}
+
+#ifndef FFUZZYPP_DISABLE_POSITION_ARRAY
+TYPED_TEST(DigestComparisonThresholdTypedTests, MatchesCompareWithPositionArray)
+{
+	static constexpr const bool ra = TypeParam::is_alphabet_restricted;
+	static constexpr const comparison_version version = TypeParam::version;
+	vector<string> corpus = DigestCorpus::generate(200, 4);
+	vector<digest<ra, false, true>> digests;
+	for (const auto& str : corpus)
+		digests.push_back(digest<ra, false, true>(str));
+	for (size_t i = 0; i < digests.size(); i++)
+	{
+		digest_position_array<ra> pa(digests[i]);
+		for (size_t j = 0; j < digests.size(); j++)
+		{
+			digest_comparison_score_t score = digest_comparison<version>::compare(digests[i], digests[j]);
+			for (digest_comparison_score_t min_score : {0u, 1u, 40u, 80u, 100u})
+			{
+				digest_comparison_score_t expected = score < min_score ? 0 : score;
+				ASSERT_EQ(expected, pa.template compare_threshold<version>(digests[j], min_score))
+					<< "compare_threshold (position array) test failed on <" << corpus[i] << "> and <" << corpus[j]
+					<< "> (min_score=" << min_score << ").";
+			}
+		}
+	}
+}
+#endif
+
+TYPED_TEST(DigestComparisonThresholdTypedTests, IdenticalEmptyBlockhashes)
+{
+	static constexpr const bool ra = TypeParam::is_alphabet_restricted;
+	static constexpr const comparison_version version = TypeParam::version;
+	// Identical scores of empty block hashes must not divide by zero (v2_9)
+	for (const char* str : { "3::", "3:ABCDEFGHIJ:", "3::ABCDEFGHIJ" })
+	{
+		digest<ra, false, true> d(str);
+		digest_comparison_score_t score = digest_comparison<version>::compare(d, d);
+		#ifndef FFUZZYPP_DISABLE_POSITION_ARRAY
+		digest_position_array<ra> pa(d);
+		#endif
+		for (digest_comparison_score_t min_score : {0u, 1u, 100u})
+		{
+			digest_comparison_score_t expected = score < min_score ? 0 : score;
+			EXPECT_EQ(expected, digest_comparison<version>::compare_threshold(d, d, min_score))
+				<< "compare_threshold test failed on <" << str << "> (min_score=" << min_score << ").";
+			#ifndef FFUZZYPP_DISABLE_POSITION_ARRAY
+			EXPECT_EQ(expected, pa.template compare_threshold<version>(d, min_score))
+				<< "compare_threshold (position array) test failed on <" << str << "> (min_score=" << min_score << ").";
+			#endif
+		}
+	}
+}
+
+#endif
@@ -0,0 +1,125 @@
+/*
+
+	ffuzzy++ : C++ implementation of fast fuzzy hasing
+
+	tests/cases/small/digest_concurrent_index.hpp
+	Append-only index (with concurrent readers) tests
+
+	Copyright (C) 2026 Tsukasa OI <floss_ssdeep@irq.a4lg.com>
+
+
+	Permission to use, copy, modify, and/or distribute this software for
+	any purpose with or without fee is hereby granted, provided that the
+	above copyright notice and this permission notice appear in all copies.
+
+	THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+	WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+	MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+	ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+	WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+	ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+	OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+
+*/
+#ifndef FFUZZYPP_TESTCASES_SMALL_DIGEST_CONCURRENT_INDEX_HPP
+#define FFUZZYPP_TESTCASES_SMALL_DIGEST_CONCURRENT_INDEX_HPP
+
+#include <cstddef>
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../common/digest_corpus.hpp"
+
+
+TEST(DigestConcurrentIndexTests, MatchesBruteForce)
+{
+	vector<string> corpus = DigestCorpus::generate(600, 11);
+	corpus.push_back("3:ABC:DE");
+	corpus.push_back("3:ABC:DE");
+	corpus.push_back("5:ABCDEFGHIJ:KLMNOPQ"); // non-natural block sizes
+	corpus.push_back("10:KLMNOPQ:");
+	vector<digest_ra_long_t> digests;
+	digest_concurrent_index_t index;
+	for (const auto& str : corpus)
+	{
+		digests.push_back(digest_ra_long_t(str));
+		ASSERT_EQ(digests.size() - 1, index.push_back(digests.back()));
+	}
+	ASSERT_EQ(digests.size(), index.size());
+	for (size_t q = 0; q < digests.size(); q += 3)
+	{
+		vector<digest_search_result> expected;
+		for (size_t i = 0; i < digests.size(); i++)
+		{
+			digest_comparison_score_t score = digest_comparison<>::compare(digests[q], digests[i]);
+			if (score)
+				expected.push_back(digest_search_result{ i, score });
+		}
+		stable_sort(expected.begin(), expected.end(),
+			[](const digest_search_result& a, const digest_search_result& b) { return a.score > b.score; });
+		vector<digest_search_result> results;
+		ASSERT_EQ(digests.size(), index.search(digests[q], results));
+		ASSERT_EQ(expected.size(), results.size())
+			<< "search test failed on <" << corpus[q] << ">.";
+		for (size_t n = 0; n < expected.size(); n++)
+		{
+			ASSERT_EQ(expected[n].index, results[n].index)
+				<< "search test failed on <" << corpus[q] << ">.";
+			ASSERT_EQ(expected[n].score, results[n].score)
+				<< "search test failed on <" << corpus[q] << ">.";
+		}
+	}
+}
+
+TEST(DigestConcurrentIndexTests, ReadersSeeConsistentSnapshots)
+{
+	vector<string> corpus = DigestCorpus::generate(1500, 12);
+	vector<digest_ra_long_t> digests;
+	for (const auto& str : corpus)
+		digests.push_back(digest_ra_long_t(str));
+	static const size_t queries = 40;
+	// Expected results against the whole corpus (by query)
+	vector<vector<digest_search_result>> all(queries);
+	for (size_t q = 0; q < queries; q++)
+		for (size_t i = 0; i < digests.size(); i++)
+			if (digest_comparison_score_t score = digest_comparison<>::compare(digests[q * 37], digests[i]))
+				all[q].push_back(digest_search_result{ i, score });
+	digest_concurrent_index_t index;
+	std::atomic<bool> done(false);
+	std::atomic<size_t> failures(0), searches(0);
+	auto reader = [&](size_t offset) {
+		vector<digest_search_result> results;
+		for (size_t n = offset; !done.load() || n < offset + queries; n++)
+		{
+			size_t q = n % queries;
+			size_t limit = index.search(digests[q * 37], results);
+			// Results must be the same as searching the first limit digests
+			vector<digest_search_result> expected;
+			for (const auto& r : all[q])
+				if (r.index < limit)
+					expected.push_back(r);
+			std::sort(results.begin(), results.end(),
+				[](const digest_search_result& a, const digest_search_result& b) { return a.index < b.index; });
+			bool ok = expected.size() == results.size();
+			for (size_t k = 0; ok && k < expected.size(); k++)
+				ok = expected[k].index == results[k].index && expected[k].score == results[k].score;
+			if (!ok)
+				failures++;
+			searches++;
+		}
+	};
+	std::thread r1(reader, 0), r2(reader, 7);
+	for (const auto& d : digests)
+		index.push_back(d);
+	done.store(true);
+	r1.join();
+	r2.join();
+	EXPECT_EQ(digests.size(), index.size());
+	EXPECT_EQ(0u, failures.load());
+	EXPECT_LE(2 * queries, searches.load());
+}
+
+#endif
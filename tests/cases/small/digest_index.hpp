@@ -0,0 +1,130 @@
+/*
+
+	ffuzzy++ : C++ implementation of fast fuzzy hasing
+
+	tests/cases/small/digest_index.hpp
+	Inverted index tests
+
+	Copyright (C) 2026 Tsukasa OI <floss_ssdeep@irq.a4lg.com>
+
+
+	Permission to use, copy, modify, and/or distribute this software for
+	any purpose with or without fee is hereby granted, provided that the
+	above copyright notice and this permission notice appear in all copies.
+
+	THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+	WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+	MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+	ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+	WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+	ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+	OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+
+*/
+#ifndef FFUZZYPP_TESTCASES_SMALL_DIGEST_INDEX_HPP
+#define FFUZZYPP_TESTCASES_SMALL_DIGEST_INDEX_HPP
+
+#include <cstddef>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "../common/digest_corpus.hpp"
+
+
+template <bool IsAlphabetRestricted, comparison_version Version>
+struct DigestIndexTestParam
+{
+	static constexpr const bool is_alphabet_restricted = IsAlphabetRestricted;
+	static constexpr const comparison_version version = Version;
+};
+
+template <typename T>
+class DigestIndexTests : public ::testing::Test {};
+
+typedef ::testing::Types<
+	DigestIndexTestParam<true,  comparison_version::v2_13>,
+	DigestIndexTestParam<true,  comparison_version::v2_9>,
+	DigestIndexTestParam<false, comparison_version::v2_13>,
+	DigestIndexTestParam<false, comparison_version::v2_9>
+> DigestIndexTypes;
+TYPED_TEST_CASE(DigestIndexTests, DigestIndexTypes);
+
+TYPED_TEST(DigestIndexTests, SearchMatchesBruteForce)
+{
+	static constexpr const bool ra = TypeParam::is_alphabet_restricted;
+	static constexpr const comparison_version version = TypeParam::version;
+	vector<string> corpus = DigestCorpus::generate(800, 6);
+	// Identical digests with short block hashes
+	corpus.push_back("3:ABC:DE");
+	corpus.push_back("3:ABC:DE");
+	corpus.push_back("6:ABC:");
+	vector<digest<ra, false, true>> digests;
+	digest_index<ra, version> index;
+	for (const auto& str : corpus)
+	{
+		digests.push_back(digest<ra, false, true>(str));
+		ASSERT_EQ(digests.size() - 1, index.push_back(digests.back()));
+	}
+	ASSERT_EQ(digests.size(), index.size());
+	size_t total_candidates = 0;
+	for (size_t q = 0; q < digests.size(); q += 3)
+	{
+		// Brute force (sorted by score [descending] and index [ascending])
+		vector<digest_search_result> expected;
+		for (size_t i = 0; i < digests.size(); i++)
+		{
+			digest_comparison_score_t score = digest_comparison<version>::compare(digests[q], digests[i]);
+			if (score)
+				expected.push_back(digest_search_result{ i, score });
+		}
+		stable_sort(expected.begin(), expected.end(),
+			[](const digest_search_result& a, const digest_search_result& b) { return a.score > b.score; });
+		vector<digest_search_result> results = index.search(digests[q]);
+		ASSERT_EQ(expected.size(), results.size())
+			<< "search test failed on <" << corpus[q] << ">.";
+		for (size_t n = 0; n < expected.size(); n++)
+		{
+			ASSERT_EQ(expected[n].index, results[n].index)
+				<< "search test failed on <" << corpus[q] << ">.";
+			ASSERT_EQ(expected[n].score, results[n].score)
+				<< "search test failed on <" << corpus[q] << ">.";
+		}
+		total_candidates += index.candidates(digests[q]).size();
+	}
+	// Candidates must be far fewer than the corpus
+	EXPECT_GT(digests.size() * digests.size() / 3 / 10, total_candidates);
+}
+
+TEST(DigestIndexUsageTests, ShortBlockhashesAndTopK)
+{
+	digest_index_t index;
+	EXPECT_EQ(0u, index.push_back("3:ABC:DE"));
+	EXPECT_EQ(1u, index.push_back("3:ABCDEFGHIJ:KLMNOPQ"));
+	EXPECT_EQ(2u, index.push_back("3:ABC:DE"));
+	EXPECT_EQ(3u, index.push_back("6:KLMNOPQ:RSTUVWX"));
+	EXPECT_EQ(4u, index.push_back("3:ABC:DF"));
+	// Identical digests with short block hashes
+	vector<digest_search_result> results = index.search(digest_ra_t("3:ABC:DE"));
+	ASSERT_EQ(2u, results.size());
+	EXPECT_EQ(0u, results[0].index);
+	EXPECT_EQ(100u, results[0].score);
+	EXPECT_EQ(2u, results[1].index);
+	EXPECT_EQ(100u, results[1].score);
+	// Match at the doubled block size
+	results = index.search_top_k(digest_ra_t("3:ABCDEFGHIJ:KLMNOPQ"), 1);
+	ASSERT_EQ(1u, results.size());
+	EXPECT_EQ(1u, results[0].index);
+	EXPECT_EQ(100u, results[0].score);
+	results = index.search(digest_ra_t("3:ABCDEFGHIJ:KLMNOPQ"));
+	ASSERT_EQ(2u, results.size());
+	EXPECT_EQ(3u, results[1].index);
+	EXPECT_EQ(
+		digest_comparison<>::compare(digest_ra_t("3:ABCDEFGHIJ:KLMNOPQ"), digest_ra_t("6:KLMNOPQ:RSTUVWX")),
+		results[1].score);
+	EXPECT_TRUE(index.search(digest_ra_t("3:ABC:DD")).empty());
+	// (index 1) 4 substrings at 3, 1 at 6; (index 3) 1 at 6, 1 at 12
+	EXPECT_EQ(7u, index.posting_count());
+}
+
+#endif
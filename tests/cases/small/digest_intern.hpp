@@ -0,0 +1,117 @@
+/*
+
+	ffuzzy++ : C++ implementation of fast fuzzy hasing
+
+	tests/cases/small/digest_intern.hpp
+	Digest interning table tests
+
+	Copyright (C) 2026 Tsukasa OI <floss_ssdeep@irq.a4lg.com>
+
+
+	Permission to use, copy, modify, and/or distribute this software for
+	any purpose with or without fee is hereby granted, provided that the
+	above copyright notice and this permission notice appear in all copies.
+
+	THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+	WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+	MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+	ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+	WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+	ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+	OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+
+*/
+#ifndef FFUZZYPP_TESTCASES_SMALL_DIGEST_INTERN_HPP
+#define FFUZZYPP_TESTCASES_SMALL_DIGEST_INTERN_HPP
+
+#include <cstddef>
+#include <algorithm>
+#include <random>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "../common/digest_corpus.hpp"
+
+
+TEST(DigestInternTests, CanonicalIds)
+{
+	vector<string> corpus = DigestCorpus::generate(500, 7);
+	// duplicate some of the digests
+	std::mt19937 rng(7);
+	for (size_t n = 0; n < 300; n++)
+		corpus.push_back(corpus[rng() % corpus.size()]);
+	std::shuffle(corpus.begin(), corpus.end(), rng);
+	digest_intern_table<true> table;
+	vector<digest<true, false, true>> digests;
+	for (size_t n = 0; n < corpus.size(); n++)
+	{
+		digests.push_back(digest<true, false, true>(corpus[n]));
+		size_t id = table.insert(corpus[n]);
+		EXPECT_EQ(id, table.canonical_id(n));
+	}
+	ASSERT_EQ(corpus.size(), table.total());
+	ASSERT_LT(table.size(), table.total());
+	size_t sum = 0;
+	for (size_t id = 0; id < table.size(); id++)
+	{
+		size_t members = 0;
+		table.for_each_member(id, [&](size_t n)
+		{
+			EXPECT_EQ(id, table.canonical_id(n));
+			EXPECT_EQ(table.get(id), digests[n]);
+			members++;
+		});
+		EXPECT_EQ(table.multiplicity(id), members);
+		sum += members;
+	}
+	EXPECT_EQ(table.total(), sum);
+	for (size_t n = 0; n < digests.size(); n++)
+	{
+		EXPECT_EQ(table.canonical_id(n), table.find(digests[n]));
+		for (size_t m = 0; m < n; m++)
+			ASSERT_EQ(digests[n] == digests[m], table.canonical_id(n) == table.canonical_id(m));
+	}
+	EXPECT_EQ(table.npos, table.find(digest<true, false, true>("3:NOTINCORPUS:")));
+}
+
+TEST(DigestInternTests, AllPairsMatchesBruteForce)
+{
+	typedef std::tuple<size_t, size_t, digest_comparison_score_t> result_type;
+	vector<string> corpus = DigestCorpus::generate(400, 8);
+	std::mt19937 rng(8);
+	for (size_t n = 0; n < 200; n++)
+		corpus.push_back(corpus[rng() % corpus.size()]);
+	std::shuffle(corpus.begin(), corpus.end(), rng);
+	digest_intern_table<false> table;
+	vector<digest<false, false, true>> digests;
+	for (const auto& str : corpus)
+	{
+		digests.push_back(digest<false, false, true>(str));
+		table.insert(digests.back());
+	}
+	for (digest_comparison_score_t min_score : {1u, 60u})
+	{
+		vector<result_type> expected;
+		for (size_t n = 0; n < digests.size(); n++)
+		{
+			for (size_t m = n + 1; m < digests.size(); m++)
+			{
+				digest_comparison_score_t score =
+					digest_comparison<comparison_version::v2_9>::compare(digests[n], digests[m]);
+				if (score && score >= min_score)
+					expected.push_back(result_type(n, m, score));
+			}
+		}
+		vector<result_type> results;
+		table.all_pairs<comparison_version::v2_9>(min_score,
+			[&results](size_t n, size_t m, digest_comparison_score_t score)
+			{
+				results.push_back(result_type(n, m, score));
+			});
+		sort(results.begin(), results.end());
+		ASSERT_EQ(expected, results) << "all_pairs test failed (min_score=" << min_score << ").";
+	}
+}
+
+#endif
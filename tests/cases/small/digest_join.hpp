@@ -0,0 +1,163 @@
+/*
+
+	ffuzzy++ : C++ implementation of fast fuzzy hasing
+
+	tests/cases/small/digest_join.hpp
+	Set-versus-set similarity join tests
+
+	Copyright (C) 2026 Tsukasa OI <floss_ssdeep@irq.a4lg.com>
+
+
+	Permission to use, copy, modify, and/or distribute this software for
+	any purpose with or without fee is hereby granted, provided that the
+	above copyright notice and this permission notice appear in all copies.
+
+	THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+	WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+	MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+	ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+	WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+	ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+	OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+
+*/
+#ifndef FFUZZYPP_TESTCASES_SMALL_DIGEST_JOIN_HPP
+#define FFUZZYPP_TESTCASES_SMALL_DIGEST_JOIN_HPP
+
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "../common/digest_corpus.hpp"
+
+
+/*
+	Right-side source over a flat buffer (as a memory-mapped file would be):
+	each record consists of block hash 1 and block hash 2 and
+	is described by an entry of the record table.
+*/
+template <bool IsAlphabetRestricted>
+class DigestJoinFlatSource
+{
+private:
+	struct record
+	{
+		digest_blocksize_t blocksize;
+		size_t offset;
+		blockhash_len_t len1;
+		blockhash_len_t len2;
+	};
+	vector<char> buffer;
+	vector<record> records;
+public:
+	template <bool IsShort>
+	void push_back(const digest<IsAlphabetRestricted, IsShort, true>& d)
+	{
+		records.push_back(record{ digest_blocksize_t(d.blocksize()), buffer.size(),
+			d.blockhash1_len(), d.blockhash2_len() });
+		buffer.insert(buffer.end(), d.digest_buffer(),
+			d.digest_buffer() + d.blockhash1_len() + d.blockhash2_len());
+	}
+	size_t size(void) const { return records.size(); }
+	digest_view<IsAlphabetRestricted> view(size_t i) const
+	{
+		const record& r = records[i];
+		const char* p = buffer.data() + r.offset;
+		return digest_view<IsAlphabetRestricted>(r.blocksize, p, r.len1, p + r.len1, r.len2);
+	}
+};
+
+template <bool IsAlphabetRestricted, comparison_version Version>
+struct DigestJoinTestParam
+{
+	static constexpr const bool is_alphabet_restricted = IsAlphabetRestricted;
+	static constexpr const comparison_version version = Version;
+};
+
+template <typename T>
+class DigestJoinTests : public ::testing::Test {};
+
+typedef ::testing::Types<
+	DigestJoinTestParam<true,  comparison_version::v2_13>,
+	DigestJoinTestParam<true,  comparison_version::v2_9>,
+	DigestJoinTestParam<false, comparison_version::v2_13>
+> DigestJoinTypes;
+TYPED_TEST_CASE(DigestJoinTests, DigestJoinTypes);
+
+TYPED_TEST(DigestJoinTests, MatchesBruteForce)
+{
+	static constexpr const bool ra = TypeParam::is_alphabet_restricted;
+	static constexpr const comparison_version version = TypeParam::version;
+	// Split families between both sides
+	vector<string> corpus = DigestCorpus::generate(1000, 8);
+	vector<digest<ra, false, true>> ldigests, rdigests;
+	digest_store<ra> lstore;
+	DigestJoinFlatSource<ra> rsource;
+	for (size_t i = 0; i < corpus.size(); i++)
+	{
+		digest<ra, false, true> d(corpus[i]);
+		if (i % 3 == 0)
+		{
+			rdigests.push_back(d);
+			rsource.push_back(d);
+		}
+		else
+		{
+			ldigests.push_back(d);
+			lstore.push_back(d);
+		}
+	}
+	digest_join<ra, version> join(lstore);
+	for (digest_comparison_score_t min_score : {0u, 50u, 100u})
+	{
+		vector<digest_join_result> expected;
+		for (size_t i = 0; i < ldigests.size(); i++)
+		{
+			for (size_t j = 0; j < rdigests.size(); j++)
+			{
+				digest_comparison_score_t score = digest_comparison<version>::compare(ldigests[i], rdigests[j]);
+				if (score && score >= min_score)
+					expected.push_back(digest_join_result{ i, j, score });
+			}
+		}
+		if (min_score == 0)
+		{
+			EXPECT_LT(50u, expected.size());
+		}
+		for (unsigned threads : {1u, 4u})
+		{
+			vector<digest_join_result> results = join.collect(rsource, min_score, threads);
+			ASSERT_EQ(expected.size(), results.size())
+				<< "min_score=" << min_score << ", threads=" << threads;
+			for (size_t k = 0; k < expected.size(); k++)
+			{
+				ASSERT_EQ(expected[k].left,  results[k].left);
+				ASSERT_EQ(expected[k].right, results[k].right);
+				ASSERT_EQ(expected[k].score, results[k].score);
+			}
+		}
+	}
+	// digest_store as the right side
+	EXPECT_EQ(join.collect(lstore, 1, 1).size(), join.collect(lstore, 1, 3).size());
+}
+
+TEST(DigestJoinUsageTests, CallbackException)
+{
+	digest_store_t lstore;
+	digest_store_t rstore;
+	for (const auto& str : DigestCorpus::generate(300, 9))
+	{
+		lstore.push_back(str);
+		rstore.push_back(str);
+	}
+	digest_join<true> join(lstore);
+	for (unsigned threads : {1u, 4u})
+	{
+		EXPECT_THROW(join.run(rstore, 1,
+			[](size_t, size_t, digest_comparison_score_t) { throw std::runtime_error("stop"); },
+			threads), std::runtime_error);
+	}
+}
+
+#endif
@@ -0,0 +1,127 @@
+/*
+
+	ffuzzy++ : C++ implementation of fast fuzzy hasing
+
+	tests/cases/small/digest_lsh_index.hpp
+	MinHash/LSH index tests
+
+	Copyright (C) 2026 Tsukasa OI <floss_ssdeep@irq.a4lg.com>
+
+
+	Permission to use, copy, modify, and/or distribute this software for
+	any purpose with or without fee is hereby granted, provided that the
+	above copyright notice and this permission notice appear in all copies.
+
+	THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+	WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+	MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+	ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+	WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+	ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+	OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+
+*/
+#ifndef FFUZZYPP_TESTCASES_SMALL_DIGEST_LSH_INDEX_HPP
+#define FFUZZYPP_TESTCASES_SMALL_DIGEST_LSH_INDEX_HPP
+
+#include <cstddef>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "../common/digest_corpus.hpp"
+
+
+TEST(DigestLSHIndexTests, SubsetOfExactIndex)
+{
+	vector<string> corpus = DigestCorpus::generate(800, 13);
+	corpus.push_back("3:ABC:DE");
+	corpus.push_back("3:ABC:DE");
+	vector<digest_ra_long_t> digests;
+	digest_index_t exact;
+	digest_lsh_index_t lsh;
+	for (const auto& str : corpus)
+	{
+		digests.push_back(digest_ra_long_t(str));
+		exact.push_back(digests.back());
+		ASSERT_EQ(exact.size() - 1, lsh.push_back(digests.back()));
+	}
+	// Each indexed block hash takes (at most) one entry per band.
+	EXPECT_GE(lsh.bands() * 2 * lsh.size(), lsh.posting_count());
+	EXPECT_LT(0u, lsh.posting_memory_usage());
+	size_t relevant = 0, found = 0;
+	for (size_t q = 0; q < digests.size(); q++)
+	{
+		vector<digest_search_result> expected = exact.search(digests[q]);
+		vector<digest_search_result> results = lsh.search(digests[q]);
+		// results are a subset of the exact results (in the same order)
+		size_t n = 0;
+		for (const auto& r : results)
+		{
+			while (n < expected.size() && expected[n].index != r.index)
+				n++;
+			ASSERT_LT(n, expected.size()) << "subset test failed on <" << corpus[q] << ">.";
+			ASSERT_EQ(expected[n].score, r.score) << "subset test failed on <" << corpus[q] << ">.";
+		}
+		// identical digests are always found
+		for (const auto& r : expected)
+		{
+			if (r.score < 50)
+				continue;
+			relevant++;
+			bool hit = false;
+			for (const auto& s : results)
+				hit |= s.index == r.index;
+			if (hit)
+				found++;
+			else
+				ASSERT_NE(digests[q], digests[r.index]) << "identical digest lost on <" << corpus[q] << ">.";
+		}
+	}
+	// close matches are mostly found with default parameters
+	EXPECT_LT(100u, relevant);
+	EXPECT_LE(relevant * 4, found * 5);
+	lsh.clear();
+	EXPECT_EQ(0u, lsh.posting_count());
+	EXPECT_EQ(0u, lsh.posting_memory_usage());
+}
+
+TEST(DigestLSHIndexTests, ExpectedRecall)
+{
+	digest_lsh_index_t single(1, 1);
+	EXPECT_DOUBLE_EQ(0.3, single.expected_recall(0.3));
+	EXPECT_DOUBLE_EQ(1.0, single.threshold());
+	digest_lsh_index_t narrow(4, 4), wide(32, 4);
+	EXPECT_EQ(4u, narrow.bands());
+	EXPECT_EQ(4u, narrow.rows());
+	EXPECT_DOUBLE_EQ(0.0, wide.expected_recall(0.0));
+	EXPECT_DOUBLE_EQ(1.0, wide.expected_recall(1.0));
+	EXPECT_LT(narrow.expected_recall(0.5), wide.expected_recall(0.5));
+	EXPECT_GT(narrow.threshold(), wide.threshold());
+	// the recall curve is monotonic and about half at the threshold
+	for (double s = 0.0; s < 1.0; s += 0.05)
+		EXPECT_LE(wide.expected_recall(s), wide.expected_recall(s + 0.05));
+	EXPECT_LT(wide.expected_recall(0.3), wide.expected_recall(0.4));
+	EXPECT_NEAR(0.5, wide.expected_recall(wide.threshold()), 0.2);
+}
+
+TEST(DigestLSHIndexTests, MoreBandsFindMore)
+{
+	vector<string> corpus = DigestCorpus::generate(500, 14);
+	digest_lsh_index_t narrow(2, 4), wide(48, 1);
+	for (const auto& str : corpus)
+	{
+		narrow.push_back(str);
+		wide.push_back(str);
+	}
+	size_t n_narrow = 0, n_wide = 0;
+	for (const auto& str : corpus)
+	{
+		digest_ra_long_t d(str);
+		n_narrow += narrow.candidates(d).size();
+		n_wide += wide.candidates(d).size();
+	}
+	EXPECT_LT(n_narrow, n_wide);
+}
+
+#endif
@@ -0,0 +1,275 @@
+/*
+
+	ffuzzy++ : C++ implementation of fast fuzzy hasing
+
+	tests/cases/small/digest_lsm_index.hpp
+	Log-structured index tests
+
+	Copyright (C) 2026 Tsukasa OI <floss_ssdeep@irq.a4lg.com>
+
+
+	Permission to use, copy, modify, and/or distribute this software for
+	any purpose with or without fee is hereby granted, provided that the
+	above copyright notice and this permission notice appear in all copies.
+
+	THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+	WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+	MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+	ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+	WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+	ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+	OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+
+*/
+#ifndef FFUZZYPP_TESTCASES_SMALL_DIGEST_LSM_INDEX_HPP
+#define FFUZZYPP_TESTCASES_SMALL_DIGEST_LSM_INDEX_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifndef FFUZZYPP_DISABLE_MAPPED_FILE
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "../common/digest_corpus.hpp"
+
+
+// Temporary directories need POSIX.
+#ifndef FFUZZYPP_DISABLE_MAPPED_FILE
+class DigestLSMIndexTests : public ::testing::Test
+{
+protected:
+	string dir;
+	vector<string> corpus;
+	vector<digest_ra_long_t> digests;
+	vector<bool> live;
+	virtual void SetUp(void)
+	{
+		char name[] = "/tmp/ffuzzypp-lsm-XXXXXX";
+		ASSERT_TRUE(mkdtemp(name) != nullptr);
+		dir = name;
+		corpus = DigestCorpus::generate(700, 11);
+		for (const auto& str : corpus)
+			digests.push_back(digest_ra_long_t(str));
+		live.assign(digests.size(), false);
+	}
+	virtual void TearDown(void)
+	{
+		if (DIR* d = opendir(dir.c_str()))
+		{
+			while (struct dirent* e = readdir(d))
+				if (e->d_name[0] != '.')
+					std::remove((dir + "/" + e->d_name).c_str());
+			closedir(d);
+		}
+		rmdir(dir.c_str());
+	}
+	// Compares search results with brute force over live digests
+	void check(const digest_lsm_index_t& index)
+	{
+		for (size_t q = 0; q < digests.size(); q += 7)
+		{
+			vector<digest_search_result> expected;
+			for (size_t i = 0; i < digests.size(); i++)
+			{
+				if (!live[i])
+					continue;
+				digest_comparison_score_t score = digest_comparison<>::compare(digests[q], digests[i]);
+				if (score)
+					expected.push_back(digest_search_result{ i, score });
+			}
+			stable_sort(expected.begin(), expected.end(),
+				[](const digest_search_result& a, const digest_search_result& b) { return a.score > b.score; });
+			vector<digest_search_result> results = index.search(digests[q]);
+			ASSERT_EQ(expected.size(), results.size()) << "search test failed on <" << corpus[q] << ">.";
+			for (size_t n = 0; n < expected.size(); n++)
+			{
+				ASSERT_EQ(expected[n].index, results[n].index) << "search test failed on <" << corpus[q] << ">.";
+				ASSERT_EQ(expected[n].score, results[n].score) << "search test failed on <" << corpus[q] << ">.";
+			}
+		}
+	}
+	void insert_all(digest_lsm_index_t& index)
+	{
+		for (size_t i = 0; i < digests.size(); i++)
+		{
+			ASSERT_EQ(uint64_t(i), index.push_back(digests[i]));
+			live[i] = true;
+			// delete some of them (in the memtable or in runs)
+			if (i % 5 == 4)
+			{
+				size_t victim = (i * 7) % (i + 1);
+				EXPECT_EQ(live[victim], index.erase(victim));
+				live[victim] = false;
+			}
+		}
+	}
+};
+
+TEST_F(DigestLSMIndexTests, MatchesBruteForce)
+{
+	digest_lsm_options options;
+	options.memtable_limit = 40;
+	options.memtable_segment_size = 8;
+	options.tier_fanout = 3;
+	digest_lsm_index_t index(dir, options);
+	insert_all(index);
+	check(index);
+	digest_lsm_stats stats = index.stats();
+	EXPECT_EQ(digests.size(), stats.inserted);
+	EXPECT_EQ(size_t(count(live.begin(), live.end(), false)), stats.erased);
+	EXPECT_EQ(digests.size() / 40, stats.flushes);
+	EXPECT_LT(0u, stats.compactions);
+	// size-tiered compaction leaves less than fanout runs per tier
+	EXPECT_GT(stats.flushes, stats.runs);
+	EXPECT_LT(1.0, stats.write_amplification());
+	EXPECT_EQ(stats.queries, (digests.size() + 6) / 7);
+	EXPECT_LE(stats.max_query_nanoseconds, stats.query_nanoseconds);
+	// unknown and deleted digests
+	EXPECT_FALSE(index.erase(digests.size()));
+	size_t dead = size_t(find(live.begin(), live.end(), false) - live.begin());
+	EXPECT_FALSE(index.erase(dead));
+	// full compaction drops all deleted digests in runs
+	index.compact();
+	EXPECT_EQ(1u, index.run_count());
+	check(index);
+	index.flush();
+	EXPECT_EQ(0u, index.stats().memtable_size);
+	check(index);
+}
+
+TEST_F(DigestLSMIndexTests, Reopen)
+{
+	digest_lsm_options options;
+	options.memtable_limit = 64;
+	{
+		digest_lsm_index_t index(dir, options);
+		insert_all(index);
+		index.flush();
+		check(index);
+	}
+	{
+		digest_lsm_index_t index(dir, options);
+		check(index);
+		// IDs continue from the last session
+		EXPECT_EQ(uint64_t(digests.size()), index.push_back("3:ABC:DEF"));
+		// tombstones survive (until compaction)
+		size_t dead = size_t(find(live.begin(), live.end(), false) - live.begin());
+		EXPECT_FALSE(index.erase(dead));
+		size_t alive = size_t(find(live.begin(), live.end(), true) - live.begin());
+		EXPECT_TRUE(index.erase(alive));
+		live[alive] = false;
+		index.flush();
+	}
+	{
+		digest_lsm_index_t index(dir, options);
+		live.push_back(true);
+		digests.push_back(digest_ra_long_t("3:ABC:DEF"));
+		corpus.push_back("3:ABC:DEF");
+		check(index);
+		index.compact();
+		check(index);
+	}
+	// unflushed digests are lost without a write-ahead log
+	{
+		digest_lsm_index_t index(dir, options);
+		index.push_back("3:ABC:DEF");
+	}
+	{
+		digest_lsm_index_t index(dir, options);
+		EXPECT_EQ(0u, index.stats().memtable_size);
+		check(index);
+	}
+}
+
+TEST_F(DigestLSMIndexTests, BackgroundCompaction)
+{
+	digest_lsm_options options;
+	options.memtable_limit = 32;
+	options.tier_fanout = 2;
+	options.background_compaction = true;
+	digest_lsm_index_t index(dir, options);
+	insert_all(index);
+	// searches may run concurrently with compaction
+	check(index);
+	index.wait_for_compaction();
+	check(index);
+	digest_lsm_stats stats = index.stats();
+	EXPECT_LT(0u, stats.compactions);
+	EXPECT_EQ(0u, stats.compaction_failures);
+	// with fanout 2, tiers hold at most one run each
+	EXPECT_GE(8u, stats.runs);
+}
+
+TEST_F(DigestLSMIndexTests, BackgroundCompactionFailure)
+{
+	digest_lsm_options options;
+	options.memtable_limit = 16;
+	options.tier_fanout = 2;
+	options.background_compaction = true;
+	digest_lsm_index_t index(dir, options);
+	// The first merge (sequence 2 after two flushes) cannot write its run.
+	string blocker = dir + "/run-2.snap";
+	ASSERT_EQ(0, mkdir(blocker.c_str(), 0700));
+	for (size_t i = 0; i < 32; i++)
+	{
+		index.push_back(digests[i]);
+		live[i] = true;
+	}
+	index.wait_for_compaction();
+	digest_lsm_stats stats = index.stats();
+	EXPECT_EQ(1u, stats.compaction_failures);
+	EXPECT_EQ(0u, stats.compactions);
+	EXPECT_EQ(2u, stats.runs);
+	check(index);
+	// retried on the next request
+	ASSERT_EQ(0, rmdir(blocker.c_str()));
+	for (size_t i = 32; i < 48; i++)
+	{
+		index.push_back(digests[i]);
+		live[i] = true;
+	}
+	index.wait_for_compaction();
+	stats = index.stats();
+	EXPECT_EQ(1u, stats.compaction_failures);
+	EXPECT_LT(0u, stats.compactions);
+	check(index);
+}
+
+TEST_F(DigestLSMIndexTests, SearchDuringFlush)
+{
+	digest_lsm_options options;
+	options.memtable_limit = 16;
+	options.memtable_segment_size = 3;
+	digest_lsm_index_t index(dir, options);
+	ASSERT_EQ(0u, index.push_back(digests[0]));
+	// Sealed and flushed digests must stay visible while their runs are written
+	std::atomic<bool> done(false);
+	std::atomic<size_t> failures(0);
+	std::thread reader([&] {
+		while (!done.load())
+		{
+			vector<digest_search_result> results = index.search(digests[0]);
+			if (results.empty() || results.front().index != 0 || results.front().score != 100)
+				failures++;
+		}
+	});
+	for (size_t i = 1; i < 200; i++)
+		index.push_back(digests[i]);
+	done.store(true);
+	reader.join();
+	EXPECT_EQ(0u, failures.load());
+	EXPECT_EQ(200u / 16, index.stats().flushes);
+}
+#endif
+
+#endif
@@ -0,0 +1,207 @@
+/*
+
+	ffuzzy++ : C++ implementation of fast fuzzy hasing
+
+	tests/cases/small/digest_parallel_all_pairs.hpp
+	Parallel all-pairs comparison tests
+
+	Copyright (C) 2026 Tsukasa OI <floss_ssdeep@irq.a4lg.com>
+
+
+	Permission to use, copy, modify, and/or distribute this software for
+	any purpose with or without fee is hereby granted, provided that the
+	above copyright notice and this permission notice appear in all copies.
+
+	THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+	WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+	MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+	ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+	WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+	ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+	OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+
+*/
+#ifndef FFUZZYPP_TESTCASES_SMALL_DIGEST_PARALLEL_ALL_PAIRS_HPP
+#define FFUZZYPP_TESTCASES_SMALL_DIGEST_PARALLEL_ALL_PAIRS_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "../common/digest_corpus.hpp"
+
+
+TEST(DigestParallelAllPairsTests, MatchesSequential)
+{
+	typedef std::tuple<size_t, size_t, digest_comparison_score_t> result_type;
+	vector<string> corpus = DigestCorpus::generate(900, 6);
+	digest_store_t store;
+	for (const auto& str : corpus)
+		store.push_back(str);
+	for (digest_comparison_score_t min_score : {0u, 50u})
+	{
+		vector<result_type> expected;
+		digest_all_pairs<true>(store).run(min_score,
+			[&expected](size_t i, size_t j, digest_comparison_score_t score)
+			{
+				expected.push_back(result_type(i, j, score));
+			});
+		sort(expected.begin(), expected.end());
+		for (unsigned threads : {1u, 3u, 8u})
+		{
+			digest_parallel_all_pairs_options options;
+			options.threads = threads;
+			options.tile_queries = 7;
+			options.tile_candidates = 50;
+			options.edge_buffer_size = 5;
+			digest_parallel_all_pairs<true> all_pairs(store, options);
+			vector<digest_all_pairs_edge> edges = all_pairs.collect(min_score);
+			ASSERT_EQ(expected.size(), edges.size()) << "threads=" << threads << ", min_score=" << min_score;
+			for (size_t n = 0; n < expected.size(); n++)
+				ASSERT_EQ(expected[n], result_type(edges[n].i, edges[n].j, edges[n].score))
+					<< "threads=" << threads << ", min_score=" << min_score;
+			// statistics
+			ASSERT_EQ(all_pairs.tiles().size(), all_pairs.tile_stats().size());
+			ASSERT_EQ(threads, all_pairs.worker_stats().size());
+			uint_least64_t tile_edges = 0, worker_tiles = 0;
+			for (const auto& s : all_pairs.tile_stats())
+			{
+				ASSERT_LT(s.worker, threads);
+				tile_edges += s.edges;
+			}
+			for (const auto& s : all_pairs.worker_stats())
+				worker_tiles += s.tiles;
+			EXPECT_EQ(edges.size(), tile_edges);
+			EXPECT_EQ(all_pairs.tiles().size(), worker_tiles);
+		}
+	}
+}
+
+TEST(DigestParallelAllPairsTests, TilesAndProgress)
+{
+	vector<string> corpus = DigestCorpus::generate(700, 7);
+	// skewed: most digests in one bucket
+	for (size_t n = 0; n < 300; n++)
+		corpus.push_back("48:" + corpus[n].substr(corpus[n].find(':') + 1));
+	digest_store_t store;
+	for (const auto& str : corpus)
+		store.push_back(str);
+	digest_parallel_all_pairs_options options;
+	options.threads = 4;
+	options.tile_queries = 16;
+	options.tile_candidates = 64;
+	digest_parallel_all_pairs<true> all_pairs(store, options);
+	// tiles cover all pairs which can have nonzero scores
+	uint_least64_t expected_comparisons = 0;
+	const auto& buckets = all_pairs.all_pairs().bucket_list();
+	for (size_t b = 0; b < buckets.size(); b++)
+	{
+		uint_least64_t n = buckets[b].end - buckets[b].begin;
+		expected_comparisons += n * (n - 1) / 2;
+		size_t d = all_pairs.all_pairs().double_bucket_of(b);
+		if (d != buckets.size())
+			expected_comparisons += n * (buckets[d].end - buckets[d].begin);
+	}
+	EXPECT_EQ(expected_comparisons, all_pairs.comparison_count());
+	uint_least64_t tile_comparisons = 0;
+	for (const auto& t : all_pairs.tiles())
+	{
+		ASSERT_LE(t.qend - t.qbegin, options.tile_queries);
+		ASSERT_LE(t.cend - t.cbegin, options.tile_candidates);
+		ASSERT_LT(0u, t.comparisons);
+		tile_comparisons += t.comparisons;
+	}
+	EXPECT_EQ(expected_comparisons, tile_comparisons);
+	// progress reports are serialized and never go backwards
+	vector<digest_all_pairs_progress> reports;
+	size_t edge_count = 0;
+	all_pairs.run(1,
+		[&edge_count](size_t i, size_t j, digest_comparison_score_t)
+		{
+			ASSERT_LT(i, j);
+			edge_count++;
+		},
+		[&reports](const digest_all_pairs_progress& p)
+		{
+			reports.push_back(p);
+		});
+	ASSERT_FALSE(reports.empty());
+	for (size_t n = 1; n < reports.size(); n++)
+	{
+		EXPECT_LE(reports[n - 1].tiles_done, reports[n].tiles_done);
+		EXPECT_LE(reports[n - 1].comparisons_done, reports[n].comparisons_done);
+	}
+	const digest_all_pairs_progress& last = reports.back();
+	EXPECT_EQ(all_pairs.tiles().size(), last.tiles_done);
+	EXPECT_EQ(all_pairs.tiles().size(), last.tiles_total);
+	EXPECT_EQ(expected_comparisons, last.comparisons_done);
+	EXPECT_EQ(expected_comparisons, last.comparisons_total);
+	EXPECT_EQ(edge_count, last.edges);
+	EXPECT_EQ(1.0, last.fraction());
+	// make sure that the corpus is meaningful
+	EXPECT_LT(100u, edge_count);
+}
+
+TEST(DigestParallelAllPairsTests, ExceptionFromCallback)
+{
+	vector<string> corpus = DigestCorpus::generate(600, 8);
+	digest_store_t store;
+	for (const auto& str : corpus)
+		store.push_back(str);
+	digest_parallel_all_pairs_options options;
+	options.threads = 4;
+	options.tile_queries = 8;
+	options.tile_candidates = 32;
+	options.edge_buffer_size = 1;
+	digest_parallel_all_pairs<true> all_pairs(store, options);
+	size_t calls = 0;
+	EXPECT_THROW(
+		all_pairs.run(1, [&calls](size_t, size_t, digest_comparison_score_t)
+		{
+			if (++calls == 10)
+				throw std::runtime_error("stop");
+		}),
+		std::runtime_error);
+	EXPECT_EQ(10u, calls);
+}
+
+TEST(DigestParallelAllPairsTests, EdgeWriter)
+{
+	vector<string> corpus = DigestCorpus::generate(400, 9);
+	digest_store_t store;
+	for (const auto& str : corpus)
+		store.push_back(str);
+	digest_parallel_all_pairs<true> all_pairs(store);
+	vector<digest_all_pairs_edge> expected = all_pairs.collect(1);
+	FILE* fp = tmpfile();
+	ASSERT_TRUE(fp != nullptr);
+	digest_edge_writer writer(fp);
+	all_pairs.run(1, writer);
+	EXPECT_TRUE(writer.is_ok());
+	rewind(fp);
+	vector<digest_all_pairs_edge> edges;
+	unsigned long long i, j;
+	unsigned score;
+	while (fscanf(fp, "%llu,%llu,%u", &i, &j, &score) == 3)
+		edges.push_back(digest_all_pairs_edge{ size_t(i), size_t(j), digest_comparison_score_t(score) });
+	fclose(fp);
+	sort(edges.begin(), edges.end(),
+		[](const digest_all_pairs_edge& a, const digest_all_pairs_edge& b)
+		{
+			return a.i != b.i ? a.i < b.i : a.j < b.j;
+		});
+	ASSERT_EQ(expected.size(), edges.size());
+	for (size_t n = 0; n < expected.size(); n++)
+	{
+		EXPECT_EQ(expected[n].i, edges[n].i);
+		EXPECT_EQ(expected[n].j, edges[n].j);
+		EXPECT_EQ(expected[n].score, edges[n].score);
+	}
+}
+
+#endif
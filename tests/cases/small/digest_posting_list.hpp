@@ -0,0 +1,193 @@
+/*
+
+	ffuzzy++ : C++ implementation of fast fuzzy hasing
+
+	tests/cases/small/digest_posting_list.hpp
+	Compressed posting list tests
+
+	Copyright (C) 2026 Tsukasa OI <floss_ssdeep@irq.a4lg.com>
+
+
+	Permission to use, copy, modify, and/or distribute this software for
+	any purpose with or without fee is hereby granted, provided that the
+	above copyright notice and this permission notice appear in all copies.
+
+	THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+	WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+	MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+	ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+	WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+	ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+	OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+
+*/
+#ifndef FFUZZYPP_TESTCASES_SMALL_DIGEST_POSTING_LIST_HPP
+#define FFUZZYPP_TESTCASES_SMALL_DIGEST_POSTING_LIST_HPP
+
+#include <cstddef>
+#include <algorithm>
+#include <iterator>
+#include <limits>
+#include <map>
+#include <random>
+#include <utility>
+#include <vector>
+
+
+// Sorted indices with mixed (small and large) gaps
+static vector<size_t> DigestPostingListTests_Indices(mt19937& rng, size_t count)
+{
+	vector<size_t> out;
+	size_t x = rng() % 4;
+	for (size_t n = 0; n < count; n++)
+	{
+		out.push_back(x);
+		switch (rng() % 4)
+		{
+			case 0:  x += 1 + rng() % 0x10000u; break;
+			case 1:  x += 1 + rng() % 0x80u; break;
+			default: x += 1; break;
+		}
+	}
+	return out;
+}
+
+static void DigestPostingListTests_Check(const digest_posting_list& list, const vector<size_t>& expected)
+{
+	ASSERT_EQ(expected.empty(), list.empty());
+	ASSERT_EQ(expected.size(), list.size());
+	if (!expected.empty())
+	{
+		ASSERT_EQ(expected.back(), list.back());
+	}
+	vector<size_t> decoded;
+	list.decode_append(decoded);
+	ASSERT_EQ(expected, decoded);
+	vector<size_t> iterated(list.begin(), list.end());
+	ASSERT_EQ(expected, iterated);
+}
+
+TEST(DigestPostingListTests, RoundTrip)
+{
+	mt19937 rng(49);
+	for (size_t count : {0u, 1u, 2u, 3u, 5u, 8u, 40u, 1000u})
+	{
+		for (int rep = 0; rep < 20; rep++)
+		{
+			vector<size_t> indices = DigestPostingListTests_Indices(rng, count);
+			digest_posting_list list;
+			for (size_t n = 0; n < indices.size(); n++)
+			{
+				list.push_back(indices[n]);
+				ASSERT_EQ(n + 1, list.size());
+				ASSERT_EQ(indices[n], list.back());
+			}
+			DigestPostingListTests_Check(list, indices);
+			// short lists are kept inline
+			if (list.byte_size() <= digest_posting_list::max_inline_bytes)
+				EXPECT_EQ(0u, list.heap_usage());
+			else
+				EXPECT_LT(list.byte_size(), list.heap_usage());
+			// copy and move
+			digest_posting_list copied(list);
+			DigestPostingListTests_Check(copied, indices);
+			digest_posting_list moved(std::move(copied));
+			DigestPostingListTests_Check(moved, indices);
+			EXPECT_TRUE(copied.empty());
+			copied = moved;
+			DigestPostingListTests_Check(copied, indices);
+			list.clear();
+			DigestPostingListTests_Check(list, vector<size_t>());
+		}
+	}
+}
+
+TEST(DigestPostingListTests, Encoding)
+{
+	digest_posting_list list;
+	// 0-127: 1 byte, 128-16383: 2 bytes
+	list.push_back(0);
+	list.push_back(127);
+	list.push_back(128);
+	EXPECT_EQ(3u, list.byte_size());
+	list.push_back(128 + 16383);
+	EXPECT_EQ(5u, list.byte_size());
+	list.push_back(128 + 16383 + 16384);
+	EXPECT_EQ(8u, list.byte_size());
+	EXPECT_NE(0u, list.heap_usage());
+	// consecutive indices take a byte each
+	digest_posting_list consecutive;
+	for (size_t i = 0; i < 1000; i++)
+		consecutive.push_back(100000 + i);
+	EXPECT_EQ(3u + 999u, consecutive.byte_size());
+	// largest index
+	digest_posting_list large;
+	large.push_back(std::numeric_limits<size_t>::max() - 1);
+	large.push_back(std::numeric_limits<size_t>::max());
+	DigestPostingListTests_Check(large,
+		vector<size_t>{ std::numeric_limits<size_t>::max() - 1, std::numeric_limits<size_t>::max() });
+}
+
+TEST(DigestPostingListTests, SetOperations)
+{
+	mt19937 rng(50);
+	for (int rep = 0; rep < 200; rep++)
+	{
+		vector<size_t> a = DigestPostingListTests_Indices(rng, rng() % 50);
+		vector<size_t> b = DigestPostingListTests_Indices(rng, rng() % 50);
+		digest_posting_list la, lb;
+		for (size_t i : a)
+			la.push_back(i);
+		for (size_t i : b)
+			lb.push_back(i);
+		vector<size_t> expected, result;
+		set_intersection(a.begin(), a.end(), b.begin(), b.end(), back_inserter(expected));
+		digest_posting_list::intersect(la, lb, result);
+		ASSERT_EQ(expected, result);
+		expected.clear();
+		set_union(a.begin(), a.end(), b.begin(), b.end(), back_inserter(expected));
+		digest_posting_list::unite(la, lb, result);
+		ASSERT_EQ(expected, result);
+	}
+}
+
+TEST(DigestPostingTableTests, MatchesMap)
+{
+	mt19937 rng(51);
+	digest_posting_table table;
+	map<uint_least64_t, vector<size_t>> expected;
+	EXPECT_TRUE(table.find(1) == nullptr);
+	for (size_t i = 0; i < 20000; i++)
+	{
+		// some keys appear twice in a row (inserted once)
+		for (int k = rng() % 3; k >= 0; k--)
+		{
+			uint_least64_t key = rng() % 3000 * 0x10001u;
+			table.insert(key, i);
+			vector<size_t>& postings = expected[key];
+			if (postings.empty() || postings.back() != i)
+				postings.push_back(i);
+		}
+	}
+	ASSERT_EQ(expected.size(), table.size());
+	for (const auto& entry : expected)
+	{
+		const digest_posting_list* list = table.find(entry.first);
+		ASSERT_TRUE(list != nullptr);
+		DigestPostingListTests_Check(*list, entry.second);
+	}
+	EXPECT_TRUE(table.find(1) == nullptr);
+	size_t visited = 0;
+	table.for_each([&](uint_least64_t key, const digest_posting_list& list) {
+		ASSERT_EQ(1u, expected.count(key));
+		EXPECT_EQ(expected[key].size(), list.size());
+		visited++;
+	});
+	EXPECT_EQ(expected.size(), visited);
+	EXPECT_LT(0u, table.memory_usage());
+	table.clear();
+	EXPECT_TRUE(table.empty());
+	EXPECT_TRUE(table.find(0) == nullptr);
+}
+
+#endif
@@ -0,0 +1,232 @@
+/*
+
+	ffuzzy++ : C++ implementation of fast fuzzy hasing
+
+	tests/cases/small/digest_query.hpp
+	Compiled query (one-vs-many comparison) tests
+
+	Copyright (C) 2026 Tsukasa OI <floss_ssdeep@irq.a4lg.com>
+
+
+	Permission to use, copy, modify, and/or distribute this software for
+	any purpose with or without fee is hereby granted, provided that the
+	above copyright notice and this permission notice appear in all copies.
+
+	THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+	WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+	MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+	ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+	WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+	ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+	OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+
+*/
+#ifndef FFUZZYPP_TESTCASES_SMALL_DIGEST_QUERY_HPP
+#define FFUZZYPP_TESTCASES_SMALL_DIGEST_QUERY_HPP
+
+#include <cstddef>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "../common/digest_corpus.hpp"
+
+
+template <bool IsAlphabetRestricted, comparison_version Version>
+struct DigestQueryTestParam
+{
+	static constexpr const bool is_alphabet_restricted = IsAlphabetRestricted;
+	static constexpr const comparison_version version = Version;
+};
+
+template <typename T>
+class DigestQueryTests : public ::testing::Test {};
+
+typedef ::testing::Types<
+	DigestQueryTestParam<true,  comparison_version::v2_13>,
+	DigestQueryTestParam<true,  comparison_version::v2_9>,
+	DigestQueryTestParam<false, comparison_version::v2_13>,
+	DigestQueryTestParam<false, comparison_version::v2_9>
+> DigestQueryTypes;
+TYPED_TEST_CASE(DigestQueryTests, DigestQueryTypes);
+
+TYPED_TEST(DigestQueryTests, CompareAllMatchesDigestComparison)
+{
+	static constexpr const bool ra = TypeParam::is_alphabet_restricted;
+	static constexpr const comparison_version version = TypeParam::version;
+	vector<string> corpus = DigestCorpus::generate(600);
+	vector<digest<ra, false, true>> digests;
+	digest_store<ra> store;
+	for (const auto& str : corpus)
+	{
+		digests.push_back(digest<ra, false, true>(str));
+		store.push_back(digests.back());
+	}
+	ASSERT_EQ(digests.size(), store.size());
+	vector<digest_comparison_score_t> scores(store.size());
+	size_t nonzero = 0;
+	for (size_t q = 0; q < digests.size(); q += 7)
+	{
+		digest_query<ra, version> query(digests[q]);
+		query.compare_all(store, scores.data());
+		for (size_t i = 0; i < digests.size(); i++)
+		{
+			digest_comparison_score_t expected =
+				digest_comparison<version>::compare(digests[q], digests[i]);
+			ASSERT_EQ(expected, scores[i])
+				<< "compare_all test failed on <" << corpus[q] << "> and <" << corpus[i] << ">.";
+			ASSERT_EQ(expected, query.compare(store, i))
+				<< "compare test failed on <" << corpus[q] << "> and <" << corpus[i] << ">.";
+			ASSERT_LE(expected, query.upper_bound(store, i))
+				<< "upper_bound test failed on <" << corpus[q] << "> and <" << corpus[i] << ">.";
+			if (expected)
+				nonzero++;
+		}
+	}
+	// make sure that the corpus is meaningful
+	EXPECT_LT(100u, nonzero);
+}
+
+TYPED_TEST(DigestQueryTests, CompareRangeWithMinScore)
+{
+	static constexpr const bool ra = TypeParam::is_alphabet_restricted;
+	static constexpr const comparison_version version = TypeParam::version;
+	vector<string> corpus = DigestCorpus::generate(300, 2);
+	vector<digest<ra, false, true>> digests;
+	digest_store<ra> store;
+	for (const auto& str : corpus)
+	{
+		digests.push_back(digest<ra, false, true>(str));
+		store.push_back(digests.back());
+	}
+	static const size_t begin = 17, end = 281;
+	vector<digest_comparison_score_t> scores(end - begin);
+	for (digest_comparison_score_t min_score : {1u, 30u, 60u, 100u})
+	{
+		for (size_t q = 0; q < digests.size(); q += 11)
+		{
+			digest_query<ra, version> query(digests[q]);
+			query.compare_range(store, begin, end, scores.data(), min_score);
+			for (size_t i = begin; i < end; i++)
+			{
+				digest_comparison_score_t expected =
+					digest_comparison<version>::compare(digests[q], digests[i]);
+				if (expected < min_score)
+					expected = 0;
+				ASSERT_EQ(expected, scores[i - begin])
+					<< "compare_range test failed on <" << corpus[q] << "> and <" << corpus[i]
+					<< "> (min_score=" << min_score << ").";
+				ASSERT_EQ(expected, query.compare_threshold(store, i, min_score))
+					<< "compare_threshold test failed on <" << corpus[q] << "> and <" << corpus[i]
+					<< "> (min_score=" << min_score << ").";
+			}
+			// Non-contiguous candidates (every third one, in reverse order)
+			vector<size_t> indices;
+			for (size_t i = end; i-- > begin; )
+				if (i % 3 == 0)
+					indices.push_back(i);
+			query.compare_indices(store, indices.data(), indices.size(), scores.data(), min_score);
+			for (size_t k = 0; k < indices.size(); k++)
+			{
+				ASSERT_EQ(query.compare_threshold(store, indices[k], min_score), scores[k])
+					<< "compare_indices test failed on <" << corpus[q] << "> and <" << corpus[indices[k]]
+					<< "> (min_score=" << min_score << ").";
+			}
+		}
+	}
+}
+
+TYPED_TEST(DigestQueryTests, SearchTopK)
+{
+	static constexpr const bool ra = TypeParam::is_alphabet_restricted;
+	static constexpr const comparison_version version = TypeParam::version;
+	vector<string> corpus = DigestCorpus::generate(500, 3);
+	vector<digest<ra, false, true>> digests;
+	digest_store<ra> store;
+	for (const auto& str : corpus)
+	{
+		digests.push_back(digest<ra, false, true>(str));
+		store.push_back(digests.back());
+	}
+	for (size_t q = 0; q < digests.size(); q += 13)
+	{
+		digest_query<ra, version> query(digests[q]);
+		// Brute force (sorted by score [descending] and index [ascending])
+		vector<digest_search_result> all;
+		for (size_t i = 0; i < digests.size(); i++)
+		{
+			digest_comparison_score_t score = digest_comparison<version>::compare(digests[q], digests[i]);
+			if (score)
+				all.push_back(digest_search_result{ i, score });
+		}
+		stable_sort(all.begin(), all.end(),
+			[](const digest_search_result& a, const digest_search_result& b) { return a.score > b.score; });
+		for (size_t k : {1u, 3u, 20u, 1000u})
+		{
+			for (digest_comparison_score_t min_score : {0u, 1u, 50u, 90u})
+			{
+				vector<digest_search_result> expected;
+				for (const auto& r : all)
+					if (expected.size() < k && r.score >= min_score)
+						expected.push_back(r);
+				vector<digest_search_result> results = query.search_top_k(store, k, min_score);
+				ASSERT_EQ(expected.size(), results.size())
+					<< "search_top_k test failed on <" << corpus[q] << "> (k=" << k << ", min_score=" << min_score << ").";
+				for (size_t n = 0; n < expected.size(); n++)
+				{
+					ASSERT_EQ(expected[n].index, results[n].index)
+						<< "search_top_k test failed on <" << corpus[q] << "> (k=" << k << ", min_score=" << min_score << ").";
+					ASSERT_EQ(expected[n].score, results[n].score)
+						<< "search_top_k test failed on <" << corpus[q] << "> (k=" << k << ", min_score=" << min_score << ").";
+				}
+			}
+		}
+	}
+}
+
+TEST(DigestQueryUsageTests, ConstructionByString)
+{
+	digest_store_t store;
+	EXPECT_EQ(0u, store.push_back("3:ABCDEFGHIJ:KLMNOPQ"));
+	EXPECT_EQ(1u, store.push_back(string("6:KLMNOPQ:RSTUVWX")));
+	EXPECT_EQ(2u, store.push_back("12:RSTUVWX:"));
+	digest_query<true> query("3:ABCDEFGHIJ:KLMNOPQ");
+	EXPECT_EQ(3u, query.blocksize());
+	EXPECT_EQ(10u, query.blockhash1_len());
+	EXPECT_EQ(7u, query.blockhash2_len());
+	digest_comparison_score_t scores[3];
+	query.compare_all(store, scores);
+	EXPECT_EQ(100u, scores[0]);
+	EXPECT_EQ(
+		digest_comparison<>::compare(digest_ra_t("3:ABCDEFGHIJ:KLMNOPQ"), digest_ra_t("6:KLMNOPQ:RSTUVWX")),
+		scores[1]);
+	EXPECT_EQ(0u, scores[2]);
+}
+
+TEST(DigestQueryUsageTests, EmptyBlockhashesOnVersion2_9)
+{
+	// Identical scores on empty block hashes must not divide by zero
+	EXPECT_EQ(0u, blockhash_comparison<comparison_version::v2_9>::score_identical(0, 3));
+	static const char* const strs[] = {
+		"3:ABCDEFGHIJ:", "3::ABCDEFGHIJ", "3::", "6:ABCDEFGHIJ:", "3:ABCDEFGHIJ:"
+	};
+	digest_store_t store;
+	for (const char* str : strs)
+		store.push_back(str);
+	for (size_t q = 0; q < store.size(); q++)
+	{
+		digest_query<true, comparison_version::v2_9> query(store, q);
+		for (size_t i = 0; i < store.size(); i++)
+		{
+			EXPECT_EQ(
+				digest_comparison<comparison_version::v2_9>::compare(digest_ra_t(strs[q]), digest_ra_t(strs[i])),
+				query.compare(store, i))
+				<< "compare test failed on <" << strs[q] << "> and <" << strs[i] << ">.";
+		}
+	}
+	EXPECT_EQ(0u, digest_comparison<comparison_version::v2_9>::compare(digest_ra_t("3::"), digest_ra_t("3::")));
+	digest_query<true, comparison_version::v2_9> query(store, 0);
+	EXPECT_NE(0u, query.compare(store, 4));
+}
+
+#endif
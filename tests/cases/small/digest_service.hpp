@@ -0,0 +1,179 @@
+/*
+
+	ffuzzy++ : C++ implementation of fast fuzzy hasing
+
+	tests/cases/small/digest_service.hpp
+	Similarity search service tests
+
+	Copyright (C) 2026 Tsukasa OI <floss_ssdeep@irq.a4lg.com>
+
+
+	Permission to use, copy, modify, and/or distribute this software for
+	any purpose with or without fee is hereby granted, provided that the
+	above copyright notice and this permission notice appear in all copies.
+
+	THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+	WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+	MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+	ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+	WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+	ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+	OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+
+*/
+#ifndef FFUZZYPP_TESTCASES_SMALL_DIGEST_SERVICE_HPP
+#define FFUZZYPP_TESTCASES_SMALL_DIGEST_SERVICE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifndef FFUZZYPP_DISABLE_SOCKETS
+#include <unistd.h>
+#endif
+
+#include "../common/digest_corpus.hpp"
+
+
+// Queries of various kinds for k-th digest of the corpus
+static vector<digest_service_query> DigestServiceTests_Queries(const vector<string>& corpus, size_t k)
+{
+	vector<digest_service_query> queries;
+	queries.push_back(digest_service_query{ corpus[k], 1, 0 });
+	queries.push_back(digest_service_query{ corpus[(k * 7 + 1) % corpus.size()], 60, 0 });
+	queries.push_back(digest_service_query{ corpus[(k * 13 + 2) % corpus.size()], 0, 3 });
+	queries.push_back(digest_service_query{ "3:invalid", 1, 0 });
+	return queries;
+}
+
+static void DigestServiceTests_CheckReplies(
+	const digest_index_t& index,
+	const vector<digest_service_query>& queries,
+	const vector<digest_service_reply>& replies
+)
+{
+	ASSERT_EQ(queries.size(), replies.size());
+	for (size_t n = 0; n < queries.size(); n++)
+	{
+		digest_ra_long_t d;
+		bool valid = digest_ra_long_t::parse(d, queries[n].digest.c_str());
+		ASSERT_EQ(valid, replies[n].is_valid) << "reply test failed on <" << queries[n].digest << ">.";
+		if (!valid)
+		{
+			EXPECT_TRUE(replies[n].matches.empty());
+			continue;
+		}
+		vector<digest_search_result> expected = queries[n].top_k
+			? index.search_top_k(d, queries[n].top_k, queries[n].min_score)
+			: index.search(d, queries[n].min_score);
+		ASSERT_EQ(expected.size(), replies[n].matches.size()) << "reply test failed on <" << queries[n].digest << ">.";
+		for (size_t i = 0; i < expected.size(); i++)
+		{
+			ASSERT_EQ(expected[i].index, replies[n].matches[i].index) << "reply test failed on <" << queries[n].digest << ">.";
+			ASSERT_EQ(expected[i].score, replies[n].matches[i].score) << "reply test failed on <" << queries[n].digest << ">.";
+		}
+	}
+}
+
+TEST(DigestServiceTests, HandlerMatchesIndex)
+{
+	vector<string> corpus = DigestCorpus::generate(500, 25);
+	digest_index_t index;
+	for (const auto& str : corpus)
+		index.push_back(str);
+	digest_service_handler<digest_index_t> handler(index);
+	vector<unsigned char> request, reply;
+	vector<digest_search_result> scratch;
+	for (size_t k = 0; k < corpus.size(); k += 5)
+	{
+		vector<digest_service_query> queries = DigestServiceTests_Queries(corpus, k);
+		digest_service_protocol::encode_request(k * 3 + 1, queries, request);
+		ASSERT_TRUE(handler.handle(request.data(), request.size(), reply, scratch));
+		uint_least64_t request_id = 0;
+		vector<digest_service_reply> replies;
+		ASSERT_TRUE(digest_service_protocol::decode_reply(reply.data(), reply.size(), request_id, replies));
+		EXPECT_EQ(k * 3 + 1, request_id);
+		DigestServiceTests_CheckReplies(index, queries, replies);
+	}
+	// empty batch
+	digest_service_protocol::encode_request(7, vector<digest_service_query>(), request);
+	ASSERT_TRUE(handler.handle(request.data(), request.size(), reply, scratch));
+	EXPECT_EQ(12u, reply.size());
+	// malformed requests
+	digest_service_protocol::encode_request(1, DigestServiceTests_Queries(corpus, 0), request);
+	for (size_t size = 0; size < request.size(); size++)
+		EXPECT_FALSE(handler.handle(request.data(), size, reply, scratch));
+	request.push_back(0);
+	EXPECT_FALSE(handler.handle(request.data(), request.size(), reply, scratch));
+}
+
+#ifndef FFUZZYPP_DISABLE_SOCKETS
+TEST(DigestServiceTests, PipelinedClients)
+{
+	static const size_t client_count = 3;
+	static const size_t request_count = 40;
+	vector<string> corpus = DigestCorpus::generate(800, 26);
+	digest_index_t index;
+	for (const auto& str : corpus)
+		index.push_back(str);
+	char dir[] = "/tmp/ffuzzypp-service-XXXXXX";
+	ASSERT_TRUE(mkdtemp(dir) != nullptr);
+	string path = string(dir) + "/socket";
+	digest_service_server<digest_index_t> server(index, 3);
+	ASSERT_TRUE(server.listen(path));
+	bool run_result = false;
+	std::thread runner([&] { run_result = server.run(); });
+	vector<std::thread> clients;
+	vector<size_t> received(client_count, 0);
+	for (size_t c = 0; c < client_count; c++)
+		clients.push_back(std::thread([&, c] {
+			digest_service_client client(path.c_str());
+			ASSERT_TRUE(client.is_open());
+			// send all requests before reading any replies
+			map<uint_least64_t, vector<digest_service_query>> sent;
+			for (size_t r = 0; r < request_count; r++)
+			{
+				uint_least64_t id = c * 1000 + r;
+				sent[id] = DigestServiceTests_Queries(corpus, (c * request_count + r) % corpus.size());
+				ASSERT_TRUE(client.send(id, sent[id]));
+			}
+			for (size_t r = 0; r < request_count; r++)
+			{
+				uint_least64_t id;
+				vector<digest_service_reply> replies;
+				ASSERT_TRUE(client.receive(id, replies));
+				ASSERT_EQ(1u, sent.count(id));
+				DigestServiceTests_CheckReplies(index, sent[id], replies);
+				sent.erase(id);
+				received[c]++;
+			}
+		}));
+	for (auto& t : clients)
+		t.join();
+	for (size_t c = 0; c < client_count; c++)
+		EXPECT_EQ(request_count, received[c]);
+	// a malformed request closes the connection
+	{
+		socket_stream s = socket_stream::connect_unix(path.c_str());
+		ASSERT_TRUE(s.is_open());
+		vector<unsigned char> garbage(5, 0xff);
+		ASSERT_TRUE(digest_shard_protocol::write_frame(s, garbage));
+		vector<unsigned char> reply;
+		EXPECT_FALSE(digest_shard_protocol::read_frame(s, reply));
+	}
+	// an idle connection does not prevent stopping
+	digest_service_client idle(path.c_str());
+	ASSERT_TRUE(idle.is_open());
+	server.stop();
+	runner.join();
+	EXPECT_TRUE(run_result);
+	EXPECT_NE(0, access(path.c_str(), F_OK));
+	rmdir(dir);
+}
+#endif
+
+#endif
@@ -0,0 +1,159 @@
+/*
+
+	ffuzzy++ : C++ implementation of fast fuzzy hasing
+
+	tests/cases/small/digest_shard.hpp
+	Sharding and query routing tests
+
+	Copyright (C) 2026 Tsukasa OI <floss_ssdeep@irq.a4lg.com>
+
+
+	Permission to use, copy, modify, and/or distribute this software for
+	any purpose with or without fee is hereby granted, provided that the
+	above copyright notice and this permission notice appear in all copies.
+
+	THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+	WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+	MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+	ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+	WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+	ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+	OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+
+*/
+#ifndef FFUZZYPP_TESTCASES_SMALL_DIGEST_SHARD_HPP
+#define FFUZZYPP_TESTCASES_SMALL_DIGEST_SHARD_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#ifndef FFUZZYPP_DISABLE_SOCKETS
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+#include "../common/digest_corpus.hpp"
+
+
+TEST(DigestShardMapTests, NearShards)
+{
+	digest_shard_map map;
+	EXPECT_EQ(32u, map.shard_count());
+	EXPECT_EQ(0u, digest_shard_map::slot_of(3));
+	EXPECT_EQ(30u, digest_shard_map::slot_of(digest_blocksize::max_blocksize));
+	// non-natural block sizes
+	EXPECT_EQ(31u, digest_shard_map::slot_of(5));
+	EXPECT_EQ(31u, digest_shard_map::slot_of(0));
+	EXPECT_EQ(vector<unsigned>({ 0, 1 }), map.shards_near(3));
+	EXPECT_EQ(vector<unsigned>({ 3, 4, 5 }), map.shards_near(48));
+	EXPECT_EQ(vector<unsigned>({ 29, 30 }), map.shards_near(digest_blocksize::max_blocksize));
+	EXPECT_EQ(vector<unsigned>({ 31 }), map.shards_near(10));
+	// groups of block size indices
+	digest_shard_map grouped(8);
+	EXPECT_EQ(4u, grouped.shard_count());
+	EXPECT_EQ(vector<unsigned>({ 0 }), grouped.shards_near(6));
+	EXPECT_EQ(vector<unsigned>({ 0, 1 }), grouped.shards_near(digest_blocksize::at(7)));
+	// sub-shards of a hot group
+	grouped.split(6, 3);
+	EXPECT_EQ(6u, grouped.shard_count());
+	EXPECT_EQ(3u, grouped.sub_shards(3));
+	EXPECT_EQ(1u, grouped.sub_shards(digest_blocksize::at(8)));
+	EXPECT_EQ(vector<unsigned>({ 0, 1, 2, 3 }), grouped.shards_near(digest_blocksize::at(7)));
+	EXPECT_EQ(vector<unsigned>({ 5 }), grouped.shards_near(7));
+}
+
+template <typename TRouter>
+static void DigestShardTests_CheckRouter(TRouter& router, size_t count, unsigned seed)
+{
+	vector<string> corpus = DigestCorpus::generate(count, seed);
+	vector<digest_ra_long_t> digests;
+	digest_index_t index;
+	for (const auto& str : corpus)
+	{
+		digests.push_back(digest_ra_long_t(str));
+		index.push_back(digests.back());
+		ASSERT_EQ(uint_least64_t(index.size() - 1), router.push_back(digests.back()));
+	}
+	size_t nonempty = 0;
+	for (size_t q = 0; q < digests.size(); q += 3)
+	{
+		for (digest_comparison_score_t min_score : {1u, 60u})
+		{
+			vector<digest_search_result> expected = index.search(digests[q], min_score);
+			vector<digest_search_result> results = router.search(digests[q], min_score);
+			ASSERT_EQ(expected.size(), results.size()) << "router test failed on <" << corpus[q] << ">.";
+			for (size_t n = 0; n < expected.size(); n++)
+			{
+				ASSERT_EQ(expected[n].index, results[n].index) << "router test failed on <" << corpus[q] << ">.";
+				ASSERT_EQ(expected[n].score, results[n].score) << "router test failed on <" << corpus[q] << ">.";
+			}
+			if (!results.empty())
+				nonempty++;
+		}
+	}
+	EXPECT_LT(100u, nonempty);
+}
+
+TEST(DigestShardRouterTests, LocalShards)
+{
+	digest_shard_map map(4);
+	map.split(96, 3);
+	vector<digest_local_shard<true>> shards(map.shard_count());
+	digest_shard_router<digest_local_shard<true>, true> router(map, std::move(shards));
+	DigestShardTests_CheckRouter(router, 600, 17);
+	size_t total = 0;
+	for (size_t i = 0; i < router.shard_count(); i++)
+	{
+		EXPECT_EQ(router.shard(i).index().size(), router.shard_size(i));
+		total += router.shard_size(i);
+	}
+	EXPECT_EQ(router.size(), total);
+	// digests in the hot group are distributed to all sub-shards
+	for (size_t i = 0; i < 3; i++)
+		EXPECT_LT(0u, router.shard_size(map.shards_near(3).front() + i));
+}
+
+#ifndef FFUZZYPP_DISABLE_SOCKETS
+TEST(DigestShardRouterTests, ShardProcesses)
+{
+	digest_shard_map map(8);
+	map.split(3, 2);
+	vector<digest_remote_shard<true>> shards;
+	vector<pid_t> children;
+	for (unsigned i = 0; i < map.shard_count(); i++)
+	{
+		socket_stream parent_end, child_end;
+		ASSERT_TRUE(socket_stream::make_pair(parent_end, child_end));
+		pid_t pid = fork();
+		ASSERT_LE(0, pid);
+		if (pid == 0)
+		{
+			// do not keep other shards' connections open
+			shards.clear();
+			parent_end.close();
+			digest_shard_server<true> server;
+			server.serve(child_end);
+			_exit(0);
+		}
+		children.push_back(pid);
+		shards.push_back(digest_remote_shard<true>(std::move(parent_end)));
+	}
+	{
+		digest_shard_router<digest_remote_shard<true>, true> router(map, std::move(shards));
+		DigestShardTests_CheckRouter(router, 400, 18);
+	}
+	// shard processes exit on the end of stream
+	for (pid_t pid : children)
+	{
+		int status = -1;
+		ASSERT_EQ(pid, waitpid(pid, &status, 0));
+		EXPECT_TRUE(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+	}
+}
+#endif
+
+#endif
@@ -0,0 +1,167 @@
+/*
+
+	ffuzzy++ : C++ implementation of fast fuzzy hasing
+
+	tests/cases/small/digest_snapshot.hpp
+	Index snapshot tests
+
+	Copyright (C) 2026 Tsukasa OI <floss_ssdeep@irq.a4lg.com>
+
+
+	Permission to use, copy, modify, and/or distribute this software for
+	any purpose with or without fee is hereby granted, provided that the
+	above copyright notice and this permission notice appear in all copies.
+
+	THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+	WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+	MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+	ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+	WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+	ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+	OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+
+*/
+#ifndef FFUZZYPP_TESTCASES_SMALL_DIGEST_SNAPSHOT_HPP
+#define FFUZZYPP_TESTCASES_SMALL_DIGEST_SNAPSHOT_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#ifndef FFUZZYPP_DISABLE_MAPPED_FILE
+#include <unistd.h>
+#endif
+
+#include "../common/digest_corpus.hpp"
+
+
+template <typename T>
+class DigestSnapshotTests : public ::testing::Test {};
+
+typedef ::testing::Types<
+	std::integral_constant<bool, true>,
+	std::integral_constant<bool, false>
+> DigestSnapshotTypes;
+TYPED_TEST_CASE(DigestSnapshotTests, DigestSnapshotTypes);
+
+template <bool IsAlphabetRestricted>
+static void DigestSnapshotTests_CheckSameResults(
+	const digest_index<IsAlphabetRestricted>& index,
+	const digest_snapshot<IsAlphabetRestricted>& snapshot,
+	const vector<digest<IsAlphabetRestricted, false, true>>& digests
+)
+{
+	ASSERT_EQ(index.size(), snapshot.size());
+	ASSERT_EQ(index.posting_count(), snapshot.posting_count());
+	for (size_t i = 0; i < index.size(); i++)
+		ASSERT_EQ(index.store().view(i), snapshot.view(i));
+	for (size_t q = 0; q < digests.size(); q += 3)
+	{
+		ASSERT_EQ(index.candidates(digests[q]), snapshot.candidates(digests[q]));
+		for (digest_comparison_score_t min_score : { 1, 50, 90 })
+		{
+			vector<digest_search_result> expected = index.search(digests[q], min_score);
+			vector<digest_search_result> results = snapshot.search(digests[q], min_score);
+			ASSERT_EQ(expected.size(), results.size());
+			for (size_t n = 0; n < expected.size(); n++)
+			{
+				ASSERT_EQ(expected[n].index, results[n].index);
+				ASSERT_EQ(expected[n].score, results[n].score);
+			}
+		}
+	}
+}
+
+TYPED_TEST(DigestSnapshotTests, MatchesIndex)
+{
+	static constexpr const bool ra = TypeParam::value;
+	vector<string> corpus = DigestCorpus::generate(600, 9);
+	corpus.push_back("3:ABC:DE");
+	corpus.push_back("3:ABC:DE");
+	vector<digest<ra, false, true>> digests;
+	digest_index<ra> index;
+	for (const auto& str : corpus)
+	{
+		digests.push_back(digest<ra, false, true>(str));
+		index.push_back(digests.back());
+	}
+	vector<unsigned char> buf;
+	digest_snapshot<ra>::write(index, buf);
+	digest_snapshot<ra> snapshot;
+	ASSERT_TRUE(snapshot.open(buf.data(), buf.size()));
+	ASSERT_TRUE(snapshot.verify());
+	DigestSnapshotTests_CheckSameResults(index, snapshot, digests);
+	// Position independence (copy to another place)
+	vector<uint64_t> moved(buf.size() / sizeof(uint64_t));
+	memcpy(moved.data(), buf.data(), buf.size());
+	buf.clear();
+	ASSERT_TRUE(snapshot.open(moved.data(), moved.size() * sizeof(uint64_t)));
+	DigestSnapshotTests_CheckSameResults(index, snapshot, digests);
+}
+
+TEST(DigestSnapshotUsageTests, RejectsBrokenSnapshots)
+{
+	digest_index_t index;
+	index.push_back("3:ABCDEFGHIJ:KLMNOPQ");
+	index.push_back("6:KLMNOPQ:RSTUVWX");
+	index.push_back("3:ABC:DE");
+	vector<unsigned char> buf;
+	digest_snapshot_t::write(index, buf);
+	digest_snapshot_t snapshot;
+	ASSERT_TRUE(snapshot.open(buf.data(), buf.size()));
+	EXPECT_TRUE(snapshot.verify());
+	// Different alphabet restriction
+	EXPECT_FALSE(digest_snapshot_non_ra_t(buf.data(), buf.size()).is_open());
+	// Truncated or extended
+	EXPECT_FALSE(snapshot.open(buf.data(), buf.size() - 8));
+	EXPECT_FALSE(snapshot.open(buf.data(), 16));
+	vector<unsigned char> ext(buf);
+	ext.resize(ext.size() + 8);
+	EXPECT_FALSE(snapshot.open(ext.data(), ext.size()));
+	// Broken header
+	vector<unsigned char> broken(buf);
+	broken[0] ^= 1;
+	EXPECT_FALSE(snapshot.open(broken.data(), broken.size()));
+	// Broken posting list (only detected by verify)
+	// (the last one of 7 postings, followed by padding and 1 unindexed digest)
+	broken = buf;
+	uint32_t bad = 3;
+	memcpy(broken.data() + broken.size() - 16 - sizeof(uint32_t) * 2, &bad, sizeof(bad));
+	ASSERT_TRUE(snapshot.open(broken.data(), broken.size()));
+	EXPECT_FALSE(snapshot.verify());
+}
+
+#ifndef FFUZZYPP_DISABLE_MAPPED_FILE
+TEST(DigestSnapshotUsageTests, MappedFile)
+{
+	vector<string> corpus = DigestCorpus::generate(200, 10);
+	vector<digest_ra_long_t> digests;
+	digest_index_t index;
+	for (const auto& str : corpus)
+	{
+		digests.push_back(digest_ra_long_t(str));
+		index.push_back(digests.back());
+	}
+	char filename[] = "/tmp/ffuzzypp-snapshot-XXXXXX";
+	int fd = mkstemp(filename);
+	ASSERT_LE(0, fd);
+	close(fd);
+	ASSERT_TRUE(digest_snapshot_t::write(index, filename));
+	{
+		mapped_file file(filename);
+		ASSERT_TRUE(file.is_open());
+		digest_snapshot_t snapshot;
+		ASSERT_TRUE(snapshot.open(file.data(), file.size()));
+		ASSERT_TRUE(snapshot.verify());
+		DigestSnapshotTests_CheckSameResults(index, snapshot, digests);
+	}
+	unlink(filename);
+	mapped_file missing(filename);
+	EXPECT_FALSE(missing.is_open());
+}
+#endif
+
+#endif
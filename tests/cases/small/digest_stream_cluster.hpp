@@ -0,0 +1,214 @@
+/*
+
+	ffuzzy++ : C++ implementation of fast fuzzy hasing
+
+	tests/cases/small/digest_stream_cluster.hpp
+	Online clustering tests
+
+	Copyright (C) 2026 Tsukasa OI <floss_ssdeep@irq.a4lg.com>
+
+
+	Permission to use, copy, modify, and/or distribute this software for
+	any purpose with or without fee is hereby granted, provided that the
+	above copyright notice and this permission notice appear in all copies.
+
+	THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+	WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+	MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+	ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+	WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+	ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+	OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+
+*/
+#ifndef FFUZZYPP_TESTCASES_SMALL_DIGEST_STREAM_CLUSTER_HPP
+#define FFUZZYPP_TESTCASES_SMALL_DIGEST_STREAM_CLUSTER_HPP
+
+#include <cstddef>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../common/digest_corpus.hpp"
+
+
+// Representatives (smallest index) of single-linkage clusters by brute force
+static vector<size_t> DigestStreamClusterTests_Reference(
+	const vector<digest_ra_long_t>& digests,
+	digest_comparison_score_t threshold
+)
+{
+	vector<size_t> parent(digests.size());
+	for (size_t i = 0; i < parent.size(); i++)
+		parent[i] = i;
+	auto find = [&](size_t x) {
+		while (parent[x] != x)
+			x = parent[x];
+		return x;
+	};
+	for (size_t i = 0; i < digests.size(); i++)
+		for (size_t j = 0; j < i; j++)
+			if (digest_comparison<>::compare(digests[i], digests[j]) >= threshold)
+			{
+				size_t a = find(i), b = find(j);
+				if (a != b)
+					parent[max(a, b)] = min(a, b);
+			}
+	for (size_t i = 0; i < parent.size(); i++)
+		parent[i] = find(i);
+	return parent;
+}
+
+// Checks that both partitions are the same (ids[k]: cluster ID of k-th digest)
+static void DigestStreamClusterTests_CheckPartition(
+	const digest_stream_cluster_t& clusters,
+	const vector<size_t>& ids,
+	const vector<size_t>& reference
+)
+{
+	map<size_t, size_t> to_ref, from_ref;
+	for (size_t k = 0; k < ids.size(); k++)
+	{
+		size_t c = clusters.find(ids[k]);
+		auto a = to_ref.insert(make_pair(c, reference[k]));
+		auto b = from_ref.insert(make_pair(reference[k], c));
+		ASSERT_EQ(reference[k], a.first->second) << "partition test failed on " << k << ".";
+		ASSERT_EQ(c, b.first->second) << "partition test failed on " << k << ".";
+	}
+	EXPECT_EQ(to_ref.size(), clusters.cluster_count());
+}
+
+TEST(DigestStreamClusterTests, MatchesBruteForce)
+{
+	static const digest_comparison_score_t threshold = 40;
+	vector<string> corpus = DigestCorpus::generate(500, 21);
+	vector<digest_ra_long_t> digests;
+	for (const auto& str : corpus)
+		digests.push_back(digest_ra_long_t(str));
+	vector<size_t> reference = DigestStreamClusterTests_Reference(digests, threshold);
+	digest_stream_cluster_t clusters(threshold);
+	EXPECT_EQ(threshold, clusters.threshold());
+	// Replay events to track clusters
+	vector<size_t> tracked;
+	size_t merges = 0;
+	vector<size_t> ids;
+	for (size_t k = 0; k < digests.size(); k++)
+	{
+		size_t id = clusters.add(digests[k], [&](const digest_cluster_event& e) {
+			if (e.kind == digest_cluster_event::created)
+			{
+				EXPECT_EQ(e.digest, e.cluster);
+				tracked.push_back(e.digest);
+			}
+			else
+			{
+				EXPECT_LT(e.cluster, e.absorbed);
+				for (size_t& c : tracked)
+					if (c == e.absorbed)
+						c = e.cluster;
+				merges++;
+			}
+		});
+		ASSERT_EQ(k, id);
+		ids.push_back(id);
+	}
+	DigestStreamClusterTests_CheckPartition(clusters, ids, reference);
+	EXPECT_EQ(digests.size(), clusters.size());
+	EXPECT_EQ(digests.size() - merges, clusters.cluster_count());
+	for (size_t k = 0; k < digests.size(); k++)
+		ASSERT_EQ(reference[k], tracked[k]);
+	// make sure that the corpus is meaningful
+	EXPECT_GT(digests.size() * 3 / 4, clusters.cluster_count());
+	EXPECT_LT(50u, clusters.cluster_count());
+}
+
+TEST(DigestStreamClusterTests, ConcurrentAdd)
+{
+	static const digest_comparison_score_t threshold = 30;
+	static const size_t thread_count = 4;
+	vector<string> corpus = DigestCorpus::generate(600, 22);
+	vector<digest_ra_long_t> digests;
+	for (const auto& str : corpus)
+		digests.push_back(digest_ra_long_t(str));
+	vector<size_t> reference = DigestStreamClusterTests_Reference(digests, threshold);
+	digest_stream_cluster_t clusters(threshold);
+	vector<size_t> ids(digests.size());
+	std::mutex event_mutex;
+	size_t created = 0, merged = 0;
+	vector<std::thread> threads;
+	for (size_t t = 0; t < thread_count; t++)
+		threads.push_back(std::thread([&, t] {
+			size_t c = 0, m = 0;
+			for (size_t k = t; k < digests.size(); k += thread_count)
+				ids[k] = clusters.add(digests[k], [&](const digest_cluster_event& e) {
+					(e.kind == digest_cluster_event::created ? c : m)++;
+				});
+			std::lock_guard<std::mutex> lock(event_mutex);
+			created += c;
+			merged += m;
+		}));
+	for (auto& th : threads)
+		th.join();
+	EXPECT_EQ(digests.size(), created);
+	EXPECT_EQ(digests.size() - merged, clusters.cluster_count());
+	DigestStreamClusterTests_CheckPartition(clusters, ids, reference);
+}
+
+TEST(DigestStreamClusterTests, ThrowingCallback)
+{
+	static const digest_comparison_score_t threshold = 40;
+	vector<string> corpus = DigestCorpus::generate(300, 24);
+	vector<digest_ra_long_t> digests;
+	for (const auto& str : corpus)
+		digests.push_back(digest_ra_long_t(str));
+	vector<size_t> reference = DigestStreamClusterTests_Reference(digests, threshold);
+	digest_stream_cluster_t clusters(threshold);
+	vector<size_t> ids;
+	for (size_t k = 0; k < digests.size(); k++)
+	{
+		// digests are merged with their neighbors even if the callback throws
+		EXPECT_THROW(clusters.add(digests[k], [](const digest_cluster_event&) {
+			throw std::runtime_error("callback failure");
+		}), std::runtime_error);
+		ids.push_back(k);
+	}
+	EXPECT_EQ(digests.size(), clusters.size());
+	DigestStreamClusterTests_CheckPartition(clusters, ids, reference);
+}
+
+TEST(DigestStreamClusterTests, Checkpoint)
+{
+	static const digest_comparison_score_t threshold = 50;
+	vector<string> corpus = DigestCorpus::generate(400, 23);
+	vector<digest_ra_long_t> digests;
+	for (const auto& str : corpus)
+		digests.push_back(digest_ra_long_t(str));
+	vector<size_t> reference = DigestStreamClusterTests_Reference(digests, threshold);
+	vector<size_t> ids;
+	digest_stream_cluster_t clusters(threshold);
+	for (size_t k = 0; k < digests.size() / 2; k++)
+		ids.push_back(clusters.add(digests[k]));
+	vector<unsigned char> buf;
+	clusters.save(buf);
+	digest_stream_cluster_t restored(threshold);
+	ASSERT_TRUE(restored.load(buf.data(), buf.size()));
+	EXPECT_EQ(clusters.size(), restored.size());
+	EXPECT_EQ(clusters.cluster_count(), restored.cluster_count());
+	for (size_t k = 0; k < ids.size(); k++)
+		ASSERT_EQ(clusters.find(ids[k]), restored.find(ids[k]));
+	// continue clustering after restoration
+	for (size_t k = digests.size() / 2; k < digests.size(); k++)
+		ids.push_back(restored.add(digests[k]));
+	DigestStreamClusterTests_CheckPartition(restored, ids, reference);
+	// broken checkpoints
+	digest_stream_cluster_t broken(threshold);
+	EXPECT_FALSE(broken.load(buf.data(), buf.size() - 1));
+	digest_stream_cluster_t nonempty(threshold);
+	nonempty.add(digests[0]);
+	EXPECT_FALSE(nonempty.load(buf.data(), buf.size()));
+}
+
+#endif
@@ -0,0 +1,189 @@
+/*
+
+	ffuzzy++ : C++ implementation of fast fuzzy hasing
+
+	tests/cases/small/digest_view.hpp
+	Digest view tests
+
+	Copyright (C) 2026 Tsukasa OI <floss_ssdeep@irq.a4lg.com>
+
+
+	Permission to use, copy, modify, and/or distribute this software for
+	any purpose with or without fee is hereby granted, provided that the
+	above copyright notice and this permission notice appear in all copies.
+
+	THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+	WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+	MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+	ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+	WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+	ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+	OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+
+*/
+#ifndef FFUZZYPP_TESTCASES_SMALL_DIGEST_VIEW_HPP
+#define FFUZZYPP_TESTCASES_SMALL_DIGEST_VIEW_HPP
+
+#include <cstddef>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../common/digest_corpus.hpp"
+
+
+template <bool IsAlphabetRestricted, comparison_version Version>
+struct DigestViewTestParam
+{
+	static constexpr const bool is_alphabet_restricted = IsAlphabetRestricted;
+	static constexpr const comparison_version version = Version;
+};
+
+template <typename T>
+class DigestViewTests : public ::testing::Test {};
+
+typedef ::testing::Types<
+	DigestViewTestParam<true,  comparison_version::v2_13>,
+	DigestViewTestParam<true,  comparison_version::v2_9>,
+	DigestViewTestParam<false, comparison_version::v2_13>,
+	DigestViewTestParam<false, comparison_version::v2_9>
+> DigestViewTypes;
+TYPED_TEST_CASE(DigestViewTests, DigestViewTypes);
+
+TYPED_TEST(DigestViewTests, CompareMatchesDigestComparison)
+{
+	static constexpr const bool ra = TypeParam::is_alphabet_restricted;
+	static constexpr const comparison_version version = TypeParam::version;
+	vector<string> corpus = DigestCorpus::generate(300, 4);
+	vector<digest<ra, false, true>> digests;
+	digest_store<ra> store;
+	for (const auto& str : corpus)
+	{
+		digests.push_back(digest<ra, false, true>(str));
+		store.push_back(digests.back());
+	}
+	size_t nonzero = 0;
+	for (size_t i = 0; i < digests.size(); i++)
+	{
+		digest_view<ra> va(digests[i]);
+		ASSERT_TRUE(va.is_valid());
+		ASSERT_TRUE(va.is_normalized());
+		ASSERT_EQ(va, store.view(i));
+		#ifndef FFUZZYPP_DISABLE_POSITION_ARRAY
+		digest_position_array<ra> pa(digests[i]);
+		#endif
+		for (size_t j = 0; j < digests.size(); j++)
+		{
+			digest_comparison_score_t expected =
+				digest_comparison<version>::compare(digests[i], digests[j]);
+			ASSERT_EQ(expected, digest_comparison<version>::compare(va, store.view(j)))
+				<< "view comparison failed on <" << corpus[i] << "> and <" << corpus[j] << ">.";
+			#ifndef FFUZZYPP_DISABLE_POSITION_ARRAY
+			ASSERT_EQ(expected, digest_position_array<ra>::template compare<version>(pa, store.view(j)))
+				<< "position array comparison failed on <" << corpus[i] << "> and <" << corpus[j] << ">.";
+			ASSERT_EQ(expected, digest_position_array<ra>::template compare<version>(store.view(j), pa))
+				<< "position array comparison failed on <" << corpus[j] << "> and <" << corpus[i] << ">.";
+			#endif
+			for (digest_comparison_score_t min_score : { 1, 50, 90 })
+			{
+				digest_comparison_score_t expected_threshold = expected < min_score ? 0 : expected;
+				ASSERT_EQ(expected_threshold, digest_comparison<version>::compare_threshold(va, store.view(j), min_score))
+					<< "view comparison (threshold) failed on <" << corpus[i] << "> and <" << corpus[j] << ">.";
+				#ifndef FFUZZYPP_DISABLE_POSITION_ARRAY
+				ASSERT_EQ(expected_threshold, digest_comparison<version>::compare_threshold(pa, store.view(j), min_score))
+					<< "position array comparison (threshold) failed on <" << corpus[i] << "> and <" << corpus[j] << ">.";
+				#endif
+			}
+			if (expected)
+				nonzero++;
+		}
+	}
+	// make sure that the corpus is meaningful
+	EXPECT_LT(100u, nonzero);
+}
+
+TYPED_TEST(DigestViewTests, NormalizeUnnormalized)
+{
+	static constexpr const bool ra = TypeParam::is_alphabet_restricted;
+	static constexpr const comparison_version version = TypeParam::version;
+	vector<string> corpus = DigestCorpus::generate(200, 5);
+	// Insert long sequences (without changing lengths)
+	std::mt19937 rng(5);
+	for (auto& str : corpus)
+	{
+		size_t c1 = str.find(':'), c2 = str.find(':', c1 + 1);
+		for (auto& range : { std::make_pair(c1 + 1, c2), std::make_pair(c2 + 1, str.size()) })
+		{
+			size_t len = range.second - range.first;
+			if (len < 6 || rng() % 2)
+				continue;
+			size_t n = 4 + rng() % 3, p = range.first + rng() % (len - n + 1);
+			for (size_t k = 1; k < n; k++)
+				str[p + k] = str[p];
+		}
+	}
+	vector<digest<ra, false, false>> unorms;
+	vector<digest<ra, false, true>> digests;
+	digest_store<ra> store;
+	for (const auto& str : corpus)
+	{
+		unorms.push_back(digest<ra, false, false>(str));
+		digests.push_back(digest<ra, false, true>(str));
+		store.push_back(unorms.back());
+	}
+	size_t copied = 0;
+	for (size_t i = 0; i < unorms.size(); i++)
+	{
+		char buf[digest_params::max_blockhash_len * 2];
+		digest_view<ra> v = digest_view<ra>::normalize(buf, unorms[i]);
+		ASSERT_TRUE(v.is_normalized());
+		ASSERT_EQ(digest_view<ra>(digests[i]), v);
+		ASSERT_EQ(digest_view<ra>(digests[i]), store.view(i));
+		// block hashes without long sequences are not copied
+		if (unorms[i].blockhash1_len() == digests[i].blockhash1_len())
+			ASSERT_EQ(unorms[i].digest_buffer(), v.blockhash1());
+		else
+			copied++;
+		for (size_t j = 0; j < unorms.size(); j++)
+		{
+			ASSERT_EQ(digest_comparison<version>::compare(digests[i], digests[j]),
+				digest_comparison<version>::compare_unnormalized(unorms[i], unorms[j]))
+				<< "comparison failed on <" << corpus[i] << "> and <" << corpus[j] << ">.";
+		}
+	}
+	// make sure that the corpus is meaningful
+	EXPECT_LT(20u, copied);
+}
+
+TEST(DigestViewUsageTests, NonAdjacentBlockhashes)
+{
+	// Block hashes need not be adjacent (or even in the same buffer).
+	digest_ra_t d("6:ABCDEFGHIJKL:MNOPQRSTUVW");
+	string bh1(d.digest_buffer(), d.blockhash1_len());
+	string bh2(d.digest_buffer() + d.blockhash1_len(), d.blockhash2_len());
+	digest_view_ra_t v(6, bh1.data(), bh1.size(), bh2.data(), bh2.size());
+	EXPECT_EQ(6u, v.blocksize());
+	EXPECT_EQ(12u, v.blockhash1_len());
+	EXPECT_EQ(11u, v.blockhash2_len());
+	EXPECT_EQ(digest_view_ra_t(d), v);
+	EXPECT_NE(digest_view_ra_t(digest_ra_t("12:ABCDEFGHIJKL:MNOPQRSTUVW")), v);
+	EXPECT_EQ(100u, digest_comparison<>::compare(v, digest_view_ra_t(d)));
+	digest_ra_t e("6:ABCDEFGHIJKX:MNOPQRSTUVW");
+	EXPECT_EQ(digest_comparison<>::compare(d, e), digest_comparison<>::compare(v, digest_view_ra_t(e)));
+}
+
+TEST(DigestViewUsageTests, IdenticalEmptyBlockhashesOnVersion2_9)
+{
+	// Identical digests with empty block hashes must not divide by zero
+	for (const char* str : { "3::", "3:ABCDEFGHIJ:", "3::ABCDEFGHIJ" })
+	{
+		digest_ra_t d(str);
+		EXPECT_EQ(
+			digest_comparison<comparison_version::v2_9>::compare(d, d),
+			digest_comparison<comparison_version::v2_9>::compare(digest_view_ra_t(d), digest_view_ra_t(d)))
+			<< "view comparison failed on <" << str << ">.";
+	}
+	EXPECT_EQ(0u, digest_comparison<comparison_version::v2_9>::compare(digest_view_ra_t(digest_ra_t("3::")), digest_view_ra_t(digest_ra_t("3::"))));
+}
+
+#endif
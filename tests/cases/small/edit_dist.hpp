@@ -25,6 +25,7 @@
 #define FFUZZYPP_TESTCASES_SMALL_EDIT_DIST_HPP
 
 #include <cstddef>
+#include <random>
 #include <string>
 
 
@@ -172,4 +173,93 @@ TYPED_TEST(EditDistanceNonemptyTestsComplex, OnRealExamples)
 	EXPECT_EQ(7, TypeParam::cost("A character sequence", 20, "Other character sequence!", 25));
 }
 
+
+template <typename T>
+class EditDistanceBoundedTests : public ::testing::Test {};
+
+typedef ::testing::Types<
+	strings::edit_dist_nonempty_fast<unsigned, EditDistanceTestParam::MaxSize>,
+	strings::edit_dist_nonempty_dp<unsigned, EditDistanceTestParam::MaxSize>,
+	strings::edit_dist_nonempty_bitparallel_wrapper<unsigned, unsigned long, '0', '9', EditDistanceTestParam::MaxSize>,
+	strings::edit_dist_norm<strings::edit_dist_nonempty_fast<unsigned, EditDistanceTestParam::MaxSize>>
+> EditDistanceBoundedTypes;
+TYPED_TEST_CASE(EditDistanceBoundedTests, EditDistanceBoundedTypes);
+
+TYPED_TEST(EditDistanceBoundedTests, MatchesUnbounded)
+{
+	static const size_t max_size = EditDistanceTestParam::MaxSize;
+	std::mt19937 rng(1);
+	for (unsigned n = 0; n < 2000; n++)
+	{
+		// small alphabet to make the distance vary
+		string strA(1 + rng() % max_size, '0');
+		string strB(1 + rng() % max_size, '0');
+		for (auto& ch : strA)
+			ch = char('0' + rng() % 4);
+		for (auto& ch : strB)
+			ch = char('0' + rng() % 4);
+		unsigned expected = strings::edit_dist_dp<unsigned, max_size>::cost(
+			strA.data(), strA.size(), strB.data(), strB.size());
+		for (unsigned max_cost = 0; max_cost <= max_size * 2; max_cost++)
+		{
+			unsigned cost = TypeParam::cost_bounded(
+				strA.data(), strA.size(), strB.data(), strB.size(), max_cost);
+			if (expected <= max_cost)
+				ASSERT_EQ(expected, cost)
+					<< "edit_dist bounded test failed on <" << strA << "> and <" << strB
+					<< "> (max_cost=" << max_cost << ").";
+			else
+				ASSERT_LT(max_cost, cost)
+					<< "edit_dist bounded test failed on <" << strA << "> and <" << strB
+					<< "> (max_cost=" << max_cost << ").";
+		}
+	}
+}
+
+
+template <typename T>
+class EditDistanceMultiTests : public ::testing::Test {};
+
+typedef ::testing::Types<
+	strings::edit_dist_nonempty_bitparallel_multi<unsigned, EditDistanceTestParam::MaxSize, 1>,
+	strings::edit_dist_nonempty_bitparallel_multi<unsigned, EditDistanceTestParam::MaxSize, 4>,
+	strings::edit_dist_nonempty_bitparallel_multi<unsigned, EditDistanceTestParam::MaxSize, 8>
+> EditDistanceMultiTypes;
+TYPED_TEST_CASE(EditDistanceMultiTests, EditDistanceMultiTypes);
+
+TYPED_TEST(EditDistanceMultiTests, MatchesSingle)
+{
+	static const size_t max_size = EditDistanceTestParam::MaxSize;
+	static const size_t lanes = TypeParam::lanes;
+	std::mt19937 rng(2);
+	for (unsigned n = 0; n < 2000; n++)
+	{
+		string strA(1 + rng() % max_size, '0');
+		for (auto& ch : strA)
+			ch = char('0' + rng() % 4);
+		strings::position_array<unsigned long, char, '0', '9'> parray(strA.data(), strA.size());
+		// lanes with different lengths
+		string strB[lanes];
+		const char* ptrs[lanes];
+		size_t lens[lanes];
+		for (size_t k = 0; k < lanes; k++)
+		{
+			strB[k].assign(1 + rng() % max_size, '0');
+			for (auto& ch : strB[k])
+				ch = char('0' + rng() % 4);
+			ptrs[k] = strB[k].data();
+			lens[k] = strB[k].size();
+		}
+		unsigned costs[lanes];
+		TypeParam::cost(parray, strA.size(), ptrs, lens, costs);
+		for (size_t k = 0; k < lanes; k++)
+		{
+			ASSERT_EQ((strings::edit_dist_dp<unsigned, max_size>::cost(
+					strA.data(), strA.size(), strB[k].data(), strB[k].size())), costs[k])
+				<< "edit_dist multi-lane test failed on <" << strA << "> and <" << strB[k]
+				<< "> (lane " << k << ").";
+		}
+	}
+}
+
 #endif
@@ -35,10 +35,30 @@ using namespace ffuzzy;
 using namespace std;
 
 #include "cases/small/base64.hpp"
+#include "cases/small/blockhash_signature.hpp"
 #include "cases/small/context_hash.hpp"
+#include "cases/small/digest_all_pairs.hpp"
+#include "cases/small/digest_bitsliced_store.hpp"
 #include "cases/small/digest_blocksize.hpp"
+#include "cases/small/digest_compact_store.hpp"
 #include "cases/small/digest_comparison_score_cap.hpp"
+#include "cases/small/digest_comparison_table.hpp"
+#include "cases/small/digest_comparison_threshold.hpp"
+#include "cases/small/digest_concurrent_index.hpp"
 #include "cases/small/digest_generator.hpp"
+#include "cases/small/digest_index.hpp"
+#include "cases/small/digest_intern.hpp"
+#include "cases/small/digest_join.hpp"
+#include "cases/small/digest_lsh_index.hpp"
+#include "cases/small/digest_lsm_index.hpp"
+#include "cases/small/digest_parallel_all_pairs.hpp"
+#include "cases/small/digest_posting_list.hpp"
+#include "cases/small/digest_query.hpp"
+#include "cases/small/digest_service.hpp"
+#include "cases/small/digest_shard.hpp"
+#include "cases/small/digest_snapshot.hpp"
+#include "cases/small/digest_stream_cluster.hpp"
+#include "cases/small/digest_view.hpp"
 #include "cases/small/common_substr.hpp"
 #include "cases/small/edit_dist.hpp"
 #include "cases/small/nosequences.hpp"